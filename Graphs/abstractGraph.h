@@ -3,6 +3,18 @@
  *
  *  Defines the necessary functions for a graph
  *
+ *  Each call to newGraph() creates a new, independent graph and
+ *  returns a handle to it. All other functions take that handle as
+ *  their first argument, so a program can keep many graphs at once.
+ *
+ *  Functions that only look at a graph (findVertex,
+ *  getAdjacentVertices, the traversals and the reachability checks)
+ *  keep their working information in storage of their own, not in
+ *  the graph. Several threads can call them on the same graph at the
+ *  same time, as long as no thread is changing that graph.
+ *  This includes isReachable when it has to rebuild the reachability
+ *  index; the graph modules use a lock for that.
+ *
  *  Copyright 2020 by Sally E. Goldin
  *
  *  May be freely copied and modified for educational purposes
@@ -13,26 +25,32 @@
 #ifndef ABSTRACTGRAPH_H
 #define ABSTRACTGRAPH_H
 
-/* Initialize the graph.
+/* opaque pointer to a graph */
+typedef void* GRAPH_HANDLE;
+
+/* Create a new, empty graph.
  * Argument 
  *    maxVertices  - how many vertices can this graph
  *                   handle.
  *    bDirected    - If true this is a directed graph.
  *                   Otherwise undirected.
- * Returns 1 unless there is a memory allocation error,
- * in which case it returns zero.
+ * Returns a handle for the graph, or NULL if there is a
+ * memory allocation error.
  */
-int initGraph(int maxVertices, int bDirected);
+GRAPH_HANDLE newGraph(int maxVertices, int bDirected);
 
 
-/* Free all memory associated with the graph and
- * reset all parameters.
+/* Free all memory associated with the graph. Does not
+ * free the data stored with the vertices.
+ * Arguments
+ *    graph  -  Graph to free. Not valid after this call.
  */
-void clearGraph();
+void graphDestroy(GRAPH_HANDLE graph);
 
 
 /* Add a vertex into the graph.
  * Arguments
+ *     graph -   Graph returned by newGraph
  *     key   -   Key value or label for the 
  *               vertex
  *     pData -   Additional information that can
@@ -44,22 +62,24 @@ void clearGraph();
  * to add a vertex with a key that matches a vertex
  * already in the graph.
  */
-int addVertex(char* key, void* pData);
+int addVertex(GRAPH_HANDLE graph, char* key, void* pData);
 
 
 /* Remove a vertex from the graph.
  * Arguments
+ *     graph -   Graph returned by newGraph
  *     key   -   Key value or label for the 
  *               vertex to remove
  * Returns a pointer to the data stored at that
  * vertex, or NULL if the vertex could not be 
  * found.
  */
-void* removeVertex(char* key);
+void* removeVertex(GRAPH_HANDLE graph, char* key);
 
 
 /* Add an edge between two vertices
  * Arguments
+ *    graph -  Graph returned by newGraph
  *    key1  -  Key for the first vertex in the edge
  *    key2  -  Key for the second vertex
  * Returns 1 if successful, 0 if failed due to
@@ -67,64 +87,114 @@ void* removeVertex(char* key);
  * is not found. Returns -1 if an edge already
  * exists in this direction.
  */
-int addEdge(char* key1, char* key2);
+int addEdge(GRAPH_HANDLE graph, char* key1, char* key2);
 
 
 /* Remove an edge between two vertices
  * Arguments
+ *    graph -  Graph returned by newGraph
  *    key1  -  Key for the first vertex in the edge
  *    key2  -  Key for the second vertex
  * Returns 1 if successful, 0 if failed 
  * because either vertex is not found or there
  * is no edge between these items.
  */
-int removeEdge(char* key1, char* key2);
+int removeEdge(GRAPH_HANDLE graph, char* key1, char* key2);
 
 
 /* Find a vertex and return its data
  * Arguments
+ *    graph -  Graph returned by newGraph
  *    key  -  Key for the vertex to find
  * Returns the data for the vertex or NULL
  * if not found.
  */
-void* findVertex(char* key);
+void* findVertex(GRAPH_HANDLE graph, char* key);
 
 /* Return an array of copies of the keys for all nodes
  * adjacent to a node. The array and its
  * contents should be freed by the caller when it 
  * is no longer needed.
  * Arguments
+ *    graph  - Graph returned by newGraph
  *    key   -  Key for the node whose adjacents we want
  *    pCount - Return number of elements in the array
  * Returns array of char* which are the keys of adjacent
  * nodes. Returns number of adjacent vertices in pCount.
  * If pCount holds -1, the vertex does not exist.
  */
-char** getAdjacentVertices(char* key, int* pCount);
+char** getAdjacentVertices(GRAPH_HANDLE graph, char* key, int* pCount);
 
 
 /* Print out all the nodes reachable from a node by a 
  * breadth-first search.
  * Arguments
+ *   graph      -  Graph returned by newGraph
  *   startKey   -  Key for start vertex
  * Returns 1 if successful, -1 if the vertex does not exist.
  */
-int printBreadthFirst(char* startKey);
+int printBreadthFirst(GRAPH_HANDLE graph, char* startKey);
 
 
 /* Print out all the nodes by a depth-first search.
+ * Arguments
+ *    graph  -  Graph returned by newGraph
  */
-void printDepthFirst();
+void printDepthFirst(GRAPH_HANDLE graph);
 
 
 /* Return information as to whether two vertices are
  * connected by a path.
  * Arguments
+ *    graph - Graph returned by newGraph
+ *    key1 -  Key for the start vertex 
+ *    key2 -  Key for the second vertex to check 
+ * Returns 1 if the two vertices are connected, 0 if they
+ * are not. Returns -1 if either vertex does not exist.
+ */
+int isReachable(GRAPH_HANDLE graph, char* key1, char* key2);
+
+
+/* Return information as to whether two vertices are
+ * connected by a path, like isReachable, and if so
+ * print the path.
+ * Arguments
+ *    graph - Graph returned by newGraph
  *    key1 -  Key for the start vertex 
  *    key2 -  Key for the second vertex to check 
  * Returns 1 if the two vertices are connected, 0 if they
  * are not. Returns -1 if either vertex does not exist.
  */
-int isReachable(char* key1, char* key2);
+int isReachablePrintPath(GRAPH_HANDLE graph, char* key1, char* key2);
+
+
+/* Build an index so that isReachable can answer without a search.
+ * This is worth doing once a graph has been loaded, if it will be
+ * asked many reachability questions before it changes. The index
+ * is a bit for each pair of vertices (or of groups of vertices that
+ * can all reach each other), so it can take a lot of memory.
+ *
+ * Changes to the graph make the index out of date, and the next
+ * isReachable call builds it again, as long as it still fits in
+ * maxBytes. A graph module may instead update the index when that
+ * is cheap; all of them do so for an edge between two vertices when
+ * the first can already reach the second.
+ * Arguments
+ *    graph     - Graph returned by newGraph
+ *    maxBytes  - Largest index to build. If 0, any index is
+ *                freed and is not built again.
+ * Returns 1 if the index was built, 0 if it would take more than
+ * maxBytes, or -1 if a memory allocation error occurs.
+ */
+int buildReachabilityIndex(GRAPH_HANDLE graph, long maxBytes);
+
+
+/* Find out how much memory the reachability index is using.
+ * Argument
+ *    graph     - Graph returned by newGraph
+ * Returns the number of bytes, or 0 if there is no index
+ * at the moment.
+ */
+long getReachabilityIndexSize(GRAPH_HANDLE graph);
 
 #endif
@@ -0,0 +1,1117 @@
+/*
+ *  bitMatrixGraph.c
+ *
+ *  Implements an abstractGraph using an adjacency matrix in which
+ *  each possible edge takes one bit instead of one int.
+ *
+ *  Row i of the matrix is a bitset: bit j is set if there is an edge
+ *  from vertex i to vertex j. Each row is a whole number of 64-bit
+ *  words, rounded up so that every row starts on a 32 byte boundary,
+ *  and all the rows are in one contiguous allocation. This takes 32
+ *  times less memory than matrixGraph.c, and lets us deal with 64
+ *  possible edges at once.
+ *
+ *  The traversals keep a "visited" bitset with the same layout as a
+ *  row. To expand a vertex in a breadth first search, we compute
+ *  (row AND NOT visited) a word at a time, which gives all the
+ *  unvisited neighbors at once, mark them visited, and then append
+ *  them to the queue in index order, skipping words with no new
+ *  vertices. On x86 processors the AND NOT loop uses SSE2, or AVX2
+ *  if the processor has it, to do 128 or 256 bits per instruction.
+ *  The order in which vertices are visited is the same as in
+ *  matrixGraph.c.
+ *
+ *  Key values are strings and are copied when vertices are inserted
+ *  into the graph. Every vertex has a void* pointer to ancillary data
+ *  which is simply stored. Since this backend is meant for large
+ *  graphs, vertices are found from their keys with a hash table
+ *  (keyIndex.c) rather than by searching the vertex array.
+ *
+ *  Depth first traversals are done by depthFirst.c, which keeps its
+ *  own stack instead of using recursion. It steps through the set
+ *  bits of a row with a count of trailing zeros.
+ *
+ *  buildReachabilityIndex() keeps the transitive closure as a second
+ *  matrix with the same layout, so isReachable() becomes a single bit
+ *  test. Adding a vertex or an edge updates the closure in place.
+ *  Removing one frees it, and the next isReachable() call builds it
+ *  again under a lock, so this module needs -lpthread.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "abstractGraph.h"
+#include "keyIndex.h"
+#include "depthFirst.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BITGRAPH_X86 1
+#include <immintrin.h>
+#endif
+
+#define ROW_ALIGN 32          /* bytes; one AVX2 register */
+#define WORD_BITS 64          /* bits in each word of a row */
+
+/* test, set and clear bit j of a bitset */
+#define TESTBIT(set,j)  (((set)[(j) / WORD_BITS] >> ((j) % WORD_BITS)) & 1)
+#define SETBIT(set,j)   ((set)[(j) / WORD_BITS] |= ((uint64_t) 1 << ((j) % WORD_BITS)))
+#define CLEARBIT(set,j) ((set)[(j) / WORD_BITS] &= ~((uint64_t) 1 << ((j) % WORD_BITS)))
+
+
+/* Structure for the main vertex list.*/
+typedef struct _vertex
+{
+    char * key;               /* key for this vertex */
+    void * data;              /* ancillary data for this vertex */
+    int index;                /* array index, and bit number in the rows */
+}  VERTEX_T;
+
+/* Function that expands one row, see expandRowPlain */
+typedef int (*EXPAND_FUNCTION_T)(const uint64_t*, uint64_t*, uint64_t*, int);
+
+/* Structure holding one graph */
+typedef struct
+{
+    VERTEX_T * vertices;      /* array of vertices. Will be allocated
+			       * in newGraph based on maximum passed in.
+                               */
+    void * matrixMemory;      /* memory holding the rows, before aligning */
+    uint64_t * rows;          /* maxVertices rows of rowWords words each */
+    int rowWords;             /* words per row, a multiple of 4 */
+    KEY_INDEX_HANDLE vertexIndex; /* maps keys to vertices */
+    int maxVertices;          /* set by newGraph */
+    int bGraphDirected;       /* if true, this is a directed graph */
+    int vertexCount;          /* keep track of the number of vertices */
+                              /* updated in addVertex and removeVertex */
+    int lastIndex;            /* last item in array that is in use */
+                              /* could be > than vertexCount if we have
+			       * removed some vertices
+                               */
+    void * reachMemory;       /* memory holding the index, before aligning */
+    uint64_t * reach;         /* reachability index, or NULL. Laid out
+                               * like the matrix; row i is a bitset of
+                               * the vertices i can reach
+                               */
+    long reachMaxBytes;       /* largest index to build, or 0 if
+                               * no index is wanted
+                               */
+    pthread_mutex_t reachLock; /* held while building the index */
+    EXPAND_FUNCTION_T expandRow; /* fastest row expansion this
+                               * processor can run, chosen once in
+                               * newGraph
+                               */
+} GRAPH_T;
+
+/* Working storage for one traversal */
+typedef struct
+{
+    void * bitsMemory;        /* memory holding both bitsets */
+    uint64_t * visited;       /* bitset of vertices already seen */
+    uint64_t * newBits;       /* unvisited neighbors of the vertex
+                               * being expanded */
+    int * queue;              /* indices of vertices waiting for a
+                               * breadth first traversal to visit them
+                               */
+    int * parent;             /* vertex each one was reached from, -1
+                               * for the start. NULL if not needed. */
+} TRAVERSAL_T;
+
+/** Private functions */
+
+/* Get the address of a row of the matrix.
+ * Arguments
+ *    pGraph  -  Graph whose matrix we want
+ *    index   -  Index of the vertex whose row we want
+ * Returns a pointer to the first word of the row.
+ */
+uint64_t* getRow(GRAPH_T* pGraph, int index)
+{
+   return pGraph->rows + (size_t) index * pGraph->rowWords;
+}
+
+/* Allocate one or more bitsets with the same layout as the
+ * rows of the matrix, one after another.
+ * Arguments
+ *    pGraph   -  Graph the bitsets are for
+ *    rowCount -  How many bitsets we want
+ *    pMemory  -  Returns the pointer to give to free()
+ * Returns the first aligned, all zero bitset, or NULL if a memory
+ * allocation error occurs.
+ */
+uint64_t* newAlignedBits(GRAPH_T* pGraph, size_t rowCount, void** pMemory)
+{
+   uint64_t* pBits = NULL;
+   *pMemory = calloc(rowCount * pGraph->rowWords * sizeof(uint64_t)
+		     + ROW_ALIGN, 1);
+   if (*pMemory != NULL)
+      pBits = (uint64_t*) (((uintptr_t) *pMemory + ROW_ALIGN - 1) &
+			   ~((uintptr_t) ROW_ALIGN - 1));
+   return pBits;
+}
+
+/* Find the unvisited neighbors of a vertex and mark them visited,
+ * one 64-bit word at a time. This version works on any processor.
+ * Arguments
+ *    row      -  Row of the vertex being expanded
+ *    visited  -  Bitset of visited vertices; updated
+ *    newBits  -  Set to the neighbors that were not visited before
+ *    words    -  Number of words in each of the bitsets
+ * Returns 1 if any new neighbors were found, else 0.
+ */
+int expandRowPlain(const uint64_t* row, uint64_t* visited,
+		   uint64_t* newBits, int words)
+{
+   int bAny = 0;
+   int w = 0;
+   for (w = 0; w < words; w++)
+      {
+      uint64_t fresh = row[w] & ~visited[w];
+      visited[w] |= fresh;
+      newBits[w] = fresh;
+      bAny |= (fresh != 0);
+      }
+   return bAny;
+}
+
+#ifdef BITGRAPH_X86
+/* Same as expandRowPlain, 128 bits at a time with SSE2.
+ * All the bitsets are aligned and a multiple of 256 bits long.
+ */
+__attribute__((target("sse2")))
+int expandRowSSE2(const uint64_t* row, uint64_t* visited,
+		  uint64_t* newBits, int words)
+{
+   __m128i any = _mm_setzero_si128();
+   int w = 0;
+   for (w = 0; w < words; w += 2)
+      {
+      __m128i r = _mm_load_si128((const __m128i*) (row + w));
+      __m128i v = _mm_load_si128((const __m128i*) (visited + w));
+      __m128i fresh = _mm_andnot_si128(v, r);   /* r AND NOT v */
+      _mm_store_si128((__m128i*) (visited + w), _mm_or_si128(v, fresh));
+      _mm_store_si128((__m128i*) (newBits + w), fresh);
+      any = _mm_or_si128(any, fresh);
+      }
+   return (_mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128()))
+	   != 0xFFFF);
+}
+
+/* Same as expandRowPlain, 256 bits at a time with AVX2. */
+__attribute__((target("avx2")))
+int expandRowAVX2(const uint64_t* row, uint64_t* visited,
+		  uint64_t* newBits, int words)
+{
+   __m256i any = _mm256_setzero_si256();
+   int w = 0;
+   for (w = 0; w < words; w += 4)
+      {
+      __m256i r = _mm256_load_si256((const __m256i*) (row + w));
+      __m256i v = _mm256_load_si256((const __m256i*) (visited + w));
+      __m256i fresh = _mm256_andnot_si256(v, r);
+      _mm256_store_si256((__m256i*) (visited + w), _mm256_or_si256(v, fresh));
+      _mm256_store_si256((__m256i*) (newBits + w), fresh);
+      any = _mm256_or_si256(any, fresh);
+      }
+   return !_mm256_testz_si256(any, any);
+}
+#endif
+
+/* Choose the fastest version of the row expansion that
+ * this processor can run.
+ * Returns a pointer to the function to use.
+ */
+EXPAND_FUNCTION_T chooseExpandFunction()
+{
+#ifdef BITGRAPH_X86
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+      return &expandRowAVX2;
+   if (__builtin_cpu_supports("sse2"))
+      return &expandRowSSE2;
+#endif
+   return &expandRowPlain;
+}
+
+/* Finds the vertex that holds the passed key
+ * (if any) and returns its index.
+ * Arguments
+ *       pGraph -  Graph to search
+ *       key    -  Key we are looking for
+ * Returns index of vertex in the vertices array, or -1
+ * if not found.
+ */
+int findVertexByKey(GRAPH_T* pGraph, char* key)
+{
+    VERTEX_T * pVertex = (VERTEX_T*) keyIndexLookup(pGraph->vertexIndex,key);
+    return (pVertex != NULL) ? pVertex->index : -1;
+}
+
+/* Finds the first unused slot in the vertices array.
+ * This may be a slot make available by a 'remove', or
+ * the slot after the current 'lastIndex'
+ * Argument
+ *    pGraph  - Graph we want to add to
+ * Returns the first available index or -1 if array is full.
+ * Updates lastIndex as a side effect if it returns lastIndex+1
+ */
+int findFirstUnused(GRAPH_T* pGraph)
+{
+    int i = 0;
+    int returnidx = -1;
+    if (pGraph->vertexCount < pGraph->maxVertices)
+      {
+      for (i=0; i <= pGraph->lastIndex; i++)
+	 {
+	 if (pGraph->vertices[i].key == NULL)
+	    {
+	    returnidx = i;
+            break;
+            }
+         }
+      if (returnidx == -1) /* no slots in the middle of the array */
+	 {
+	 pGraph->lastIndex++;
+         returnidx = pGraph->lastIndex;
+         }
+      }
+    return returnidx;
+}
+
+/* Count adjacent vertices to a vertex. Edges to removed
+ * vertices are always cleared, so we just count the bits.
+ * Arguments
+ *    pGraph        -   Graph the vertex belongs to
+ *    whichVertex   -   Index of vertex whose adjacent nodes we want to count
+ * Returns integer value for count (could be zero)
+ */
+int countAdjacent(GRAPH_T* pGraph, int whichVertex)
+{
+    uint64_t * row = getRow(pGraph,whichVertex);
+    int count = 0;
+    int w = 0;
+    for (w = 0; w < pGraph->rowWords; w++)
+       count += __builtin_popcountll(row[w]);
+    return count;
+}
+
+/* Free the memory used by a traversal.
+ * Argument
+ *    pTraversal  - Traversal to free (may be NULL)
+ */
+void freeTraversal(TRAVERSAL_T* pTraversal)
+{
+    if (pTraversal != NULL)
+       {
+       free(pTraversal->bitsMemory);
+       free(pTraversal->queue);
+       free(pTraversal->parent);
+       free(pTraversal);
+       }
+}
+
+/* Allocate the working storage for one traversal of a graph,
+ * with no vertices visited.
+ * Arguments
+ *    pGraph   - Graph we are going to traverse
+ *    bParents - If true, also allocate the parent array
+ * Returns the new traversal, or NULL if a memory allocation
+ * error occurs.
+ */
+TRAVERSAL_T* newTraversal(GRAPH_T* pGraph, int bParents)
+{
+    TRAVERSAL_T* pTraversal = (TRAVERSAL_T*) calloc(1,sizeof(TRAVERSAL_T));
+    if (pTraversal != NULL)
+       {
+       pTraversal->visited = newAlignedBits(pGraph,2,&pTraversal->bitsMemory);
+       pTraversal->newBits = pTraversal->visited + pGraph->rowWords;
+       pTraversal->queue = (int*) calloc(pGraph->maxVertices,sizeof(int));
+       if (bParents)
+	  pTraversal->parent = (int*) calloc(pGraph->maxVertices,sizeof(int));
+       if ((pTraversal->visited == NULL) || (pTraversal->queue == NULL) ||
+	   ((bParents) && (pTraversal->parent == NULL)))
+          {
+	  freeTraversal(pTraversal);
+	  pTraversal = NULL;
+	  }
+       }
+    return pTraversal;
+}
+
+/* Execute a breadth first search from a vertex,
+ * calling the function (*vFunction) on each vertex
+ * as we visit it. A vertex is marked visited when it
+ * goes into the queue, so it is never queued twice.
+ * Arguments
+ *    pGraph     - Graph to traverse
+ *    pTraversal - Working storage, no vertices visited
+ *    vIndex     - Index of the starting vertex
+ *    endIndex   - If not -1, stop as soon as this vertex is found
+ *    vFunction  - Function to call for each vertex, or NULL
+ */
+void traverseBreadthFirst(GRAPH_T* pGraph, TRAVERSAL_T* pTraversal,
+			  int vIndex, int endIndex,
+			  void (*vFunction)(VERTEX_T*))
+{
+    EXPAND_FUNCTION_T expandRow = pGraph->expandRow;
+    uint64_t * visited = pTraversal->visited;
+    uint64_t * newBits = pTraversal->newBits;
+    int * queue = pTraversal->queue;
+    int * parent = pTraversal->parent;
+    int head = 0;
+    int tail = 0;
+    int current = -1;
+    queue[tail++] = vIndex;
+    SETBIT(visited,vIndex);
+    if (parent != NULL)
+       parent[vIndex] = -1;
+    while ((head < tail) && ((endIndex < 0) || (!TESTBIT(visited,endIndex))))
+        {
+        current = queue[head++];
+        if (vFunction != NULL)
+	   (*vFunction)(&pGraph->vertices[current]);
+        if ((*expandRow)(getRow(pGraph,current),visited,newBits,
+			 pGraph->rowWords))
+	   {
+	   int w = 0;
+	   /* queue the new neighbors in index order */
+	   for (w = 0; w < pGraph->rowWords; w++)
+	      {
+	      uint64_t bits = newBits[w];
+	      while (bits != 0)
+	         {
+		 int i = w * WORD_BITS + __builtin_ctzll(bits);
+		 bits &= bits - 1;   /* clear the lowest bit */
+		 queue[tail++] = i;
+		 if (parent != NULL)
+		    parent[i] = current;
+		 }
+	      }
+	   }
+       } /* end while queue has data */
+}
+
+
+/* Find the first vertex adjacent to a vertex, starting
+ * from the cursor's bit.
+ * Arguments
+ *    pGraph     - Graph to look in
+ *    vIndex     - Index of the vertex
+ *    pCursor    - Bit to start at; set to the bit found
+ * Returns the index of the adjacent vertex, or -1 if there
+ * are no more.
+ */
+int scanAdjacent(GRAPH_T* pGraph, int vIndex, DFS_CURSOR_T* pCursor)
+{
+    uint64_t * row = getRow(pGraph,vIndex);
+    int w = (int) (pCursor->position / WORD_BITS);
+    uint64_t bits = 0;
+    if (w >= pGraph->rowWords)
+       return -1;
+    /* ignore the bits before the cursor in its word */
+    bits = row[w] & (~(uint64_t) 0 << (pCursor->position % WORD_BITS));
+    while (bits == 0)
+       {
+       w++;
+       if (w >= pGraph->rowWords)
+	  {
+	  pCursor->position = (long) w * WORD_BITS;
+	  return -1;
+	  }
+       bits = row[w];
+       }
+    pCursor->position = (long) w * WORD_BITS + __builtin_ctzll(bits);
+    return (int) pCursor->position;
+}
+
+/* Start looking through the vertices adjacent to a vertex.
+ * Used by the depth first search engine.
+ * Arguments
+ *    pGraph     - Graph to look in (will be cast to GRAPH_T*)
+ *    vIndex     - Index of the vertex
+ *    pCursor    - Set to the bit of the first adjacent vertex
+ * Returns the index of the first adjacent vertex, or -1.
+ */
+int firstAdjacent(void* pGraph, int vIndex, DFS_CURSOR_T* pCursor)
+{
+    pCursor->position = 0;
+    return scanAdjacent((GRAPH_T*) pGraph,vIndex,pCursor);
+}
+
+/* Move on to the next vertex adjacent to a vertex.
+ * Used by the depth first search engine.
+ * Arguments
+ *    pGraph     - Graph to look in (will be cast to GRAPH_T*)
+ *    vIndex     - Index of the vertex
+ *    pCursor    - Bit of the current adjacent vertex;
+ *                 moved to the next one
+ * Returns the index of the next adjacent vertex, or -1.
+ */
+int nextAdjacent(void* pGraph, int vIndex, DFS_CURSOR_T* pCursor)
+{
+    pCursor->position++;
+    return scanAdjacent((GRAPH_T*) pGraph,vIndex,pCursor);
+}
+
+
+/* Function to print the information about a vertex
+ * Argument
+ *   pVertex   -   vertex we want to print
+ */
+void printVertexInfo(VERTEX_T* pVertex)
+{
+    printf("== Vertex key |%s| - data |%s|\n",
+	   pVertex->key, pVertex->data);
+}
+
+/* Work out how much memory the reachability index of a graph
+ * needs. It is the same size as the matrix.
+ * Argument
+ *    pGraph  - Graph we want an index for
+ * Returns the number of bytes.
+ */
+long reachBytes(GRAPH_T* pGraph)
+{
+   return (long) pGraph->maxVertices * pGraph->rowWords * sizeof(uint64_t)
+          + ROW_ALIGN;
+}
+
+/* Free the reachability index of a graph, if it has one.
+ * Argument
+ *    pGraph  - Graph whose index we are freeing
+ */
+void freeReach(GRAPH_T* pGraph)
+{
+   free(pGraph->reachMemory);
+   pGraph->reachMemory = NULL;
+   pGraph->reach = NULL;
+}
+
+/* OR the index row of one vertex into the rows of all the
+ * vertices that can reach another vertex. Used to build the
+ * index, and to keep it up to date when an edge is added.
+ * Arguments
+ *    pGraph  - Graph whose index we are changing
+ *    from    - Index of the vertex whose reachers we update
+ *    to      - Index of the vertex whose row we add to theirs
+ */
+void spreadReach(GRAPH_T* pGraph, int from, int to)
+{
+   int words = pGraph->lastIndex / WORD_BITS + 1;
+   uint64_t * toRow = pGraph->reach + (size_t) to * pGraph->rowWords;
+   int i = 0;
+   int w = 0;
+   for (i = 0; i <= pGraph->lastIndex; i++)
+      {
+      uint64_t * row = pGraph->reach + (size_t) i * pGraph->rowWords;
+      if (TESTBIT(row,from))
+         {
+	 for (w = 0; w < words; w++)
+	    row[w] |= toRow[w];
+         }
+      }
+}
+
+/* Build the reachability index, a transitive closure of the
+ * matrix. It starts as a copy of the matrix with each vertex
+ * reaching itself; then, for each vertex k in turn, anything that
+ * reaches k also reaches everything k reaches (Warshall's
+ * algorithm), a word at a time. The caller must hold the index lock.
+ * Argument
+ *    pGraph  - Graph that does not have an index
+ * Returns 1 if successful, 0 if the index would take more than
+ * reachMaxBytes, or -1 for a memory allocation error.
+ */
+int buildReach(GRAPH_T* pGraph)
+{
+   int i = 0;
+   if (reachBytes(pGraph) > pGraph->reachMaxBytes)
+      return 0;
+   pGraph->reach = newAlignedBits(pGraph,pGraph->maxVertices,
+				  &pGraph->reachMemory);
+   if (pGraph->reach == NULL)
+      return -1;
+   /* rows of removed vertices are all zero in the matrix */
+   memcpy(pGraph->reach,pGraph->rows,(size_t) pGraph->maxVertices *
+	  pGraph->rowWords * sizeof(uint64_t));
+   for (i = 0; i <= pGraph->lastIndex; i++)
+      {
+      if (pGraph->vertices[i].key != NULL)
+	 SETBIT(pGraph->reach + (size_t) i * pGraph->rowWords,i);
+      }
+   for (i = 0; i <= pGraph->lastIndex; i++)
+      {
+      if (pGraph->vertices[i].key != NULL)
+	 spreadReach(pGraph,i,i);
+      }
+   return 1;
+}
+
+/* Get the reachability index of a graph, building it again
+ * if it is wanted but out of date.
+ * Argument
+ *    pGraph  - Graph we are going to check
+ * Returns the index, or NULL if there is none.
+ */
+uint64_t* ensureReach(GRAPH_T* pGraph)
+{
+   uint64_t * reach = NULL;
+   pthread_mutex_lock(&pGraph->reachLock);
+   if ((pGraph->reach == NULL) && (pGraph->reachMaxBytes > 0))
+      buildReach(pGraph);
+   reach = pGraph->reach;
+   pthread_mutex_unlock(&pGraph->reachLock);
+   return reach;
+}
+
+
+/********************************/
+/** Public functions start here */
+/********************************/
+
+/* Create a new, empty graph.
+ * Argument
+ *    maxVertices  - how many vertices can this graph
+ *                   handle.
+ *    bDirected    - If true this is a directed graph.
+ *                   Otherwise undirected.
+ * Returns a handle for the graph, or NULL if there is a
+ * memory allocation error.
+ */
+GRAPH_HANDLE newGraph(int maxVertices, int bDirected)
+{
+    GRAPH_T * pGraph = (GRAPH_T*) calloc(1,sizeof(GRAPH_T));
+    if (pGraph == NULL)
+       return NULL;
+    pGraph->bGraphDirected = bDirected;
+    pGraph->maxVertices = maxVertices;
+    pGraph->lastIndex = -1;
+    pthread_mutex_init(&pGraph->reachLock,NULL);
+    pGraph->expandRow = chooseExpandFunction();
+    /* round each row up to a whole number of 256 bit blocks */
+    pGraph->rowWords = ((maxVertices + 255) / 256) * 4;
+    pGraph->vertices = (VERTEX_T*) calloc(maxVertices,sizeof(VERTEX_T));
+    pGraph->rows = newAlignedBits(pGraph,maxVertices,&pGraph->matrixMemory);
+    pGraph->vertexIndex = newKeyIndex(maxVertices);
+    if ((pGraph->vertices == NULL) || (pGraph->rows == NULL) ||
+	(pGraph->vertexIndex == NULL))
+       {
+       graphDestroy(pGraph);
+       pGraph = NULL;
+       }
+    return (GRAPH_HANDLE) pGraph;
+}
+
+
+/* Free all memory associated with the graph. Does not
+ * free the data stored with the vertices.
+ * Arguments
+ *    graph  -  Graph to free. Not valid after this call.
+ */
+void graphDestroy(GRAPH_HANDLE graph)
+{
+    GRAPH_T * pGraph = (GRAPH_T*) graph;
+    int i;
+    if (pGraph == NULL)
+       return;
+    for (i = 0; (pGraph->vertices != NULL) && (i < pGraph->maxVertices); i++)
+       {
+       free(pGraph->vertices[i].key);  /* because it was strduped */
+       }
+    keyIndexDestroy(pGraph->vertexIndex);
+    free(pGraph->vertices);
+    free(pGraph->matrixMemory);
+    freeReach(pGraph);
+    pthread_mutex_destroy(&pGraph->reachLock);
+    free(pGraph);
+}
+
+/* Add a vertex into the graph.
+ * Arguments
+ *     graph -   Graph returned by newGraph
+ *     key   -   Key value or label for the
+ *               vertex
+ *     pData -   Additional information that can
+ *               be associated with the vertex.
+ * Returns 1 unless there is an error, in which case
+ * it returns a 0. An error could mean a memory allocation
+ * error or running out of space, depending on how the
+ * graph is implemented. Returns -1 if the caller tries
+ * to add a vertex with a key that matches a vertex
+ * already in the graph.
+ */
+int addVertex(GRAPH_HANDLE graph, char* key, void* pData)
+{
+    GRAPH_T * pGraph = (GRAPH_T*) graph;
+    int retval = 1;
+    int location  = findVertexByKey(pGraph,key);
+    if (location >=0)  /* key is already in the graph */
+       {
+       retval = -1;
+       }
+    else
+       {
+       char * pKeyval = strdup(key);
+       int newloc = -1;
+       if ((pKeyval == NULL))
+          {
+	  retval = 0;  /* allocation error */
+	  }
+       else if ((newloc = findFirstUnused(pGraph)) < 0)
+	  {
+	  free(pKeyval);
+	  retval = 0;  /* graph is full */
+	  }
+       else if (keyIndexInsert(pGraph->vertexIndex,pKeyval,
+			       &pGraph->vertices[newloc]) != 1)
+	  {
+	  free(pKeyval);
+	  if (newloc == pGraph->lastIndex)
+	     pGraph->lastIndex--;
+	  retval = 0;  /* allocation error */
+	  }
+       else
+	  {
+	  pGraph->vertices[newloc].key = pKeyval;
+	  pGraph->vertices[newloc].data = pData;
+	  pGraph->vertices[newloc].index = newloc;
+	  pGraph->vertexCount++;
+	  /* a new vertex only reaches itself */
+	  if (pGraph->reach != NULL)
+	     SETBIT(pGraph->reach + (size_t) newloc * pGraph->rowWords,newloc);
+	  }
+       }
+    return retval;
+}
+
+
+/* Remove a vertex from the graph.
+ * Arguments
+ *     graph -   Graph returned by newGraph
+ *     key   -   Key value or label for the
+ *               vertex to remove
+ * Returns a pointer to the data stored at that
+ * vertex, or NULL if the vertex could not be
+ * found.
+ */
+void* removeVertex(GRAPH_HANDLE graph, char* key)
+{
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   VERTEX_T * vertices = pGraph->vertices;
+   int i;
+   void * pData = NULL; /* data to return */
+   int idx = findVertexByKey(pGraph,key);
+   if (idx >= 0)
+      {
+      keyIndexRemove(pGraph->vertexIndex,key);
+      free(vertices[idx].key);
+      vertices[idx].key = NULL;
+      pData = vertices[idx].data;
+      vertices[idx].data = NULL;
+      vertices[idx].index = -1;
+      pGraph->vertexCount--;
+      if (idx == pGraph->lastIndex)
+	 pGraph->lastIndex--;
+      /* now remove any edges where this vertex
+         is either the start or the end vertex
+       */
+      memset(getRow(pGraph,idx),0,pGraph->rowWords * sizeof(uint64_t));
+      for (i=0; i < pGraph->maxVertices; i++)
+	  {
+          CLEARBIT(getRow(pGraph,i),idx);
+          }
+      freeReach(pGraph);
+      }
+   return pData;
+}
+
+
+/* Add an edge between two vertices
+ * Arguments
+ *    graph -  Graph returned by newGraph
+ *    key1  -  Key for the first vertex in the edge
+ *    key2  -  Key for the second vertex
+ * Returns 1 if successful, 0 if failed due to
+ * memory allocation error, or if either vertex
+ * is not found. Returns -1 if an edge already
+ * exists in this direction.
+ */
+int addEdge(GRAPH_HANDLE graph, char* key1, char* key2)
+{
+    GRAPH_T * pGraph = (GRAPH_T*) graph;
+    int retval = 1;
+    int fromidx = findVertexByKey(pGraph,key1);
+    int toidx = findVertexByKey(pGraph,key2);
+    if ((fromidx <0) || (toidx < 0))
+       {
+       retval = 0;
+       }
+    else if (TESTBIT(getRow(pGraph,fromidx),toidx))
+       {
+       retval = -1;
+       }
+    else
+       {
+       SETBIT(getRow(pGraph,fromidx),toidx);
+       /* If undirected, add an edge in the other direction */
+       if (!pGraph->bGraphDirected)
+           SETBIT(getRow(pGraph,toidx),fromidx);
+       /* anything that reaches the first vertex can now reach
+	* everything the second one reaches */
+       if (pGraph->reach != NULL)
+          {
+	  spreadReach(pGraph,fromidx,toidx);
+	  if (!pGraph->bGraphDirected)
+	     spreadReach(pGraph,toidx,fromidx);
+          }
+       }
+    return retval;
+}
+
+
+/* Remove an edge between two vertices
+ * Arguments
+ *    graph -  Graph returned by newGraph
+ *    key1  -  Key for the first vertex in the edge
+ *    key2  -  Key for the second vertex
+ * Returns 1 if successful, 0 if failed
+ * because either vertex is not found or there
+ * is no edge between these items.
+ */
+int removeEdge(GRAPH_HANDLE graph, char* key1, char* key2)
+{
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   int bOk = 1;
+   int fromidx = findVertexByKey(pGraph,key1);
+   int toidx = findVertexByKey(pGraph,key2);
+   if ((fromidx < 0) || (toidx < 0))
+       {
+       bOk = 0;
+       }
+   else if (!TESTBIT(getRow(pGraph,fromidx),toidx)) /* no edge to remove */
+       {
+       bOk = 0;
+       }
+   else
+       {
+       CLEARBIT(getRow(pGraph,fromidx),toidx);
+       /* If undirected, remove edge in the other direction */
+       if (!pGraph->bGraphDirected)
+           CLEARBIT(getRow(pGraph,toidx),fromidx);
+       freeReach(pGraph);
+       }
+   return bOk;
+}
+
+/* Find a vertex and return its data
+ * Arguments
+ *    graph -  Graph returned by newGraph
+ *    key  -  Key for the vertex to find
+ * Returns the data for the vertex or NULL
+ * if not found.
+ */
+void* findVertex(GRAPH_HANDLE graph, char* key)
+{
+    GRAPH_T * pGraph = (GRAPH_T*) graph;
+    void* pData = NULL;
+    int index = findVertexByKey(pGraph,key);
+    if (index >= 0)
+       {
+       pData = pGraph->vertices[index].data;
+       }
+    return pData;
+}
+
+
+
+/* Return an array of copies of the keys for all nodes
+ * adjacent to a node. The array and its
+ * contents should be freed by the caller when it
+ * is no longer needed.
+ * Arguments
+ *    graph -  Graph returned by newGraph
+ *    key   -  Key for the node whose adjacents we want
+ *    pCount - Return number of elements in the array
+ * Returns array of char* which are the keys of adjacent
+ * nodes. Returns number of adjacent vertices in pCount.
+ * If pCount holds -1, the vertex does not exist.
+ */
+char** getAdjacentVertices(GRAPH_HANDLE graph, char* key, int* pCount)
+{
+    GRAPH_T * pGraph = (GRAPH_T*) graph;
+    VERTEX_T * vertices = pGraph->vertices;
+    char** keyArray = NULL;
+    int foundidx = findVertexByKey(pGraph,key);
+    if (foundidx >=0)
+       {
+       *pCount = countAdjacent(pGraph,foundidx);
+       if (*pCount > 0)
+          {
+	  uint64_t * row = getRow(pGraph,foundidx);
+	  int dest = 0;
+          int w = 0;
+	  keyArray = (char**) calloc(*pCount, sizeof(char*));
+          if (keyArray != NULL)
+	     {
+	     for (w = 0; w < pGraph->rowWords; w++)
+	        {
+		uint64_t bits = row[w];
+		while (bits != 0)
+		    {
+		    int i = w * WORD_BITS + __builtin_ctzll(bits);
+		    bits &= bits - 1;
+		    keyArray[dest] = strdup(vertices[i].key);
+		    dest += 1;
+		    }
+	        }
+	     }
+          }
+       }
+    else
+       {
+       *pCount = -1;
+       }
+    return keyArray;
+}
+
+
+/* Print out all the nodes reachable from a node by a
+ * breadth-first search.
+ * Arguments
+ *   graph      -  Graph returned by newGraph
+ *   startKey   -  Key for start vertex
+ * Returns 1 if successful, -1 if the vertex does not exist.
+ */
+int printBreadthFirst(GRAPH_HANDLE graph, char* startKey)
+{
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   int retval = 1;
+   TRAVERSAL_T * pTraversal = NULL;
+   if (pGraph->vertexCount == 0)
+      {
+      printf("The graph is empty\n");
+      }
+   int foundidx = findVertexByKey(pGraph,startKey);
+   if (foundidx < 0)
+      {
+      printf("Vertex |%s| does not exist\n", startKey);
+      retval = -1;
+      }
+   else if ((pTraversal = newTraversal(pGraph,0)) == NULL)
+      {
+      printf("Allocation error in printBreadthFirst!\n");
+      }
+   else
+      {
+      traverseBreadthFirst(pGraph,pTraversal,foundidx,-1,&printVertexInfo);
+      freeTraversal(pTraversal);
+      }
+   return retval;
+}
+
+/* Print out all the nodes by a depth-first search.
+ * Each vertex is printed after all the vertices below it.
+ * Arguments
+ *    graph  -  Graph returned by newGraph
+ */
+void printDepthFirst(GRAPH_HANDLE graph)
+{
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   DFS_HANDLE search = NULL;
+   if (pGraph->vertexCount == 0)
+      {
+      printf("The graph is empty\n");
+      }
+   else if ((search = newDepthFirst(pGraph->lastIndex + 1)) == NULL)
+      {
+      printf("Allocation error in printDepthFirst!\n");
+      }
+   else
+      {
+      DFS_GRAPH_T dfsGraph;
+      int * postOrder = NULL;
+      int postCount = 0;
+      int printed = 0;
+      int i = 0;
+      dfsGraph.pGraph = pGraph;
+      dfsGraph.vertexCount = pGraph->lastIndex + 1;
+      dfsGraph.firstAdjacent = &firstAdjacent;
+      dfsGraph.nextAdjacent = &nextAdjacent;
+      for (i = 0; i <= pGraph->lastIndex; i++)
+         {
+	 if ((pGraph->vertices[i].key != NULL) &&
+	     (depthFirstDiscovery(search,i) < 0))
+	    {
+	    printf("\nStarting new traversal from |%s|\n",
+                   pGraph->vertices[i].key);
+	    if (depthFirstVisit(search,&dfsGraph,i) < 0)
+	       {
+	       printf("Allocation error in printDepthFirst!\n");
+	       break;
+	       }
+	    postOrder = depthFirstPostOrder(search,&postCount);
+	    while (printed < postCount)
+	       {
+	       printVertexInfo(&pGraph->vertices[postOrder[printed]]);
+	       printed++;
+	       }
+	    }
+	 }
+      depthFirstDestroy(search);
+      }
+}
+
+
+/* Return information as to whether two vertices are
+ * connected by a path.
+ * Arguments
+ *    graph - Graph returned by newGraph
+ *    key1 -  Key for the start vertex
+ *    key2 -  Key for the second vertex to check
+ * Returns 1 if the two vertices are connected, 0 if they
+ * are not. Returns -1 if either vertex does not exist.
+ */
+int isReachable(GRAPH_HANDLE graph, char* key1, char* key2)
+{
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   int retval = 1;
+   int startindex = findVertexByKey(pGraph,key1);
+   int endindex = findVertexByKey(pGraph,key2);
+   TRAVERSAL_T * pTraversal = NULL;
+   uint64_t * reach = NULL;
+   if ((startindex < 0) || (endindex < 0))
+      {
+      retval = -1;
+      }
+   else if ((reach = ensureReach(pGraph)) != NULL)
+      {
+      retval = TESTBIT(reach + (size_t) startindex * pGraph->rowWords,
+		       endindex);
+      }
+   else if ((pTraversal = newTraversal(pGraph,0)) == NULL)
+      {
+      printf("Allocation error in isReachable!\n");
+      retval = 0;
+      }
+   else
+      {
+      /* the search stops as soon as it finds the end vertex */
+      traverseBreadthFirst(pGraph,pTraversal,startindex,endindex,NULL);
+      if (!TESTBIT(pTraversal->visited,endindex))
+          retval = 0;
+      freeTraversal(pTraversal);
+      }
+   return retval;
+
+}
+
+/* Return information as to whether two vertices are
+ * connected by a path. Also print the path if it
+ * exists. We do this by keeping track of where we
+ * reached each vertex from during the breadth first
+ * traversal.
+ * Arguments
+ *    graph - Graph returned by newGraph
+ *    key1 -  Key for the start vertex
+ *    key2 -  Key for the second vertex to check
+ * Returns 1 if the two vertices are connected, 0 if they
+ * are not. Returns -1 if either vertex does not exist.
+ */
+int isReachablePrintPath(GRAPH_HANDLE graph, char* key1, char* key2)
+{
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   int retval = 1;
+   int startindex = findVertexByKey(pGraph,key1);
+   int endindex = findVertexByKey(pGraph,key2);
+   TRAVERSAL_T * pTraversal = NULL;
+   if ((startindex < 0) || (endindex < 0))
+      {
+      retval = -1;
+      }
+   else if ((pTraversal = newTraversal(pGraph,1)) == NULL)
+      {
+      printf("Allocation error in isReachablePrintPath!\n");
+      retval = 0;
+      }
+   else
+      {
+      traverseBreadthFirst(pGraph,pTraversal,startindex,endindex,NULL);
+      if (!TESTBIT(pTraversal->visited,endindex))
+	  {
+          retval = 0;
+          }
+      else
+	  {
+	  /* the queue is free now, use it to hold the path backwards */
+	  int pathCount = 0;
+	  int current = endindex;
+	  int i = 0;
+	  while (current >= 0)
+	     {
+	     pTraversal->queue[pathCount++] = current;
+	     current = pTraversal->parent[current];
+	     }
+	  printf("Path from %s to %s:\n",key1,key2);
+	  for (i = pathCount-1; i >= 0; i--)
+	     {
+	     printf(" %s ",pGraph->vertices[pTraversal->queue[i]].key);
+	     if (i > 0)
+		printf("==>");
+	     }
+	  printf("\n");
+          }
+      freeTraversal(pTraversal);
+      }
+   return retval;
+}
+
+
+/* Build an index so that isReachable can answer without a search.
+ * The index is the transitive closure of the matrix, the same size
+ * as the matrix. Adding a vertex or an edge updates it; removing
+ * one means it must be built again.
+ * Arguments
+ *    graph     - Graph returned by newGraph
+ *    maxBytes  - Largest index to build. If 0, any index is
+ *                freed and is not built again.
+ * Returns 1 if the index was built, 0 if it would take more than
+ * maxBytes, or -1 if a memory allocation error occurs.
+ */
+int buildReachabilityIndex(GRAPH_HANDLE graph, long maxBytes)
+{
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   int retval = 0;
+   pthread_mutex_lock(&pGraph->reachLock);
+   freeReach(pGraph);
+   pGraph->reachMaxBytes = (maxBytes > 0) ? maxBytes : 0;
+   if (pGraph->reachMaxBytes > 0)
+      retval = buildReach(pGraph);
+   pthread_mutex_unlock(&pGraph->reachLock);
+   return retval;
+}
+
+
+/* Find out how much memory the reachability index is using.
+ * Argument
+ *    graph     - Graph returned by newGraph
+ * Returns the number of bytes, or 0 if there is no index
+ * at the moment.
+ */
+long getReachabilityIndexSize(GRAPH_HANDLE graph)
+{
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   long bytes = 0;
+   pthread_mutex_lock(&pGraph->reachLock);
+   if (pGraph->reach != NULL)
+      bytes = reachBytes(pGraph);
+   pthread_mutex_unlock(&pGraph->reachLock);
+   return bytes;
+}
@@ -0,0 +1,400 @@
+/*
+ *  breadthFirst.c
+ *
+ *  Direction-optimizing, level-synchronous breadth first search on
+ *  a CSR view of a graph. See breadthFirst.h.
+ *
+ *  The vertices found are stored in the order array level by level,
+ *  so the current frontier is always the last part of that array.
+ *  A vertex is in the frontier exactly when its level is the current
+ *  level, so the bottom-up step just checks the levels array.
+ *
+ *  When a level is split among threads, each thread gets a part of
+ *  the frontier (top-down) or of the vertex numbers (bottom-up) and
+ *  collects the vertices it finds in its own buffer. Afterwards the
+ *  buffers are appended to the order array in part order. In the
+ *  top-down step two threads can find the same vertex at once, so a
+ *  thread claims a vertex by changing its level from -1 with an
+ *  atomic compare and swap. In the bottom-up step each vertex is
+ *  only looked at by one thread, so no claiming is needed; the levels
+ *  are still read and written atomically, since other threads are
+ *  reading them.
+ *
+ *  Note this module needs to be linked with -lpthread.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "breadthFirst.h"
+
+#define ALPHA 14		/* go bottom-up when the frontier's edges are
+				 * more than 1/ALPHA of the unexplored edges */
+#define BETA 24			/* go back to top-down when the frontier has
+				 * fewer than 1/BETA of the vertices */
+#define BOTTOM_UP_MIN_VERTICES 4096	/* smaller graphs are always
+					 * searched top-down */
+#define PARALLEL_MIN_WORK 16384	/* edges (top-down) or vertices (bottom-up)
+				 * a level needs before we use threads */
+#define MAX_THREADS 64		/* upper limit on the number of threads */
+
+/* read and write a level, atomically but without ordering */
+#define GETLEVEL(levels,v)    __atomic_load_n(&(levels)[v], __ATOMIC_RELAXED)
+#define SETLEVEL(levels,v,l)  __atomic_store_n(&(levels)[v], (l), __ATOMIC_RELAXED)
+
+/* Growable array of vertex indices found by one thread */
+typedef struct
+{
+    int *items;			/* the indices */
+    int count;			/* number in use */
+    int capacity;		/* number allocated */
+} INT_BUFFER_T;
+
+/* Information shared by all the threads working on one level */
+typedef struct
+{
+    BFS_GRAPH_T *pGraph;	/* graph being searched */
+    int *levels;		/* level of each vertex */
+    int *parents;		/* parent of each vertex */
+    int *frontier;		/* vertices found in the last level */
+    int level;			/* level of the frontier vertices */
+    int bBottomUp;		/* direction for this level */
+    int bParallel;		/* true if several threads are working */
+    int splits[MAX_THREADS + 1];	/* part p is from splits[p] up to
+					 * splits[p+1] of the frontier
+					 * (top-down) or vertices (bottom-up) */
+    INT_BUFFER_T found[MAX_THREADS];	/* vertices found by each part */
+    long edgesChecked[MAX_THREADS];	/* edges looked at by each part */
+    int bFailed[MAX_THREADS];	/* set if a part runs out of memory */
+} LEVEL_T;
+
+/* What each thread needs to know */
+typedef struct
+{
+    LEVEL_T *pLevel;		/* the level being expanded */
+    int part;			/* which part to do */
+} WORKER_T;
+
+
+/* Add an index to a buffer, making it bigger if necessary.
+ * Arguments
+ *    pBuffer  -  Buffer to add to
+ *    value    -  Index to add
+ * Returns 1 if successful, 0 for a memory allocation error.
+ */
+static int appendIndex(INT_BUFFER_T * pBuffer, int value)
+{
+    if (pBuffer->count == pBuffer->capacity)
+    {
+	int newCapacity = (pBuffer->capacity > 0) ? pBuffer->capacity * 2 : 256;
+	int *newItems = realloc(pBuffer->items, newCapacity * sizeof(int));
+	if (newItems == NULL)
+	    return 0;
+	pBuffer->items = newItems;
+	pBuffer->capacity = newCapacity;
+    }
+    pBuffer->items[pBuffer->count++] = value;
+    return 1;
+}
+
+
+/* Expand part of the frontier top-down.
+ * Arguments
+ *    pLevel   -  Level being expanded
+ *    part     -  Which part of the frontier to do
+ */
+static void expandTopDown(LEVEL_T * pLevel, int part)
+{
+    BFS_GRAPH_T *pGraph = pLevel->pGraph;
+    int *levels = pLevel->levels;
+    int nextLevel = pLevel->level + 1;
+    INT_BUFFER_T *pFound = &pLevel->found[part];
+    long checked = 0;
+    int i = 0;
+    for (i = pLevel->splits[part]; i < pLevel->splits[part + 1]; i++)
+    {
+	int u = pLevel->frontier[i];
+	int e = 0;
+	for (e = pGraph->offsets[u]; e < pGraph->offsets[u + 1]; e++)
+	{
+	    int v = pGraph->targets[e];
+	    int unseen = -1;
+	    checked++;
+	    if (GETLEVEL(levels, v) != -1)
+		continue;
+	    if (pLevel->bParallel)
+	    {
+		/* some other thread may be trying to claim it too */
+		if (!__atomic_compare_exchange_n(&levels[v], &unseen, nextLevel,
+						 0, __ATOMIC_RELAXED,
+						 __ATOMIC_RELAXED))
+		    continue;
+	    }
+	    else
+	    {
+		levels[v] = nextLevel;
+	    }
+	    pLevel->parents[v] = u;
+	    if (!appendIndex(pFound, v))
+		pLevel->bFailed[part] = 1;
+	}
+    }
+    pLevel->edgesChecked[part] = checked;
+}
+
+
+/* Expand part of the vertices bottom-up.
+ * Arguments
+ *    pLevel   -  Level being expanded
+ *    part     -  Which range of vertex indices to do
+ */
+static void expandBottomUp(LEVEL_T * pLevel, int part)
+{
+    BFS_GRAPH_T *pGraph = pLevel->pGraph;
+    int *levels = pLevel->levels;
+    int level = pLevel->level;
+    INT_BUFFER_T *pFound = &pLevel->found[part];
+    long checked = 0;
+    int v = 0;
+    for (v = pLevel->splits[part]; v < pLevel->splits[part + 1]; v++)
+    {
+	int e = 0;
+	if (GETLEVEL(levels, v) != -1)
+	    continue;
+	for (e = pGraph->inOffsets[v]; e < pGraph->inOffsets[v + 1]; e++)
+	{
+	    int u = pGraph->inSources[e];
+	    checked++;
+	    if (GETLEVEL(levels, u) == level)
+	    {
+		SETLEVEL(levels, v, level + 1);
+		pLevel->parents[v] = u;
+		if (!appendIndex(pFound, v))
+		    pLevel->bFailed[part] = 1;
+		break;		/* one parent is enough */
+	    }
+	}
+    }
+    pLevel->edgesChecked[part] = checked;
+}
+
+
+/* Work done by each extra thread: expand one part of a level.
+ * Arguments
+ *    pArg   -  What to do (will be cast to WORKER_T *)
+ * Returns NULL.
+ */
+static void *levelWorker(void *pArg)
+{
+    WORKER_T *pWorker = (WORKER_T *) pArg;
+    if (pWorker->pLevel->bBottomUp)
+	expandBottomUp(pWorker->pLevel, pWorker->part);
+    else
+	expandTopDown(pWorker->pLevel, pWorker->part);
+    return NULL;
+}
+
+
+/* Divide the work for a level into parts. Top-down, the frontier
+ * is divided so that each part has about the same number of edges
+ * to look at. Bottom-up, the vertex indices are divided evenly.
+ * Arguments
+ *    pLevel        -  Level being expanded
+ *    frontierCount -  Number of vertices in the frontier
+ *    frontierEdges -  Number of edges leaving them
+ *    parts         -  Number of parts wanted
+ */
+static void splitLevel(LEVEL_T * pLevel, int frontierCount,
+		       long frontierEdges, int parts)
+{
+    BFS_GRAPH_T *pGraph = pLevel->pGraph;
+    int p = 0;
+    pLevel->splits[0] = 0;
+    if (pLevel->bBottomUp)
+    {
+	for (p = 1; p <= parts; p++)
+	    pLevel->splits[p] = (int) ((long) pGraph->vertexCount * p / parts);
+    }
+    else
+    {
+	/* count each vertex as one unit of work plus its edges */
+	long total = frontierEdges + frontierCount;
+	long sum = 0;
+	int i = 0;
+	for (p = 1; p < parts; p++)
+	{
+	    long target = total * p / parts;
+	    while ((i < frontierCount) && (sum < target))
+	    {
+		int u = pLevel->frontier[i];
+		sum += 1 + pGraph->offsets[u + 1] - pGraph->offsets[u];
+		i++;
+	    }
+	    pLevel->splits[p] = i;
+	}
+	pLevel->splits[parts] = frontierCount;
+    }
+}
+
+
+/* Expand one level, using several threads if parts > 1.
+ * Arguments
+ *    pLevel   -  Level to expand, already split into parts
+ *    parts    -  Number of parts
+ */
+static void runLevel(LEVEL_T * pLevel, int parts)
+{
+    pthread_t threads[MAX_THREADS];
+    WORKER_T workers[MAX_THREADS];
+    int started = 0;
+    int p = 0;
+    pLevel->bParallel = (parts > 1);
+    for (p = 0; p < parts; p++)
+    {
+	pLevel->found[p].count = 0;
+	workers[p].pLevel = pLevel;
+	workers[p].part = p;
+    }
+    /* the calling thread does part 0 itself */
+    for (p = 1; p < parts; p++)
+    {
+	if (pthread_create(&threads[p], NULL, &levelWorker, &workers[p]) != 0)
+	    break;
+	started = p;
+    }
+    levelWorker(&workers[0]);
+    /* do any parts for which we could not start a thread */
+    for (p = started + 1; p < parts; p++)
+	levelWorker(&workers[p]);
+    for (p = 1; p <= started; p++)
+	pthread_join(threads[p], NULL);
+}
+
+
+/********************************/
+/** Public functions start here */
+/********************************/
+
+/* Find all the vertices reachable from a start vertex, with
+ * the number of edges on the shortest path to each.
+ * Arguments
+ *    pGraph      -  CSR view of the graph to search
+ *    startIndex  -  Index of the start vertex
+ *    endIndex    -  If not -1, stop after the level in which
+ *                   this vertex is found
+ *    threadCount -  Largest number of threads to use. If zero or
+ *                   less, uses one thread per processor.
+ *    levels      -  Set to the level of each vertex, or -1
+ *    parents     -  Set to the parent of each vertex, or -1
+ *    order       -  If not NULL, filled with the vertices found
+ *    pStats      -  If not NULL, filled in with information about
+ *                   the search
+ * Returns the number of vertices found, or -1 if the start index
+ * is invalid or a memory allocation error occurs.
+ */
+int breadthFirstSearch(BFS_GRAPH_T * pGraph, int startIndex, int endIndex,
+		       int threadCount, int *levels, int *parents,
+		       int *order, BFS_STATS_T * pStats)
+{
+    LEVEL_T *pLevel = NULL;
+    BFS_STATS_T stats;
+    int *myOrder = NULL;
+    int found = 0;		/* vertices in order so far */
+    int frontierStart = 0;	/* where the frontier starts in order */
+    long frontierEdges = 0;	/* edges leaving the frontier */
+    long unexploredEdges = pGraph->edgeCount;	/* edges leaving vertices
+						 * not yet found */
+    int bFailed = 0;
+    int p = 0;
+
+    if ((startIndex < 0) || (startIndex >= pGraph->vertexCount))
+	return -1;
+    if (threadCount <= 0)
+	threadCount = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (threadCount > MAX_THREADS)
+	threadCount = MAX_THREADS;
+    if (threadCount < 1)
+	threadCount = 1;
+    if (order == NULL)
+	order = myOrder = calloc(pGraph->vertexCount, sizeof(int));
+    pLevel = calloc(1, sizeof(LEVEL_T));
+    if ((order == NULL) || (pLevel == NULL))
+    {
+	free(myOrder);
+	free(pLevel);
+	return -1;
+    }
+    memset(&stats, 0, sizeof(stats));
+    memset(levels, -1, pGraph->vertexCount * sizeof(int));
+    memset(parents, -1, pGraph->vertexCount * sizeof(int));
+    pLevel->pGraph = pGraph;
+    pLevel->levels = levels;
+    pLevel->parents = parents;
+
+    levels[startIndex] = 0;
+    order[found++] = startIndex;
+    frontierEdges = pGraph->offsets[startIndex + 1] - pGraph->offsets[startIndex];
+    unexploredEdges -= frontierEdges;
+    while ((frontierStart < found) && (!bFailed) &&
+	   ((endIndex < 0) || (levels[endIndex] < 0)))
+    {
+	int frontierCount = found - frontierStart;
+	long work = 0;
+	int parts = 1;
+	/* choose the direction for this level */
+	if ((!pLevel->bBottomUp) &&
+	    (pGraph->vertexCount >= BOTTOM_UP_MIN_VERTICES) &&
+	    (frontierEdges > unexploredEdges / ALPHA))
+	    pLevel->bBottomUp = 1;
+	else if ((pLevel->bBottomUp) &&
+		 (frontierCount < pGraph->vertexCount / BETA))
+	    pLevel->bBottomUp = 0;
+	work = (pLevel->bBottomUp) ? pGraph->vertexCount : frontierEdges;
+	if (work >= PARALLEL_MIN_WORK)
+	    parts = threadCount;
+	pLevel->frontier = order + frontierStart;
+	splitLevel(pLevel, frontierCount, frontierEdges, parts);
+	runLevel(pLevel, parts);
+
+	/* the new frontier is what all the parts found, in order */
+	frontierStart = found;
+	frontierEdges = 0;
+	for (p = 0; p < parts; p++)
+	{
+	    int i = 0;
+	    for (i = 0; i < pLevel->found[p].count; i++)
+	    {
+		int v = pLevel->found[p].items[i];
+		order[found++] = v;
+		frontierEdges += pGraph->offsets[v + 1] - pGraph->offsets[v];
+	    }
+	    stats.edgesChecked += pLevel->edgesChecked[p];
+	    bFailed |= pLevel->bFailed[p];
+	}
+	unexploredEdges -= frontierEdges;
+	stats.levelCount++;
+	if (pLevel->bBottomUp)
+	    stats.bottomUpLevels++;
+	else
+	    stats.topDownLevels++;
+	if (parts > 1)
+	    stats.parallelLevels++;
+	pLevel->level++;
+    }
+
+    for (p = 0; p < MAX_THREADS; p++)
+	free(pLevel->found[p].items);
+    free(pLevel);
+    free(myOrder);
+    if (pStats != NULL)
+	*pStats = stats;
+    return (bFailed) ? -1 : found;
+}
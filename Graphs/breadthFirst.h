@@ -0,0 +1,94 @@
+/*
+ *  breadthFirst.h
+ *
+ *  Declarations for a breadth first search engine that works on a
+ *  compressed sparse row (CSR) view of a graph, in which vertices
+ *  are numbered from 0 and all the edges are packed into arrays:
+ *
+ *     The edges leaving vertex i go to targets[offsets[i]] up to
+ *     (but not including) targets[offsets[i+1]].
+ *
+ *  The search goes one level at a time. Each level can be expanded
+ *  in one of two ways:
+ *
+ *    - top-down: look at the edges leaving each vertex in the
+ *      frontier (the vertices found in the previous level), and
+ *      add every vertex not yet seen to the next frontier.
+ *
+ *    - bottom-up: look at every vertex not yet seen, and check its
+ *      entering edges for a vertex in the frontier. A vertex can
+ *      stop checking as soon as it finds one.
+ *
+ *  Top-down is cheaper while the frontier is small. When the
+ *  frontier gets big, most of the edges it looks at lead to vertices
+ *  already seen, and bottom-up does much less work. The engine
+ *  switches between the two using the heuristic of Beamer, Asanovic
+ *  and Patterson ("direction-optimizing" BFS).
+ *
+ *  When a level has a lot of work, it is split among several
+ *  threads. Small graphs are always searched top-down, and small
+ *  levels are done by the calling thread alone, so on a small graph
+ *  the search finds the vertices in exactly the same order as a
+ *  plain queue-based breadth first search.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+#ifndef BREADTHFIRST_H
+#define BREADTHFIRST_H
+
+/* CSR view of a graph. For an undirected graph, the entering
+ * edges are the same as the leaving edges, and inOffsets and
+ * inSources can point to the same arrays as offsets and targets.
+ */
+typedef struct
+{
+    int vertexCount;     /* number of vertex indices */
+    int edgeCount;       /* number of entries in targets */
+    int* offsets;        /* vertexCount+1 entries, see above */
+    int* targets;        /* vertex at the end of each leaving edge */
+    int* inOffsets;      /* same as offsets, for the entering edges */
+    int* inSources;      /* vertex at the start of each entering edge */
+} BFS_GRAPH_T;
+
+/* Information about how a search went */
+typedef struct
+{
+    int levelCount;      /* number of levels expanded */
+    int topDownLevels;   /* how many of them were done top-down */
+    int bottomUpLevels;  /* and how many bottom-up */
+    int parallelLevels;  /* how many were split among threads */
+    long edgesChecked;   /* number of edges looked at */
+} BFS_STATS_T;
+
+
+/* Find all the vertices reachable from a start vertex, with
+ * the number of edges on the shortest path to each.
+ * Arguments
+ *    pGraph      -  CSR view of the graph to search
+ *    startIndex  -  Index of the start vertex
+ *    endIndex    -  If not -1, stop after the level in which
+ *                   this vertex is found
+ *    threadCount -  Largest number of threads to use. If zero or
+ *                   less, uses one thread per processor.
+ *    levels      -  Array of vertexCount entries. Set to the level
+ *                   of each vertex found (0 for the start vertex)
+ *                   or -1 for vertices not found.
+ *    parents     -  Array of vertexCount entries. Set to the vertex
+ *                   from which each vertex was found, or -1 for the
+ *                   start vertex and vertices not found.
+ *    order       -  If not NULL, array of vertexCount entries. Filled
+ *                   with the vertices found, level by level.
+ *    pStats      -  If not NULL, filled in with information about
+ *                   the search
+ * Returns the number of vertices found, or -1 if the start index
+ * is invalid or a memory allocation error occurs.
+ */
+int breadthFirstSearch(BFS_GRAPH_T* pGraph, int startIndex, int endIndex,
+                       int threadCount, int* levels, int* parents,
+                       int* order, BFS_STATS_T* pStats);
+
+#endif
@@ -0,0 +1,212 @@
+/*
+ *  componentDemo.c
+ *
+ *  Demo of strongly connected components, topological ordering and
+ *  reachability checks on a directed dependency graph.
+ *
+ *  Reads a file in which each line names two vertices, "from to",
+ *  meaning there is an edge from the first to the second (for
+ *  instance, "from" must be built before "to"). Blank lines and
+ *  lines starting with '#' are ignored. Vertices are created the
+ *  first time they are named.
+ *
+ *  The program prints each component that has more than one vertex
+ *  (these are the dependency cycles), then either a topological order
+ *  of all the vertices or a message that there is none, and the size
+ *  of the condensed graph. It then builds a reachability index, and
+ *  any further pairs of keys on the command line are checked with
+ *  isReachable().
+ *
+ *  Usage:  componentDemo file [fromKey toKey]...
+ *
+ *  Note this module needs to be linked with linkedListGraph.c and
+ *  the modules it needs.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "abstractGraph.h"
+#include "components.h"
+
+#define MAX_VERTICES 100000   /* used to size the key index */
+#define MAX_INDEX_BYTES (64L * 1024 * 1024)  /* largest reachability index */
+
+/* Read the edges from a file into a new directed graph.
+ * Arguments
+ *    filename  -  File to read
+ * Returns the graph, or NULL if the file cannot be read or
+ * a memory allocation error occurs.
+ */
+GRAPH_HANDLE readGraph(char* filename)
+{
+    GRAPH_HANDLE graph = NULL;
+    FILE* pIn = fopen(filename,"r");
+    char input[256];
+    char key1[128];
+    char key2[128];
+    int lineNumber = 0;
+    if (pIn == NULL)
+       {
+       fprintf(stderr,"Cannot open file %s\n",filename);
+       return NULL;
+       }
+    graph = newGraph(MAX_VERTICES,1);
+    while ((graph != NULL) && (fgets(input,sizeof(input),pIn) != NULL))
+       {
+       lineNumber++;
+       if ((input[0] == '#') || (sscanf(input,"%127s",key1) != 1))
+	  continue;
+       if (sscanf(input,"%127s %127s",key1,key2) != 2)
+	  {
+	  fprintf(stderr,"Line %d: expected two keys\n",lineNumber);
+	  continue;
+	  }
+       /* the vertices may already exist, which is fine */
+       if ((addVertex(graph,key1,NULL) == 0) ||
+	   (addVertex(graph,key2,NULL) == 0) ||
+	   (addEdge(graph,key1,key2) == 0))
+	  {
+	  fprintf(stderr,"Memory allocation error reading line %d\n",
+		  lineNumber);
+	  graphDestroy(graph);
+	  graph = NULL;
+	  }
+       }
+    fclose(pIn);
+    return graph;
+}
+
+
+/* Print the components that have more than one vertex.
+ * Argument
+ *    graph     -  Graph to look at
+ * Returns the number of components, or -1 for a memory
+ * allocation error.
+ */
+int printCycles(GRAPH_HANDLE graph)
+{
+    char** keys = NULL;
+    int* componentIds = NULL;
+    int* sizes = NULL;
+    int count = 0;
+    int componentCount = getStrongComponents(graph,&keys,&componentIds,
+					     &count);
+    int c = 0;
+    int i = 0;
+    if (componentCount < 0)
+       return -1;
+    sizes = (int*) calloc(componentCount + 1,sizeof(int));
+    if (sizes == NULL)
+       {
+       componentCount = -1;
+       }
+    else
+       {
+       for (i = 0; i < count; i++)
+	  sizes[componentIds[i]]++;
+       for (c = 0; c < componentCount; c++)
+	  {
+	  if (sizes[c] < 2)
+	     continue;
+	  printf("Cycle - component %d has %d vertices:",c,sizes[c]);
+	  for (i = 0; i < count; i++)
+	     {
+	     if (componentIds[i] == c)
+		printf(" %s",keys[i]);
+	     }
+	  printf("\n");
+	  }
+       }
+    free(sizes);
+    free(keys);
+    free(componentIds);
+    return componentCount;
+}
+
+
+/* Read the graph and report on it */
+int main(int argc, char* argv[])
+{
+    GRAPH_HANDLE graph = NULL;
+    BFS_GRAPH_T* pDag = NULL;
+    char** keys = NULL;
+    int count = 0;
+    int componentCount = 0;
+    int retval = 0;
+    int i = 0;
+
+    if ((argc < 2) || (argc % 2 != 0))
+       {
+       fprintf(stderr,"Usage: %s file [fromKey toKey]...\n",argv[0]);
+       exit(1);
+       }
+    graph = readGraph(argv[1]);
+    if (graph == NULL)
+       exit(1);
+
+    componentCount = printCycles(graph);
+    if (componentCount < 0)
+       {
+       fprintf(stderr,"Memory allocation error finding components\n");
+       graphDestroy(graph);
+       exit(1);
+       }
+
+    retval = getTopologicalOrder(graph,&keys,&count);
+    if (retval < 0)
+       {
+       printf("Memory allocation error sorting the graph\n");
+       }
+    else if (retval == 0)
+       {
+       printf("The graph has a cycle, so there is no topological order\n");
+       printf("(%d vertices can be ordered before the first cycle)\n",
+	      count);
+       }
+    else
+       {
+       printf("Topological order:");
+       for (i = 0; i < count; i++)
+	  printf(" %s",keys[i]);
+       printf("\n");
+       }
+    free(keys);
+
+    pDag = getCondensedGraph(graph);
+    if (pDag != NULL)
+       {
+       printf("Condensed graph has %d vertices and %d edges\n",
+	      pDag->vertexCount,pDag->edgeCount);
+       freeCondensedGraph(pDag);
+       }
+
+    retval = buildReachabilityIndex(graph,MAX_INDEX_BYTES);
+    if (retval < 0)
+       printf("Memory allocation error building the reachability index\n");
+    else if (retval == 0)
+       printf("Reachability index would be larger than %ld bytes\n",
+	      MAX_INDEX_BYTES);
+    else
+       printf("Reachability index uses %ld bytes\n",
+	      getReachabilityIndexSize(graph));
+
+    for (i = 2; i < argc; i += 2)
+       {
+       retval = isReachable(graph,argv[i],argv[i+1]);
+       if (retval < 0)
+	  printf("%s or %s does not exist\n",argv[i],argv[i+1]);
+       else
+	  printf("%s %s reach %s\n",argv[i],(retval) ? "can" : "cannot",
+		 argv[i+1]);
+       }
+
+    graphDestroy(graph);
+    return 0;
+}
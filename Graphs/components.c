@@ -0,0 +1,511 @@
+/*
+ *  components.c
+ *
+ *  Strongly connected components, topological ordering and the
+ *  condensed graph, working on the CSR view of a graph. See
+ *  components.h.
+ *
+ *  Components are found with Kosaraju's algorithm, which is two depth
+ *  first searches done by the engine in depthFirst.c, so neither uses
+ *  recursion. The first search goes along the leaving edges and
+ *  gives the order in which the vertices finish. The second goes
+ *  backwards along the entering edges, starting from each vertex not
+ *  yet found in reverse order of finishing. Each of its new roots
+ *  finds exactly one component, and the roots come in topological
+ *  order of the components, so we can number them as we go.
+ *
+ *  The reachability index is a bit-parallel transitive closure of the
+ *  condensed graph: one bitset row per component, built in reverse
+ *  topological order by ORing together the rows of the components
+ *  each one leads to.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "components.h"
+#include "depthFirst.h"
+
+#define WORD_BITS 64		/* bits in each word of a row */
+
+/* Structure holding a reachability index. Row c is a bitset of the
+ * components that component c can reach. Since the components are
+ * numbered in topological order, c can only reach components
+ * numbered c or more, so row c starts at the word that holds bit c
+ * and the words before it are not stored. This halves the memory.
+ */
+typedef struct
+{
+    int componentCount;		/* number of rows and of bits in each */
+    long *rowStart;		/* where each row starts in bits */
+    uint64_t *bits;		/* all the rows, one after another */
+} REACH_INDEX_T;
+
+
+/* Group the vertices by component.
+ * Arguments
+ *    vertexCount    -  Number of vertices
+ *    componentIds   -  Component of each vertex
+ *    componentCount -  Number of components
+ *    start          -  Array of componentCount+1 entries. The vertices
+ *                      of component c are set to be in members[start[c]]
+ *                      up to (but not including) members[start[c+1]].
+ *    members        -  Array of vertexCount entries to fill
+ */
+static void groupMembers(int vertexCount, int *componentIds,
+			 int componentCount, int *start, int *members)
+{
+    int v = 0;
+    int c = 0;
+    memset(start, 0, (componentCount + 1) * sizeof(int));
+    for (v = 0; v < vertexCount; v++)
+	start[componentIds[v] + 1]++;
+    for (c = 0; c < componentCount; c++)
+	start[c + 1] += start[c];
+    /* use start[c] as the next free place, then shift back */
+    for (v = 0; v < vertexCount; v++)
+	members[start[componentIds[v]]++] = v;
+    for (c = componentCount; c > 0; c--)
+	start[c] = start[c - 1];
+    start[0] = 0;
+}
+
+
+/* Go through the edges of the condensed graph, leaving out edges
+ * inside a component and repeated edges between two components.
+ * Arguments
+ *    pGraph         -  CSR view of the graph
+ *    componentIds   -  Component of each vertex
+ *    componentCount -  Number of components
+ *    start          -  Where each component's members start
+ *    members        -  Vertices grouped by component
+ *    lastSeen       -  Array of componentCount entries for working
+ *    offsets        -  If not NULL, set to where each component's
+ *                      edges start in targets
+ *    targets        -  If not NULL, filled with the edges
+ * Returns the number of edges.
+ */
+static int walkCondensedEdges(BFS_GRAPH_T * pGraph, int *componentIds,
+			      int componentCount, int *start, int *members,
+			      int *lastSeen, int *offsets, int *targets)
+{
+    int edgeCount = 0;
+    int c = 0;
+    memset(lastSeen, -1, componentCount * sizeof(int));
+    for (c = 0; c < componentCount; c++)
+    {
+	int i = 0;
+	if (offsets != NULL)
+	    offsets[c] = edgeCount;
+	for (i = start[c]; i < start[c + 1]; i++)
+	{
+	    int v = members[i];
+	    int e = 0;
+	    for (e = pGraph->offsets[v]; e < pGraph->offsets[v + 1]; e++)
+	    {
+		int d = componentIds[pGraph->targets[e]];
+		if ((d != c) && (lastSeen[d] != c))
+		{
+		    lastSeen[d] = c;
+		    if (targets != NULL)
+			targets[edgeCount] = d;
+		    edgeCount++;
+		}
+	    }
+	}
+    }
+    if (offsets != NULL)
+	offsets[componentCount] = edgeCount;
+    return edgeCount;
+}
+
+
+/* Adjacency functions for the depth first search engine. The
+ * cursor holds the position of the current edge in the targets
+ * array (leaving edges) or the inSources array (entering edges).
+ * Arguments
+ *    pGraph     -  CSR view of the graph (will be cast to BFS_GRAPH_T *)
+ *    vertex     -  Vertex whose edges we want
+ *    pCursor    -  Where we are in the vertex's edges
+ * Return the vertex at the other end of the edge, or -1 if there
+ * are no more edges.
+ */
+static int firstLeaving(void *pGraph, int vertex, DFS_CURSOR_T * pCursor)
+{
+    BFS_GRAPH_T *pCsr = (BFS_GRAPH_T *) pGraph;
+    pCursor->position = pCsr->offsets[vertex];
+    if (pCursor->position >= pCsr->offsets[vertex + 1])
+	return -1;
+    return pCsr->targets[pCursor->position];
+}
+
+static int nextLeaving(void *pGraph, int vertex, DFS_CURSOR_T * pCursor)
+{
+    BFS_GRAPH_T *pCsr = (BFS_GRAPH_T *) pGraph;
+    pCursor->position++;
+    if (pCursor->position >= pCsr->offsets[vertex + 1])
+	return -1;
+    return pCsr->targets[pCursor->position];
+}
+
+static int firstEntering(void *pGraph, int vertex, DFS_CURSOR_T * pCursor)
+{
+    BFS_GRAPH_T *pCsr = (BFS_GRAPH_T *) pGraph;
+    pCursor->position = pCsr->inOffsets[vertex];
+    if (pCursor->position >= pCsr->inOffsets[vertex + 1])
+	return -1;
+    return pCsr->inSources[pCursor->position];
+}
+
+static int nextEntering(void *pGraph, int vertex, DFS_CURSOR_T * pCursor)
+{
+    BFS_GRAPH_T *pCsr = (BFS_GRAPH_T *) pGraph;
+    pCursor->position++;
+    if (pCursor->position >= pCsr->inOffsets[vertex + 1])
+	return -1;
+    return pCsr->inSources[pCursor->position];
+}
+
+
+/* Find the word of a row that holds the bit for a component.
+ * Arguments
+ *    pIndex    -  Index to look in
+ *    row       -  Component whose row we want
+ *    column    -  Component whose bit we want; must be >= row
+ * Returns a pointer to the word.
+ */
+static uint64_t *reachWord(REACH_INDEX_T * pIndex, int row, int column)
+{
+    return pIndex->bits + pIndex->rowStart[row] +
+	(column / WORD_BITS - row / WORD_BITS);
+}
+
+
+/********************************/
+/** Public functions start here */
+/********************************/
+
+/* Find the strongly connected components of a graph.
+ * The components are numbered in topological order: every edge
+ * that joins two different components goes from the one with
+ * the lower number to the one with the higher number.
+ * Arguments
+ *    pGraph       -  CSR view of the graph, including the
+ *                    entering edges
+ *    componentIds -  Array of vertexCount entries. Set to the
+ *                    component number of each vertex.
+ * Returns the number of components, or -1 if a memory allocation
+ * error occurs.
+ */
+int findStrongComponents(BFS_GRAPH_T * pGraph, int *componentIds)
+{
+    int n = pGraph->vertexCount;
+    DFS_HANDLE forward = newDepthFirst(n);
+    DFS_HANDLE backward = newDepthFirst(n);
+    DFS_GRAPH_T dfsGraph;
+    int *postOrder = NULL;
+    int postCount = 0;
+    int *found = NULL;
+    int foundCount = 0;
+    int componentCount = 0;
+    int i = 0;
+    if ((forward == NULL) || (backward == NULL))
+    {
+	componentCount = -1;
+	n = 0;			/* skip the searches */
+    }
+    dfsGraph.pGraph = pGraph;
+    dfsGraph.vertexCount = n;
+    dfsGraph.firstAdjacent = &firstLeaving;
+    dfsGraph.nextAdjacent = &nextLeaving;
+    for (i = 0; (i < n) && (componentCount >= 0); i++)
+    {
+	if (depthFirstVisit(forward, &dfsGraph, i) < 0)
+	    componentCount = -1;
+    }
+    if (componentCount >= 0)
+	postOrder = depthFirstPostOrder(forward, &postCount);
+    dfsGraph.firstAdjacent = &firstEntering;
+    dfsGraph.nextAdjacent = &nextEntering;
+    for (i = postCount - 1; (i >= 0) && (componentCount >= 0); i--)
+    {
+	int newCount = depthFirstVisit(backward, &dfsGraph, postOrder[i]);
+	if (newCount < 0)
+	{
+	    componentCount = -1;
+	}
+	else if (newCount > 0)
+	{
+	    /* the vertices just found are one component */
+	    found = depthFirstPreOrder(backward, &foundCount);
+	    while (newCount > 0)
+	    {
+		componentIds[found[foundCount - newCount]] = componentCount;
+		newCount--;
+	    }
+	    componentCount++;
+	}
+    }
+    if (forward != NULL)
+	depthFirstDestroy(forward);
+    if (backward != NULL)
+	depthFirstDestroy(backward);
+    return componentCount;
+}
+
+
+/* Put the vertices of a graph in topological order. If the graph
+ * has a cycle, only the vertices that do not lie on or after a
+ * cycle can be ordered.
+ * Arguments
+ *    pGraph  -  CSR view of the graph. The entering edges
+ *               are not used.
+ *    order   -  Array of vertexCount entries. Filled with the
+ *               vertices in topological order.
+ * Returns the number of vertices put in order, which is less than
+ * vertexCount if there is a cycle, or -1 if a memory allocation
+ * error occurs.
+ */
+int sortTopologically(BFS_GRAPH_T * pGraph, int *order)
+{
+    int n = pGraph->vertexCount;
+    int *inDegree = calloc((n > 0) ? n : 1, sizeof(int));
+    int head = 0;
+    int count = 0;
+    int v = 0;
+    int e = 0;
+    if (inDegree == NULL)
+	return -1;
+    for (e = 0; e < pGraph->edgeCount; e++)
+	inDegree[pGraph->targets[e]]++;
+    /* the order array is also the queue of vertices with
+     * no edges left entering them */
+    for (v = 0; v < n; v++)
+    {
+	if (inDegree[v] == 0)
+	    order[count++] = v;
+    }
+    while (head < count)
+    {
+	v = order[head++];
+	for (e = pGraph->offsets[v]; e < pGraph->offsets[v + 1]; e++)
+	{
+	    int adjacent = pGraph->targets[e];
+	    inDegree[adjacent]--;
+	    if (inDegree[adjacent] == 0)
+		order[count++] = adjacent;
+	}
+    }
+    free(inDegree);
+    return count;
+}
+
+
+/* Build the condensed graph, with one vertex for each component
+ * and an edge from one component to another if there is at least
+ * one edge between their vertices. Both the leaving and entering
+ * edges are filled in, so the result can be searched with
+ * breadthFirstSearch().
+ * Arguments
+ *    pGraph         -  CSR view of the graph
+ *    componentIds   -  Component of each vertex, as set by
+ *                      findStrongComponents()
+ *    componentCount -  Number of components
+ * Returns the condensed graph, which should be freed with
+ * freeCondensedGraph(), or NULL if a memory allocation error occurs.
+ */
+BFS_GRAPH_T *condenseGraph(BFS_GRAPH_T * pGraph, int *componentIds,
+			   int componentCount)
+{
+    int count = componentCount + 1;
+    BFS_GRAPH_T *pDag = calloc(1, sizeof(BFS_GRAPH_T));
+    int *start = malloc(count * sizeof(int));
+    int *members = malloc((pGraph->vertexCount + 1) * sizeof(int));
+    int *lastSeen = malloc(count * sizeof(int));
+    int c = 0;
+    int e = 0;
+    if ((pDag == NULL) || (start == NULL) || (members == NULL) ||
+	(lastSeen == NULL))
+    {
+	free(pDag);
+	pDag = NULL;
+    }
+    else
+    {
+	groupMembers(pGraph->vertexCount, componentIds, componentCount,
+		     start, members);
+	pDag->vertexCount = componentCount;
+	/* count the edges first, then fill them in */
+	pDag->edgeCount = walkCondensedEdges(pGraph, componentIds,
+					     componentCount, start, members,
+					     lastSeen, NULL, NULL);
+	pDag->offsets = calloc(count, sizeof(int));
+	pDag->targets = malloc((pDag->edgeCount + 1) * sizeof(int));
+	pDag->inOffsets = calloc(count, sizeof(int));
+	pDag->inSources = malloc((pDag->edgeCount + 1) * sizeof(int));
+	if ((pDag->offsets == NULL) || (pDag->targets == NULL) ||
+	    (pDag->inOffsets == NULL) || (pDag->inSources == NULL))
+	{
+	    freeCondensedGraph(pDag);
+	    pDag = NULL;
+	}
+    }
+    if (pDag != NULL)
+    {
+	walkCondensedEdges(pGraph, componentIds, componentCount, start,
+			   members, lastSeen, pDag->offsets, pDag->targets);
+	/* the entering edges: count them, then use lastSeen as the
+	 * next free place for each component */
+	for (e = 0; e < pDag->edgeCount; e++)
+	    pDag->inOffsets[pDag->targets[e] + 1]++;
+	for (c = 0; c < componentCount; c++)
+	    pDag->inOffsets[c + 1] += pDag->inOffsets[c];
+	memcpy(lastSeen, pDag->inOffsets, componentCount * sizeof(int));
+	for (c = 0; c < componentCount; c++)
+	{
+	    for (e = pDag->offsets[c]; e < pDag->offsets[c + 1]; e++)
+		pDag->inSources[lastSeen[pDag->targets[e]]++] = c;
+	}
+    }
+    free(start);
+    free(members);
+    free(lastSeen);
+    return pDag;
+}
+
+
+/* Free a graph returned by condenseGraph().
+ * Argument
+ *    pDag   -  Condensed graph to free, or NULL
+ */
+void freeCondensedGraph(BFS_GRAPH_T * pDag)
+{
+    if (pDag != NULL)
+    {
+	free(pDag->offsets);
+	free(pDag->targets);
+	free(pDag->inOffsets);
+	free(pDag->inSources);
+	free(pDag);
+    }
+}
+
+
+/* Work out how much memory a reachability index needs.
+ * Argument
+ *    componentCount -  Number of components in the condensed graph
+ * Returns the number of bytes.
+ */
+long reachIndexBytes(int componentCount)
+{
+    long rowWords = (componentCount + WORD_BITS - 1) / WORD_BITS;
+    long words = 0;
+    int c = 0;
+    /* rows in the same group of WORD_BITS all start at the same word */
+    for (c = 0; c < componentCount; c += WORD_BITS)
+    {
+	int rows = (componentCount - c < WORD_BITS) ?
+	    componentCount - c : WORD_BITS;
+	words += rows * (rowWords - c / WORD_BITS);
+    }
+    return sizeof(REACH_INDEX_T) + words * sizeof(uint64_t) +
+	componentCount * sizeof(long);
+}
+
+
+/* Build an index that says which components of a condensed graph
+ * can reach which others, so that reachability questions can be
+ * answered without a search.
+ * We go through the components from the last to the first. Every
+ * component a component leads to has a higher number, so its row is
+ * already finished, and the row of the component is its own bit ORed
+ * with the rows of the components it leads to. If one of those is
+ * already in the row, its row is too, so we skip it.
+ * Argument
+ *    pDag    -   Condensed graph returned by condenseGraph()
+ * Returns a handle for the index, or NULL if a memory allocation
+ * error occurs.
+ */
+REACH_INDEX_HANDLE buildReachIndex(BFS_GRAPH_T * pDag)
+{
+    int count = pDag->vertexCount;
+    long rowWords = (count + WORD_BITS - 1) / WORD_BITS;
+    long words = 0;
+    int c = 0;
+    REACH_INDEX_T *pIndex = calloc(1, sizeof(REACH_INDEX_T));
+    if (pIndex == NULL)
+	return NULL;
+    pIndex->componentCount = count;
+    pIndex->rowStart = malloc(((count > 0) ? count : 1) * sizeof(long));
+    if (pIndex->rowStart != NULL)
+    {
+	for (c = 0; c < count; c++)
+	{
+	    pIndex->rowStart[c] = words;
+	    words += rowWords - c / WORD_BITS;
+	}
+	pIndex->bits = calloc((words > 0) ? words : 1, sizeof(uint64_t));
+    }
+    if (pIndex->bits == NULL)
+    {
+	freeReachIndex(pIndex);
+	return NULL;
+    }
+    for (c = count - 1; c >= 0; c--)
+    {
+	int e = 0;
+	*reachWord(pIndex, c, c) |= (uint64_t) 1 << (c % WORD_BITS);
+	for (e = pDag->offsets[c]; e < pDag->offsets[c + 1]; e++)
+	{
+	    int d = pDag->targets[e];
+	    uint64_t *from = pIndex->bits + pIndex->rowStart[d];
+	    uint64_t *to = reachWord(pIndex, c, d);
+	    long i = 0;
+	    long length = rowWords - d / WORD_BITS;
+	    if ((*to >> (d % WORD_BITS)) & 1)
+		continue;
+	    for (i = 0; i < length; i++)
+		to[i] |= from[i];
+	}
+    }
+    return (REACH_INDEX_HANDLE) pIndex;
+}
+
+
+/* Check whether one component can reach another, using an index.
+ * Arguments
+ *    index   -   Index returned by buildReachIndex()
+ *    from    -   Component to start from
+ *    to      -   Component we want to reach
+ * Returns 1 if it can be reached (including when from and to are
+ * the same), 0 if not.
+ */
+int testReachIndex(REACH_INDEX_HANDLE index, int from, int to)
+{
+    REACH_INDEX_T *pIndex = (REACH_INDEX_T *) index;
+    if (to < from)
+	return 0;
+    return (*reachWord(pIndex, from, to) >> (to % WORD_BITS)) & 1;
+}
+
+
+/* Free a reachability index.
+ * Argument
+ *    index   -   Index returned by buildReachIndex(), or NULL
+ */
+void freeReachIndex(REACH_INDEX_HANDLE index)
+{
+    REACH_INDEX_T *pIndex = (REACH_INDEX_T *) index;
+    if (pIndex != NULL)
+    {
+	free(pIndex->rowStart);
+	free(pIndex->bits);
+	free(pIndex);
+    }
+}
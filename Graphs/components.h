@@ -0,0 +1,184 @@
+/**
+ *  components.h
+ *
+ *  Declarations for strongly connected components, topological
+ *  ordering and the condensed graph, for directed graphs such as
+ *  dependency graphs.
+ *
+ *  Two vertices are in the same strongly connected component if each
+ *  can be reached from the other. Replacing every component by a
+ *  single vertex gives the condensed graph, which never has a cycle
+ *  (it is a DAG). One vertex can reach another exactly when its
+ *  component can reach the other's component in the condensed graph,
+ *  and the condensed graph is usually much smaller.
+ *
+ *  A topological order lists the vertices so that every edge goes
+ *  from an earlier vertex to a later one. Such an order exists only
+ *  if the graph has no cycle.
+ *
+ *  The engine functions work on the CSR view of a graph used by
+ *  breadthFirst.c, with vertices numbered from 0. They take time in
+ *  proportion to the number of vertices plus edges, and do not use
+ *  recursion, so they work on very deep graphs. Components are found
+ *  with Kosaraju's algorithm, and the topological order with Kahn's
+ *  algorithm (repeatedly taking a vertex with no edges entering it).
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include "abstractGraph.h"
+#include "breadthFirst.h"
+
+/* opaque pointer to a reachability index */
+typedef void* REACH_INDEX_HANDLE;
+
+/* Find the strongly connected components of a graph.
+ * The components are numbered in topological order: every edge
+ * that joins two different components goes from the one with
+ * the lower number to the one with the higher number.
+ * Arguments
+ *    pGraph       -  CSR view of the graph, including the
+ *                    entering edges
+ *    componentIds -  Array of vertexCount entries. Set to the
+ *                    component number of each vertex.
+ * Returns the number of components, or -1 if a memory allocation
+ * error occurs.
+ */
+int findStrongComponents(BFS_GRAPH_T* pGraph, int* componentIds);
+
+
+/* Put the vertices of a graph in topological order. If the graph
+ * has a cycle, only the vertices that do not lie on or after a
+ * cycle can be ordered.
+ * Arguments
+ *    pGraph  -  CSR view of the graph. The entering edges
+ *               are not used.
+ *    order   -  Array of vertexCount entries. Filled with the
+ *               vertices in topological order.
+ * Returns the number of vertices put in order, which is less than
+ * vertexCount if there is a cycle, or -1 if a memory allocation
+ * error occurs.
+ */
+int sortTopologically(BFS_GRAPH_T* pGraph, int* order);
+
+
+/* Build the condensed graph, with one vertex for each component
+ * and an edge from one component to another if there is at least
+ * one edge between their vertices. Both the leaving and entering
+ * edges are filled in, so the result can be searched with
+ * breadthFirstSearch().
+ * Arguments
+ *    pGraph         -  CSR view of the graph
+ *    componentIds   -  Component of each vertex, as set by
+ *                      findStrongComponents()
+ *    componentCount -  Number of components
+ * Returns the condensed graph, which should be freed with
+ * freeCondensedGraph(), or NULL if a memory allocation error occurs.
+ */
+BFS_GRAPH_T* condenseGraph(BFS_GRAPH_T* pGraph, int* componentIds,
+                           int componentCount);
+
+
+/* Free a graph returned by condenseGraph().
+ * Argument
+ *    pDag   -  Condensed graph to free, or NULL
+ */
+void freeCondensedGraph(BFS_GRAPH_T* pDag);
+
+
+/* Work out how much memory a reachability index needs. This grows
+ * with the square of the number of components (about one bit for
+ * every two pairs), so check it before building a large index.
+ * Argument
+ *    componentCount -  Number of components in the condensed graph
+ * Returns the number of bytes.
+ */
+long reachIndexBytes(int componentCount);
+
+
+/* Build an index that says which components of a condensed graph
+ * can reach which others, so that reachability questions can be
+ * answered without a search.
+ * Argument
+ *    pDag    -   Condensed graph returned by condenseGraph()
+ * Returns a handle for the index, or NULL if a memory allocation
+ * error occurs.
+ */
+REACH_INDEX_HANDLE buildReachIndex(BFS_GRAPH_T* pDag);
+
+
+/* Check whether one component can reach another, using an index.
+ * Arguments
+ *    index   -   Index returned by buildReachIndex()
+ *    from    -   Component to start from
+ *    to      -   Component we want to reach
+ * Returns 1 if it can be reached (including when from and to are
+ * the same), 0 if not.
+ */
+int testReachIndex(REACH_INDEX_HANDLE index, int from, int to);
+
+
+/* Free a reachability index.
+ * Argument
+ *    index   -   Index returned by buildReachIndex(), or NULL
+ */
+void freeReachIndex(REACH_INDEX_HANDLE index);
+
+
+/* The following functions are implemented by the graph module
+ * (linkedListGraph.c). The graph keeps its components and condensed
+ * graph until it changes, and isReachable() answers its questions
+ * using the condensed graph.
+ */
+
+/* Find the strongly connected components of a graph. For an
+ * undirected graph these are just its connected pieces.
+ * Arguments
+ *    graph         -  Graph returned by newGraph
+ *    pKeys         -  Used to return an array with the keys of all
+ *                     the vertices. The caller should free the
+ *                     array but not the keys.
+ *    pComponentIds -  Used to return an array with the component
+ *                     number of each of those vertices, numbered in
+ *                     topological order as for findStrongComponents().
+ *                     The caller should free it.
+ *    pCount        -  Used to return the number of vertices
+ * Returns the number of components, or -1 if a memory allocation
+ * error occurs. The keys are only valid until the graph changes.
+ */
+int getStrongComponents(GRAPH_HANDLE graph, char*** pKeys,
+                        int** pComponentIds, int* pCount);
+
+
+/* Put the vertices of a directed graph in topological order.
+ * Arguments
+ *    graph      -  Graph returned by newGraph
+ *    pKeys      -  Used to return an array with the keys of the
+ *                  vertices in topological order. The caller should
+ *                  free the array but not the keys.
+ *    pCount     -  Used to return the number of vertices
+ * Returns 1 if successful, 0 if the graph has a cycle (in which case
+ * the array holds only the vertices that could be ordered), or -1
+ * if a memory allocation error occurs. In an undirected graph every
+ * edge counts as a cycle. The keys are only valid until the graph
+ * changes.
+ */
+int getTopologicalOrder(GRAPH_HANDLE graph, char*** pKeys, int* pCount);
+
+
+/* Get a copy of the condensed graph. Its vertices are the
+ * component numbers returned by getStrongComponents().
+ * Argument
+ *    graph      -  Graph returned by newGraph
+ * Returns the condensed graph, which should be freed with
+ * freeCondensedGraph(), or NULL if a memory allocation error occurs.
+ */
+BFS_GRAPH_T* getCondensedGraph(GRAPH_HANDLE graph);
+
+#endif
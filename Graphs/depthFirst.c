@@ -0,0 +1,297 @@
+/*
+ *  depthFirst.c
+ *
+ *  Depth first search with an explicit stack. See depthFirst.h.
+ *
+ *  Each item on the stack (a frame) holds a vertex on the current
+ *  path and the cursor that says which of its edges to look at next.
+ *  The frames are kept in fixed size blocks. The blocks form a doubly
+ *  linked list, so when one fills up we move on to the next one
+ *  (allocating it the first time), and when it empties we move back.
+ *  Frames never move once they are pushed, and blocks are kept for
+ *  reuse until the search is destroyed, so a search that goes deep
+ *  once does not allocate again.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "depthFirst.h"
+
+/* Number of frames in each block of the stack */
+#define STACK_BLOCK_FRAMES 4096
+
+/* One vertex on the stack */
+typedef struct
+{
+    int vertex;			/* vertex on the current path */
+    DFS_CURSOR_T cursor;	/* where we are in its adjacent vertices */
+} FRAME_T;
+
+/* One block of the stack */
+typedef struct _stackBlock
+{
+    struct _stackBlock *prev;	/* block below this one */
+    struct _stackBlock *next;	/* block above this one, if allocated */
+    FRAME_T frames[STACK_BLOCK_FRAMES];
+} STACK_BLOCK_T;
+
+/* Structure holding one search */
+typedef struct
+{
+    int vertexCount;		/* size of each array below */
+    int *discovery;		/* discovery time of each vertex, or -1 */
+    int *finish;		/* finish time of each vertex, or -1 */
+    int *preOrder;		/* vertices in order of discovery */
+    int *postOrder;		/* vertices in order of finishing */
+    int preCount;		/* number of vertices in preOrder */
+    int postCount;		/* number of vertices in postOrder */
+    int clock;			/* time to give the next event */
+    STACK_BLOCK_T *pBottom;	/* first block of the stack */
+    STACK_BLOCK_T *pBlock;	/* block holding the top of the stack */
+    int top;			/* number of frames used in pBlock */
+} DFS_T;
+
+
+/* Push a new frame onto the stack.
+ * Arguments
+ *   pSearch   -   Search whose stack we are using
+ *   vertex    -   Vertex for the new frame
+ * Returns the new frame, or NULL for a memory allocation error.
+ */
+static FRAME_T *pushFrame(DFS_T * pSearch, int vertex)
+{
+    FRAME_T *pFrame = NULL;
+    if ((pSearch->pBlock == NULL) || (pSearch->top == STACK_BLOCK_FRAMES))
+    {
+	STACK_BLOCK_T *pNext = (pSearch->pBlock != NULL) ?
+	    pSearch->pBlock->next : pSearch->pBottom;
+	if (pNext == NULL)
+	{
+	    pNext = malloc(sizeof(STACK_BLOCK_T));
+	    if (pNext == NULL)
+		return NULL;
+	    pNext->prev = pSearch->pBlock;
+	    pNext->next = NULL;
+	    if (pSearch->pBlock != NULL)
+		pSearch->pBlock->next = pNext;
+	    else
+		pSearch->pBottom = pNext;
+	}
+	pSearch->pBlock = pNext;
+	pSearch->top = 0;
+    }
+    pFrame = &pSearch->pBlock->frames[pSearch->top++];
+    pFrame->vertex = vertex;
+    return pFrame;
+}
+
+
+/* Pop the top frame off the stack.
+ * Arguments
+ *   pSearch   -   Search whose stack we are using
+ * Returns the frame that is now on top, or NULL if the
+ * stack is empty.
+ */
+static FRAME_T *popFrame(DFS_T * pSearch)
+{
+    pSearch->top--;
+    if (pSearch->top == 0)
+    {
+	if (pSearch->pBlock->prev == NULL)
+	{
+	    /* the stack is empty; start again from the bottom block */
+	    pSearch->pBlock = NULL;
+	    return NULL;
+	}
+	pSearch->pBlock = pSearch->pBlock->prev;
+	pSearch->top = STACK_BLOCK_FRAMES;
+    }
+    return &pSearch->pBlock->frames[pSearch->top - 1];
+}
+
+
+/********************************/
+/** Public functions start here */
+/********************************/
+
+/* Create the working storage for a depth first search.
+ * Arguments
+ *   vertexCount  -  Number of vertex numbers the search must handle
+ * Returns a handle for the search, or NULL if a memory allocation
+ * error occurs.
+ */
+DFS_HANDLE newDepthFirst(int vertexCount)
+{
+    DFS_T *pSearch = calloc(1, sizeof(DFS_T));
+    if (pSearch != NULL)
+    {
+	int count = (vertexCount > 0) ? vertexCount : 1;
+	pSearch->vertexCount = vertexCount;
+	pSearch->discovery = malloc(count * sizeof(int));
+	pSearch->finish = malloc(count * sizeof(int));
+	pSearch->preOrder = malloc(count * sizeof(int));
+	pSearch->postOrder = malloc(count * sizeof(int));
+	if ((pSearch->discovery == NULL) || (pSearch->finish == NULL) ||
+	    (pSearch->preOrder == NULL) || (pSearch->postOrder == NULL))
+	{
+	    depthFirstDestroy(pSearch);
+	    return NULL;
+	}
+	memset(pSearch->discovery, -1, count * sizeof(int));
+	memset(pSearch->finish, -1, count * sizeof(int));
+    }
+    return (DFS_HANDLE) pSearch;
+}
+
+
+/* Free all memory associated with a search.
+ * Arguments
+ *   search   -  Search to free. Not valid after this call.
+ */
+void depthFirstDestroy(DFS_HANDLE search)
+{
+    DFS_T *pSearch = (DFS_T *) search;
+    STACK_BLOCK_T *pBlock = NULL;
+    if (pSearch == NULL)
+	return;
+    pBlock = pSearch->pBottom;
+    while (pBlock != NULL)
+    {
+	STACK_BLOCK_T *pNext = pBlock->next;
+	free(pBlock);
+	pBlock = pNext;
+    }
+    free(pSearch->discovery);
+    free(pSearch->finish);
+    free(pSearch->preOrder);
+    free(pSearch->postOrder);
+    free(pSearch);
+}
+
+
+/* Search depth first from a root vertex, unless it has already
+ * been found. Each vertex is finished only after every vertex that
+ * can be reached from it has been found.
+ * Arguments
+ *   search   -  Search returned by newDepthFirst
+ *   pGraph   -  Graph to search. Must have no more vertices than
+ *               the search was created for.
+ *   root     -  Number of the vertex to start from
+ * Returns the number of vertices newly found (0 if the root was
+ * already found), or -1 if a memory allocation error occurs.
+ */
+int depthFirstVisit(DFS_HANDLE search, DFS_GRAPH_T * pGraph, int root)
+{
+    DFS_T *pSearch = (DFS_T *) search;
+    int *discovery = pSearch->discovery;
+    FRAME_T *pFrame = NULL;
+    int adjacent = -1;
+    int found = 0;
+    if (discovery[root] >= 0)
+	return 0;
+    pFrame = pushFrame(pSearch, root);
+    if (pFrame == NULL)
+	return -1;
+    discovery[root] = pSearch->clock++;
+    pSearch->preOrder[pSearch->preCount++] = root;
+    found++;
+    adjacent = (*pGraph->firstAdjacent) (pGraph->pGraph, root,
+					 &pFrame->cursor);
+    while (pFrame != NULL)
+    {
+	if ((adjacent >= 0) && (discovery[adjacent] >= 0))
+	{
+	    /* already found - try the next edge */
+	    adjacent = (*pGraph->nextAdjacent) (pGraph->pGraph,
+						pFrame->vertex,
+						&pFrame->cursor);
+	}
+	else if (adjacent >= 0)
+	{
+	    /* go down one level */
+	    pFrame = pushFrame(pSearch, adjacent);
+	    if (pFrame == NULL)
+	    {
+		pSearch->pBlock = NULL;	/* abandon the stack */
+		return -1;
+	    }
+	    discovery[adjacent] = pSearch->clock++;
+	    pSearch->preOrder[pSearch->preCount++] = adjacent;
+	    found++;
+	    adjacent = (*pGraph->firstAdjacent) (pGraph->pGraph, adjacent,
+						 &pFrame->cursor);
+	}
+	else
+	{
+	    /* no more edges - this vertex is finished */
+	    pSearch->finish[pFrame->vertex] = pSearch->clock++;
+	    pSearch->postOrder[pSearch->postCount++] = pFrame->vertex;
+	    pFrame = popFrame(pSearch);
+	    if (pFrame != NULL)
+		adjacent = (*pGraph->nextAdjacent) (pGraph->pGraph,
+						    pFrame->vertex,
+						    &pFrame->cursor);
+	}
+    }
+    return found;
+}
+
+
+/* Get the time at which a vertex was discovered.
+ * Arguments
+ *   search   -  Search returned by newDepthFirst
+ *   vertex   -  Vertex we are interested in
+ * Returns the time, or -1 if the vertex has not been found.
+ */
+int depthFirstDiscovery(DFS_HANDLE search, int vertex)
+{
+    return ((DFS_T *) search)->discovery[vertex];
+}
+
+
+/* Get the time at which a vertex was finished.
+ * Arguments
+ *   search   -  Search returned by newDepthFirst
+ *   vertex   -  Vertex we are interested in
+ * Returns the time, or -1 if the vertex is not finished.
+ */
+int depthFirstFinish(DFS_HANDLE search, int vertex)
+{
+    return ((DFS_T *) search)->finish[vertex];
+}
+
+
+/* Get the vertices found so far, in the order they were discovered.
+ * Arguments
+ *   search   -  Search returned by newDepthFirst
+ *   pCount   -  Used to return the number of vertices
+ * Returns an array belonging to the search. It is only valid
+ * until the search is destroyed.
+ */
+int *depthFirstPreOrder(DFS_HANDLE search, int *pCount)
+{
+    DFS_T *pSearch = (DFS_T *) search;
+    *pCount = pSearch->preCount;
+    return pSearch->preOrder;
+}
+
+
+/* Get the vertices finished so far, in the order they were finished.
+ * Arguments
+ *   search   -  Search returned by newDepthFirst
+ *   pCount   -  Used to return the number of vertices
+ * Returns an array belonging to the search. It is only valid
+ * until the search is destroyed.
+ */
+int *depthFirstPostOrder(DFS_HANDLE search, int *pCount)
+{
+    DFS_T *pSearch = (DFS_T *) search;
+    *pCount = pSearch->postCount;
+    return pSearch->postOrder;
+}
@@ -0,0 +1,134 @@
+/**
+ *  depthFirst.h
+ *
+ *  Header file for a depth first search engine that does not use
+ *  recursion. A recursive search uses one C stack frame for each
+ *  vertex on the current path, so on a long chain of vertices it can
+ *  run out of stack. This engine instead keeps its own stack in
+ *  memory blocks that are allocated as the search gets deeper, so
+ *  the depth is only limited by the memory available.
+ *
+ *  The engine does not know how a graph is stored. The vertices are
+ *  numbered from 0, and the graph module supplies two functions that
+ *  step through the vertices adjacent to a vertex, keeping their
+ *  place in a DFS_CURSOR_T. The engine keeps one cursor for each
+ *  vertex on its stack, so when it comes back up to a vertex it
+ *  carries on with the next edge, exactly as the recursive version
+ *  would.
+ *
+ *  For every vertex found, the search records:
+ *    - its discovery time, when it was first reached
+ *    - its finish time, when all the vertices below it were done
+ *    - its place in the pre-order (order of discovery) and the
+ *      post-order (order of finishing)
+ *  The times come from one clock that ticks at every discovery and
+ *  every finish, so they run from 0 to twice the number of vertices.
+ *
+ *  A search can be continued from several roots. Vertices found
+ *  from an earlier root are not visited again, so calling
+ *  depthFirstVisit() for every vertex in turn gives a complete
+ *  depth first traversal (a depth first forest).
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+#ifndef DEPTHFIRST_H
+#define DEPTHFIRST_H
+
+/* Where a graph module is in the list of vertices adjacent
+ * to a vertex. Which member it uses is up to the module.
+ */
+typedef union
+{
+    long position;     /* e.g. a column or an offset in an array */
+    void* pItem;       /* e.g. an adjacency list item */
+} DFS_CURSOR_T;
+
+/* Description of the graph to search */
+typedef struct
+{
+    void* pGraph;      /* passed to the functions below */
+    int vertexCount;   /* vertices are numbered 0 to vertexCount-1 */
+    /* Set the cursor to the first vertex adjacent to a vertex.
+     * Returns that vertex's number, or -1 if there are none. */
+    int (*firstAdjacent)(void* pGraph, int vertex, DFS_CURSOR_T* pCursor);
+    /* Move the cursor to the next adjacent vertex.
+     * Returns that vertex's number, or -1 if there are no more. */
+    int (*nextAdjacent)(void* pGraph, int vertex, DFS_CURSOR_T* pCursor);
+} DFS_GRAPH_T;
+
+/* opaque pointer to a search */
+typedef void* DFS_HANDLE;
+
+
+/* Create the working storage for a depth first search.
+ * Arguments
+ *   vertexCount  -  Number of vertex numbers the search must handle
+ * Returns a handle for the search, or NULL if a memory allocation
+ * error occurs.
+ */
+DFS_HANDLE newDepthFirst(int vertexCount);
+
+
+/* Free all memory associated with a search.
+ * Arguments
+ *   search   -  Search to free. Not valid after this call.
+ */
+void depthFirstDestroy(DFS_HANDLE search);
+
+
+/* Search depth first from a root vertex, unless it has already
+ * been found. Each vertex is finished only after every vertex that
+ * can be reached from it has been found.
+ * Arguments
+ *   search   -  Search returned by newDepthFirst
+ *   pGraph   -  Graph to search. Must have no more vertices than
+ *               the search was created for.
+ *   root     -  Number of the vertex to start from
+ * Returns the number of vertices newly found (0 if the root was
+ * already found), or -1 if a memory allocation error occurs.
+ */
+int depthFirstVisit(DFS_HANDLE search, DFS_GRAPH_T* pGraph, int root);
+
+
+/* Get the time at which a vertex was discovered.
+ * Arguments
+ *   search   -  Search returned by newDepthFirst
+ *   vertex   -  Vertex we are interested in
+ * Returns the time, or -1 if the vertex has not been found.
+ */
+int depthFirstDiscovery(DFS_HANDLE search, int vertex);
+
+
+/* Get the time at which a vertex was finished.
+ * Arguments
+ *   search   -  Search returned by newDepthFirst
+ *   vertex   -  Vertex we are interested in
+ * Returns the time, or -1 if the vertex is not finished.
+ */
+int depthFirstFinish(DFS_HANDLE search, int vertex);
+
+
+/* Get the vertices found so far, in the order they were discovered.
+ * Arguments
+ *   search   -  Search returned by newDepthFirst
+ *   pCount   -  Used to return the number of vertices
+ * Returns an array belonging to the search. It is only valid
+ * until the search is destroyed.
+ */
+int* depthFirstPreOrder(DFS_HANDLE search, int* pCount);
+
+
+/* Get the vertices finished so far, in the order they were finished.
+ * Arguments
+ *   search   -  Search returned by newDepthFirst
+ *   pCount   -  Used to return the number of vertices
+ * Returns an array belonging to the search. It is only valid
+ * until the search is destroyed.
+ */
+int* depthFirstPostOrder(DFS_HANDLE search, int* pCount);
+
+#endif
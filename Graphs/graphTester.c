@@ -21,6 +21,7 @@ int getMenuOption();
 /* Loop asking for actions until the user chooses to exit */
 int main(int argc, char* argv[])
 {
+    GRAPH_HANDLE graph = NULL;
     int maxVertices = 0;
     int bDirected = 0;
     char input[64];
@@ -38,6 +39,12 @@ int main(int argc, char* argv[])
         memset(keystring1,0,sizeof(keystring1));
         memset(keystring2,0,sizeof(keystring2));
         newString = key = NULL;
+        if ((choice > 1) && (graph == NULL))
+	   {
+	   printf(">>> Error! Create the graph first (option 1)\n");
+	   choice = getMenuOption();
+	   continue;
+	   }
 	switch (choice)
 	{
 	    case 1:  /* create the graph */ 
@@ -56,8 +63,9 @@ int main(int argc, char* argv[])
                        bDirected = 1;
 		   else
                        bDirected = 0;
-                   clearGraph();
-                   if (!initGraph(maxVertices, bDirected))
+                   graphDestroy(graph);
+                   graph = newGraph(maxVertices, bDirected);
+                   if (graph == NULL)
 		      {
 		      printf(">>> Error! Cannot initialize graph\n");
 		      }
@@ -83,7 +91,7 @@ int main(int argc, char* argv[])
 		   }
                 else
 		   { 
-		   retval = addVertex(key,newString);
+		   retval = addVertex(graph,key,newString);
 		   if (retval == 1) 
 		      {
 		      printf("Vertex |%s| added\n",key);
@@ -119,7 +127,7 @@ int main(int argc, char* argv[])
 		   }
                 else
 		   {
-		   retval = addEdge(keystring1,keystring2);  
+		   retval = addEdge(graph,keystring1,keystring2);  
 		   if (retval == 1) 
 		       {
 		       printf("Added edge from |%s| to |%s|\n",
@@ -142,7 +150,7 @@ int main(int argc, char* argv[])
 		fgets(input,sizeof(input),stdin);
 		input[strlen(input) - 1] = '\0';  
 		sscanf(input,"%s",keystring1);  
-                char* returnData = removeVertex(keystring1);
+                char* returnData = removeVertex(graph,keystring1);
                 if (returnData != NULL)
 		   {
 		   printf(
@@ -168,7 +176,7 @@ int main(int argc, char* argv[])
 		fgets(input,sizeof(input),stdin);
 		input[strlen(input) - 1] = '\0';  
 		sscanf(input,"%s",keystring2);
-                retval = removeEdge(keystring1,keystring2);  
+                retval = removeEdge(graph,keystring1,keystring2);  
                 if (retval == 1) 
 		   {
 		   printf("Removed edge from |%s| to |%s|\n",
@@ -188,7 +196,7 @@ int main(int argc, char* argv[])
 		fgets(input,sizeof(input),stdin);
 		input[strlen(input) - 1] = '\0';  
 		sscanf(input,"%s",keystring1);  
-                adjacentKeys = getAdjacentVertices(keystring1,&count);
+                adjacentKeys = getAdjacentVertices(graph,keystring1,&count);
                 if (count == 0)
 		   {
 		   printf(">>> Vertex |%s| has no adjacent vertices\n",
@@ -223,7 +231,7 @@ int main(int argc, char* argv[])
 		    fgets(input,sizeof(input),stdin);
 		    input[strlen(input) - 1] = '\0';  
 		    sscanf(input,"%s",keystring1);  
-		    retval = printBreadthFirst(keystring1);
+		    retval = printBreadthFirst(graph,keystring1);
 		    if (retval < 0)
 		       { 
 		       printf(">>> Vertex |%s| does not exist\n",
@@ -232,7 +240,7 @@ int main(int argc, char* argv[])
 		    }
 		else
 		    {
-		    printDepthFirst();
+		    printDepthFirst(graph);
 		    }
 		break;
 	    case 8:   /* check reachable */
@@ -259,9 +267,9 @@ int main(int argc, char* argv[])
 		   printf("Do you want to print the path (Y/N)? ");
                    fgets(input,sizeof(input),stdin);
                    if ((input[0] == 'Y') || (input[0] == 'y'))
-		       retval = isReachablePrintPath(keystring1,keystring2);  
+		       retval = isReachablePrintPath(graph,keystring1,keystring2);  
 		   else 
-		       retval = isReachable(keystring1,keystring2);  
+		       retval = isReachable(graph,keystring1,keystring2);  
 		   if (retval == 1) 
 		       {
 		       printf("Vertex |%s| IS reachable from |%s|\n",
@@ -284,6 +292,7 @@ int main(int argc, char* argv[])
 	choice = getMenuOption();
     }      /* end while loop */
 
+    graphDestroy(graph);
 /* exit here - we're done */
 }
 
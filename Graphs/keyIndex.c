@@ -0,0 +1,250 @@
+/*
+ *  keyIndex.c
+ *
+ *  Hash table that maps string keys to pointers, using open
+ *  addressing with linear probing. All the entries live in one
+ *  array; if the slot a key hashes to is taken, we simply try the
+ *  next slot, and the next, until we find the key or an empty slot.
+ *
+ *  The array size is always a power of two, so we can use a mask
+ *  instead of the modulo operator, and we keep it at most 70% full
+ *  so the runs of occupied slots stay short.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "keyIndex.h"
+
+#define MIN_SLOTS 16
+
+/* One slot in the table. An empty slot has a NULL key */
+typedef struct
+{
+    char *key;			/* key string - not copied */
+    void *value;		/* pointer stored for this key */
+    unsigned int hash;		/* saved hash value of the key */
+} SLOT_T;
+
+/* Structure holding one index */
+typedef struct
+{
+    SLOT_T *slots;		/* array of slots */
+    int slotCount;		/* size of the array, a power of two */
+    int count;			/* number of keys stored */
+} KEY_INDEX_T;
+
+
+/* Compute a hash value for a string (FNV-1a).
+ * Arguments
+ *   key    -   String to hash
+ * Returns the hash value
+ */
+static unsigned int hashKey(char *key)
+{
+    unsigned int hash = 2166136261u;
+    while (*key != '\0')
+    {
+	hash ^= (unsigned char) *key;
+	hash *= 16777619u;
+	key++;
+    }
+    return hash;
+}
+
+/* Find the slot holding a key, or the empty slot where it would go.
+ * Arguments
+ *   pIndex  -   Index to search
+ *   key     -   Key we are looking for
+ *   hash    -   Hash value of the key
+ * Returns the slot number.
+ */
+static int probe(KEY_INDEX_T * pIndex, char *key, unsigned int hash)
+{
+    int mask = pIndex->slotCount - 1;
+    int i = hash & mask;
+    while (pIndex->slots[i].key != NULL)
+    {
+	if ((pIndex->slots[i].hash == hash) &&
+	    (strcmp(pIndex->slots[i].key, key) == 0))
+	    break;
+	i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/* Allocate a new slot array of a different size and move
+ * all the existing keys into it.
+ * Arguments
+ *   pIndex      -   Index to resize
+ *   newCount    -   New number of slots (a power of two)
+ * Returns 1 if successful, 0 for a memory allocation error.
+ */
+static int resize(KEY_INDEX_T * pIndex, int newCount)
+{
+    int i = 0;
+    SLOT_T *oldSlots = pIndex->slots;
+    int oldCount = pIndex->slotCount;
+    SLOT_T *newSlots = calloc(newCount, sizeof(SLOT_T));
+    if (newSlots == NULL)
+	return 0;
+    pIndex->slots = newSlots;
+    pIndex->slotCount = newCount;
+    for (i = 0; i < oldCount; i++)
+    {
+	if (oldSlots[i].key != NULL)
+	{
+	    int mask = newCount - 1;
+	    int j = oldSlots[i].hash & mask;
+	    while (newSlots[j].key != NULL)
+		j = (j + 1) & mask;
+	    newSlots[j] = oldSlots[i];
+	}
+    }
+    free(oldSlots);
+    return 1;
+}
+
+
+/********************************/
+/** Public functions start here */
+/********************************/
+
+/* Create a new, empty index.
+ * Arguments
+ *   expectedCount  -  How many keys we expect to store.
+ * Returns a handle for the index, or NULL if a memory allocation
+ * error occurs.
+ */
+KEY_INDEX_HANDLE newKeyIndex(int expectedCount)
+{
+    KEY_INDEX_T *pIndex = calloc(1, sizeof(KEY_INDEX_T));
+    int slotCount = MIN_SLOTS;
+    /* keep the table no more than 70% full */
+    while (slotCount * 7 < expectedCount * 10)
+	slotCount *= 2;
+    if (pIndex != NULL)
+    {
+	pIndex->slots = calloc(slotCount, sizeof(SLOT_T));
+	pIndex->slotCount = slotCount;
+	if (pIndex->slots == NULL)
+	{
+	    free(pIndex);
+	    pIndex = NULL;
+	}
+    }
+    return (KEY_INDEX_HANDLE) pIndex;
+}
+
+
+/* Free all memory associated with an index. Does not free
+ * the keys or the values.
+ * Arguments
+ *   index   -  Index to free. Not valid after this call.
+ */
+void keyIndexDestroy(KEY_INDEX_HANDLE index)
+{
+    KEY_INDEX_T *pIndex = (KEY_INDEX_T *) index;
+    if (pIndex != NULL)
+    {
+	free(pIndex->slots);
+	free(pIndex);
+    }
+}
+
+
+/* Add a key and its value to the index.
+ * Arguments
+ *   index   -  Index to add to
+ *   key     -  Key string (not copied)
+ *   value   -  Pointer to associate with the key
+ * Returns 1 if successful, -1 if the key is already in the index,
+ * 0 if a memory allocation error occurs.
+ */
+int keyIndexInsert(KEY_INDEX_HANDLE index, char *key, void *value)
+{
+    KEY_INDEX_T *pIndex = (KEY_INDEX_T *) index;
+    unsigned int hash = hashKey(key);
+    int i = 0;
+    if ((pIndex->count + 1) * 10 > pIndex->slotCount * 7)
+    {
+	if (!resize(pIndex, pIndex->slotCount * 2))
+	    return 0;
+    }
+    i = probe(pIndex, key, hash);
+    if (pIndex->slots[i].key != NULL)
+	return -1;
+    pIndex->slots[i].key = key;
+    pIndex->slots[i].value = value;
+    pIndex->slots[i].hash = hash;
+    pIndex->count++;
+    return 1;
+}
+
+
+/* Find the value associated with a key.
+ * Arguments
+ *   index   -  Index to search
+ *   key     -  Key we are looking for
+ * Returns the value, or NULL if the key is not in the index.
+ */
+void *keyIndexLookup(KEY_INDEX_HANDLE index, char *key)
+{
+    KEY_INDEX_T *pIndex = (KEY_INDEX_T *) index;
+    int i = probe(pIndex, key, hashKey(key));
+    return pIndex->slots[i].value;	/* NULL if the slot is empty */
+}
+
+
+/* Remove a key from the index. Rather than leaving a special
+ * "deleted" marker, we move later entries in the same run back
+ * to fill the hole, so that searches still work.
+ * Arguments
+ *   index   -  Index to remove from
+ *   key     -  Key to remove
+ * Returns the value that was associated with the key, or NULL
+ * if the key was not in the index.
+ */
+void *keyIndexRemove(KEY_INDEX_HANDLE index, char *key)
+{
+    KEY_INDEX_T *pIndex = (KEY_INDEX_T *) index;
+    int mask = pIndex->slotCount - 1;
+    int hole = probe(pIndex, key, hashKey(key));
+    int i = 0;
+    void *value = pIndex->slots[hole].value;
+    if (pIndex->slots[hole].key == NULL)
+	return NULL;
+    i = (hole + 1) & mask;
+    while (pIndex->slots[i].key != NULL)
+    {
+	int home = pIndex->slots[i].hash & mask;
+	/* this entry can move into the hole only if its home slot
+	 * is not between the hole and where it is now */
+	if (((i - home) & mask) >= ((i - hole) & mask))
+	{
+	    pIndex->slots[hole] = pIndex->slots[i];
+	    hole = i;
+	}
+	i = (i + 1) & mask;
+    }
+    pIndex->slots[hole].key = NULL;
+    pIndex->slots[hole].value = NULL;
+    pIndex->count--;
+    return value;
+}
+
+
+/* Find out how many keys are in the index.
+ * Arguments
+ *   index   -  Index we are interested in
+ * Returns number of keys (could be zero)
+ */
+int keyIndexCount(KEY_INDEX_HANDLE index)
+{
+    return ((KEY_INDEX_T *) index)->count;
+}
@@ -11,6 +11,63 @@
  *  the graph. Every vertex has a void* pointer to ancillary data which
  *  is simply stored. 
  *
+ *  To find a vertex from its key quickly, we also keep a hash table
+ *  (keyIndex.c) that maps each key to its vertex. The vertex list is
+ *  doubly linked so that we can unlink a vertex found this way
+ *  without searching for its predecessor.
+ *
+ *  Every edge is stored in a list at each of its ends: in the
+ *  adjacency lists of both vertices if the graph is undirected, or
+ *  in the adjacency list of the start vertex and the incoming list
+ *  of the end vertex if it is directed. The two list items point
+ *  to each other ("twins"), and the lists are doubly linked, so
+ *  removing a vertex only needs to look at the vertex's own edges.
+ *
+ *  Vertices and list items are allocated from two pools (nodePool.c)
+ *  rather than one at a time with calloc. A pool gets memory in large
+ *  slabs and reuses freed items, and graphDestroy gives back each pool
+ *  as a whole instead of freeing every edge.
+ *
+ *  All the information about one graph is kept in a GRAPH_T
+ *  structure, and the handle returned by newGraph() points to it,
+ *  so a program can have many graphs. The information used by
+ *  traversals (what has been visited, where we arrived from) is not
+ *  stored in the vertices. Instead each traversal allocates its own
+ *  arrays, so traversals never change the graph and several can run
+ *  at once.
+ *
+ *  Traversals are done by breadthFirst.c and depthFirst.c, which work
+ *  on a compressed sparse row (CSR) copy of the edges: every vertex
+ *  gets a number from 0 in list order, and the edges are packed into
+ *  arrays. The copy is built by the first search after the graph
+ *  changes and then kept for later searches. Since several searches
+ *  may run at once, building it is protected by a mutex. This module
+ *  must therefore be linked with breadthFirst.c, depthFirst.c and
+ *  -lpthread.
+ *
+ *  The first reachability check after a change also finds the
+ *  strongly connected components (components.c) and builds the
+ *  condensed graph, and keeps them with the CSR copy. Two vertices in
+ *  the same component can always reach each other, and a vertex can
+ *  never reach one in a component with a lower number, so most checks
+ *  need no search at all. The rest search the condensed graph, which
+ *  is usually much smaller than the graph itself.
+ *
+ *  Those searches, and the one done by isReachablePrintPath(), stop
+ *  as soon as they find the end vertex and often look at only a few
+ *  vertices. So that they do not have to clear an array the size of
+ *  the graph first, they mark each vertex with the number (epoch) of
+ *  the search that reached it, and a new search just uses the next
+ *  epoch. The graph keeps one spare set of these arrays for reuse.
+ *
+ *  If buildReachabilityIndex() has been called, isReachable() instead
+ *  looks the answer up in a bitset transitive closure of the condensed
+ *  graph (see components.c). The index records each vertex's component
+ *  by vertex index, since the CSR numbers change when the graph does.
+ *  Adding an edge that does not let anything new be reached keeps the
+ *  index; any other change frees it, and the next isReachable() call
+ *  builds it again under the CSR lock.
+ *
  *  Copyright 2020 by Sally E. Goldin
  *
  *  May be freely copied and modified for educational purposes
@@ -21,14 +78,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include "abstractGraph.h"
-#include "abstractQueue.h"
-
-#define WHITE 0
-#define GRAY  1
-#define BLACK 2
+#include "keyIndex.h"
+#include "nodePool.h"
+#include "breadthFirst.h"
+#include "depthFirst.h"
+#include "components.h"
 
-char* colorName[] = {"WHITE", "GRAY", "BLACK"};
+/* Number of records in each slab of the vertex and edge pools */
+#define VERTEX_SLAB_SIZE 1024
+#define EDGE_SLAB_SIZE 4096
 
 /* List items for the adjacency list.
  * Each one is a reference to an existing vertex
@@ -39,6 +99,10 @@ typedef struct _adjVertex
                                * item refers to.
                                */
     struct _adjVertex* next;  /* next item in the ajacency list */ 
+    struct _adjVertex* prev;  /* previous item in the ajacency list */ 
+    struct _adjVertex* twin;  /* item for the same edge in the list
+                               * of the vertex at the other end
+                               */
 } ADJACENT_T;
 
 /* List items for the main vertex list.*/
@@ -46,72 +110,220 @@ typedef struct _vertex
 {
     char * key;               /* key for this vertex */
     void * data;              /* ancillary data for this vertex */
-    int color;                /* used to mark nodes as visited */
+    int index;                /* number given to this vertex when it
+                               * was added; never reused
+                               */
     struct _vertex * next;    /* next vertex in the list */
-    struct _vertex * pFrom;     /* what vertex did we arrive from? */
+    struct _vertex * prev;    /* previous vertex in the list */
     ADJACENT_T * adjacentHead;    /* pointer to the head of the
 		               * adjacent vertices list
                                */
     ADJACENT_T * adjacentTail;    /* pointer to the tail of the
 			       * adjacent vertices list
                                */
+    ADJACENT_T * incomingHead;    /* head of the list of edges that
+                               * enter this vertex (directed only)
+                               */
+    ADJACENT_T * incomingTail;    /* tail of that list */
 }  VERTEX_T;
 
 
-VERTEX_T * vListHead = NULL;  /* head of the vertex list */
-VERTEX_T * vListTail = NULL;  /* tail of the vertex list */
-int bGraphDirected = 0;       /* if true, this is a directed graph */
-int vertexCount = 0;          /* keep track of the number of vertices */
+/* Working storage for a breadth first search that stops as soon
+ * as it finds the vertex it is looking for, so it often looks at
+ * only a small part of the graph. A vertex has been reached by the
+ * current search if its mark equals the current epoch. Starting a
+ * new search just adds one to the epoch, so nothing needs to be
+ * cleared and the cost of a search does not depend on the size
+ * of the graph.
+ */
+typedef struct
+{
+    int capacity;             /* entries in each array below */
+    unsigned int epoch;       /* number of the current search */
+    unsigned int * mark;      /* epoch of the last search that
+                               * reached each vertex
+                               */
+    int * parent;             /* vertex each one was reached from,
+                               * or -1 for the start vertex
+                               */
+    int * queue;              /* vertices waiting to be expanded */
+} LOCAL_SEARCH_T;
+
+
+/* Structure holding one graph */
+typedef struct
+{
+    VERTEX_T * vListHead;     /* head of the vertex list */
+    VERTEX_T * vListTail;     /* tail of the vertex list */
+    int bGraphDirected;       /* if true, this is a directed graph */
+    int vertexCount;          /* keep track of the number of vertices */
                               /* updated in addVertex and removeVertex */
                               /* used in printPath */
+    int nextIndex;            /* index to give the next vertex added */
+    KEY_INDEX_HANDLE vertexIndex; /* maps keys to vertices */
+    NODE_POOL_HANDLE vertexPool;  /* storage for VERTEX_T records */
+    NODE_POOL_HANDLE edgePool;    /* storage for ADJACENT_T records */
+    BFS_GRAPH_T * pCsr;       /* CSR copy of the edges, or NULL */
+    VERTEX_T ** csrVertices;  /* vertex for each CSR number */
+    int * csrNumber;          /* CSR number for each vertex index */
+    int bCsrStale;            /* true if the graph has changed since
+                               * the CSR copy was built
+                               */
+    int * componentIds;       /* component of each CSR number, or NULL
+                               * if not found yet
+                               */
+    int componentCount;       /* number of components */
+    BFS_GRAPH_T * pDag;       /* condensed graph, or NULL */
+    REACH_INDEX_HANDLE reachIndex; /* reachability index, or NULL */
+    int * reachComponent;     /* component of each vertex index, as
+                               * numbered in the reachability index
+                               */
+    long reachBytes;          /* memory used by the index */
+    long reachMaxBytes;       /* largest index to build, or 0 if
+                               * no index is wanted
+                               */
+    pthread_mutex_t csrLock;  /* held while building the CSR copy
+                               * or the reachability index
+                               */
+    LOCAL_SEARCH_T * pSpareLocal; /* storage for a local search that
+                               * no search is using, or NULL
+                               */
+    pthread_mutex_t localLock;  /* protects pSpareLocal */
+} GRAPH_T;
+
+/* Results of one breadth first search. Each array has an
+ * entry for every vertex in the CSR copy it was run on.
+ */
+typedef struct
+{
+    int * levels;             /* edges from the start, or -1 */
+    int * parents;            /* CSR number of the vertex we arrived
+                               * from, or -1
+                               */
+    int * order;              /* CSR numbers of the vertices found,
+                               * in the order they were found
+                               */
+    int count;                /* number of vertices found */
+} SEARCH_T;
 
 /** Private functions */
 
 /* Finds the vertex that holds the passed key
  * (if any) and returns a pointer to that vertex.
+ * Uses the key index rather than searching the list.
  * Arguments
+ *       pGraph -  Graph to search
  *       key    -  Key we are looking for
  *       pPred  -  used to return the predecessor if any
  * Returns pointer to the vertex structure if one is found       
  */
-VERTEX_T * findVertexByKey(char* key, VERTEX_T** pPred) 
+VERTEX_T * findVertexByKey(GRAPH_T* pGraph, char* key, VERTEX_T** pPred)
 {
     VERTEX_T * pFoundVtx = NULL;
-    VERTEX_T * pCurVertex = vListHead;
     *pPred = NULL;
-    /* while there are vertices left and we haven't found
-     * the one we want.
-     */
-    while ((pCurVertex != NULL) && (pFoundVtx == NULL))
-       {
-       if (strcmp(pCurVertex->key,key) == 0)
-          {
-	  pFoundVtx = pCurVertex;
-	  }
-       else
-          {
-	  *pPred = pCurVertex;
-          pCurVertex = pCurVertex->next;
-          }
-       }
+    pFoundVtx = (VERTEX_T*) keyIndexLookup(pGraph->vertexIndex,key);
+    if (pFoundVtx != NULL)
+       *pPred = pFoundVtx->prev;
     return pFoundVtx;
 }
 
-/* Free the adjacencyList for a vertex 
- * Argument
- *   pVertex    - vertex whose edges we want to delete 
+/* Free one list of edge references
+ * Arguments
+ *   pGraph     - graph the list belongs to
+ *   pCurRef    - head of the list
  */
-void freeAdjacencyList(VERTEX_T *pVertex)
+void freeRefList(GRAPH_T* pGraph, ADJACENT_T *pCurRef)
 {
-   ADJACENT_T * pCurRef = pVertex->adjacentHead;
    while (pCurRef != NULL)
       {
       ADJACENT_T * pDelRef = pCurRef;
       pCurRef = pCurRef->next;
-      free(pDelRef);
+      nodePoolFree(pGraph->edgePool,pDelRef);
       }
+}
+
+/* Free the adjacencyList for a vertex, and its incoming list
+ * Arguments
+ *   pGraph     - graph the vertex belongs to
+ *   pVertex    - vertex whose edges we want to delete 
+ */
+void freeAdjacencyList(GRAPH_T* pGraph, VERTEX_T *pVertex)
+{
+   freeRefList(pGraph,pVertex->adjacentHead);
+   freeRefList(pGraph,pVertex->incomingHead);
    pVertex->adjacentHead = NULL;
    pVertex->adjacentTail = NULL;
+   pVertex->incomingHead = NULL;
+   pVertex->incomingTail = NULL;
+}
+
+/* Add a new reference to the end of a list
+ * Arguments
+ *   pGraph     - graph the list belongs to
+ *   pHead      - address of the list head
+ *   pTail      - address of the list tail
+ *   pVertex    - vertex the new reference points to
+ * Returns the new list item, or NULL if allocation fails.
+ */
+ADJACENT_T* appendRef(GRAPH_T* pGraph, ADJACENT_T** pHead,
+		      ADJACENT_T** pTail, VERTEX_T* pVertex)
+{
+   ADJACENT_T * pNewRef = (ADJACENT_T*) nodePoolAlloc(pGraph->edgePool);
+   if (pNewRef != NULL)
+      {
+      pNewRef->pVertex = pVertex;
+      pNewRef->prev = *pTail;
+      if (*pTail != NULL)
+	 {
+	 (*pTail)->next = pNewRef;
+	 }
+      else
+	 {
+	 *pHead = pNewRef;
+	 }
+      *pTail = pNewRef;
+      }
+   return pNewRef;
+}
+
+/* Unlink a reference from a list. Does not free it.
+ * Arguments
+ *   pHead      - address of the list head
+ *   pTail      - address of the list tail
+ *   pRef       - item to unlink
+ */
+void unlinkRef(ADJACENT_T** pHead, ADJACENT_T** pTail, ADJACENT_T* pRef)
+{
+   if (pRef->prev != NULL)
+      pRef->prev->next = pRef->next;
+   else
+      *pHead = pRef->next;
+   if (pRef->next != NULL)
+      pRef->next->prev = pRef->prev;
+   else
+      *pTail = pRef->prev;
+}
+
+/* Delete an edge, taking it out of the lists at both of its ends
+ * Arguments
+ *   pGraph     - graph the edge belongs to
+ *   pFromVtx   - vertex whose adjacency list holds pRef
+ *   pRef       - item for the edge in that list
+ */
+void deleteEdge(GRAPH_T* pGraph, VERTEX_T* pFromVtx, ADJACENT_T* pRef)
+{
+   VERTEX_T * pToVtx = (VERTEX_T*) pRef->pVertex;
+   ADJACENT_T * pTwin = pRef->twin;
+   unlinkRef(&pFromVtx->adjacentHead,&pFromVtx->adjacentTail,pRef);
+   if (pTwin != pRef)
+      {
+      if (pGraph->bGraphDirected)
+         unlinkRef(&pToVtx->incomingHead,&pToVtx->incomingTail,pTwin);
+      else
+         unlinkRef(&pToVtx->adjacentHead,&pToVtx->adjacentTail,pTwin);
+      nodePoolFree(pGraph->edgePool,pTwin);
+      }
+   nodePoolFree(pGraph->edgePool,pRef);
 }
 
 /* Check if there is already an edge between
@@ -141,49 +353,28 @@ int edgeExists(VERTEX_T* pFrom, VERTEX_T* pTo)
     return bEdgeExists;
 }
 
-/* Component of removeVertex. Removes all references
- * to this vertex as the end point of edges in other
- * vertices' adjacency lists.
+/* Component of removeVertex. Removes all the edges
+ * that start or end at this vertex, from the lists at
+ * both of their ends. Thanks to the twin pointers, this
+ * only needs to look at the target's own lists.
+ * Arguments
+ *   pGraph     - graph the vertex belongs to
+ *   pTarget    - vertex being removed
  */
-void removeReferences(VERTEX_T * pTarget)
+void removeReferences(GRAPH_T* pGraph, VERTEX_T * pTarget)
 {
-   VERTEX_T * pCurrentVtx = vListHead;
-   while (pCurrentVtx != NULL)
+   /* edges leaving the target (all its edges, if undirected) */
+   while (pTarget->adjacentHead != NULL)
       {
-      if (pCurrentVtx != pTarget)
-         {
-	 /* skip the target vertex */
-	 ADJACENT_T* pRef = pCurrentVtx->adjacentHead;
-	 ADJACENT_T* pPrevRef = NULL;
-	 while (pRef != NULL)
-	    {
-	    if (pRef->pVertex == pTarget)  /* if this edge involves the target*/
-	       {
-	       if (pPrevRef != NULL)
-	          {
-		  pPrevRef->next = pRef->next;
-	          }
-               else
-	          {
-		  pCurrentVtx->adjacentHead = pRef->next;   
-	          }
-               if (pRef == pCurrentVtx->adjacentTail)
-	          {
-		  pCurrentVtx->adjacentTail = NULL;
-		  }
-               free(pRef);
-               pRef = NULL;
-	       break;    /* can only show up once in the adjacency list*/
-	       }
-            else
-	       {
-	       pPrevRef = pRef;
-               pRef = pRef->next;
-	       }  
-	    }
-	 }
-      pCurrentVtx = pCurrentVtx->next;      
-      } 
+      deleteEdge(pGraph,pTarget,pTarget->adjacentHead);
+      }
+   /* edges entering the target, if directed. The twin of each
+    * item is in the adjacency list of the start vertex */
+   while (pTarget->incomingHead != NULL)
+      {
+      deleteEdge(pGraph,(VERTEX_T*) pTarget->incomingHead->pVertex,
+		 pTarget->incomingHead->twin);
+      }
 }
 
 /* Count adjacent vertices to a vertex.
@@ -203,84 +394,498 @@ int countAdjacent(VERTEX_T * pVertex)
     return count;
 }
 
-/* Set all vertices to the passed color.
+/* Free the CSR copy of a graph's edges, if any.
  * Argument
- *    A color constant
- * 12 Mar 2015 Also set pFrom to NULL
+ *    pGraph    -   Graph whose copy we want to free
  */
-void colorAll(int color)
+void freeCsr(GRAPH_T* pGraph)
 {
-    VERTEX_T* pVertex = vListHead;
-    while (pVertex != NULL)
+    if (pGraph->pCsr != NULL)
        {
-       pVertex->color = color;
-       pVertex->pFrom = NULL;
-       pVertex = pVertex->next;
+       if (pGraph->pCsr->inOffsets != pGraph->pCsr->offsets)
+          {
+	  free(pGraph->pCsr->inOffsets);
+	  free(pGraph->pCsr->inSources);
+          }
+       free(pGraph->pCsr->offsets);
+       free(pGraph->pCsr->targets);
+       free(pGraph->pCsr);
+       pGraph->pCsr = NULL;
        }
+    free(pGraph->csrVertices);
+    free(pGraph->csrNumber);
+    free(pGraph->componentIds);
+    freeCondensedGraph(pGraph->pDag);
+    pGraph->csrVertices = NULL;
+    pGraph->csrNumber = NULL;
+    pGraph->componentIds = NULL;
+    pGraph->pDag = NULL;
 }
 
-/* Execute a breadth first search from a vertex,
- * calling the function (*vFunction) on each vertex
- * as we visit it and color it black.
+/* Pack one kind of edge list for every vertex into CSR arrays.
+ * The edges of each vertex are kept in list order.
  * Arguments
- *    pVertex    -  starting vertex for traversal
+ *    pGraph    -   Graph being copied; csrVertices and
+ *                  csrNumber must already be filled in
+ *    edgeCount -   Total number of items in the lists
+ *    bIncoming -   If true, use the incoming lists,
+ *                  otherwise the adjacency lists
+ *    pOffsets  -   Used to return the offsets array
+ *    pEnds     -   Used to return the array of vertices
+ *                  at the other end of each edge
+ * Returns 1 if successful, 0 for a memory allocation error.
  */
-void traverseBreadthFirst(VERTEX_T* pVertex, void (*vFunction)(VERTEX_T*))
+int packEdges(GRAPH_T* pGraph, int edgeCount, int bIncoming,
+	      int** pOffsets, int** pEnds)
 {
-    VERTEX_T * pCurrent = NULL;
-    VERTEX_T * pAdjacent = NULL;    
-    queueClear();
-    colorAll(WHITE);
-    pVertex->color = GRAY;
-    enqueue(pVertex);
-    while (queueSize() > 0)
+    int count = pGraph->vertexCount;
+    int* offsets = (int*) calloc(count + 1,sizeof(int));
+    int* ends = (int*) calloc(edgeCount + 1,sizeof(int));
+    int e = 0;
+    int i = 0;
+    if ((offsets == NULL) || (ends == NULL))
+       {
+       free(offsets);
+       free(ends);
+       return 0;
+       }
+    for (i = 0; i < count; i++)
        {
-       pCurrent = (VERTEX_T*) dequeue();
-       if (pCurrent->color != BLACK)
+       VERTEX_T * pVertex = pGraph->csrVertices[i];
+       ADJACENT_T * pRef = (bIncoming) ? pVertex->incomingHead
+	                               : pVertex->adjacentHead;
+       offsets[i] = e;
+       while (pRef != NULL)
           {
-          (*vFunction)(pCurrent);
-          pCurrent->color = BLACK;
-	  ADJACENT_T* pRef = pCurrent->adjacentHead;
-	  while (pRef != NULL)
-             {
-	     pAdjacent = (VERTEX_T*) pRef->pVertex;
-	     if (pAdjacent->color == WHITE)
-	         {
-		 pAdjacent->color = GRAY;
-		 enqueue(pAdjacent);
-	         }
-	     pRef = pRef->next;
-             }
-	  }
-       } /* end while queue has data */
+	  ends[e++] = pGraph->csrNumber[((VERTEX_T*) pRef->pVertex)->index];
+	  pRef = pRef->next;
+          }
+       }
+    offsets[count] = e;
+    *pOffsets = offsets;
+    *pEnds = ends;
+    return 1;
 }
 
+/* Build the CSR copy of a graph's edges. The vertices are
+ * numbered in list order.
+ * Argument
+ *    pGraph    -   Graph to copy; must not have a copy already
+ * Returns 1 if successful, 0 for a memory allocation error.
+ */
+int buildCsr(GRAPH_T* pGraph)
+{
+    BFS_GRAPH_T * pCsr = (BFS_GRAPH_T*) calloc(1,sizeof(BFS_GRAPH_T));
+    VERTEX_T * pVertex = NULL;
+    int edgeCount = 0;
+    int i = 0;
+    pGraph->pCsr = pCsr;
+    pGraph->csrVertices = (VERTEX_T**) calloc(pGraph->vertexCount + 1,
+					      sizeof(VERTEX_T*));
+    pGraph->csrNumber = (int*) calloc(pGraph->nextIndex + 1,sizeof(int));
+    if ((pCsr == NULL) || (pGraph->csrVertices == NULL) ||
+	(pGraph->csrNumber == NULL))
+       {
+       freeCsr(pGraph);
+       return 0;
+       }
+    for (pVertex = pGraph->vListHead; pVertex != NULL; pVertex = pVertex->next)
+       {
+       pGraph->csrVertices[i] = pVertex;
+       pGraph->csrNumber[pVertex->index] = i;
+       edgeCount += countAdjacent(pVertex);
+       i++;
+       }
+    pCsr->vertexCount = pGraph->vertexCount;
+    pCsr->edgeCount = edgeCount;
+    if (!packEdges(pGraph,edgeCount,0,&pCsr->offsets,&pCsr->targets))
+       {
+       freeCsr(pGraph);
+       return 0;
+       }
+    if (!pGraph->bGraphDirected)
+       {
+       /* every edge is in the adjacency lists at both ends */
+       pCsr->inOffsets = pCsr->offsets;
+       pCsr->inSources = pCsr->targets;
+       }
+    else if (!packEdges(pGraph,edgeCount,1,&pCsr->inOffsets,&pCsr->inSources))
+       {
+       freeCsr(pGraph);
+       return 0;
+       }
+    return 1;
+}
+
+/* Find the components of the CSR copy and build the
+ * condensed graph.
+ * Argument
+ *    pGraph    -   Graph whose CSR copy is up to date
+ * Returns 1 if successful, 0 for a memory allocation error.
+ */
+int buildCondensed(GRAPH_T* pGraph)
+{
+    pGraph->componentIds = (int*) calloc(pGraph->pCsr->vertexCount + 1,
+					 sizeof(int));
+    if (pGraph->componentIds != NULL)
+       {
+       pGraph->componentCount = findStrongComponents(pGraph->pCsr,
+						     pGraph->componentIds);
+       if (pGraph->componentCount >= 0)
+	  pGraph->pDag = condenseGraph(pGraph->pCsr,pGraph->componentIds,
+				       pGraph->componentCount);
+       }
+    if (pGraph->pDag == NULL)
+       {
+       free(pGraph->componentIds);
+       pGraph->componentIds = NULL;
+       return 0;
+       }
+    return 1;
+}
+
+/* Build the CSR copy of a graph's edges again if the graph
+ * has changed. The caller must hold the CSR lock.
+ * Arguments
+ *    pGraph     -   Graph we are going to search
+ *    bCondensed -   If true, also make sure we have the
+ *                   components and the condensed graph
+ * Returns 1 if successful, 0 for a memory allocation error.
+ */
+int updateCsr(GRAPH_T* pGraph, int bCondensed)
+{
+    int bOk = 1;
+    if ((pGraph->bCsrStale) || (pGraph->pCsr == NULL))
+       {
+       freeCsr(pGraph);
+       bOk = buildCsr(pGraph);
+       pGraph->bCsrStale = !bOk;
+       }
+    if ((bOk) && (bCondensed) && (pGraph->pDag == NULL))
+       bOk = buildCondensed(pGraph);
+    return bOk;
+}
 
-/* Execute a depth first search from a single vertex,
- * calling the function (*vFunction) on the lowest level
- * vertex we visit, and coloring it black.
+/* Make sure the CSR copy of a graph's edges is up to date,
+ * building it again if the graph has changed.
  * Arguments
- *    pVertex    -  starting vertex for traversal
+ *    pGraph     -   Graph we are going to search
+ *    bCondensed -   If true, also make sure we have the
+ *                   components and the condensed graph
+ * Returns 1 if successful, 0 for a memory allocation error.
  */
-void traverseDepthFirst(VERTEX_T* pVertex, void (*vFunction)(VERTEX_T*))
+int ensureCsr(GRAPH_T* pGraph, int bCondensed)
 {
-    VERTEX_T * pAdjacent = NULL;    
-    ADJACENT_T* pRef = pVertex->adjacentHead;
-    while (pRef != NULL)
+    int bOk = 1;
+    pthread_mutex_lock(&pGraph->csrLock);
+    bOk = updateCsr(pGraph,bCondensed);
+    pthread_mutex_unlock(&pGraph->csrLock);
+    return bOk;
+}
+
+/* Free the reachability index of a graph, if it has one.
+ * Argument
+ *    pGraph    -   Graph whose index we are freeing
+ */
+void freeReach(GRAPH_T* pGraph)
+{
+    freeReachIndex(pGraph->reachIndex);
+    free(pGraph->reachComponent);
+    pGraph->reachIndex = NULL;
+    pGraph->reachComponent = NULL;
+    pGraph->reachBytes = 0;
+}
+
+/* Build the reachability index of a graph over its condensed
+ * graph, unless it would be too big. The caller must hold the
+ * CSR lock.
+ * Argument
+ *    pGraph    -   Graph that does not have an index
+ * Returns 1 if successful, 0 if the index would take more than
+ * reachMaxBytes, or -1 for a memory allocation error.
+ */
+int buildReach(GRAPH_T* pGraph)
+{
+    long bytes = 0;
+    int i = 0;
+    if (!updateCsr(pGraph,1))
+       return -1;
+    bytes = reachIndexBytes(pGraph->componentCount) +
+	    (pGraph->nextIndex + 1) * sizeof(int);
+    if (bytes > pGraph->reachMaxBytes)
+       return 0;
+    pGraph->reachComponent = (int*) calloc(pGraph->nextIndex + 1,
+					   sizeof(int));
+    pGraph->reachIndex = buildReachIndex(pGraph->pDag);
+    if ((pGraph->reachComponent == NULL) || (pGraph->reachIndex == NULL))
        {
-       pAdjacent = (VERTEX_T*) pRef->pVertex;
-       if (pAdjacent->color == WHITE)
-	   {
-	   pAdjacent->color = GRAY;
-           traverseDepthFirst(pAdjacent,vFunction);
-           }
-       pRef = pRef->next;  
-       } /* end while queue has data */
-    /* when we return from the bottom, call the 
-     * function and color this node black.
-     */
-    (*vFunction)(pVertex);
-    pVertex->color = BLACK;
+       freeReach(pGraph);
+       return -1;
+       }
+    /* the CSR numbers change when the graph does, so keep our own
+     * record of each vertex's component */
+    for (i = 0; i < pGraph->pCsr->vertexCount; i++)
+       {
+       int index = pGraph->csrVertices[i]->index;
+       pGraph->reachComponent[index] = pGraph->componentIds[i];
+       }
+    pGraph->reachBytes = bytes;
+    return 1;
+}
+
+/* Get the reachability index of a graph, building it again
+ * if it is wanted but out of date.
+ * Argument
+ *    pGraph    -   Graph we are going to check
+ * Returns the index, or NULL if there is none.
+ */
+REACH_INDEX_HANDLE ensureReach(GRAPH_T* pGraph)
+{
+    REACH_INDEX_HANDLE index = NULL;
+    pthread_mutex_lock(&pGraph->csrLock);
+    if ((pGraph->reachIndex == NULL) && (pGraph->reachMaxBytes > 0))
+       buildReach(pGraph);
+    index = pGraph->reachIndex;
+    pthread_mutex_unlock(&pGraph->csrLock);
+    return index;
+}
+
+/* Free the results of a breadth first search.
+ * Argument
+ *    pSearch   -  Results returned by searchFrom, or NULL
+ */
+void freeSearch(SEARCH_T* pSearch)
+{
+    if (pSearch != NULL)
+       {
+       free(pSearch->levels);
+       free(pSearch->parents);
+       free(pSearch->order);
+       free(pSearch);
+       }
+}
+
+/* Do a breadth first search from a vertex.
+ * Arguments
+ *    pGraph     -  Graph to search
+ *    pVertex    -  starting vertex for the search
+ *    pEndVertex -  If not NULL, we can stop once this
+ *                  vertex has been found
+ * Returns the results, or NULL for a memory allocation error.
+ */
+SEARCH_T* searchFrom(GRAPH_T* pGraph, VERTEX_T* pVertex,
+		     VERTEX_T* pEndVertex)
+{
+    SEARCH_T * pSearch = NULL;
+    int count = 0;
+    if (!ensureCsr(pGraph,0))
+       return NULL;
+    count = pGraph->pCsr->vertexCount;
+    pSearch = (SEARCH_T*) calloc(1,sizeof(SEARCH_T));
+    if (pSearch != NULL)
+       {
+       pSearch->levels = (int*) calloc(count,sizeof(int));
+       pSearch->parents = (int*) calloc(count,sizeof(int));
+       pSearch->order = (int*) calloc(count,sizeof(int));
+       if ((pSearch->levels == NULL) || (pSearch->parents == NULL) ||
+	   (pSearch->order == NULL))
+          {
+	  freeSearch(pSearch);
+	  return NULL;
+          }
+       pSearch->count = breadthFirstSearch(pGraph->pCsr,
+		           pGraph->csrNumber[pVertex->index],
+			   (pEndVertex != NULL) ?
+			       pGraph->csrNumber[pEndVertex->index] : -1,
+			   0,pSearch->levels,pSearch->parents,
+			   pSearch->order,NULL);
+       if (pSearch->count < 0)
+          {
+	  freeSearch(pSearch);
+	  pSearch = NULL;
+          }
+       }
+    return pSearch;
+}
+
+/* Free the storage for a local search.
+ * Argument
+ *    pLocal    -  Storage to free, or NULL
+ */
+void freeLocalSearch(LOCAL_SEARCH_T* pLocal)
+{
+    if (pLocal != NULL)
+       {
+       free(pLocal->mark);
+       free(pLocal->parent);
+       free(pLocal->queue);
+       free(pLocal);
+       }
+}
+
+/* Get storage for a local search, with room for a number of
+ * vertices, and start a new epoch in it. Uses the graph's spare
+ * storage if no other search has it.
+ * Arguments
+ *    pGraph    -  Graph we are going to search
+ *    count     -  Number of vertices in the CSR view to search
+ * Returns the storage, or NULL for a memory allocation error.
+ */
+LOCAL_SEARCH_T* getLocalSearch(GRAPH_T* pGraph, int count)
+{
+    LOCAL_SEARCH_T * pLocal = NULL;
+    pthread_mutex_lock(&pGraph->localLock);
+    pLocal = pGraph->pSpareLocal;
+    pGraph->pSpareLocal = NULL;
+    pthread_mutex_unlock(&pGraph->localLock);
+    if (pLocal == NULL)
+       pLocal = (LOCAL_SEARCH_T*) calloc(1,sizeof(LOCAL_SEARCH_T));
+    if ((pLocal != NULL) && (count > pLocal->capacity))
+       {
+       int capacity = (pLocal->capacity > 0) ? pLocal->capacity : 16;
+       unsigned int * mark = NULL;
+       while (capacity < count)
+	  capacity *= 2;
+       /* the old marks are no use to us, so don't copy them */
+       mark = (unsigned int*) calloc(capacity,sizeof(unsigned int));
+       free(pLocal->parent);
+       free(pLocal->queue);
+       pLocal->parent = (int*) malloc(capacity * sizeof(int));
+       pLocal->queue = (int*) malloc(capacity * sizeof(int));
+       if ((mark == NULL) || (pLocal->parent == NULL) ||
+	   (pLocal->queue == NULL))
+          {
+	  free(mark);
+	  freeLocalSearch(pLocal);
+	  return NULL;
+          }
+       free(pLocal->mark);
+       pLocal->mark = mark;
+       pLocal->capacity = capacity;
+       pLocal->epoch = 0;
+       }
+    if (pLocal != NULL)
+       {
+       pLocal->epoch++;
+       if (pLocal->epoch == 0)
+          {
+	  /* the epoch has wrapped around, so old marks could
+	   * look current; clear them once */
+	  memset(pLocal->mark,0,pLocal->capacity * sizeof(unsigned int));
+	  pLocal->epoch = 1;
+          }
+       }
+    return pLocal;
+}
+
+/* Give back the storage for a local search, keeping it as the
+ * graph's spare if there is none.
+ * Arguments
+ *    pGraph    -  Graph that was searched
+ *    pLocal    -  Storage returned by getLocalSearch
+ */
+void releaseLocalSearch(GRAPH_T* pGraph, LOCAL_SEARCH_T* pLocal)
+{
+    pthread_mutex_lock(&pGraph->localLock);
+    if (pGraph->pSpareLocal == NULL)
+       {
+       pGraph->pSpareLocal = pLocal;
+       pLocal = NULL;
+       }
+    pthread_mutex_unlock(&pGraph->localLock);
+    freeLocalSearch(pLocal);
+}
+
+/* Search breadth first from one vertex of a CSR view until we
+ * find another one, recording where each vertex was reached from.
+ * Arguments
+ *    pCsr      -  CSR view to search
+ *    pLocal    -  Storage from getLocalSearch, for a new epoch
+ *    start     -  Number of the vertex to start from
+ *    end       -  Number of the vertex we are looking for
+ * Returns 1 if the end vertex was found, 0 if not.
+ */
+int searchLocal(BFS_GRAPH_T* pCsr, LOCAL_SEARCH_T* pLocal, int start,
+		int end)
+{
+    unsigned int epoch = pLocal->epoch;
+    int head = 0;
+    int tail = 0;
+    pLocal->mark[start] = epoch;
+    pLocal->parent[start] = -1;
+    pLocal->queue[tail++] = start;
+    while ((head < tail) && (pLocal->mark[end] != epoch))
+       {
+       int current = pLocal->queue[head++];
+       int e = 0;
+       for (e = pCsr->offsets[current]; e < pCsr->offsets[current+1]; e++)
+          {
+	  int adjacent = pCsr->targets[e];
+	  if (pLocal->mark[adjacent] != epoch)
+	     {
+	     pLocal->mark[adjacent] = epoch;
+	     pLocal->parent[adjacent] = current;
+	     pLocal->queue[tail++] = adjacent;
+	     }
+          }
+       }
+    return (pLocal->mark[end] == epoch);
+}
+
+/* Check whether one component can reach another in the
+ * condensed graph, using a breadth first search.
+ * Arguments
+ *    pGraph     -  Graph whose condensed graph is up to date
+ *    from       -  Component to start from
+ *    to         -  Component we want to reach
+ * Returns 1 if it can be reached, 0 if not, or -1 for a
+ * memory allocation error.
+ */
+int searchCondensed(GRAPH_T* pGraph, int from, int to)
+{
+    LOCAL_SEARCH_T * pLocal = getLocalSearch(pGraph,pGraph->componentCount);
+    int retval = -1;
+    if (pLocal != NULL)
+       {
+       retval = searchLocal(pGraph->pDag,pLocal,from,to);
+       releaseLocalSearch(pGraph,pLocal);
+       }
+    return retval;
+}
+
+
+/* Start looking through the vertices adjacent to a vertex
+ * in the CSR copy. Used by the depth first search engine.
+ * Arguments
+ *    pCsr      -  CSR copy of the graph (will be cast to BFS_GRAPH_T*)
+ *    vertex    -  CSR number of the vertex
+ *    pCursor   -  Set to the position of the first edge
+ * Returns the CSR number of the first adjacent vertex, or -1.
+ */
+int csrFirstAdjacent(void* pCsr, int vertex, DFS_CURSOR_T* pCursor)
+{
+    BFS_GRAPH_T * pGraph = (BFS_GRAPH_T*) pCsr;
+    pCursor->position = pGraph->offsets[vertex];
+    if (pCursor->position < pGraph->offsets[vertex + 1])
+       return pGraph->targets[pCursor->position];
+    return -1;
+}
+
+/* Move on to the next vertex adjacent to a vertex in the CSR copy.
+ * Used by the depth first search engine.
+ * Arguments
+ *    pCsr      -  CSR copy of the graph (will be cast to BFS_GRAPH_T*)
+ *    vertex    -  CSR number of the vertex
+ *    pCursor   -  Position of the current edge; moved to the next
+ * Returns the CSR number of the next adjacent vertex, or -1.
+ */
+int csrNextAdjacent(void* pCsr, int vertex, DFS_CURSOR_T* pCursor)
+{
+    BFS_GRAPH_T * pGraph = (BFS_GRAPH_T*) pCsr;
+    pCursor->position++;
+    if (pCursor->position < pGraph->offsets[vertex + 1])
+       return pGraph->targets[pCursor->position];
+    return -1;
 }
 
 
@@ -299,49 +904,73 @@ void printVertexInfo(VERTEX_T* pVertex)
 /** Public functions start here */
 /********************************/
 
-/* Initialize or reintialize the graph.
+/* Create a new, empty graph.
  * Argument 
  *    maxVertices  - how many vertices can this graph
- *                   handle.
+ *                   handle. For a linked list graph this
+ *                   is only used to size the key index.
  *    bDirected    - If true this is a directed graph.
  *                   Otherwise undirected.
- * Returns 1 unless there is a memory allocation error,
- * in which case it returns zero.
+ * Returns a handle for the graph, or NULL if there is a
+ * memory allocation error.
  */
-int initGraph(int maxVertices, int bDirected)
+GRAPH_HANDLE newGraph(int maxVertices, int bDirected)
 { 
-    /* for a linked list graph, we call
-     * clearGraph and then initialize bGraphDirected
-     */
-    clearGraph();
-    bGraphDirected = bDirected;
-    return 1;  /* this implementation of initGraph can never fail */ 
+    GRAPH_T * pGraph = (GRAPH_T*) calloc(1,sizeof(GRAPH_T));
+    if (pGraph != NULL)
+       {
+       pGraph->bGraphDirected = bDirected;
+       pGraph->bCsrStale = 1;
+       pthread_mutex_init(&pGraph->csrLock,NULL);
+       pthread_mutex_init(&pGraph->localLock,NULL);
+       /* size the key index for the expected number of vertices */
+       pGraph->vertexIndex = newKeyIndex(maxVertices);
+       pGraph->vertexPool = newNodePool(sizeof(VERTEX_T),VERTEX_SLAB_SIZE);
+       pGraph->edgePool = newNodePool(sizeof(ADJACENT_T),EDGE_SLAB_SIZE);
+       if ((pGraph->vertexIndex == NULL) || (pGraph->vertexPool == NULL) ||
+	   (pGraph->edgePool == NULL))
+          {
+	  graphDestroy(pGraph);
+	  pGraph = NULL;
+          }
+       }
+    return (GRAPH_HANDLE) pGraph;
 }
 
 
-/* Free all memory associated with the graph and
- * reset all parameters.
+/* Free all memory associated with the graph. Does not
+ * free the data stored with the vertices.
+ * Arguments
+ *    graph  -  Graph to free. Not valid after this call.
  */
-void clearGraph()
+void graphDestroy(GRAPH_HANDLE graph)
 {
-    VERTEX_T * pCurVertex = vListHead;
+    GRAPH_T * pGraph = (GRAPH_T*) graph;
+    VERTEX_T * pCurVertex = NULL;
+    if (pGraph == NULL)
+       return;
+    pCurVertex = pGraph->vListHead;
     while (pCurVertex != NULL)
        {
-       freeAdjacencyList(pCurVertex);
-       VERTEX_T * pDelVtx = pCurVertex;
+       /* the list items and vertices themselves are freed
+	* all at once when we destroy the pools below */
+       free(pCurVertex->key);
        pCurVertex = pCurVertex->next;
-       free(pDelVtx->key);
-       free(pDelVtx);
        }
-
-    vListHead = NULL;  
-    vListTail = NULL; 
-    bGraphDirected = 0;
-
+    nodePoolDestroy(pGraph->edgePool);
+    nodePoolDestroy(pGraph->vertexPool);
+    keyIndexDestroy(pGraph->vertexIndex);
+    freeCsr(pGraph);
+    freeReach(pGraph);
+    freeLocalSearch(pGraph->pSpareLocal);
+    pthread_mutex_destroy(&pGraph->csrLock);
+    pthread_mutex_destroy(&pGraph->localLock);
+    free(pGraph);
 }
 
 /* Add a vertex into the graph.
  * Arguments
+ *     graph -   Graph returned by newGraph
  *     key   -   Key value or label for the 
  *               vertex
  *     pData -   Additional information that can
@@ -353,37 +982,46 @@ void clearGraph()
  * to add a vertex with a key that matches a vertex
  * already in the graph.
  */
-int addVertex(char* key, void* pData)
+int addVertex(GRAPH_HANDLE graph, char* key, void* pData)
 {
+    GRAPH_T * pGraph = (GRAPH_T*) graph;
     int bOk = 1;
     VERTEX_T * pPred;
-    VERTEX_T * pFound = findVertexByKey(key, &pPred);
+    VERTEX_T * pFound = findVertexByKey(pGraph,key,&pPred);
     if (pFound != NULL)  /* key is already in the graph */
        {
        bOk = -1;
        }
     else
        {
-       VERTEX_T * pNewVtx = (VERTEX_T *) calloc(1,sizeof(VERTEX_T));
+       VERTEX_T * pNewVtx = (VERTEX_T *) nodePoolAlloc(pGraph->vertexPool);
        char * pKeyval = strdup(key);
-       if ((pNewVtx == NULL) || (pKeyval == NULL))
+       if ((pNewVtx == NULL) || (pKeyval == NULL) ||
+	   (keyIndexInsert(pGraph->vertexIndex,pKeyval,pNewVtx) != 1))
           {
+	  nodePoolFree(pGraph->vertexPool,pNewVtx);
+	  free(pKeyval);
 	  bOk = 0;  /* allocation error */
 	  }
        else
           {
 	  pNewVtx->key = pKeyval;
           pNewVtx->data = pData;
-	  if (vListHead == NULL)  /* first vertex */
+	  pNewVtx->index = pGraph->nextIndex;
+	  pGraph->nextIndex++;
+	  if (pGraph->vListHead == NULL)  /* first vertex */
 	     {
-	     vListHead = pNewVtx;
+	     pGraph->vListHead = pNewVtx;
 	     }
 	  else
 	     {
-	     vListTail->next = pNewVtx; 
+	     pGraph->vListTail->next = pNewVtx;
+	     pNewVtx->prev = pGraph->vListTail;
 	     }
-	  vListTail = pNewVtx;
-	  vertexCount++; /* SEG added 12 Mar 2015 */
+	  pGraph->vListTail = pNewVtx;
+	  pGraph->vertexCount++; /* SEG added 12 Mar 2015 */
+	  pGraph->bCsrStale = 1;
+	  freeReach(pGraph);
 	  }
 
        }
@@ -393,35 +1031,42 @@ int addVertex(char* key, void* pData)
 
 /* Remove a vertex from the graph.
  * Arguments
+ *     graph -   Graph returned by newGraph
  *     key   -   Key value or label for the 
  *               vertex to remove
  * Returns a pointer to the data stored at that
  * vertex, or NULL if the vertex could not be 
  * found.
  */
-void* removeVertex(char* key)
+void* removeVertex(GRAPH_HANDLE graph, char* key)
 {
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
    void * pData = NULL; /* data to return */
    VERTEX_T * pPredVtx = NULL;
-   VERTEX_T * pRemoveVtx = findVertexByKey(key,&pPredVtx);
+   VERTEX_T * pRemoveVtx = findVertexByKey(pGraph,key,&pPredVtx);
    if (pRemoveVtx != NULL)
       {
-      removeReferences(pRemoveVtx);
-      freeAdjacencyList(pRemoveVtx);
+      removeReferences(pGraph,pRemoveVtx);
+      freeAdjacencyList(pGraph,pRemoveVtx);
       if (pPredVtx != NULL)
          {
 	 pPredVtx->next = pRemoveVtx->next;
          }
       else /* if there is no predecessor that means this was the head */
          {
-         vListHead = pRemoveVtx->next;
+         pGraph->vListHead = pRemoveVtx->next;
          }   
-      if (pRemoveVtx == vListTail)
-	 vListTail = pPredVtx;
+      if (pRemoveVtx->next != NULL)
+	 pRemoveVtx->next->prev = pPredVtx;
+      if (pRemoveVtx == pGraph->vListTail)
+	 pGraph->vListTail = pPredVtx;
+      keyIndexRemove(pGraph->vertexIndex,pRemoveVtx->key);
       free(pRemoveVtx->key);
       pData = pRemoveVtx->data;
-      free(pRemoveVtx);
-      vertexCount--; /* SEG added 12 Mar 2015 */
+      nodePoolFree(pGraph->vertexPool,pRemoveVtx);
+      pGraph->vertexCount--; /* SEG added 12 Mar 2015 */
+      pGraph->bCsrStale = 1;
+      freeReach(pGraph);
       } 
    return pData;
 }
@@ -429,6 +1074,7 @@ void* removeVertex(char* key)
 
 /* Add an edge between two vertices
  * Arguments
+ *    graph -  Graph returned by newGraph
  *    key1  -  Key for the first vertex in the edge
  *    key2  -  Key for the second vertex
  * Returns 1 if successful, 0 if failed due to
@@ -436,12 +1082,13 @@ void* removeVertex(char* key)
  * is not found. Returns -1 if an edge already
  * exists in this direction.
  */
-int addEdge(char* key1, char* key2)
+int addEdge(GRAPH_HANDLE graph, char* key1, char* key2)
 {
+    GRAPH_T * pGraph = (GRAPH_T*) graph;
     int bOk = 1;
     VERTEX_T * pDummy = NULL;
-    VERTEX_T * pFromVtx = findVertexByKey(key1,&pDummy);
-    VERTEX_T * pToVtx = findVertexByKey(key2,&pDummy);
+    VERTEX_T * pFromVtx = findVertexByKey(pGraph,key1,&pDummy);
+    VERTEX_T * pToVtx = findVertexByKey(pGraph,key2,&pDummy);
     if ((pFromVtx == NULL) || (pToVtx == NULL))
        {
        bOk = 0;
@@ -452,46 +1099,50 @@ int addEdge(char* key1, char* key2)
        }
     else
        {
-       ADJACENT_T * pNewRef = (ADJACENT_T*) calloc(1,sizeof(ADJACENT_T));
-       if (pNewRef == NULL)
+       ADJACENT_T * pNewRef = appendRef(pGraph,&pFromVtx->adjacentHead,
+					&pFromVtx->adjacentTail,pToVtx);
+       ADJACENT_T * pNewRef2 = NULL;
+       /* Record the edge at the other end too: in the other
+	* direction if undirected, or as an incoming edge if directed.
+	* An undirected loop is only stored once, as its own twin. */
+       if ((pNewRef != NULL) && (!pGraph->bGraphDirected) &&
+	   (pFromVtx == pToVtx))
           {
-	  bOk = 0;
+	  pNewRef2 = pNewRef;
           }
-       else
+       else if ((pNewRef != NULL) && (!pGraph->bGraphDirected))
           {
-	  pNewRef->pVertex = pToVtx;
-	  if (pFromVtx->adjacentTail != NULL)
-              {
-	      pFromVtx->adjacentTail->next = pNewRef;
-	      }
-          else
-	      {
-	      pFromVtx->adjacentHead = pNewRef;
-	      }
-	  pFromVtx->adjacentTail = pNewRef;
-          } 
-       } 
-    /* If undirected, add an edge in the other direction */
-    if ((bOk) && (!bGraphDirected))
-       {
-       ADJACENT_T * pNewRef2 = (ADJACENT_T*) calloc(1,sizeof(ADJACENT_T));
-       if (pNewRef2 == NULL)
+	  pNewRef2 = appendRef(pGraph,&pToVtx->adjacentHead,
+			       &pToVtx->adjacentTail,pFromVtx);
+          }
+       else if (pNewRef != NULL)
           {
-	  bOk = 0;
+	  pNewRef2 = appendRef(pGraph,&pToVtx->incomingHead,
+			       &pToVtx->incomingTail,pFromVtx);
+          }
+       if (pNewRef2 != NULL)
+          {
+	  pNewRef->twin = pNewRef2;
+	  pNewRef2->twin = pNewRef;
+	  pGraph->bCsrStale = 1;
+	  /* if the first vertex could already reach the second,
+	   * nothing new can be reached and the index is still right */
+	  if ((pGraph->reachIndex != NULL) &&
+	      (!testReachIndex(pGraph->reachIndex,
+			       pGraph->reachComponent[pFromVtx->index],
+			       pGraph->reachComponent[pToVtx->index])))
+	     freeReach(pGraph);
           }
        else
           {
-	  pNewRef2->pVertex = pFromVtx;
-	  if (pToVtx->adjacentTail != NULL)
-              {
-	      pToVtx->adjacentTail->next = pNewRef2;
-	      }
-          else
-	      {
-	      pToVtx->adjacentHead = pNewRef2;
-	      }
-	  pToVtx->adjacentTail = pNewRef2;
-          } 
+	  if (pNewRef != NULL)
+	     {
+	     unlinkRef(&pFromVtx->adjacentHead,&pFromVtx->adjacentTail,
+		       pNewRef);
+	     nodePoolFree(pGraph->edgePool,pNewRef);
+	     }
+	  bOk = 0;
+          }
        } 
     return bOk;
 }
@@ -499,18 +1150,20 @@ int addEdge(char* key1, char* key2)
 
 /* Remove an edge between two vertices
  * Arguments
+ *    graph -  Graph returned by newGraph
  *    key1  -  Key for the first vertex in the edge
  *    key2  -  Key for the second vertex
  * Returns 1 if successful, 0 if failed 
  * because either vertex is not found or there
  * is no edge between these items.
  */
-int removeEdge(char* key1, char* key2)
+int removeEdge(GRAPH_HANDLE graph, char* key1, char* key2)
 {
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
    int bOk = 1;
    VERTEX_T * pDummy = NULL;
-   VERTEX_T * pFromVtx = findVertexByKey(key1,&pDummy);
-   VERTEX_T * pToVtx = findVertexByKey(key2,&pDummy);
+   VERTEX_T * pFromVtx = findVertexByKey(pGraph,key1,&pDummy);
+   VERTEX_T * pToVtx = findVertexByKey(pGraph,key2,&pDummy);
    if ((pFromVtx == NULL) || (pToVtx == NULL))
        {
        bOk = 0;
@@ -522,78 +1175,31 @@ int removeEdge(char* key1, char* key2)
    else
        {
        ADJACENT_T* pRef = pFromVtx->adjacentHead;
-       ADJACENT_T* pPrevRef = NULL;
-       while (pRef != NULL)
+       while (pRef->pVertex != pToVtx)
           {  
-	  if (pRef->pVertex == pToVtx)  /* if this edge involves the target*/
-	     {
-	     if (pPrevRef != NULL)
-	        {
-	        pPrevRef->next = pRef->next;
-		}
-             else
-	        {
-		pFromVtx->adjacentHead = pRef->next;   
-	        }
-             if (pRef == pFromVtx->adjacentTail)
-	        {
-		pFromVtx->adjacentTail = NULL;
-		}
-	     free(pRef);
-	     break;    /* can only show up once in the adjacency list*/
-	     }
-	  else
-	     {
-	     pPrevRef = pRef;
-	     pRef = pRef->next;
-	     }  
-	  }
-       /* If undirected, remove edge in the other direction */
-       if ((bOk) && (!bGraphDirected))
-          {
-          ADJACENT_T* pRef2 = pToVtx->adjacentHead;
-          ADJACENT_T* pPrevRef2 = NULL;
-	  while (pRef2 != NULL)
-             {   
-	     if (pRef2->pVertex == pFromVtx)  
-	        {
-	        if (pPrevRef2 != NULL)
-	           {
-	           pPrevRef2->next = pRef2->next;
-		   }
-		else
-	           {
-		   pToVtx->adjacentHead = pRef2->next;   
-		   }
-		if (pRef2 == pToVtx->adjacentTail)
-	           {
-		   pToVtx->adjacentTail = NULL;
-		   }
-		free(pRef2);
-		break;    /* can only show up once in the adjacency list*/
-		}
-	     else
-	        {
-		pPrevRef2 = pRef2;
-		pRef2 = pRef2->next;
-		}  
-	     }
+	  pRef = pRef->next;
 	  }
+       /* this also removes the edge in the other direction,
+	* if undirected */
+       deleteEdge(pGraph,pFromVtx,pRef);
+       pGraph->bCsrStale = 1;
+       freeReach(pGraph);
        }
    return bOk;
 }
 
 /* Find a vertex and return its data
  * Arguments
+ *    graph -  Graph returned by newGraph
  *    key  -  Key for the vertex to find
  * Returns the data for the vertex or NULL
  * if not found.
  */
-void* findVertex(char* key)
+void* findVertex(GRAPH_HANDLE graph, char* key)
 {
     void* pData = NULL;
     VERTEX_T * pDummy = NULL;
-    VERTEX_T * pFoundVtx = findVertexByKey(key,&pDummy);
+    VERTEX_T * pFoundVtx = findVertexByKey((GRAPH_T*) graph,key,&pDummy);
     if (pFoundVtx != NULL)
        {
        pData = pFoundVtx->data;
@@ -608,17 +1214,18 @@ void* findVertex(char* key)
  * contents should be freed by the caller when it 
  * is no longer needed.
  * Arguments
+ *    graph  - Graph returned by newGraph
  *    key   -  Key for the node whose adjacents we want
  *    pCount - Return number of elements in the array
  * Returns array of char* which are the keys of adjacent
  * nodes. Returns number of adjacent vertices in pCount.
  * If pCount holds -1, the vertex does not exist.
  */
-char** getAdjacentVertices(char* key, int* pCount)
+char** getAdjacentVertices(GRAPH_HANDLE graph, char* key, int* pCount)
 {
     char** keyArray = NULL;
     VERTEX_T * pDummy = NULL;
-    VERTEX_T * pFoundVtx = findVertexByKey(key,&pDummy);
+    VERTEX_T * pFoundVtx = findVertexByKey((GRAPH_T*) graph,key,&pDummy);
     if (pFoundVtx != NULL)
        {
        *pCount = countAdjacent(pFoundVtx);
@@ -650,90 +1257,139 @@ char** getAdjacentVertices(char* key, int* pCount)
 /* Print out all the nodes reachable from a node by a 
  * breadth-first search.
  * Arguments
+ *   graph      -  Graph returned by newGraph
  *   startKey   -  Key for start vertex
  * Returns 1 if successful, -1 if the vertex does not exist.
  */
-int printBreadthFirst(char* startKey)
+int printBreadthFirst(GRAPH_HANDLE graph, char* startKey)
 {
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
    int retval = 1;
    VERTEX_T * pDummy = NULL;
-   VERTEX_T * pVertex = findVertexByKey(startKey,&pDummy);
+   VERTEX_T * pVertex = findVertexByKey(pGraph,startKey,&pDummy);
+   SEARCH_T * pSearch = NULL;
    if (pVertex == NULL)
       {
       retval = -1;
       }
+   else if ((pSearch = searchFrom(pGraph,pVertex,NULL)) == NULL)
+      {
+      printf("Allocation error in printBreadthFirst!\n");
+      }
    else
       {
-      traverseBreadthFirst(pVertex,&printVertexInfo);
+      int i = 0;
+      for (i = 0; i < pSearch->count; i++)
+         printVertexInfo(pGraph->csrVertices[pSearch->order[i]]);
+      freeSearch(pSearch);
       }
    return retval;
 }
 
 /* Print out all the nodes by a depth-first search.
+ * Each vertex is printed after all the vertices below it.
+ * Arguments
+ *    graph  -  Graph returned by newGraph
  */
-void printDepthFirst()
+void printDepthFirst(GRAPH_HANDLE graph)
 {
-   VERTEX_T* pVertex = vListHead;
-   if (pVertex == NULL)
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   DFS_HANDLE search = NULL;
+   if (pGraph->vListHead == NULL)
       {
       printf("The graph is empty\n");
       }
+   else if ((!ensureCsr(pGraph,0)) ||
+	    ((search = newDepthFirst(pGraph->pCsr->vertexCount)) == NULL))
+      {
+      printf("Allocation error in printDepthFirst!\n");
+      }
    else
       {
-      colorAll(WHITE);
-      while (pVertex != NULL)
+      DFS_GRAPH_T dfsGraph;
+      int * postOrder = NULL;
+      int postCount = 0;
+      int printed = 0;
+      int i = 0;
+      dfsGraph.pGraph = pGraph->pCsr;
+      dfsGraph.vertexCount = pGraph->pCsr->vertexCount;
+      dfsGraph.firstAdjacent = &csrFirstAdjacent;
+      dfsGraph.nextAdjacent = &csrNextAdjacent;
+      for (i = 0; i < dfsGraph.vertexCount; i++)
          {
-	 if (pVertex->color == WHITE)
+	 if (depthFirstDiscovery(search,i) < 0)
 	    {
 	    printf("\nStarting new traversal from |%s|\n",
-                   pVertex->key);
-	    pVertex->color = GRAY;
-            traverseDepthFirst(pVertex,&printVertexInfo);
+                   pGraph->csrVertices[i]->key);
+	    if (depthFirstVisit(search,&dfsGraph,i) < 0)
+	       {
+	       printf("Allocation error in printDepthFirst!\n");
+	       break;
+	       }
+	    postOrder = depthFirstPostOrder(search,&postCount);
+	    while (printed < postCount)
+	       {
+	       printVertexInfo(pGraph->csrVertices[postOrder[printed]]);
+	       printed++;
+	       }
 	    }
-         pVertex = pVertex->next;
 	 }
+      depthFirstDestroy(search);
       }
 }
 
 /**/
 
-/* No-op function allows us to traverse without
- * doing anything other than setting colors
- * Argument  
- *   pVertex   -   vertex - will be ignored
- */
-void emptyFunction(VERTEX_T* pVertex)
-{
-}
-
-
 /* Return information as to whether two vertices are
  * connected by a path.
  * Arguments
+ *    graph - Graph returned by newGraph
  *    key1 -  Key for the start vertex 
  *    key2 -  Key for the second vertex to check 
  * Returns 1 if the two vertices are connected, 0 if they
  * are not. Returns -1 if either vertex does not exist.
  */
-int isReachable(char* key1, char* key2)
+int isReachable(GRAPH_HANDLE graph, char* key1, char* key2)
 {
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
    int retval = 1;
    VERTEX_T * pDummy = NULL;
-   VERTEX_T * pStartVertex = findVertexByKey(key1,&pDummy);
-   VERTEX_T * pEndVertex = findVertexByKey(key2,&pDummy);
+   VERTEX_T * pStartVertex = findVertexByKey(pGraph,key1,&pDummy);
+   VERTEX_T * pEndVertex = findVertexByKey(pGraph,key2,&pDummy);
+   REACH_INDEX_HANDLE reachIndex = NULL;
    if ((pStartVertex == NULL) || (pEndVertex == NULL))
       {
       retval = -1;
       }
+   else if ((reachIndex = ensureReach(pGraph)) != NULL)
+      {
+      retval = testReachIndex(reachIndex,
+			      pGraph->reachComponent[pStartVertex->index],
+			      pGraph->reachComponent[pEndVertex->index]);
+      }
+   else if (!ensureCsr(pGraph,1))
+      {
+      printf("Allocation error in isReachable!\n");
+      retval = 0;
+      }
    else
       {
-      traverseBreadthFirst(pStartVertex,&emptyFunction);
-      /* if after a breadth first traversal, we didn't reach the 
-       * the end vertex, it is not reachable.
-       */
-      if (pEndVertex->color != BLACK)
-          retval = 0;
-
+      int from = pGraph->componentIds[pGraph->csrNumber[pStartVertex->index]];
+      int to = pGraph->componentIds[pGraph->csrNumber[pEndVertex->index]];
+      if (from > to)
+         {
+	 /* edges only go to components with higher numbers */
+	 retval = 0;
+         }
+      else if (from < to)
+         {
+	 retval = searchCondensed(pGraph,from,to);
+	 if (retval < 0)
+	    {
+	    printf("Allocation error in isReachable!\n");
+	    retval = 0;
+	    }
+         }
       }
    return retval;
 
@@ -741,100 +1397,224 @@ int isReachable(char* key1, char* key2)
 
 /* Print path to the end vertex passed as the argument.
  * This is called after doing a breadth-first search, which
- * will set the pFrom pointer on each vertex. To print
+ * will set the parent of each vertex found. To print
  * the path in the correct order, we put the items into
  * an array then read from the end.
  * Arguments
+ *    pGraph     - graph that was searched
+ *    pLocal     - storage used for the breadth-first search
  *    pEndVertex - end point of path we want to print. 
  */
-void printPath(VERTEX_T* pEndVertex)
+void printPath(GRAPH_T* pGraph, LOCAL_SEARCH_T* pLocal, VERTEX_T* pEndVertex)
 {
-    VERTEX_T** pathVertices = calloc(vertexCount,sizeof(VERTEX_T*));
-    /* this array is big enough to hold all the vertices we have */
+    /* the queue is free now, so use it to hold the path backwards */
+    int * path = pLocal->queue;
     int pathCount = 0;
-    if (pathVertices == NULL) 
+    int i = 0;
+    int current = pGraph->csrNumber[pEndVertex->index];
+    while (current >= 0)  /* traverse the parent links */
        {
-       printf("Allocation error in printPath!\n");
+       path[pathCount] = current;
+       pathCount++;
+       current = pLocal->parent[current];
        }
-    else
+    /* Now start at the end of the array to print the path */
+    for (i = pathCount-1; i >= 0; i--)
        {
-       int i = 0;
-       VERTEX_T * pCurrent = pEndVertex;
-       while (pCurrent != NULL)  /* traverse the pFrom links */
-	  {
-	  pathVertices[pathCount] = pCurrent;
-          pathCount++;
-          pCurrent = pCurrent->pFrom;
-          }
-       /* Now start at the end of the array to print the path */
-       for (i = pathCount-1; i >= 0; i--)
-	  {
-	  printf(" %s ",pathVertices[i]->key);
-          if (i > 0)
-	     printf("==>");
-          } 
-       printf("\n");
-       free(pathVertices);
-       }
+       printf(" %s ",pGraph->csrVertices[path[i]]->key);
+       if (i > 0)
+	  printf("==>");
+       } 
+    printf("\n");
 }
 
 /* Return information as to whether two vertices are
  * connected by a path. Also print the path if it
- * exists. We do this by keeping track of source vertices
- * as we do the breadth first traversal.
+ * exists. The breadth first search keeps track of
+ * the vertex we arrived from at each vertex.
  * Arguments
+ *    graph - Graph returned by newGraph
  *    key1 -  Key for the start vertex 
  *    key2 -  Key for the second vertex to check 
  * Returns 1 if the two vertices are connected, 0 if they
  * are not. Returns -1 if either vertex does not exist.
  */
-int isReachablePrintPath(char* key1, char* key2)
+int isReachablePrintPath(GRAPH_HANDLE graph, char* key1, char* key2)
 {
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
    int retval = 1;
    VERTEX_T * pDummy = NULL;
-   VERTEX_T * pAdjacent = NULL;
-   VERTEX_T * pStartVertex = findVertexByKey(key1,&pDummy);
-   VERTEX_T * pEndVertex = findVertexByKey(key2,&pDummy);
+   VERTEX_T * pStartVertex = findVertexByKey(pGraph,key1,&pDummy);
+   VERTEX_T * pEndVertex = findVertexByKey(pGraph,key2,&pDummy);
+   LOCAL_SEARCH_T * pLocal = NULL;
    if ((pStartVertex == NULL) || (pEndVertex == NULL))
       {
       retval = -1;
       }
+   else if ((!ensureCsr(pGraph,0)) ||
+	    ((pLocal = getLocalSearch(pGraph,pGraph->pCsr->vertexCount))
+	     == NULL))
+      {
+      printf("Allocation error in isReachablePrintPath!\n");
+      retval = 0;
+      }
    else
       {
-      queueClear();
-      colorAll(WHITE);
-      enqueue(pStartVertex);
-      while (queueSize() > 0)
-        {
-        VERTEX_T* pCurrent = (VERTEX_T*) dequeue();
-	if (pCurrent->color != BLACK)
-            {
-            pCurrent->color = BLACK;
-	    ADJACENT_T* pRef = pCurrent->adjacentHead;
-	    while (pRef != NULL)
-	      {
-	      pAdjacent = (VERTEX_T*) pRef->pVertex;
-	      if (pAdjacent->color != BLACK)
-		  {
-		  pAdjacent->pFrom = pCurrent;
-	          enqueue(pAdjacent);
-		  }
-	      pRef = pRef->next;
-	      }
-	    }
-	} /* end while queue has data */
-      if (pEndVertex->color != BLACK)
+      if (!searchLocal(pGraph->pCsr,pLocal,
+		       pGraph->csrNumber[pStartVertex->index],
+		       pGraph->csrNumber[pEndVertex->index]))
 	  { 
           retval = 0; 
           } 
       else
 	  {
 	  printf("Path from %s to %s:\n",pStartVertex->key,pEndVertex->key); 
-	  printPath(pEndVertex);
+	  printPath(pGraph,pLocal,pEndVertex);
           }
+      releaseLocalSearch(pGraph,pLocal);
       }
    return retval;
 
 }
 
- 
+
+/* Find the strongly connected components of a graph. For an
+ * undirected graph these are just its connected pieces.
+ * Arguments
+ *    graph         -  Graph returned by newGraph
+ *    pKeys         -  Used to return an array with the keys of all
+ *                     the vertices. The caller should free the
+ *                     array but not the keys.
+ *    pComponentIds -  Used to return an array with the component
+ *                     number of each of those vertices.
+ *                     The caller should free it.
+ *    pCount        -  Used to return the number of vertices
+ * Returns the number of components, or -1 if a memory allocation
+ * error occurs.
+ */
+int getStrongComponents(GRAPH_HANDLE graph, char*** pKeys,
+			int** pComponentIds, int* pCount)
+{
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   int count = pGraph->vertexCount;
+   int i = 0;
+   *pKeys = NULL;
+   *pComponentIds = NULL;
+   *pCount = 0;
+   if (!ensureCsr(pGraph,1))
+      return -1;
+   *pKeys = (char**) calloc(count + 1,sizeof(char*));
+   *pComponentIds = (int*) calloc(count + 1,sizeof(int));
+   if ((*pKeys == NULL) || (*pComponentIds == NULL))
+      {
+      free(*pKeys);
+      free(*pComponentIds);
+      *pKeys = NULL;
+      *pComponentIds = NULL;
+      return -1;
+      }
+   for (i = 0; i < count; i++)
+      {
+      (*pKeys)[i] = pGraph->csrVertices[i]->key;
+      (*pComponentIds)[i] = pGraph->componentIds[i];
+      }
+   *pCount = count;
+   return pGraph->componentCount;
+}
+
+
+/* Put the vertices of a directed graph in topological order.
+ * Arguments
+ *    graph      -  Graph returned by newGraph
+ *    pKeys      -  Used to return an array with the keys of the
+ *                  vertices in topological order. The caller should
+ *                  free the array but not the keys.
+ *    pCount     -  Used to return the number of vertices
+ * Returns 1 if successful, 0 if the graph has a cycle (in which case
+ * the array holds only the vertices that could be ordered), or -1
+ * if a memory allocation error occurs.
+ */
+int getTopologicalOrder(GRAPH_HANDLE graph, char*** pKeys, int* pCount)
+{
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   int count = pGraph->vertexCount;
+   int * order = NULL;
+   int i = 0;
+   *pKeys = NULL;
+   *pCount = 0;
+   if (!ensureCsr(pGraph,0))
+      return -1;
+   order = (int*) calloc(count + 1,sizeof(int));
+   *pKeys = (char**) calloc(count + 1,sizeof(char*));
+   if ((order == NULL) || (*pKeys == NULL) ||
+       ((*pCount = sortTopologically(pGraph->pCsr,order)) < 0))
+      {
+      free(order);
+      free(*pKeys);
+      *pKeys = NULL;
+      *pCount = 0;
+      return -1;
+      }
+   for (i = 0; i < *pCount; i++)
+      (*pKeys)[i] = pGraph->csrVertices[order[i]]->key;
+   free(order);
+   return (*pCount == count);
+}
+
+
+/* Get a copy of the condensed graph. Its vertices are the
+ * component numbers returned by getStrongComponents().
+ * Argument
+ *    graph      -  Graph returned by newGraph
+ * Returns the condensed graph, which should be freed with
+ * freeCondensedGraph(), or NULL if a memory allocation error occurs.
+ */
+BFS_GRAPH_T* getCondensedGraph(GRAPH_HANDLE graph)
+{
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   if (!ensureCsr(pGraph,1))
+      return NULL;
+   return condenseGraph(pGraph->pCsr,pGraph->componentIds,
+			pGraph->componentCount);
+}
+
+
+/* Build an index so that isReachable can answer without a search.
+ * The index has a bit for each pair of components in the
+ * condensed graph.
+ * Arguments
+ *    graph     - Graph returned by newGraph
+ *    maxBytes  - Largest index to build. If 0, any index is
+ *                freed and is not built again.
+ * Returns 1 if the index was built, 0 if it would take more than
+ * maxBytes, or -1 if a memory allocation error occurs.
+ */
+int buildReachabilityIndex(GRAPH_HANDLE graph, long maxBytes)
+{
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   int retval = 0;
+   pthread_mutex_lock(&pGraph->csrLock);
+   freeReach(pGraph);
+   pGraph->reachMaxBytes = (maxBytes > 0) ? maxBytes : 0;
+   if (pGraph->reachMaxBytes > 0)
+      retval = buildReach(pGraph);
+   pthread_mutex_unlock(&pGraph->csrLock);
+   return retval;
+}
+
+
+/* Find out how much memory the reachability index is using.
+ * Argument
+ *    graph     - Graph returned by newGraph
+ * Returns the number of bytes, or 0 if there is no index
+ * at the moment.
+ */
+long getReachabilityIndexSize(GRAPH_HANDLE graph)
+{
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   long bytes = 0;
+   pthread_mutex_lock(&pGraph->csrLock);
+   bytes = pGraph->reachBytes;
+   pthread_mutex_unlock(&pGraph->csrLock);
+   return bytes;
+}
@@ -1,131 +0,0 @@
-/*
- *   linkedListQueue.c 
- *
- *   Linked list implementation of an abstract queue
- *
- *  Copyright 2020 by Sally E. Goldin
- *
- *  May be freely copied and modified for educational purposes
- *  as long as this notice is retained in the header.
- *  Note this code is not intended for real-world applications.
- *
- */
-
-#include <stdlib.h>
-#include <stdio.h>
-#include "abstractQueue.h"
-
-
-/* Structure that represents one item of the list */
-typedef struct _listitem
-{
-    void* data;               /* Pointer to the data for this node */
-    struct _listitem * next;  /* Link to the next item in the list */
-} LISTITEM_T;
-
-static int count = 0;              /* number of items in the queue */
-static LISTITEM_T * head = NULL;   /* front item in the queue */
-static LISTITEM_T * tail = NULL;   /* end item in the queue */
-
-
-/**
- * Add a data item to the queue (end of the list)
- * Arguments:
- *   data      -   Pointer to generic data we want to add to queue   
- * Returns 1 if successful, 0 if we have run out of space.
- */
-int enqueue(void* data)
-{
-   int bOk = 1;
-   LISTITEM_T * newItem = (LISTITEM_T *)calloc(1,sizeof(LISTITEM_T));
-   if (newItem == NULL)
-       {
-       bOk = 0;
-       }
-   else
-       {
-       newItem->data = data;  /* store the data */
-       if (head == NULL)       /* nothing in the queue yet */
-          {
-	  head = newItem;      
-          }
-       else
-          {
-	  tail->next = newItem;  /* add to the end of the queue */ 
-          }
-       tail = newItem;         /* either way the new item is now the end */
-       count++;
-       }
-   return bOk;
-}
-
-
-/* Get the next item in the queue. This is the element 
- * at the front of the queue.
- * Returns the data stored at the front of the queue.
- * Also removes that item from the queue.
- * Returns NULL if the queue is empty.
- */
-void * dequeue()
-{
-   void * returnData = NULL;
-   if (count > 0)
-      {
-      LISTITEM_T * firstItem = head;
-      returnData = firstItem->data;
-      head = firstItem->next;
-      if (head == NULL)  /* if that was the last item on the queue */
-	  tail = NULL;
-      free(firstItem);
-      count--;
-      }
-   return returnData;
-}
-
-
-/* Find out how many items are currently in the queue.
- * Return number of items in the queue (could be zero)
- */
-int queueSize()
-{
-   return count;
-}
-
-
-/* Clear so we can reuse 
- */
-void queueClear()
-{
-    int i = 0;
-    LISTITEM_T * item = head;
-    LISTITEM_T * freeItem = NULL;
-    while (item != NULL)
-       {
-       freeItem = item;
-       item = item->next;
-       free(freeItem);
-       }
-    /* reset head, tail and count */
-    head = NULL;
-    tail = NULL;
-    count = 0;
-}
-
-
-/** DEBUGGING FUNCTION PRINTS SOME INFO ABOUT THE QUEUE **/
-void printDebug()
-{
-   int i, j;
-   printf("count = %d   head = %p  tail = %p\n",
-	  count, head, tail);
-   if (count > 0)
-      {
-      printf("Contents: \n");
-      LISTITEM_T * item = head;
-      while (item != NULL)
-        {
-	printf("\t\t%s\n", item->data);
-	item = item->next;
-	}
-      }
-}
@@ -7,6 +7,25 @@
  *  the graph. Every vertex has a void* pointer to ancillary data which
  *  is simply stored. 
  *
+ *  All the information about one graph is kept in a GRAPH_T
+ *  structure, and the handle returned by newGraph() points to it.
+ *  The marks used by traversals are kept in a separate array for
+ *  each traversal (TRAVERSAL_T), so traversals never change the
+ *  graph and several can run at once. A vertex is marked with the
+ *  number (epoch) of the traversal that saw it, so a new traversal
+ *  only has to move on to the next epoch rather than clear the
+ *  array, and the graph keeps one spare TRAVERSAL_T for reuse.
+ *
+ *  Depth first traversals are done by depthFirst.c, which keeps its
+ *  own stack instead of using recursion, so this module must be
+ *  linked with depthFirst.c.
+ *
+ *  buildReachabilityIndex() keeps the transitive closure of the matrix
+ *  as one bitset row per vertex, so isReachable() becomes a single bit
+ *  test. Adding a vertex or an edge updates the closure in place.
+ *  Removing one frees it, and the next isReachable() call builds it
+ *  again under a lock, so this module needs -lpthread.
+ *
  *  Copyright 2020 by Sally E. Goldin
  *
  *  May be freely copied and modified for educational purposes
@@ -17,15 +36,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <pthread.h>
 #include "abstractGraph.h"
-#include "abstractQueue.h"
+#include "depthFirst.h"
 
-#define WHITE 0
-#define GRAY  1
-#define BLACK 2
-
-char* colorName[] = {"WHITE", "GRAY", "BLACK"};
+#define WORD_BITS 64          /* bits in each word of a reachability row */
 
+/* test and set bit j of a bitset */
+#define TESTBIT(set,j)  (((set)[(j) / WORD_BITS] >> ((j) % WORD_BITS)) & 1)
+#define SETBIT(set,j)   ((set)[(j) / WORD_BITS] |= ((uint64_t) 1 << ((j) % WORD_BITS)))
 
 /* Structure for the main vertex list.*/
 typedef struct _vertex
@@ -33,37 +53,71 @@ typedef struct _vertex
     char * key;               /* key for this vertex */
     void * data;              /* ancillary data for this vertex */
     int index;                /* array index. Makes using the queue easier */
-    int color;                /* used to mark nodes as visited */
 }  VERTEX_T;
 
-VERTEX_T * vertices = NULL;   /* array of vertices. Will be allocated
-			       * in initGraph based on maximum passed in.
+/* Structure holding one graph */
+typedef struct
+{
+    VERTEX_T * vertices;      /* array of vertices. Will be allocated
+			       * in newGraph based on maximum passed in.
                                */ 
-int ** edges = NULL;          /* matrix (2D array) of edges. Will
-                               * be allocated in initGraph     */
-int maxVertices = 0;          /* set by initGraph */
-int bGraphDirected = 0;       /* if true, this is a directed graph */
-int vertexCount = 0;          /* keep track of the number of vertices */
+    int ** edges;             /* matrix (2D array) of edges. Will
+                               * be allocated in newGraph     */
+    int maxVertices;          /* set by newGraph */
+    int bGraphDirected;       /* if true, this is a directed graph */
+    int vertexCount;          /* keep track of the number of vertices */
                               /* updated in addVertex and removeVertex */
-int lastIndex = -1;          /* last item in array that is in use */
+    int lastIndex;            /* last item in array that is in use */
                               /* could be > than vertexCount if we have 
 			       * removed some vertices
                                */
+    uint64_t * reach;         /* reachability index, or NULL. Row i is
+                               * a bitset of the vertices i can reach
+                               */
+    int reachWords;           /* words in each row of the index */
+    long reachMaxBytes;       /* largest index to build, or 0 if
+                               * no index is wanted
+                               */
+    pthread_mutex_t reachLock; /* held while building the index */
+    void * pSpareTraversal;   /* storage for a traversal that no
+                               * traversal is using, or NULL
+                               */
+    pthread_mutex_t traversalLock; /* protects pSpareTraversal */
+} GRAPH_T;
+
+/* Working storage for one traversal, with an entry
+ * for each slot in the vertices array. A vertex has been
+ * seen by the current traversal if its mark equals the
+ * current epoch.
+ */
+typedef struct
+{
+    unsigned int epoch;       /* number of the current traversal */
+    unsigned int * mark;      /* epoch of the last traversal that
+                               * saw each vertex
+                               */
+    int * queue;              /* indices of vertices waiting for a
+                               * breadth first traversal to visit them
+                               */
+} TRAVERSAL_T;
+
 /** Private functions */
 
 /* Finds the vertex that holds the passed key
  * (if any) and returns a pointer to that vertex.
  * Arguments
+ *       pGraph -  Graph to search
  *       key    -  Key we are looking for
  * Returns index of vertex in the vertices array, or -1
  * if not found.       
  */
-int findVertexByKey(char* key) 
+int findVertexByKey(GRAPH_T* pGraph, char* key) 
 {
+    VERTEX_T * vertices = pGraph->vertices;
     int found = -1;
     int i = 0;
     /* loop through the array looking for the one we wnat */
-    for (i=0; (i <= lastIndex) && (found < 0); i++)
+    for (i=0; (i <= pGraph->lastIndex) && (found < 0); i++)
        {
        if ((vertices[i].key != NULL) && (strcmp(vertices[i].key,key) == 0))
           {
@@ -76,18 +130,20 @@ int findVertexByKey(char* key)
 /* Finds the first unused slot in the vertices array.
  * This may be a slot make available by a 'remove', or
  * the slot after the current 'lastIndex'
+ * Argument
+ *    pGraph  - Graph we want to add to
  * Returns the first available index or -1 if array is full.
  * Updates lastIndex as a side effect if it returns lastIndex+1
  */
-int findFirstUnused()
+int findFirstUnused(GRAPH_T* pGraph)
 {
     int i = 0;
     int returnidx = -1;
-    if (vertexCount < maxVertices)
+    if (pGraph->vertexCount < pGraph->maxVertices)
       {
-      for (i=0; i <= lastIndex; i++)
+      for (i=0; i <= pGraph->lastIndex; i++)
 	 {
-	 if (vertices[i].key == NULL) 
+	 if (pGraph->vertices[i].key == NULL) 
 	    {
 	    returnidx = i;
             break;
@@ -95,107 +151,209 @@ int findFirstUnused()
          }
       if (returnidx == -1) /* no slots in the middle of the array */
 	 {
-	 lastIndex++;
-         returnidx = lastIndex;
+	 pGraph->lastIndex++;
+         returnidx = pGraph->lastIndex;
          }
       }
     return returnidx;
 }
 
 /* Count adjacent vertices to a vertex.
- * Argument
+ * Arguments
+ *    pGraph        -   Graph the vertex belongs to
  *    whichVertex   -   Index of vertex whose adjacent nodes we want to count
  * Returns integer value for count (could be zero)
  */
-int countAdjacent(int whichVertex)
+int countAdjacent(GRAPH_T* pGraph, int whichVertex)
 {
     int count = 0;
     int i = 0;
-    for (i = 0; i <= lastIndex; i++) 
+    for (i = 0; i <= pGraph->lastIndex; i++) 
        {
-       if ((vertices[i].key != NULL) && (edges[whichVertex][i] > 0))
+       if ((pGraph->vertices[i].key != NULL) &&
+	   (pGraph->edges[whichVertex][i] > 0))
            count += 1;
        }
     return count;
 }
 
-/* Set all vertices to the passed color.
+/* Free the memory used by a traversal.
  * Argument
- *    A color constant
- * 12 Mar 2015 Also set pFrom to NULL
+ *    pTraversal  - Traversal to free (may be NULL)
  */
-void colorAll(int color)
+void freeTraversal(TRAVERSAL_T* pTraversal)
 {
-    int i = 0;
-    for (i = 0; i <= lastIndex; i++)
+    if (pTraversal != NULL)
+       {
+       free(pTraversal->mark);
+       free(pTraversal->queue);
+       free(pTraversal);
+       }
+}
+
+/* Get the working storage for one traversal of a graph, and
+ * start a new epoch in it so that no vertex has been seen.
+ * Uses the graph's spare storage if no other traversal has it,
+ * so usually nothing needs to be allocated or cleared.
+ * Argument
+ *    pGraph  - Graph we are going to traverse
+ * Returns the traversal, or NULL if a memory allocation
+ * error occurs.
+ */
+TRAVERSAL_T* getTraversal(GRAPH_T* pGraph)
+{
+    TRAVERSAL_T* pTraversal = NULL;
+    pthread_mutex_lock(&pGraph->traversalLock);
+    pTraversal = (TRAVERSAL_T*) pGraph->pSpareTraversal;
+    pGraph->pSpareTraversal = NULL;
+    pthread_mutex_unlock(&pGraph->traversalLock);
+    if (pTraversal == NULL)
+       {
+       pTraversal = (TRAVERSAL_T*) calloc(1,sizeof(TRAVERSAL_T));
+       if (pTraversal != NULL)
+          {
+	  pTraversal->mark = (unsigned int*) calloc(pGraph->maxVertices,
+						    sizeof(unsigned int));
+	  pTraversal->queue = (int*) calloc(pGraph->maxVertices,sizeof(int));
+	  if ((pTraversal->mark == NULL) || (pTraversal->queue == NULL))
+	     {
+	     freeTraversal(pTraversal);
+	     return NULL;
+	     }
+          }
+       }
+    if (pTraversal != NULL)
+       {
+       pTraversal->epoch++;
+       if (pTraversal->epoch == 0)
+          {
+	  /* the epoch has wrapped around, so old marks could
+	   * look current; clear them once */
+	  memset(pTraversal->mark,0,
+		 pGraph->maxVertices * sizeof(unsigned int));
+	  pTraversal->epoch = 1;
+          }
+       }
+    return pTraversal;
+}
+
+/* Give back the working storage for a traversal, keeping
+ * it as the graph's spare if there is none.
+ * Arguments
+ *    pGraph     - Graph that was traversed
+ *    pTraversal - Storage returned by getTraversal
+ */
+void releaseTraversal(GRAPH_T* pGraph, TRAVERSAL_T* pTraversal)
+{
+    pthread_mutex_lock(&pGraph->traversalLock);
+    if (pGraph->pSpareTraversal == NULL)
        {
-       vertices[i].color = color;
+       pGraph->pSpareTraversal = pTraversal;
+       pTraversal = NULL;
        }
+    pthread_mutex_unlock(&pGraph->traversalLock);
+    freeTraversal(pTraversal);
 }
 
 /* Execute a breadth first search from a vertex,
  * calling the function (*vFunction) on each vertex
- * as we visit it and color it black.
+ * as we visit it.
+ * A vertex is marked as seen when it goes into the queue,
+ * so it is never queued twice and the queue needs at most
+ * one slot per vertex.
  * Arguments
- *    vIndex  - Index of the starting vertex
+ *    pGraph     - Graph to traverse
+ *    pTraversal - Working storage from getTraversal
+ *    vIndex     - Index of the starting vertex
+ *    endIndex   - If not -1, stop as soon as this vertex is seen
+ *    vFunction  - Function to call for each vertex, or NULL
  */
-void traverseBreadthFirst(int vIndex, void (*vFunction)(VERTEX_T*))
+void traverseBreadthFirst(GRAPH_T* pGraph, TRAVERSAL_T* pTraversal,
+			  int vIndex, int endIndex,
+			  void (*vFunction)(VERTEX_T*))
 {
-    queueClear();
-    colorAll(WHITE);
-    int adjacentIndex = -1;
+    unsigned int * mark = pTraversal->mark;
+    unsigned int epoch = pTraversal->epoch;
+    int * queue = pTraversal->queue;
+    int head = 0;
+    int tail = 0;
+    int current = -1;
     int i = 0;
-    VERTEX_T * pCurrent = NULL;
-    VERTEX_T * pAdjacent = NULL;
-    enqueue(&vertices[vIndex]);   /* Our queue requires pointers as data */
-    while (queueSize() > 0)
+    queue[tail++] = vIndex;
+    mark[vIndex] = epoch;
+    while ((head < tail) && ((endIndex < 0) || (mark[endIndex] != epoch)))
         {
-        pCurrent = (VERTEX_T*) dequeue();
-        if (pCurrent->color != BLACK)
-           {
-           (*vFunction)(pCurrent);
-            pCurrent->color = BLACK;
-            for (i = 0; i <= lastIndex; i++)  
-               {
-	       /* if there is an edge from current to this vertex */
-               if ((vertices[i].key != NULL) && (edges[pCurrent->index][i] > 0))
-		  {  
-		  pAdjacent = &vertices[i];
-	          if (pAdjacent->color != BLACK)
-	             {
-		     enqueue(pAdjacent);
-	             }
-		  } /* end if */
-	       } /* end for */
-	  }
+        current = queue[head++];
+	if (vFunction != NULL)
+	   (*vFunction)(&pGraph->vertices[current]);
+        for (i = 0; i <= pGraph->lastIndex; i++)  
+            {
+	    /* if there is an edge from current to this vertex */
+            if ((pGraph->vertices[i].key != NULL) &&
+		(pGraph->edges[current][i] > 0) &&
+		(mark[i] != epoch))
+	       {  
+	       mark[i] = epoch;
+	       queue[tail++] = i;
+	       } /* end if */
+	    } /* end for */
        } /* end while queue has data */
 }
 
 
-/* Execute a depth first search from a single vertex,
- * calling the function (*vFunction) on the lowest level
- * vertex we visit, and coloring it black.
+/* Find the first vertex adjacent to a vertex, starting
+ * from the cursor's column.
  * Arguments
- *    vIndex  - Index of the starting vertex
+ *    pGraph     - Graph to look in
+ *    vIndex     - Index of the vertex
+ *    pCursor    - Column to start at; set to the column found
+ * Returns the index of the adjacent vertex, or -1 if there
+ * are no more.
  */
-void traverseDepthFirst(int vIndex, void (*vFunction)(VERTEX_T*))
+int scanAdjacent(GRAPH_T* pGraph, int vIndex, DFS_CURSOR_T* pCursor)
 {
-    VERTEX_T * pAdjacent = NULL;    
-    int i = 0;
-    for (i = 0; i <= lastIndex; i++)  
+    int * row = pGraph->edges[vIndex];
+    long i = 0;
+    for (i = pCursor->position; i <= pGraph->lastIndex; i++)
         {
-        /* if there is an edge from current to this vertex */
-        if ((vertices[i].key != NULL) && (edges[vIndex][i] > 0))
-	   { 
-           if (vertices[i].color == WHITE)
-	       {
-	       vertices[i].color = GRAY;
-               traverseDepthFirst(i,vFunction);
-               }
-	   } /* end if this index is adjacent to vertex at vIndex*/
-	} /* end looking at the adjacents */
-    (*vFunction)(&vertices[vIndex]);
-    vertices[vIndex].color = BLACK;
+        /* if there is an edge from vIndex to this vertex */
+        if ((pGraph->vertices[i].key != NULL) && (row[i] > 0))
+	   {
+	   pCursor->position = i;
+	   return (int) i;
+	   }
+	}
+    pCursor->position = i;
+    return -1;
+}
+
+/* Start looking through the vertices adjacent to a vertex.
+ * Used by the depth first search engine.
+ * Arguments
+ *    pGraph     - Graph to look in (will be cast to GRAPH_T*)
+ *    vIndex     - Index of the vertex
+ *    pCursor    - Set to the column of the first adjacent vertex
+ * Returns the index of the first adjacent vertex, or -1.
+ */
+int firstAdjacent(void* pGraph, int vIndex, DFS_CURSOR_T* pCursor)
+{
+    pCursor->position = 0;
+    return scanAdjacent((GRAPH_T*) pGraph,vIndex,pCursor);
+}
+
+/* Move on to the next vertex adjacent to a vertex.
+ * Used by the depth first search engine.
+ * Arguments
+ *    pGraph     - Graph to look in (will be cast to GRAPH_T*)
+ *    vIndex     - Index of the vertex
+ *    pCursor    - Column of the current adjacent vertex;
+ *                 moved to the next one
+ * Returns the index of the next adjacent vertex, or -1.
+ */
+int nextAdjacent(void* pGraph, int vIndex, DFS_CURSOR_T* pCursor)
+{
+    pCursor->position++;
+    return scanAdjacent((GRAPH_T*) pGraph,vIndex,pCursor);
 }
 
 
@@ -209,76 +367,194 @@ void printVertexInfo(VERTEX_T* pVertex)
 	   pVertex->key, pVertex->data);
 }
 
+/* Work out how much memory the reachability index of a graph
+ * needs, with one row of bits for each slot in the vertices array.
+ * Argument
+ *    pGraph  - Graph we want an index for
+ * Returns the number of bytes.
+ */
+long reachBytes(GRAPH_T* pGraph)
+{
+    return (long) pGraph->maxVertices * pGraph->reachWords * sizeof(uint64_t);
+}
+
+/* Free the reachability index of a graph, if it has one.
+ * Argument
+ *    pGraph  - Graph whose index we are freeing
+ */
+void freeReach(GRAPH_T* pGraph)
+{
+    free(pGraph->reach);
+    pGraph->reach = NULL;
+}
+
+/* OR the row of one vertex into the rows of all the vertices
+ * that can reach another vertex. Used to build the index, and to
+ * keep it up to date when an edge is added.
+ * Arguments
+ *    pGraph  - Graph whose index we are changing
+ *    from    - Index of the vertex whose reachers we update
+ *    to      - Index of the vertex whose row we add to theirs
+ */
+void spreadReach(GRAPH_T* pGraph, int from, int to)
+{
+    int words = pGraph->lastIndex / WORD_BITS + 1;
+    uint64_t * toRow = pGraph->reach + (size_t) to * pGraph->reachWords;
+    int i = 0;
+    int w = 0;
+    for (i = 0; i <= pGraph->lastIndex; i++)
+       {
+       uint64_t * row = pGraph->reach + (size_t) i * pGraph->reachWords;
+       if (TESTBIT(row,from))
+          {
+	  for (w = 0; w < words; w++)
+	     row[w] |= toRow[w];
+          }
+       }
+}
+
+/* Build the reachability index, a transitive closure of the
+ * matrix. Each vertex reaches itself and its adjacent vertices;
+ * then, for each vertex k in turn, anything that reaches k also
+ * reaches everything k reaches (Warshall's algorithm), 64 columns
+ * at a time. The caller must hold the index lock.
+ * Argument
+ *    pGraph  - Graph that does not have an index
+ * Returns 1 if successful, 0 if the index would take more than
+ * reachMaxBytes, or -1 for a memory allocation error.
+ */
+int buildReach(GRAPH_T* pGraph)
+{
+    int i = 0;
+    int j = 0;
+    if (reachBytes(pGraph) > pGraph->reachMaxBytes)
+       return 0;
+    pGraph->reach = (uint64_t*) calloc((size_t) pGraph->maxVertices *
+				       pGraph->reachWords,sizeof(uint64_t));
+    if (pGraph->reach == NULL)
+       return -1;
+    for (i = 0; i <= pGraph->lastIndex; i++)
+       {
+       uint64_t * row = pGraph->reach + (size_t) i * pGraph->reachWords;
+       if (pGraph->vertices[i].key == NULL)
+	  continue;
+       SETBIT(row,i);
+       for (j = 0; j <= pGraph->lastIndex; j++)
+          {
+	  if ((pGraph->vertices[j].key != NULL) && (pGraph->edges[i][j] > 0))
+	     SETBIT(row,j);
+          }
+       }
+    for (i = 0; i <= pGraph->lastIndex; i++)
+       {
+       if (pGraph->vertices[i].key != NULL)
+	  spreadReach(pGraph,i,i);
+       }
+    return 1;
+}
+
+/* Get the reachability index of a graph, building it again
+ * if it is wanted but out of date.
+ * Argument
+ *    pGraph  - Graph we are going to check
+ * Returns the index, or NULL if there is none.
+ */
+uint64_t* ensureReach(GRAPH_T* pGraph)
+{
+    uint64_t * reach = NULL;
+    pthread_mutex_lock(&pGraph->reachLock);
+    if ((pGraph->reach == NULL) && (pGraph->reachMaxBytes > 0))
+       buildReach(pGraph);
+    reach = pGraph->reach;
+    pthread_mutex_unlock(&pGraph->reachLock);
+    return reach;
+}
+
 
 /********************************/
 /** Public functions start here */
 /********************************/
 
-/* Initialize or reintialize the graph.
+/* Create a new, empty graph.
  * Argument 
- *    max          - how many vertices can this graph
+ *    maxVertices  - how many vertices can this graph
  *                   handle.
  *    bDirected    - If true this is a directed graph.
  *                   Otherwise undirected.
- * Returns 1 unless there is a memory allocation error,
- * in which case it returns zero.
+ * Returns a handle for the graph, or NULL if there is a
+ * memory allocation error.
  */
-int initGraph(int max, int bDirected)
+GRAPH_HANDLE newGraph(int maxVertices, int bDirected)
 { 
-    int returnval = 1;
-    clearGraph();
-    bGraphDirected = bDirected;
-    maxVertices = max;
+    int bOk = 1;
+    GRAPH_T * pGraph = (GRAPH_T*) calloc(1,sizeof(GRAPH_T));
+    if (pGraph == NULL)
+       return NULL;
+    pGraph->bGraphDirected = bDirected;
+    pGraph->maxVertices = maxVertices;
+    pGraph->lastIndex = -1;
+    pGraph->reachWords = (maxVertices + WORD_BITS - 1) / WORD_BITS;
+    pthread_mutex_init(&pGraph->reachLock,NULL);
+    pthread_mutex_init(&pGraph->traversalLock,NULL);
     /* do the memory allocation */
-    vertices = (VERTEX_T*) calloc(maxVertices,sizeof(VERTEX_T));
-    if (vertices != NULL)
-         {
-	 int i = 0;
-         /* allocate an array of rows */
-	 edges = (int **) calloc(max,sizeof(int*));
-         if (edges == NULL)
-	     returnval = 0; 
-         for (i=0; (i < max) && (returnval); i++)
-             {
-	     /* allocate each row */ 
-	     edges[i] = (int*) calloc(max,sizeof(int));
-	     if (edges[i] == NULL)
-	         returnval = 0; 
-             /* if any allocation fails, we'll stop the loop */
-             }   
-	 }
+    pGraph->vertices = (VERTEX_T*) calloc(maxVertices,sizeof(VERTEX_T));
+    /* allocate an array of rows */
+    pGraph->edges = (int **) calloc(maxVertices,sizeof(int*));
+    if ((pGraph->vertices == NULL) || (pGraph->edges == NULL))
+       {
+       bOk = 0; 
+       }
     else
-         {
-	 returnval = 0;
-         }
-    return returnval;  
+       {
+       int i = 0;
+       for (i=0; (i < maxVertices) && (bOk); i++)
+          {
+	  /* allocate each row */ 
+	  pGraph->edges[i] = (int*) calloc(maxVertices,sizeof(int));
+	  if (pGraph->edges[i] == NULL)
+	      bOk = 0; 
+          /* if any allocation fails, we'll stop the loop */
+          }   
+       }
+    if (!bOk)
+       {
+       graphDestroy(pGraph);
+       pGraph = NULL;
+       }
+    return (GRAPH_HANDLE) pGraph;  
 }
 
 
-/* Free all memory associated with the graph and
- * reset all parameters.
+/* Free all memory associated with the graph. Does not
+ * free the data stored with the vertices.
+ * Arguments
+ *    graph  -  Graph to free. Not valid after this call.
  */
-void clearGraph()
+void graphDestroy(GRAPH_HANDLE graph)
 {
+    GRAPH_T * pGraph = (GRAPH_T*) graph;
     int i;
-    for (i = 0; i < maxVertices; i++)
+    if (pGraph == NULL)
+       return;
+    for (i = 0; i < pGraph->maxVertices; i++)
        {
-       if (vertices[i].key != NULL)
-	  free(vertices[i].key);  /* because it was strduped */
-       free(edges[i]);
+       if ((pGraph->vertices != NULL) && (pGraph->vertices[i].key != NULL))
+	  free(pGraph->vertices[i].key);  /* because it was strduped */
+       if (pGraph->edges != NULL)
+          free(pGraph->edges[i]);
        }
-    free(vertices);
-    vertices = NULL;
-    free(edges);
-    edges = NULL;
-    bGraphDirected = 0;
-    maxVertices = 0;
-    lastIndex = -1;
-    vertexCount = 0;
+    free(pGraph->vertices);
+    free(pGraph->edges);
+    freeReach(pGraph);
+    freeTraversal((TRAVERSAL_T*) pGraph->pSpareTraversal);
+    pthread_mutex_destroy(&pGraph->reachLock);
+    pthread_mutex_destroy(&pGraph->traversalLock);
+    free(pGraph);
 }
 
 /* Add a vertex into the graph.
  * Arguments
+ *     graph -   Graph returned by newGraph
  *     key   -   Key value or label for the 
  *               vertex
  *     pData -   Additional information that can
@@ -290,10 +566,11 @@ void clearGraph()
  * to add a vertex with a key that matches a vertex
  * already in the graph.
  */
-int addVertex(char* key, void* pData)
+int addVertex(GRAPH_HANDLE graph, char* key, void* pData)
 {
+    GRAPH_T * pGraph = (GRAPH_T*) graph;
     int retval = 1;
-    int location  = findVertexByKey(key);
+    int location  = findVertexByKey(pGraph,key);
     if (location >=0)  /* key is already in the graph */
        {
        retval = -1;
@@ -307,15 +584,22 @@ int addVertex(char* key, void* pData)
 	  }
        else
           {
-	  int newloc = findFirstUnused();
+	  int newloc = findFirstUnused(pGraph);
           if (newloc < 0)
+	     {
+	     free(pKeyval);
 	     retval = 0;  /* graph is full */
+	     }
 	  else
 	     {
-	     vertices[newloc].key = pKeyval;
-	     vertices[newloc].data = pData;
-             vertices[newloc].index = newloc;
-	     vertexCount++; 
+	     pGraph->vertices[newloc].key = pKeyval;
+	     pGraph->vertices[newloc].data = pData;
+             pGraph->vertices[newloc].index = newloc;
+	     pGraph->vertexCount++; 
+	     /* a new vertex only reaches itself */
+	     if (pGraph->reach != NULL)
+		SETBIT(pGraph->reach + (size_t) newloc * pGraph->reachWords,
+		       newloc);
 	     }
 	  }
        }
@@ -325,17 +609,20 @@ int addVertex(char* key, void* pData)
 
 /* Remove a vertex from the graph.
  * Arguments
+ *     graph -   Graph returned by newGraph
  *     key   -   Key value or label for the 
  *               vertex to remove
  * Returns a pointer to the data stored at that
  * vertex, or NULL if the vertex could not be 
  * found.
  */
-void* removeVertex(char* key)
+void* removeVertex(GRAPH_HANDLE graph, char* key)
 {
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   VERTEX_T * vertices = pGraph->vertices;
    int i;
    void * pData = NULL; /* data to return */
-   int idx = findVertexByKey(key);
+   int idx = findVertexByKey(pGraph,key);
    if (idx >= 0)
       {
       free(vertices[idx].key);
@@ -343,17 +630,18 @@ void* removeVertex(char* key)
       pData = vertices[idx].data;
       vertices[idx].data = NULL;
       vertices[idx].index = -1;
-      vertexCount--; 
-      if (idx == lastIndex)
-	 lastIndex--;
+      pGraph->vertexCount--; 
+      if (idx == pGraph->lastIndex)
+	 pGraph->lastIndex--;
       /* now remove any edges where this vertex
          is either the start or the end vertex
        */
-      for (i=0; i < maxVertices; i++)
+      for (i=0; i < pGraph->maxVertices; i++)
 	  {
-	  edges[idx][i] = 0; 
-          edges[i][idx] = 0;
+	  pGraph->edges[idx][i] = 0; 
+          pGraph->edges[i][idx] = 0;
           }        
+      freeReach(pGraph);
       } 
    return pData;
 }
@@ -361,6 +649,7 @@ void* removeVertex(char* key)
 
 /* Add an edge between two vertices
  * Arguments
+ *    graph -  Graph returned by newGraph
  *    key1  -  Key for the first vertex in the edge
  *    key2  -  Key for the second vertex
  * Returns 1 if successful, 0 if failed due to
@@ -368,11 +657,13 @@ void* removeVertex(char* key)
  * is not found. Returns -1 if an edge already
  * exists in this direction.
  */
-int addEdge(char* key1, char* key2)
+int addEdge(GRAPH_HANDLE graph, char* key1, char* key2)
 {
+    GRAPH_T * pGraph = (GRAPH_T*) graph;
+    int ** edges = pGraph->edges;
     int retval = 1;
-    int fromidx = findVertexByKey(key1);
-    int toidx = findVertexByKey(key2);
+    int fromidx = findVertexByKey(pGraph,key1);
+    int toidx = findVertexByKey(pGraph,key2);
     if ((fromidx <0) || (toidx < 0))
        {
        retval = 0;
@@ -385,8 +676,16 @@ int addEdge(char* key1, char* key2)
        {
        edges[fromidx][toidx] = 1;	 
        /* If undirected, add an edge in the other direction */
-       if ((retval) && (!bGraphDirected))
+       if ((retval) && (!pGraph->bGraphDirected))
            edges[toidx][fromidx] = 1;	 
+       /* anything that reaches the first vertex can now reach
+	* everything the second one reaches */
+       if (pGraph->reach != NULL)
+          {
+	  spreadReach(pGraph,fromidx,toidx);
+	  if (!pGraph->bGraphDirected)
+	     spreadReach(pGraph,toidx,fromidx);
+          }
        } 
     return retval;
 }
@@ -394,17 +693,20 @@ int addEdge(char* key1, char* key2)
 
 /* Remove an edge between two vertices
  * Arguments
+ *    graph -  Graph returned by newGraph
  *    key1  -  Key for the first vertex in the edge
  *    key2  -  Key for the second vertex
  * Returns 1 if successful, 0 if failed 
  * because either vertex is not found or there
  * is no edge between these items.
  */
-int removeEdge(char* key1, char* key2)
+int removeEdge(GRAPH_HANDLE graph, char* key1, char* key2)
 {
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   int ** edges = pGraph->edges;
    int bOk = 1;
-   int fromidx = findVertexByKey(key1);
-   int toidx = findVertexByKey(key2);
+   int fromidx = findVertexByKey(pGraph,key1);
+   int toidx = findVertexByKey(pGraph,key2);
    if ((fromidx < 0) || (toidx < 0))
        {
        bOk = 0;
@@ -417,26 +719,28 @@ int removeEdge(char* key1, char* key2)
        {
        edges[fromidx][toidx] = 0;	 
        /* If undirected, remove edge in the other direction */
-       if (!bGraphDirected)
+       if (!pGraph->bGraphDirected)
            edges[toidx][fromidx] = 0;	 
- 
+       freeReach(pGraph);
        }
    return bOk;
 }
 
 /* Find a vertex and return its data
  * Arguments
+ *    graph -  Graph returned by newGraph
  *    key  -  Key for the vertex to find
  * Returns the data for the vertex or NULL
  * if not found.
  */
-void* findVertex(char* key)
+void* findVertex(GRAPH_HANDLE graph, char* key)
 {
+    GRAPH_T * pGraph = (GRAPH_T*) graph;
     void* pData = NULL;
-    int index = findVertexByKey(key);
+    int index = findVertexByKey(pGraph,key);
     if (index >= 0)
        {
-       pData = vertices[index].data;
+       pData = pGraph->vertices[index].data;
        }
     return pData; 
 }
@@ -448,19 +752,22 @@ void* findVertex(char* key)
  * contents should be freed by the caller when it 
  * is no longer needed.
  * Arguments
+ *    graph -  Graph returned by newGraph
  *    key   -  Key for the node whose adjacents we want
  *    pCount - Return number of elements in the array
  * Returns array of char* which are the keys of adjacent
  * nodes. Returns number of adjacent vertices in pCount.
  * If pCount holds -1, the vertex does not exist.
  */
-char** getAdjacentVertices(char* key, int* pCount)
+char** getAdjacentVertices(GRAPH_HANDLE graph, char* key, int* pCount)
 {
+    GRAPH_T * pGraph = (GRAPH_T*) graph;
+    VERTEX_T * vertices = pGraph->vertices;
     char** keyArray = NULL;
-    int foundidx = findVertexByKey(key);
+    int foundidx = findVertexByKey(pGraph,key);
     if (foundidx >=0)
        {
-       *pCount = countAdjacent(foundidx);
+       *pCount = countAdjacent(pGraph,foundidx);
        if (*pCount > 0)
           {
 	  int dest = 0;
@@ -468,9 +775,10 @@ char** getAdjacentVertices(char* key, int* pCount)
 	  keyArray = (char**) calloc(*pCount, sizeof(char*));
           if (keyArray != NULL)
 	     {
-	     for (i = 0; i <= lastIndex; i++)
+	     for (i = 0; i <= pGraph->lastIndex; i++)
 	        {
-		if ((edges[foundidx][i] > 0) && (vertices[i].key != NULL))
+		if ((pGraph->edges[foundidx][i] > 0) &&
+		    (vertices[i].key != NULL))
 		    {
 		    keyArray[dest] = strdup(vertices[i].key);
 		    dest += 1;
@@ -490,93 +798,131 @@ char** getAdjacentVertices(char* key, int* pCount)
 /* Print out all the nodes reachable from a node by a 
  * breadth-first search.
  * Arguments
+ *   graph      -  Graph returned by newGraph
  *   startKey   -  Key for start vertex
  * Returns 1 if successful, -1 if the vertex does not exist.
  */
-int printBreadthFirst(char* startKey)
+int printBreadthFirst(GRAPH_HANDLE graph, char* startKey)
 {
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
    int retval = 1;
-   if (vertexCount == 0)
+   TRAVERSAL_T * pTraversal = NULL;
+   if (pGraph->vertexCount == 0)
       {
       printf("The graph is empty\n");
       }
-   int foundidx = findVertexByKey(startKey);
+   int foundidx = findVertexByKey(pGraph,startKey);
    if (foundidx < 0)
       {
       printf("Vertex |%s| does not exist\n", startKey);
       retval = -1;
       }
+   else if ((pTraversal = getTraversal(pGraph)) == NULL)
+      {
+      printf("Allocation error in printBreadthFirst!\n");
+      }
    else
       {
-      traverseBreadthFirst(foundidx,&printVertexInfo);
+      traverseBreadthFirst(pGraph,pTraversal,foundidx,-1,&printVertexInfo);
+      releaseTraversal(pGraph,pTraversal);
       }
    return retval;
 }
 
 /* Print out all the nodes by a depth-first search.
+ * Each vertex is printed after all the vertices below it.
+ * Arguments
+ *    graph  -  Graph returned by newGraph
  */
-void printDepthFirst()
+void printDepthFirst(GRAPH_HANDLE graph)
 {
-   if (vertexCount == 0)
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   DFS_HANDLE search = NULL;
+   if (pGraph->vertexCount == 0)
       {
       printf("The graph is empty\n");
       }
+   else if ((search = newDepthFirst(pGraph->lastIndex + 1)) == NULL)
+      {
+      printf("Allocation error in printDepthFirst!\n");
+      }
    else
       {
+      DFS_GRAPH_T dfsGraph;
+      int * postOrder = NULL;
+      int postCount = 0;
+      int printed = 0;
       int i = 0;
-      colorAll(WHITE);
-      for (i = 0; i <= lastIndex; i++)
+      dfsGraph.pGraph = pGraph;
+      dfsGraph.vertexCount = pGraph->lastIndex + 1;
+      dfsGraph.firstAdjacent = &firstAdjacent;
+      dfsGraph.nextAdjacent = &nextAdjacent;
+      for (i = 0; i <= pGraph->lastIndex; i++)
          {
-	 if ((vertices[i].key != NULL) && 
-	     (vertices[i].color == WHITE))
+	 if ((pGraph->vertices[i].key != NULL) && 
+	     (depthFirstDiscovery(search,i) < 0))
 	    {
 	    printf("\nStarting new traversal from |%s|\n",
-                   vertices[i].key);
-	    vertices[i].color = GRAY;
-            traverseDepthFirst(i,&printVertexInfo);
+                   pGraph->vertices[i].key);
+	    if (depthFirstVisit(search,&dfsGraph,i) < 0)
+	       {
+	       printf("Allocation error in printDepthFirst!\n");
+	       break;
+	       }
+	    postOrder = depthFirstPostOrder(search,&postCount);
+	    while (printed < postCount)
+	       {
+	       printVertexInfo(&pGraph->vertices[postOrder[printed]]);
+	       printed++;
+	       }
 	    }
 	 }
+      depthFirstDestroy(search);
       }
 }
 
 /**/
 
-/* No-op function allows us to traverse without
- * doing anything other than setting colors
- * Argument  
- *   pVertex   -   vertex - will be ignored
- */
-void emptyFunction(VERTEX_T* pVertex)
-{
-}
-
-
 /* Return information as to whether two vertices are
  * connected by a path.
  * Arguments
+ *    graph - Graph returned by newGraph
  *    key1 -  Key for the start vertex 
  *    key2 -  Key for the second vertex to check 
  * Returns 1 if the two vertices are connected, 0 if they
  * are not. Returns -1 if either vertex does not exist.
  */
-int isReachable(char* key1, char* key2)
+int isReachable(GRAPH_HANDLE graph, char* key1, char* key2)
 {
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
    int retval = 1;
-   int startindex = findVertexByKey(key1);
-   int endindex = findVertexByKey(key2);
+   int startindex = findVertexByKey(pGraph,key1);
+   int endindex = findVertexByKey(pGraph,key2);
+   TRAVERSAL_T * pTraversal = NULL;
+   uint64_t * reach = NULL;
    if ((startindex < 0) || (endindex < 0))
       {
       retval = -1;
       }
+   else if ((reach = ensureReach(pGraph)) != NULL)
+      {
+      retval = TESTBIT(reach + (size_t) startindex * pGraph->reachWords,
+		       endindex);
+      }
+   else if ((pTraversal = getTraversal(pGraph)) == NULL)
+      {
+      printf("Allocation error in isReachable!\n");
+      retval = 0;
+      }
    else
       {
-      traverseBreadthFirst(startindex,&emptyFunction);
-      /* if after a breadth first traversal, we didn't reach the 
-       * the end vertex, it is not reachable.
+      /* the search stops as soon as it sees the end vertex;
+       * if it never does, the end vertex is not reachable.
        */
-      if (vertices[endindex].color != BLACK)
+      traverseBreadthFirst(pGraph,pTraversal,startindex,endindex,NULL);
+      if (pTraversal->mark[endindex] != pTraversal->epoch)
           retval = 0;
-
+      releaseTraversal(pGraph,pTraversal);
       }
    return retval;
 
@@ -587,15 +933,57 @@ int isReachable(char* key1, char* key2)
  * exists. We do this by keeping track of source vertices
  * as we do the breadth first traversal.
  * Arguments
+ *    graph - Graph returned by newGraph
  *    key1 -  Key for the start vertex 
  *    key2 -  Key for the second vertex to check 
  * Returns 1 if the two vertices are connected, 0 if they
  * are not. Returns -1 if either vertex does not exist.
  */
-int isReachablePrintPath(char* key1, char* key2)
+int isReachablePrintPath(GRAPH_HANDLE graph, char* key1, char* key2)
 {
    printf("Path printing not implemented!\n");
-   return isReachable(key1,key2);
+   return isReachable(graph,key1,key2);
+}
+
+
+/* Build an index so that isReachable can answer without a search.
+ * The index is the transitive closure of the matrix, one bit for
+ * each pair of vertex slots. Adding a vertex or an edge updates
+ * it; removing one means it must be built again.
+ * Arguments
+ *    graph     - Graph returned by newGraph
+ *    maxBytes  - Largest index to build. If 0, any index is
+ *                freed and is not built again.
+ * Returns 1 if the index was built, 0 if it would take more than
+ * maxBytes, or -1 if a memory allocation error occurs.
+ */
+int buildReachabilityIndex(GRAPH_HANDLE graph, long maxBytes)
+{
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   int retval = 0;
+   pthread_mutex_lock(&pGraph->reachLock);
+   freeReach(pGraph);
+   pGraph->reachMaxBytes = (maxBytes > 0) ? maxBytes : 0;
+   if (pGraph->reachMaxBytes > 0)
+      retval = buildReach(pGraph);
+   pthread_mutex_unlock(&pGraph->reachLock);
+   return retval;
 }
 
- 
+
+/* Find out how much memory the reachability index is using.
+ * Argument
+ *    graph     - Graph returned by newGraph
+ * Returns the number of bytes, or 0 if there is no index
+ * at the moment.
+ */
+long getReachabilityIndexSize(GRAPH_HANDLE graph)
+{
+   GRAPH_T * pGraph = (GRAPH_T*) graph;
+   long bytes = 0;
+   pthread_mutex_lock(&pGraph->reachLock);
+   if (pGraph->reach != NULL)
+      bytes = reachBytes(pGraph);
+   pthread_mutex_unlock(&pGraph->reachLock);
+   return bytes;
+}
@@ -0,0 +1,172 @@
+/*
+ *  nodePool.c
+ *
+ *  Pool allocator for fixed size records. Memory comes from the
+ *  system in slabs, each holding a fixed number of records. New
+ *  records are taken from the free list if it is not empty, and
+ *  otherwise from the unused part of the newest slab, so records
+ *  allocated one after another sit next to each other in memory.
+ *
+ *  A free record holds the pointer to the next free record in its
+ *  first bytes, so the free list needs no extra memory.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "nodePool.h"
+
+/* Records (and the start of the records in each slab) are aligned
+ * to this many bytes, which is enough for any of our structures */
+#define POOL_ALIGN 16
+
+/* Round a size up to a multiple of POOL_ALIGN */
+#define ALIGN_UP(size) (((size) + POOL_ALIGN - 1) & ~(size_t) (POOL_ALIGN - 1))
+
+/* Header at the start of each slab. The slabs form a list so
+ * that they can all be freed together. */
+typedef struct _slab
+{
+    struct _slab *next;		/* slab allocated before this one */
+} SLAB_T;
+
+/* Structure holding one pool */
+typedef struct
+{
+    size_t recordSize;		/* size of each record, rounded up */
+    int slabRecords;		/* number of records per slab */
+    SLAB_T *slabs;		/* most recently allocated slab */
+    char *nextUnused;		/* first never used record in that slab */
+    char *slabEnd;		/* end of that slab */
+    void *freeList;		/* records that were freed */
+    int count;			/* number of records in use */
+} NODE_POOL_T;
+
+
+/* Allocate a new slab and make it the one we take
+ * unused records from.
+ * Arguments
+ *   pPool   -   Pool that needs more records
+ * Returns 1 if successful, 0 for a memory allocation error.
+ */
+static int addSlab(NODE_POOL_T * pPool)
+{
+    size_t headerSize = ALIGN_UP(sizeof(SLAB_T));
+    size_t recordBytes = pPool->recordSize * pPool->slabRecords;
+    SLAB_T *pSlab = malloc(headerSize + recordBytes);
+    if (pSlab == NULL)
+	return 0;
+    pSlab->next = pPool->slabs;
+    pPool->slabs = pSlab;
+    pPool->nextUnused = (char *) pSlab + headerSize;
+    pPool->slabEnd = pPool->nextUnused + recordBytes;
+    return 1;
+}
+
+
+/********************************/
+/** Public functions start here */
+/********************************/
+
+/* Create a new, empty pool.
+ * Arguments
+ *   recordSize   -  Size in bytes of each record
+ *   slabRecords  -  Number of records in each slab
+ * Returns a handle for the pool, or NULL if a memory allocation
+ * error occurs.
+ */
+NODE_POOL_HANDLE newNodePool(int recordSize, int slabRecords)
+{
+    NODE_POOL_T *pPool = calloc(1, sizeof(NODE_POOL_T));
+    if (pPool != NULL)
+    {
+	/* a free record must have room for the free list pointer */
+	if (recordSize < (int) sizeof(void *))
+	    recordSize = sizeof(void *);
+	pPool->recordSize = ALIGN_UP((size_t) recordSize);
+	pPool->slabRecords = (slabRecords > 0) ? slabRecords : 1;
+    }
+    return (NODE_POOL_HANDLE) pPool;
+}
+
+
+/* Free all memory associated with a pool, including every record
+ * allocated from it.
+ * Arguments
+ *   pool    -  Pool to free. Not valid after this call.
+ */
+void nodePoolDestroy(NODE_POOL_HANDLE pool)
+{
+    NODE_POOL_T *pPool = (NODE_POOL_T *) pool;
+    if (pPool != NULL)
+    {
+	SLAB_T *pSlab = pPool->slabs;
+	while (pSlab != NULL)
+	{
+	    SLAB_T *pDelSlab = pSlab;
+	    pSlab = pSlab->next;
+	    free(pDelSlab);
+	}
+	free(pPool);
+    }
+}
+
+
+/* Get a zero filled record from the pool.
+ * Arguments
+ *   pool    -  Pool to allocate from
+ * Returns a pointer to the record, or NULL if a memory allocation
+ * error occurs.
+ */
+void *nodePoolAlloc(NODE_POOL_HANDLE pool)
+{
+    NODE_POOL_T *pPool = (NODE_POOL_T *) pool;
+    void *pRecord = pPool->freeList;
+    if (pRecord != NULL)
+    {
+	pPool->freeList = *(void **) pRecord;
+    }
+    else
+    {
+	if ((pPool->nextUnused == pPool->slabEnd) && (!addSlab(pPool)))
+	    return NULL;
+	pRecord = pPool->nextUnused;
+	pPool->nextUnused += pPool->recordSize;
+    }
+    memset(pRecord, 0, pPool->recordSize);
+    pPool->count++;
+    return pRecord;
+}
+
+
+/* Give a record back to the pool so it can be reused.
+ * Arguments
+ *   pool    -  Pool the record came from
+ *   pRecord -  Record to free, or NULL
+ */
+void nodePoolFree(NODE_POOL_HANDLE pool, void *pRecord)
+{
+    NODE_POOL_T *pPool = (NODE_POOL_T *) pool;
+    if (pRecord != NULL)
+    {
+	*(void **) pRecord = pPool->freeList;
+	pPool->freeList = pRecord;
+	pPool->count--;
+    }
+}
+
+
+/* Find out how many records are currently allocated from a pool.
+ * Arguments
+ *   pool    -  Pool we are interested in
+ * Returns number of records (could be zero)
+ */
+int nodePoolCount(NODE_POOL_HANDLE pool)
+{
+    return ((NODE_POOL_T *) pool)->count;
+}
@@ -4,6 +4,17 @@
  *  Defines the necessary functions for a network, that is a 
  *  graph with weights on each edge
  *
+ *  Each call to newGraph() creates a new, independent network and
+ *  returns a handle to it. All other functions take that handle as
+ *  their first argument, so a program can keep many networks at once.
+ *
+ *  Functions that only look at a network (findVertex, findEdge,
+ *  getAdjacentVertices, the traversals, the shortest path and
+ *  spanning tree functions) keep their working information in
+ *  storage of their own, not in the network. Several threads can
+ *  call them on the same network at the same time, as long as no
+ *  thread is changing that network.
+ *
  *  Copyright 2020 by Sally E. Goldin
  *
  *  May be freely copied and modified for educational purposes
@@ -14,26 +25,32 @@
 #ifndef ABSTRACTNETWORK_H
 #define ABSTRACTNETWORK_H
 
-/* Initialize the graph.
+/* opaque pointer to a network */
+typedef void* GRAPH_HANDLE;
+
+/* Create a new, empty network.
  * Argument 
  *    maxVertices  - how many vertices can this graph
  *                   handle.
  *    bDirected    - If true this is a directed graph.
  *                   Otherwise undirected.
- * Returns 1 unless there is a memory allocation error,
- * in which case it returns zero.
+ * Returns a handle for the network, or NULL if there is a
+ * memory allocation error.
  */
-int initGraph(int maxVertices, int bDirected);
+GRAPH_HANDLE newGraph(int maxVertices, int bDirected);
 
 
-/* Free all memory associated with the graph and
- * reset all parameters.
+/* Free all memory associated with the network. Does not
+ * free the data stored with the vertices.
+ * Argument
+ *    graph  -  Network to free. Not valid after this call.
  */
-void clearGraph();
+void graphDestroy(GRAPH_HANDLE graph);
 
 
 /* Add a vertex into the graph.
  * Arguments
+ *     graph -   Network returned by newGraph
  *     key   -   Key value or label for the 
  *               vertex
  *     pData -   Additional information that can
@@ -45,22 +62,24 @@ void clearGraph();
  * to add a vertex with a key that matches a vertex
  * already in the graph.
  */
-int addVertex(char* key, void* pData);
+int addVertex(GRAPH_HANDLE graph, char* key, void* pData);
 
 
 /* Remove a vertex from the graph.
  * Arguments
+ *     graph -   Network returned by newGraph
  *     key   -   Key value or label for the 
  *               vertex to remove
  * Returns a pointer to the data stored at that
  * vertex, or NULL if the vertex could not be 
  * found.
  */
-void* removeVertex(char* key);
+void* removeVertex(GRAPH_HANDLE graph, char* key);
 
 
 /* Add an edge between two vertices
  * Arguments
+ *    graph -  Network returned by newGraph
  *    key1  -  Key for the first vertex in the edge
  *    key2  -  Key for the second vertex
  *    weight - Weight for this edge. Constrained to be positive
@@ -69,37 +88,53 @@ void* removeVertex(char* key);
  * is not found. Returns -1 if an edge already
  * exists in this direction.
  */
-int addEdge(char* key1, char* key2, int weight);
+int addEdge(GRAPH_HANDLE graph, char* key1, char* key2, int weight);
 
 
 /* Remove an edge between two vertices
  * Arguments
+ *    graph -  Network returned by newGraph
  *    key1  -  Key for the first vertex in the edge
  *    key2  -  Key for the second vertex
  * Returns 1 if successful, 0 if failed 
  * because either vertex is not found or there
  * is no edge between these items.
  */
-int removeEdge(char* key1, char* key2);
+int removeEdge(GRAPH_HANDLE graph, char* key1, char* key2);
 
 
 /* Find a vertex and return its data
  * Arguments
- *    key  -  Key for the vertex to find
+ *    graph -  Network returned by newGraph
+ *    key   -  Key for the vertex to find
  * Returns the data for the vertex or NULL
  * if not found.
  */
-void* findVertex(char* key);
+void* findVertex(GRAPH_HANDLE graph, char* key);
 
 /* Find the edge between two vertices (if any) and return
  * its weight
  * Arguments
+ *    graph -  Network returned by newGraph
  *    key1  -  Key for the first vertex in the edge
  *    key2  -  Key for the second vertex
  * Returns weight if successful and edge exists.
  * Returns -1 if an edge is not found
  */
-int findEdge(char* key1, char* key2);
+int findEdge(GRAPH_HANDLE graph, char* key1, char* key2);
+
+/* Change the weight of an existing edge. For an undirected
+ * network, changes the weight in both directions.
+ * Arguments
+ *    graph  -  Network returned by newGraph
+ *    key1   -  Key for the first vertex in the edge
+ *    key2   -  Key for the second vertex
+ *    weight -  New weight for the edge
+ * Returns 1 if successful, 0 if either vertex is not
+ * found or there is no edge between them.
+ */
+int updateEdgeWeight(GRAPH_HANDLE graph, char* key1, char* key2,
+                     int weight);
 
 
 /* Return an array of copies of the keys for all nodes
@@ -107,38 +142,158 @@ int findEdge(char* key1, char* key2);
  * contents should be freed by the caller when it 
  * is no longer needed.
  * Arguments
- *    key   -  Key for the node whose adjacents we want
+ *    graph  - Network returned by newGraph
+ *    key    - Key for the node whose adjacents we want
  *    pCount - Return number of elements in the array
  * Returns array of char* which are the keys of adjacent
  * nodes. Returns number of adjacent vertices in pCount.
  * If pCount holds -1, the vertex does not exist.
  */
-char** getAdjacentVertices(char* key, int* pCount);
+char** getAdjacentVertices(GRAPH_HANDLE graph, char* key, int* pCount);
 
 
 /* Print out all the nodes reachable from a node by a 
  * breadth-first search.
  * Arguments
+ *   graph      -  Network returned by newGraph
  *   startKey   -  Key for start vertex
  * Returns 1 if successful, -1 if the vertex does not exist.
  */
-int printBreadthFirst(char* startKey);
+int printBreadthFirst(GRAPH_HANDLE graph, char* startKey);
 
 
 /* Print out all the nodes by a depth-first search.
+ * Argument
+ *   graph      -  Network returned by newGraph
  */
-void printDepthFirst();
+void printDepthFirst(GRAPH_HANDLE graph);
 
 /* Print out the lowest weight path from one vertex to 
  * another through the network using Dijkstra's
  * algorithm. 
  * Arguments
+ *    graph       -  Network returned by newGraph
  *    startKey    -  Key of start vertex
  *    endKey      -  Key of ending vertex
  * Returns the sum of the weights along the path.
  * Returns -1 if either key is invalid. Returns -2
- * if network is not directed.
+ * if network is not directed. Returns -3 if the
+ * network has negative weights. Returns -4 if end is not
+ * reachable from the start. Returns -5 for a memory
+ * allocation error.
+ */
+int printShortestPath(GRAPH_HANDLE graph, char* startKey, char* endKey);
+
+/* Find the lowest weight path from one vertex to another
+ * through the network using Dijkstra's algorithm, without
+ * printing anything. The search stops as soon as the end
+ * vertex is reached.
+ * Arguments
+ *    graph       -  Network returned by newGraph
+ *    startKey    -  Key of start vertex
+ *    endKey      -  Key of ending vertex
+ *    pPathKeys   -  If not NULL, used to return an array holding the
+ *                   keys along the path, start first. The caller
+ *                   should free the array but not the keys, which
+ *                   belong to the network.
+ *    pPathCount  -  If not NULL, returns the number of keys in the path
+ * Returns the sum of the weights along the path, or the same
+ * negative error values as printShortestPath.
+ */
+int findShortestPath(GRAPH_HANDLE graph, char* startKey, char* endKey,
+                     char*** pPathKeys, int* pPathCount);
+
+/* Methods for findShortestPathUsing */
+#define PATH_DIJKSTRA      0  /* plain Dijkstra, as in findShortestPath */
+#define PATH_BIDIRECTIONAL 1  /* search from both ends at once */
+#define PATH_ASTAR         2  /* A* search guided by a heuristic */
+
+/* Find the lowest weight path from one vertex to another, like
+ * findShortestPath, but choosing the search method. All methods
+ * find a path with the same total weight, but on a large network the
+ * bidirectional and A* searches usually look at many fewer vertices.
+ * Arguments
+ *    graph         -  Network returned by newGraph
+ *    method        -  PATH_DIJKSTRA, PATH_BIDIRECTIONAL or PATH_ASTAR
+ *    startKey      -  Key of start vertex
+ *    endKey        -  Key of ending vertex
+ *    heuristic     -  For PATH_ASTAR, a function that is given the data
+ *                     of some vertex and the data of the end vertex,
+ *                     and returns an estimate of the weight of the path
+ *                     between them (for instance, the straight line
+ *                     distance if the data holds map coordinates). The
+ *                     estimate must never be more than the real weight.
+ *                     Ignored for the other methods.
+ *    pPathKeys     -  As for findShortestPath
+ *    pPathCount    -  As for findShortestPath
+ *    pSettledCount -  If not NULL, returns the number of vertices
+ *                     the search settled, as a measure of its work
+ * Returns the sum of the weights along the path, or the same
+ * negative error values as printShortestPath. Also returns -5 if
+ * the method is not valid or PATH_ASTAR is used without a heuristic.
+ */
+int findShortestPathUsing(GRAPH_HANDLE graph, int method,
+                          char* startKey, char* endKey,
+                          int (*heuristic)(void* pData, void* pEndData),
+                          char*** pPathKeys, int* pPathCount,
+                          int* pSettledCount);
+
+/* Find the lowest weight path distances for a whole batch of
+ * (start, end) pairs, running the searches in parallel on
+ * several threads. The searches run on a frozen copy of the
+ * network, which is kept and reused by later calls until the
+ * network is changed. The network must not be changed while
+ * this function is running.
+ * Arguments
+ *    graph       -  Network returned by newGraph
+ *    startKeys   -  Key of the start vertex for each pair
+ *    endKeys     -  Key of the end vertex for each pair
+ *    pairCount   -  Number of pairs
+ *    distances   -  Array of pairCount values to fill in. Each is
+ *                   set to the sum of the weights along the path,
+ *                   -1 if either key is invalid, or -4 if the end
+ *                   is not reachable from the start.
+ *    threadCount -  Number of threads to use. If zero or less, uses
+ *                   one thread per processor.
+ * Returns 1 if successful, -2 if network is not directed,
+ * -3 if the network has negative weights, or -5 for a memory
+ * allocation error.
+ */
+int findShortestPathBatch(GRAPH_HANDLE graph, char** startKeys,
+                          char** endKeys, int pairCount,
+                          int* distances, int threadCount);
+
+/* One edge of a spanning tree, as returned by
+ * computeMinimumSpanningTree. The keys belong to the network.
+ */
+typedef struct
+{
+    char* fromKey;    /* key of the vertex at one end */
+    char* toKey;      /* key of the vertex at the other end */
+    int weight;       /* weight of the edge */
+} NETWORK_EDGE_T;
+
+/* Methods for computeMinimumSpanningTree */
+#define MST_AUTOMATIC 0   /* choose based on how dense the network is */
+#define MST_PRIM      1   /* Prim's algorithm using a binary heap */
+#define MST_KRUSKAL   2   /* Kruskal's algorithm using union-find */
+
+/* Find a minimum spanning tree of an undirected network, without
+ * printing anything. If the network is not connected, finds a
+ * minimum spanning tree for each connected part (a spanning forest).
+ * Arguments
+ *    graph         -  Network returned by newGraph
+ *    method        -  MST_PRIM, MST_KRUSKAL, or MST_AUTOMATIC to use
+ *                     Prim for dense networks and Kruskal for sparse ones
+ *    pTreeEdges    -  Used to return an array of the edges in the tree.
+ *                     The caller should free the array but not the keys.
+ *    pEdgeCount    -  Used to return the number of edges in the tree
+ *    pTotalWeight  -  Used to return the sum of the edge weights
+ * Returns 1 if successful, -2 if the network is directed,
+ * or -5 for a memory allocation error.
  */
-int printShortestPath(char* startKey, char* endKey);
+int computeMinimumSpanningTree(GRAPH_HANDLE graph, int method,
+                               NETWORK_EDGE_T** pTreeEdges,
+                               int* pEdgeCount, int* pTotalWeight);
 
 #endif
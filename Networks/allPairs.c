@@ -0,0 +1,376 @@
+/*
+ *  allPairs.c
+ *
+ *  All-pairs shortest paths using the Floyd-Warshall algorithm.
+ *  See allPairs.h.
+ *
+ *  The basic algorithm is three nested loops over k, i and j:
+ *  if going from i to k and then from k to j is shorter than the
+ *  best path known from i to j, use that instead. Written that
+ *  way, every step of k walks through the whole table, which is
+ *  slow once the table no longer fits in the cache.
+ *
+ *  So we divide the table into square tiles of TILE x TILE entries
+ *  and handle the k values one tile-width at a time. For each group
+ *  of k values, we first update the tile on the diagonal, then the
+ *  other tiles in the same row and column of tiles (which only
+ *  depend on the diagonal tile), and finally all the remaining tiles
+ *  (which only depend on the row and column). Each tile update works
+ *  on a small piece of the table that stays in the cache, and within
+ *  each of the last two steps the tiles do not depend on each other,
+ *  so they can be shared among several threads.
+ *
+ *  The distance and next hop tables are kept in one allocation. The
+ *  row length is rounded up to a multiple of TILE so every tile is
+ *  full; the extra entries are just vertices that have no edges.
+ *
+ *  Note this module must be linked with -lpthread.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "allPairs.h"
+
+#define TILE 32			/* width and height of a tile */
+#define NO_PATH (INT_MAX / 2)	/* distance for "no path", so that adding
+				 * two of them cannot overflow */
+#define MAX_THREADS 64		/* upper limit on the number of threads */
+
+/* Structure holding the tables for one network */
+typedef struct
+{
+    int vertexCount;		/* number of real vertices */
+    int rowLength;		/* vertexCount rounded up to a multiple of TILE */
+    int *dist;			/* dist[i*rowLength + j] is the best distance
+				 * from i to j found so far */
+    int *next;			/* next[i*rowLength + j] is the vertex after i
+				 * on that path, -1 if there is no path */
+} ALL_PAIRS_T;
+
+/* Information shared by the threads during one computation */
+typedef struct
+{
+    ALL_PAIRS_T *pAllPairs;	/* tables being computed */
+    int threadCount;		/* number of threads actually running */
+    pthread_mutex_t startLock;	/* held until all threads are created */
+    pthread_barrier_t barrier;	/* keeps the threads in step */
+} FW_JOB_T;
+
+/* Information for one thread */
+typedef struct
+{
+    FW_JOB_T *pJob;		/* the shared information */
+    int id;			/* thread number, 0 to threadCount-1 */
+} FW_WORKER_T;
+
+
+/* Apply the k values from kStart to kStart+TILE-1 to the tile
+ * whose top left corner is at row iStart, column jStart.
+ * The inner loop has no branches, so the compiler can use
+ * vector instructions for it.
+ * Arguments
+ *    pAllPairs  -  Tables to update
+ *    iStart     -  First row of the tile
+ *    jStart     -  First column of the tile
+ *    kStart     -  First k value
+ */
+static void updateTile(ALL_PAIRS_T * pAllPairs, int iStart, int jStart,
+		       int kStart)
+{
+    int rowLength = pAllPairs->rowLength;
+    int i = 0;
+    int j = 0;
+    int k = 0;
+    for (k = kStart; k < kStart + TILE; k++)
+    {
+	int *rowK = pAllPairs->dist + k * rowLength + jStart;
+	for (i = iStart; i < iStart + TILE; i++)
+	{
+	    int *rowI = pAllPairs->dist + i * rowLength + jStart;
+	    int *nextI = pAllPairs->next + i * rowLength + jStart;
+	    int distIK = pAllPairs->dist[i * rowLength + k];
+	    int nextIK = pAllPairs->next[i * rowLength + k];
+	    if (distIK >= NO_PATH)
+		continue;	/* no path from i to k, nothing can improve */
+	    for (j = 0; j < TILE; j++)
+	    {
+		int candidate = distIK + rowK[j];
+		int bShorter = (candidate < rowI[j]);
+		rowI[j] = bShorter ? candidate : rowI[j];
+		nextI[j] = bShorter ? nextIK : nextI[j];
+	    }
+	}
+    }
+}
+
+
+/* Work done by each thread. For each group of k values, thread 0
+ * updates the diagonal tile, then the threads share the tiles in
+ * the same row and column, then all the remaining tiles. The barrier
+ * makes sure each step is finished before the next one starts.
+ * Arguments
+ *    pArg   -  This thread's information (will be cast to FW_WORKER_T *)
+ * Returns NULL.
+ */
+static void *fwWorker(void *pArg)
+{
+    FW_WORKER_T *pWorker = (FW_WORKER_T *) pArg;
+    FW_JOB_T *pJob = pWorker->pJob;
+    ALL_PAIRS_T *pAllPairs = NULL;
+    int tileCount = 0;
+    int kTile = 0;
+    int threadCount = 0;
+    /* wait until the main thread knows how many threads are running */
+    pthread_mutex_lock(&pJob->startLock);
+    pthread_mutex_unlock(&pJob->startLock);
+    pAllPairs = pJob->pAllPairs;
+    threadCount = pJob->threadCount;
+    if (threadCount == 0)
+	return NULL;		/* setup failed, nothing to do */
+    tileCount = pAllPairs->rowLength / TILE;
+    for (kTile = 0; kTile < tileCount; kTile++)
+    {
+	int kStart = kTile * TILE;
+	int turn = 0;
+	int a = 0;
+	int b = 0;
+	if (pWorker->id == 0)
+	    updateTile(pAllPairs, kStart, kStart, kStart);
+	pthread_barrier_wait(&pJob->barrier);
+	for (a = 0; a < tileCount; a++)
+	{
+	    if (a == kTile)
+		continue;
+	    if (turn++ % threadCount == pWorker->id)
+		updateTile(pAllPairs, kStart, a * TILE, kStart);
+	    if (turn++ % threadCount == pWorker->id)
+		updateTile(pAllPairs, a * TILE, kStart, kStart);
+	}
+	pthread_barrier_wait(&pJob->barrier);
+	turn = 0;
+	for (a = 0; a < tileCount; a++)
+	{
+	    for (b = 0; b < tileCount; b++)
+	    {
+		if ((a == kTile) || (b == kTile))
+		    continue;
+		if (turn++ % threadCount == pWorker->id)
+		    updateTile(pAllPairs, a * TILE, b * TILE, kStart);
+	    }
+	}
+	pthread_barrier_wait(&pJob->barrier);
+    }
+    return NULL;
+}
+
+
+/* Set the tables to show no paths at all, except from
+ * each vertex to itself.
+ * Arguments
+ *    pAllPairs  -  Tables to reset
+ */
+static void clearTables(ALL_PAIRS_T * pAllPairs)
+{
+    int rowLength = pAllPairs->rowLength;
+    int i = 0;
+    int j = 0;
+    for (i = 0; i < rowLength; i++)
+    {
+	for (j = 0; j < rowLength; j++)
+	{
+	    pAllPairs->dist[i * rowLength + j] = (i == j) ? 0 : NO_PATH;
+	    pAllPairs->next[i * rowLength + j] = (i == j) ? i : -1;
+	}
+    }
+}
+
+
+/********************************/
+/** Public functions start here */
+/********************************/
+
+/* Create the tables for a network.
+ * Arguments
+ *    vertexCount  -  Number of vertices (indices 0 to vertexCount-1)
+ * Returns a handle to use in the other functions, or NULL if
+ * a memory allocation error occurs.
+ */
+ALL_PAIRS_HANDLE newAllPairs(int vertexCount)
+{
+    ALL_PAIRS_T *pAllPairs = NULL;
+    size_t tableSize = 0;
+    if (vertexCount <= 0)
+	return NULL;
+    pAllPairs = calloc(1, sizeof(ALL_PAIRS_T));
+    if (pAllPairs != NULL)
+    {
+	pAllPairs->vertexCount = vertexCount;
+	pAllPairs->rowLength = ((vertexCount + TILE - 1) / TILE) * TILE;
+	tableSize = (size_t) pAllPairs->rowLength * pAllPairs->rowLength;
+	/* both tables in one block */
+	pAllPairs->dist = malloc(2 * tableSize * sizeof(int));
+	if (pAllPairs->dist == NULL)
+	{
+	    free(pAllPairs);
+	    return NULL;
+	}
+	pAllPairs->next = pAllPairs->dist + tableSize;
+	clearTables(pAllPairs);
+    }
+    return (ALL_PAIRS_HANDLE) pAllPairs;
+}
+
+
+/* Free all memory associated with the tables.
+ * Arguments
+ *    allPairs   -  Handle returned by newAllPairs. Not valid
+ *                  after this call.
+ */
+void allPairsDestroy(ALL_PAIRS_HANDLE allPairs)
+{
+    ALL_PAIRS_T *pAllPairs = (ALL_PAIRS_T *) allPairs;
+    if (pAllPairs != NULL)
+    {
+	free(pAllPairs->dist);	/* also frees next */
+	free(pAllPairs);
+    }
+}
+
+
+/* Compute the distance and next hop tables.
+ * Arguments
+ *    allPairs    -  Handle returned by newAllPairs
+ *    weights     -  Adjacency matrix stored row by row in one array
+ *    rowLength   -  Number of values in each row of weights
+ *    threadCount -  Number of threads to use, zero or less for one
+ *                   per processor
+ * Returns 1 if successful, 0 if the threads cannot be started.
+ */
+int allPairsCompute(ALL_PAIRS_HANDLE allPairs, int *weights, int rowLength,
+		    int threadCount)
+{
+    ALL_PAIRS_T *pAllPairs = (ALL_PAIRS_T *) allPairs;
+    FW_JOB_T job;
+    FW_WORKER_T workers[MAX_THREADS];
+    pthread_t threads[MAX_THREADS];
+    int tileCount = pAllPairs->rowLength / TILE;
+    int started = 0;
+    int i = 0;
+    int j = 0;
+    clearTables(pAllPairs);
+    for (i = 0; i < pAllPairs->vertexCount; i++)
+    {
+	for (j = 0; j < pAllPairs->vertexCount; j++)
+	{
+	    int weight = weights[i * rowLength + j];
+	    if ((i != j) && (weight > 0))
+	    {
+		pAllPairs->dist[i * pAllPairs->rowLength + j] = weight;
+		pAllPairs->next[i * pAllPairs->rowLength + j] = j;
+	    }
+	}
+    }
+    if (threadCount <= 0)
+	threadCount = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    /* with one row of tiles there is nothing to share */
+    if (threadCount > (tileCount - 1) * (tileCount - 1))
+	threadCount = (tileCount - 1) * (tileCount - 1);
+    if (threadCount > MAX_THREADS)
+	threadCount = MAX_THREADS;
+    if (threadCount < 1)
+	threadCount = 1;
+    job.pAllPairs = pAllPairs;
+    pthread_mutex_init(&job.startLock, NULL);
+    pthread_mutex_lock(&job.startLock);
+    for (i = 1; i < threadCount; i++)
+    {
+	workers[i].pJob = &job;
+	workers[i].id = i;
+	if (pthread_create(&threads[started], NULL, &fwWorker, &workers[i])
+	    != 0)
+	    break;
+	started++;
+    }
+    /* now we know how many threads we really have */
+    job.threadCount = started + 1;
+    if (pthread_barrier_init(&job.barrier, NULL, job.threadCount) != 0)
+    {
+	/* let the other threads finish at once */
+	job.threadCount = 0;
+    }
+    pthread_mutex_unlock(&job.startLock);
+    if (job.threadCount > 0)
+    {
+	workers[0].pJob = &job;
+	workers[0].id = 0;
+	fwWorker(&workers[0]);
+    }
+    for (i = 0; i < started; i++)
+	pthread_join(threads[i], NULL);
+    if (job.threadCount > 0)
+	pthread_barrier_destroy(&job.barrier);
+    pthread_mutex_destroy(&job.startLock);
+    return (job.threadCount > 0);
+}
+
+
+/* Get the lowest path weight between two vertices.
+ * Arguments
+ *    allPairs   -  Tables computed by allPairsCompute
+ *    fromIndex  -  Index of start vertex
+ *    toIndex    -  Index of end vertex
+ * Returns the total weight, -1 if the end vertex is not
+ * reachable, or -2 if an index is out of range.
+ */
+int allPairsDistance(ALL_PAIRS_HANDLE allPairs, int fromIndex, int toIndex)
+{
+    ALL_PAIRS_T *pAllPairs = (ALL_PAIRS_T *) allPairs;
+    int distance = 0;
+    if ((fromIndex < 0) || (fromIndex >= pAllPairs->vertexCount) ||
+	(toIndex < 0) || (toIndex >= pAllPairs->vertexCount))
+	return -2;
+    distance = pAllPairs->dist[fromIndex * pAllPairs->rowLength + toIndex];
+    return (distance >= NO_PATH) ? -1 : distance;
+}
+
+
+/* Copy the lowest weight path between two vertices into an
+ * array, by following the next hop table.
+ * Arguments
+ *    allPairs    -  Tables computed by allPairsCompute
+ *    fromIndex   -  Index of start vertex
+ *    toIndex     -  Index of end vertex
+ *    pathIndices -  Array to fill in with vertex indices
+ *    maxCount    -  Size of the pathIndices array
+ * Returns the number of vertices in the path, 0 if the end
+ * vertex is not reachable, or -1 if the array is too small.
+ */
+int allPairsGetPath(ALL_PAIRS_HANDLE allPairs, int fromIndex, int toIndex,
+		    int *pathIndices, int maxCount)
+{
+    ALL_PAIRS_T *pAllPairs = (ALL_PAIRS_T *) allPairs;
+    int pathCount = 0;
+    int current = fromIndex;
+    if (allPairsDistance(allPairs, fromIndex, toIndex) < 0)
+	return 0;
+    while (1)
+    {
+	if (pathCount >= maxCount)
+	    return -1;
+	pathIndices[pathCount] = current;
+	pathCount++;
+	if (current == toIndex)
+	    break;
+	current = pAllPairs->next[current * pAllPairs->rowLength + toIndex];
+    }
+    return pathCount;
+}
@@ -0,0 +1,86 @@
+/**
+ *  allPairs.h
+ *
+ *  Declarations for an all-pairs shortest path engine, for small,
+ *  dense networks stored as adjacency matrices. Instead of running
+ *  Dijkstra's algorithm once for every query, we compute the lowest
+ *  path weight between every pair of vertices at once, using the
+ *  Floyd-Warshall algorithm. After that, each query is answered just
+ *  by looking in a table.
+ *
+ *  Along with the distance table we keep a "next hop" table:
+ *  next[i][j] is the second vertex on the best path from i to j.
+ *  Following these entries gives the whole path.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+#ifndef ALLPAIRS_H
+#define ALLPAIRS_H
+
+/* opaque pointer to the tables for one network */
+typedef void* ALL_PAIRS_HANDLE;
+
+/* Create the tables for a network.
+ * Arguments
+ *    vertexCount  -  Number of vertices (indices 0 to vertexCount-1)
+ * Returns a handle to use in the other functions, or NULL if
+ * a memory allocation error occurs.
+ */
+ALL_PAIRS_HANDLE newAllPairs(int vertexCount);
+
+
+/* Free all memory associated with the tables.
+ * Arguments
+ *    allPairs   -  Handle returned by newAllPairs. Not valid
+ *                  after this call.
+ */
+void allPairsDestroy(ALL_PAIRS_HANDLE allPairs);
+
+
+/* Compute the distance and next hop tables.
+ * Arguments
+ *    allPairs    -  Handle returned by newAllPairs
+ *    weights     -  Adjacency matrix stored row by row in one array.
+ *                   weights[i*rowLength + j] is the weight of the edge
+ *                   from vertex i to vertex j, or 0 (or less) if there
+ *                   is no edge.
+ *    rowLength   -  Number of values in each row of weights (at least
+ *                   the vertex count)
+ *    threadCount -  Number of threads to use. If zero or less, uses
+ *                   one thread per processor.
+ * Returns 1 if successful, 0 if the threads cannot be started.
+ */
+int allPairsCompute(ALL_PAIRS_HANDLE allPairs, int* weights, int rowLength,
+                    int threadCount);
+
+
+/* Get the lowest path weight between two vertices.
+ * Arguments
+ *    allPairs   -  Tables computed by allPairsCompute
+ *    fromIndex  -  Index of start vertex
+ *    toIndex    -  Index of end vertex
+ * Returns the total weight, -1 if the end vertex is not
+ * reachable, or -2 if an index is out of range.
+ */
+int allPairsDistance(ALL_PAIRS_HANDLE allPairs, int fromIndex, int toIndex);
+
+
+/* Copy the lowest weight path between two vertices into an
+ * array, in order from the start vertex to the end vertex.
+ * Arguments
+ *    allPairs    -  Tables computed by allPairsCompute
+ *    fromIndex   -  Index of start vertex
+ *    toIndex     -  Index of end vertex
+ *    pathIndices -  Array to fill in with vertex indices
+ *    maxCount    -  Size of the pathIndices array
+ * Returns the number of vertices in the path, 0 if the end
+ * vertex is not reachable, or -1 if the array is too small.
+ */
+int allPairsGetPath(ALL_PAIRS_HANDLE allPairs, int fromIndex, int toIndex,
+                    int* pathIndices, int maxCount);
+
+#endif
@@ -0,0 +1,268 @@
+/*
+ *  batchBench.c
+ *
+ *  Benchmark for findShortestPathBatch(). It builds a random directed
+ *  network, picks random (start, end) pairs, and finds the distance
+ *  for every pair with findShortestPath(), one query at a time. These
+ *  are the answers the batch must match.
+ *
+ *  It then runs the whole batch with 1, 2, 4 ... maxThreads threads
+ *  and, for each, prints the time taken, the number of queries per
+ *  second and the speedup compared with the one-at-a-time queries,
+ *  and checks every distance against the serial answer. The first
+ *  batch call also freezes the network, so its time is printed on
+ *  its own line; the later calls reuse the frozen copy.
+ *
+ *  Finally it changes the weight of some edges and checks another
+ *  batch, to make sure the frozen copy was not used after the
+ *  network changed, and checks that pairs with a key that is not in
+ *  the network are rejected just as findShortestPath() rejects them.
+ *
+ *  Usage:  batchBench [vertices [queries [maxThreads]]]
+ *
+ *  Note this module needs to be linked with the network module and
+ *  the modules it needs, and with -lpthread
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "abstractNetwork.h"
+
+#define MAX_THREADS 64		/* upper limit on threads */
+#define EDGES_PER_VERTEX 4	/* average out-degree of the network */
+#define CHANGED_EDGES 20	/* edges changed before the last check */
+#define UNKNOWN_KEY "no such vertex"	/* key not in the network */
+
+/* Get the time in seconds */
+double now()
+{
+    struct timeval time;
+    gettimeofday(&time, NULL);
+    return time.tv_sec + time.tv_usec / 1000000.0;
+}
+
+
+/* Find the distance for every pair one at a time with
+ * findShortestPath().
+ * Arguments
+ *    graph      -  Network to search
+ *    startKeys  -  Key of the start vertex for each pair
+ *    endKeys    -  Key of the end vertex for each pair
+ *    queryCount -  Number of pairs
+ *    distances  -  Array of queryCount values to fill in
+ */
+void findSerial(GRAPH_HANDLE graph, char **startKeys, char **endKeys,
+		int queryCount, int *distances)
+{
+    int i = 0;
+    for (i = 0; i < queryCount; i++)
+	distances[i] = findShortestPath(graph, startKeys[i], endKeys[i],
+					NULL, NULL);
+}
+
+
+/* Run the whole batch once and compare the results with the
+ * serial answers.
+ * Arguments
+ *    graph       -  Network to search
+ *    startKeys   -  Key of the start vertex for each pair
+ *    endKeys     -  Key of the end vertex for each pair
+ *    queryCount  -  Number of pairs
+ *    expected    -  Distances found by findSerial()
+ *    distances   -  Array of queryCount values for the batch results
+ *    threadCount -  Number of threads for the batch
+ *    pSeconds    -  Used to return the time the batch took
+ * Returns the number of distances that do not match, or -1 if
+ * the batch failed.
+ */
+int runBatch(GRAPH_HANDLE graph, char **startKeys, char **endKeys,
+	     int queryCount, int *expected, int *distances,
+	     int threadCount, double *pSeconds)
+{
+    double start = now();
+    int wrong = 0;
+    int i = 0;
+    int status = findShortestPathBatch(graph, startKeys, endKeys,
+				       queryCount, distances, threadCount);
+    *pSeconds = now() - start;
+    if (status != 1)
+    {
+	printf("findShortestPathBatch returned %d\n", status);
+	return -1;
+    }
+    for (i = 0; i < queryCount; i++)
+    {
+	if (distances[i] != expected[i])
+	    wrong++;
+    }
+    return wrong;
+}
+
+
+/* Print one line of the results table.
+ * Arguments
+ *    label      -  What was timed
+ *    seconds    -  Time taken
+ *    queryCount -  Number of queries done
+ *    serialTime -  Time the serial queries took
+ *    wrong      -  Number of wrong results, or -1 if the batch failed
+ */
+void printResult(char *label, double seconds, int queryCount,
+		 double serialTime, int wrong)
+{
+    if (wrong < 0)
+	printf("%10s  FAILED\n", label);
+    else if (wrong > 0)
+	printf("%10s  %d WRONG RESULTS\n", label, wrong);
+    else
+	printf("%10s %10.4f %12.0f %8.2f\n", label, seconds,
+	       (seconds > 0) ? queryCount / seconds : 0.0,
+	       (seconds > 0) ? serialTime / seconds : 0.0);
+}
+
+
+/* Build the network, then time and check the batches */
+int main(int argc, char *argv[])
+{
+    int vertexCount = (argc > 1) ? atoi(argv[1]) : 5000;
+    int queryCount = (argc > 2) ? atoi(argv[2]) : 200;
+    int maxThreads = (argc > 3) ? atoi(argv[3]) : 4;
+    GRAPH_HANDLE graph = NULL;
+    char **keys = NULL;
+    char **startKeys = NULL;
+    char **endKeys = NULL;
+    int *expected = NULL;
+    int *distances = NULL;
+    char label[32];
+    double serialTime = 0;
+    double seconds = 0;
+    int threadCount = 0;
+    int wrong = 0;
+    int bAllOk = 1;
+    int i = 0;
+
+    if ((vertexCount < 2) || (queryCount < 2) || (maxThreads < 1) ||
+	(maxThreads > MAX_THREADS))
+    {
+	fprintf(stderr, "Usage: %s [vertices [queries [maxThreads]]]\n",
+		argv[0]);
+	fprintf(stderr,
+		"  (at least 2 vertices and 2 queries, 1 to %d threads)\n",
+		MAX_THREADS);
+	exit(1);
+    }
+    graph = newGraph(vertexCount, 1);
+    keys = calloc(vertexCount, sizeof(char *));
+    startKeys = calloc(queryCount, sizeof(char *));
+    endKeys = calloc(queryCount, sizeof(char *));
+    expected = calloc(queryCount, sizeof(int));
+    distances = calloc(queryCount, sizeof(int));
+    if ((graph == NULL) || (keys == NULL) || (startKeys == NULL) ||
+	(endKeys == NULL) || (expected == NULL) || (distances == NULL))
+    {
+	fprintf(stderr, "Memory allocation error\n");
+	exit(1);
+    }
+    for (i = 0; i < vertexCount; i++)
+    {
+	sprintf(label, "v%d", i);
+	keys[i] = strdup(label);
+	if ((keys[i] == NULL) || (addVertex(graph, keys[i], NULL) != 1))
+	{
+	    fprintf(stderr, "Memory allocation error building the network\n");
+	    exit(1);
+	}
+    }
+    srand(1);
+    for (i = 0; i < vertexCount * EDGES_PER_VERTEX; i++)
+    {
+	int from = rand() % vertexCount;
+	int to = rand() % vertexCount;
+	if (from != to)
+	    addEdge(graph, keys[from], keys[to], 1 + rand() % 99);
+    }
+    for (i = 0; i < queryCount; i++)
+    {
+	startKeys[i] = keys[rand() % vertexCount];
+	endKeys[i] = keys[rand() % vertexCount];
+    }
+    printf("Network has %d vertices and about %d edges, %d queries\n",
+	   vertexCount, vertexCount * EDGES_PER_VERTEX, queryCount);
+
+    seconds = now();
+    findSerial(graph, startKeys, endKeys, queryCount, expected);
+    serialTime = now() - seconds;
+    printf("%10s %10s %12s %8s\n", "threads", "seconds", "queries/sec",
+	   "speedup");
+    printResult("serial", serialTime, queryCount, serialTime, 0);
+
+    /* the first call freezes the network */
+    wrong = runBatch(graph, startKeys, endKeys, queryCount, expected,
+		     distances, 1, &seconds);
+    printResult("1+freeze", seconds, queryCount, serialTime, wrong);
+    if (wrong != 0)
+	bAllOk = 0;
+    for (threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+	wrong = runBatch(graph, startKeys, endKeys, queryCount, expected,
+			 distances, threadCount, &seconds);
+	sprintf(label, "%d", threadCount);
+	printResult(label, seconds, queryCount, serialTime, wrong);
+	if (wrong != 0)
+	    bAllOk = 0;
+    }
+
+    /* change some weights, so the frozen copy is out of date */
+    for (i = 0; i < CHANGED_EDGES; i++)
+    {
+	int from = rand() % vertexCount;
+	char **adjacentKeys = NULL;
+	int adjacentCount = 0;
+	adjacentKeys = getAdjacentVertices(graph, keys[from], &adjacentCount);
+	if (adjacentCount > 0)
+	    updateEdgeWeight(graph, keys[from], adjacentKeys[0], 1);
+	while (adjacentCount > 0)
+	    free(adjacentKeys[--adjacentCount]);
+	free(adjacentKeys);
+    }
+    findSerial(graph, startKeys, endKeys, queryCount, expected);
+    wrong = runBatch(graph, startKeys, endKeys, queryCount, expected,
+		     distances, maxThreads, &seconds);
+    if (wrong != 0)
+	bAllOk = 0;
+    printf("After changing %d edge weights: %s\n", CHANGED_EDGES,
+	   (wrong == 0) ? "all results match" : "RESULTS DO NOT MATCH");
+
+    /* a key that is not in the network must give the same error
+     * code as findShortestPath, for either end of the pair */
+    startKeys[0] = keys[0];
+    endKeys[0] = UNKNOWN_KEY;
+    startKeys[1] = UNKNOWN_KEY;
+    endKeys[1] = keys[0];
+    findSerial(graph, startKeys, endKeys, 2, expected);
+    wrong = runBatch(graph, startKeys, endKeys, 2, expected, distances,
+		     maxThreads, &seconds);
+    if ((wrong != 0) || (expected[0] != -1) || (expected[1] != -1))
+	bAllOk = 0;
+    printf("Pairs with an unknown key: %s\n",
+	   ((wrong == 0) && (expected[0] == -1) && (expected[1] == -1)) ?
+	   "rejected" : "WRONG RESULTS");
+
+    graphDestroy(graph);
+    for (i = 0; i < vertexCount; i++)
+	free(keys[i]);
+    free(keys);
+    free(startKeys);
+    free(endKeys);
+    free(expected);
+    free(distances);
+    return (bAllOk) ? 0 : 1;
+}
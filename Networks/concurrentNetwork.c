@@ -0,0 +1,259 @@
+/*
+ *  concurrentNetwork.c
+ *
+ *  Demo of one writer thread changing a network while several
+ *  reader threads run shortest path queries on it at the same time,
+ *  using the snapshot publisher in networkPublisher.c.
+ *
+ *  The program builds a random directed network. The reader threads
+ *  repeatedly pin the current snapshot, find the shortest path
+ *  between two random vertices, and unpin it. Meanwhile the main
+ *  thread adds and removes random edges, and now and then removes a
+ *  vertex and puts it back, publishing a new snapshot after every
+ *  few changes. At the end it reports how many queries were done
+ *  and how many old snapshots were freed.
+ *
+ *  Usage:  concurrentNetwork [vertices [readers [changes [perPublish]]]]
+ *
+ *  Note this module needs to be linked with networkPublisher.c, the
+ *  network module and the modules it needs, and with -lpthread
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "abstractNetwork.h"
+#include "networkSnapshot.h"
+#include "networkPublisher.h"
+#include "shortestPath.h"
+
+#define MAX_READERS 64		/* upper limit on reader threads */
+
+/* Information shared by the main thread and the readers */
+typedef struct
+{
+    PUBLISHER_HANDLE publisher;	/* where the readers get snapshots */
+    atomic_int bStop;		/* set to 1 when the readers should quit */
+} SHARED_T;
+
+/* Information for one reader thread */
+typedef struct
+{
+    SHARED_T *pShared;		/* shared by all the threads */
+    unsigned int seed;		/* for rand_r */
+    long queries;		/* number of queries done */
+    long found;			/* number that found a path */
+    int bFailed;		/* 1 if the reader could not start */
+} READER_T;
+
+
+/* Work done by each reader thread. Runs queries until told to stop.
+ * Arguments
+ *    pArg   -  The reader's information (will be cast to READER_T *)
+ * Returns NULL.
+ */
+void *readerThread(void *pArg)
+{
+    READER_T *pReader = (READER_T *) pArg;
+    PUBLISHER_HANDLE publisher = pReader->pShared->publisher;
+    PATH_SEARCH_HANDLE search = newPathSearch(0);
+    int readerId = registerReader(publisher);
+    if ((search == NULL) || (readerId < 0))
+    {
+	pReader->bFailed = 1;
+	if (search != NULL)
+	    pathSearchDestroy(search);
+	unregisterReader(publisher, readerId);
+	return NULL;
+    }
+    while (!atomic_load(&pReader->pShared->bStop))
+    {
+	NETWORK_SNAPSHOT_T *pSnapshot = pinSnapshot(publisher, readerId);
+	if (pSnapshot->vertexCount > 0)
+	{
+	    int start = rand_r(&pReader->seed) % pSnapshot->vertexCount;
+	    int end = rand_r(&pReader->seed) % pSnapshot->vertexCount;
+	    /* look at the vertex data too, which the writer may have
+	     * handed to the publisher to free */
+	    if ((pSnapshot->data[start] != NULL) &&
+		(strlen((char *) pSnapshot->data[start]) > 0) &&
+		(snapshotShortestPath(pSnapshot, search, start, end) >= 0))
+		pReader->found++;
+	    pReader->queries++;
+	}
+	unpinSnapshot(publisher, readerId);
+    }
+    unregisterReader(publisher, readerId);
+    pathSearchDestroy(search);
+    return NULL;
+}
+
+
+/* Add a vertex with a copy of its key as its data.
+ * Arguments
+ *    graph   -  Network to add to
+ *    key     -  Key for the new vertex
+ * Returns 1 if successful, else 0.
+ */
+int addDemoVertex(GRAPH_HANDLE graph, char *key)
+{
+    /* addVertex copies the key, so we only need to copy the data */
+    char *newData = strdup(key);
+    if ((newData == NULL) || (addVertex(graph, key, newData) != 1))
+    {
+	free(newData);
+	return 0;
+    }
+    return 1;
+}
+
+
+/* Build the network, start the readers, and make changes
+ * until done.
+ */
+int main(int argc, char *argv[])
+{
+    GRAPH_HANDLE graph = NULL;
+    SHARED_T shared;
+    READER_T readers[MAX_READERS];
+    pthread_t threads[MAX_READERS];
+    PUBLISHER_STATS_T stats;
+    struct timeval start;
+    struct timeval end;
+    char key1[32];
+    char key2[32];
+    int vertexCount = (argc > 1) ? atoi(argv[1]) : 1000;
+    int readerCount = (argc > 2) ? atoi(argv[2]) : 4;
+    int changeCount = (argc > 3) ? atoi(argv[3]) : 2000;
+    int perPublish = (argc > 4) ? atoi(argv[4]) : 10;
+    int started = 0;
+    long totalQueries = 0;
+    long totalFound = 0;
+    double seconds = 0;
+    int i = 0;
+
+    if ((vertexCount < 2) || (readerCount < 1) ||
+	(readerCount > MAX_READERS) || (changeCount < 0) || (perPublish < 1))
+    {
+	fprintf(stderr,
+		"Usage: %s [vertices [readers [changes [perPublish]]]]\n",
+		argv[0]);
+	fprintf(stderr, "  (at least 2 vertices, 1 to %d readers)\n",
+		MAX_READERS);
+	exit(1);
+    }
+    graph = newGraph(vertexCount, 1);
+    for (i = 0; (graph != NULL) && (i < vertexCount); i++)
+    {
+	sprintf(key1, "v%d", i);
+	if (!addDemoVertex(graph, key1))
+	{
+	    graphDestroy(graph);
+	    graph = NULL;
+	}
+    }
+    if (graph == NULL)
+    {
+	fprintf(stderr, "Memory allocation error building the network\n");
+	exit(1);
+    }
+    srand(1);
+    for (i = 0; i < vertexCount * 4; i++)
+    {
+	sprintf(key1, "v%d", rand() % vertexCount);
+	sprintf(key2, "v%d", rand() % vertexCount);
+	if (strcmp(key1, key2) != 0)
+	    addEdge(graph, key1, key2, 1 + rand() % 9);
+    }
+    shared.publisher = newPublisher(graph, readerCount);
+    if (shared.publisher == NULL)
+    {
+	fprintf(stderr, "Memory allocation error creating the publisher\n");
+	graphDestroy(graph);
+	exit(1);
+    }
+    atomic_init(&shared.bStop, 0);
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < readerCount; i++)
+    {
+	memset(&readers[i], 0, sizeof(READER_T));
+	readers[i].pShared = &shared;
+	readers[i].seed = i + 1;
+	if (pthread_create(&threads[i], NULL, &readerThread, &readers[i])
+	    != 0)
+	    break;
+	started++;
+    }
+
+    /* The main thread is the writer */
+    for (i = 1; i <= changeCount; i++)
+    {
+	sprintf(key1, "v%d", rand() % vertexCount);
+	if (i % 50 == 0)
+	{
+	    /* take a vertex out and put it back, without its edges */
+	    char *pData = removeVertex(graph, key1);
+	    /* readers may still see the data in older snapshots */
+	    if ((pData != NULL) &&
+		(!publisherRetireData(shared.publisher, pData)))
+		fprintf(stderr, "Memory allocation error retiring data\n");
+	    addDemoVertex(graph, key1);
+	}
+	else
+	{
+	    sprintf(key2, "v%d", rand() % vertexCount);
+	    if (findEdge(graph, key1, key2) >= 0)
+		removeEdge(graph, key1, key2);
+	    else if (strcmp(key1, key2) != 0)
+		addEdge(graph, key1, key2, 1 + rand() % 9);
+	}
+	if ((i % perPublish == 0) && (!publishNetwork(shared.publisher)))
+	    fprintf(stderr, "Memory allocation error publishing\n");
+    }
+
+    atomic_store(&shared.bStop, 1);
+    for (i = 0; i < started; i++)
+	pthread_join(threads[i], NULL);
+    gettimeofday(&end, NULL);
+    seconds = (end.tv_sec - start.tv_sec) +
+	(end.tv_usec - start.tv_usec) / 1000000.0;
+
+    for (i = 0; i < started; i++)
+    {
+	if (readers[i].bFailed)
+	    printf("Reader %d could not start\n", i);
+	printf("Reader %d: %ld queries, %ld found a path\n",
+	       i, readers[i].queries, readers[i].found);
+	totalQueries += readers[i].queries;
+	totalFound += readers[i].found;
+    }
+    publisherReclaim(shared.publisher);
+    getPublisherStats(shared.publisher, &stats);
+    printf("%d changes in %.3f seconds, %ld snapshots published\n",
+	   changeCount, seconds, stats.published);
+    printf("%ld old snapshots freed, %d still waiting\n",
+	   stats.reclaimed, stats.pending);
+    printf("%ld queries (%.0f per second), %ld found a path\n",
+	   totalQueries, (seconds > 0) ? totalQueries / seconds : 0.0,
+	   totalFound);
+
+    publisherDestroy(shared.publisher);
+    /* free the data of the vertices that are left */
+    for (i = 0; i < vertexCount; i++)
+    {
+	sprintf(key1, "v%d", i);
+	free(removeVertex(graph, key1));
+    }
+    graphDestroy(graph);
+    return 0;
+}
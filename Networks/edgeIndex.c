@@ -0,0 +1,215 @@
+/*
+ *  edgeIndex.c
+ *
+ *  Hash table that maps pointer keys to pointers, using open
+ *  addressing with linear probing, exactly like keyIndex.c.
+ *
+ *  Pointers returned by malloc are multiples of 8 or 16, and
+ *  vertices allocated one after another are usually close together,
+ *  so we mix the bits with a multiplication (Fibonacci hashing)
+ *  before using them to choose a slot.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "edgeIndex.h"
+
+#define MIN_SLOTS 16
+
+/* One slot in the table. An empty slot has a NULL key */
+typedef struct
+{
+    void *key;			/* key pointer */
+    void *value;		/* pointer stored for this key */
+} SLOT_T;
+
+/* Structure holding one index */
+typedef struct
+{
+    SLOT_T *slots;		/* array of slots */
+    int slotCount;		/* size of the array, a power of two */
+    int count;			/* number of keys stored */
+} EDGE_INDEX_T;
+
+
+/* Compute a hash value for a pointer.
+ * Arguments
+ *   key    -   Pointer to hash
+ * Returns the hash value
+ */
+static unsigned int hashPointer(void *key)
+{
+    uint64_t bits = (uint64_t) (uintptr_t) key;
+    return (unsigned int) ((bits * 11400714819323198485ull) >> 32);
+}
+
+/* Find the slot holding a key, or the empty slot where it would go.
+ * Arguments
+ *   pIndex  -   Index to search
+ *   key     -   Key we are looking for
+ * Returns the slot number.
+ */
+static int probe(EDGE_INDEX_T * pIndex, void *key)
+{
+    int mask = pIndex->slotCount - 1;
+    int i = hashPointer(key) & mask;
+    while ((pIndex->slots[i].key != NULL) && (pIndex->slots[i].key != key))
+	i = (i + 1) & mask;
+    return i;
+}
+
+/* Allocate a new slot array of a different size and move
+ * all the existing keys into it.
+ * Arguments
+ *   pIndex      -   Index to resize
+ *   newCount    -   New number of slots (a power of two)
+ * Returns 1 if successful, 0 for a memory allocation error.
+ */
+static int resize(EDGE_INDEX_T * pIndex, int newCount)
+{
+    int i = 0;
+    SLOT_T *oldSlots = pIndex->slots;
+    int oldCount = pIndex->slotCount;
+    SLOT_T *newSlots = calloc(newCount, sizeof(SLOT_T));
+    if (newSlots == NULL)
+	return 0;
+    pIndex->slots = newSlots;
+    pIndex->slotCount = newCount;
+    for (i = 0; i < oldCount; i++)
+    {
+	if (oldSlots[i].key != NULL)
+	    newSlots[probe(pIndex, oldSlots[i].key)] = oldSlots[i];
+    }
+    free(oldSlots);
+    return 1;
+}
+
+
+/********************************/
+/** Public functions start here */
+/********************************/
+
+/* Create a new, empty index.
+ * Arguments
+ *   expectedCount  -  How many keys we expect to store.
+ * Returns a handle for the index, or NULL if a memory allocation
+ * error occurs.
+ */
+EDGE_INDEX_HANDLE newEdgeIndex(int expectedCount)
+{
+    EDGE_INDEX_T *pIndex = calloc(1, sizeof(EDGE_INDEX_T));
+    int slotCount = MIN_SLOTS;
+    /* keep the table no more than 70% full */
+    while (slotCount * 7 < expectedCount * 10)
+	slotCount *= 2;
+    if (pIndex != NULL)
+    {
+	pIndex->slots = calloc(slotCount, sizeof(SLOT_T));
+	pIndex->slotCount = slotCount;
+	if (pIndex->slots == NULL)
+	{
+	    free(pIndex);
+	    pIndex = NULL;
+	}
+    }
+    return (EDGE_INDEX_HANDLE) pIndex;
+}
+
+
+/* Free all memory associated with an index. Does not free
+ * the keys or the values.
+ * Arguments
+ *   index   -  Index to free. Not valid after this call.
+ */
+void edgeIndexDestroy(EDGE_INDEX_HANDLE index)
+{
+    EDGE_INDEX_T *pIndex = (EDGE_INDEX_T *) index;
+    if (pIndex != NULL)
+    {
+	free(pIndex->slots);
+	free(pIndex);
+    }
+}
+
+
+/* Add a key and its value to the index.
+ * Arguments
+ *   index   -  Index to add to
+ *   key     -  Key pointer (must not be NULL)
+ *   value   -  Pointer to associate with the key
+ * Returns 1 if successful, -1 if the key is already in the index,
+ * 0 if a memory allocation error occurs.
+ */
+int edgeIndexInsert(EDGE_INDEX_HANDLE index, void *key, void *value)
+{
+    EDGE_INDEX_T *pIndex = (EDGE_INDEX_T *) index;
+    int i = 0;
+    if ((pIndex->count + 1) * 10 > pIndex->slotCount * 7)
+    {
+	if (!resize(pIndex, pIndex->slotCount * 2))
+	    return 0;
+    }
+    i = probe(pIndex, key);
+    if (pIndex->slots[i].key != NULL)
+	return -1;
+    pIndex->slots[i].key = key;
+    pIndex->slots[i].value = value;
+    pIndex->count++;
+    return 1;
+}
+
+
+/* Find the value associated with a key.
+ * Arguments
+ *   index   -  Index to search
+ *   key     -  Key we are looking for
+ * Returns the value, or NULL if the key is not in the index.
+ */
+void *edgeIndexLookup(EDGE_INDEX_HANDLE index, void *key)
+{
+    EDGE_INDEX_T *pIndex = (EDGE_INDEX_T *) index;
+    return pIndex->slots[probe(pIndex, key)].value;	/* NULL if empty */
+}
+
+
+/* Remove a key from the index. As in keyIndex.c, we move later
+ * entries in the same run back to fill the hole.
+ * Arguments
+ *   index   -  Index to remove from
+ *   key     -  Key to remove
+ * Returns the value that was associated with the key, or NULL
+ * if the key was not in the index.
+ */
+void *edgeIndexRemove(EDGE_INDEX_HANDLE index, void *key)
+{
+    EDGE_INDEX_T *pIndex = (EDGE_INDEX_T *) index;
+    int mask = pIndex->slotCount - 1;
+    int hole = probe(pIndex, key);
+    int i = 0;
+    void *value = pIndex->slots[hole].value;
+    if (pIndex->slots[hole].key == NULL)
+	return NULL;
+    i = (hole + 1) & mask;
+    while (pIndex->slots[i].key != NULL)
+    {
+	int home = hashPointer(pIndex->slots[i].key) & mask;
+	/* this entry can move into the hole only if its home slot
+	 * is not between the hole and where it is now */
+	if (((i - home) & mask) >= ((i - hole) & mask))
+	{
+	    pIndex->slots[hole] = pIndex->slots[i];
+	    hole = i;
+	}
+	i = (i + 1) & mask;
+    }
+    pIndex->slots[hole].key = NULL;
+    pIndex->slots[hole].value = NULL;
+    pIndex->count--;
+    return value;
+}
@@ -0,0 +1,72 @@
+/**
+ *  edgeIndex.h
+ *
+ *  Header file for a small hash table module that maps vertex
+ *  pointers to pointers. linkedListNetwork.c gives one to each
+ *  vertex with many edges, mapping the vertex at the other end of
+ *  each edge to its adjacency list item, so that it can find an edge
+ *  in constant expected time instead of searching the whole list.
+ *
+ *  It works just like keyIndex.c, except that the keys are compared
+ *  as pointers rather than as strings.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+#ifndef EDGEINDEX_H
+#define EDGEINDEX_H
+
+/* opaque pointer to an index */
+typedef void* EDGE_INDEX_HANDLE;
+
+/* Create a new, empty index.
+ * Arguments
+ *   expectedCount  -  How many keys we expect to store. The index
+ *                     grows if more are added.
+ * Returns a handle for the index, or NULL if a memory allocation
+ * error occurs.
+ */
+EDGE_INDEX_HANDLE newEdgeIndex(int expectedCount);
+
+
+/* Free all memory associated with an index. Does not free
+ * the keys or the values.
+ * Arguments
+ *   index   -  Index to free. Not valid after this call.
+ */
+void edgeIndexDestroy(EDGE_INDEX_HANDLE index);
+
+
+/* Add a key and its value to the index.
+ * Arguments
+ *   index   -  Index to add to
+ *   key     -  Key pointer (must not be NULL)
+ *   value   -  Pointer to associate with the key
+ * Returns 1 if successful, -1 if the key is already in the index,
+ * 0 if a memory allocation error occurs.
+ */
+int edgeIndexInsert(EDGE_INDEX_HANDLE index, void* key, void* value);
+
+
+/* Find the value associated with a key.
+ * Arguments
+ *   index   -  Index to search
+ *   key     -  Key we are looking for
+ * Returns the value, or NULL if the key is not in the index.
+ */
+void* edgeIndexLookup(EDGE_INDEX_HANDLE index, void* key);
+
+
+/* Remove a key from the index.
+ * Arguments
+ *   index   -  Index to remove from
+ *   key     -  Key to remove
+ * Returns the value that was associated with the key, or NULL
+ * if the key was not in the index.
+ */
+void* edgeIndexRemove(EDGE_INDEX_HANDLE index, void* key);
+
+#endif
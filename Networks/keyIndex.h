@@ -0,0 +1,82 @@
+/**
+ *  keyIndex.h
+ *
+ *  Header file for a small hash table module that maps string keys
+ *  to pointers. It is used by the graph and network implementations
+ *  to find a vertex from its key in constant expected time, instead
+ *  of searching the whole vertex list.
+ *
+ *  Each call to newKeyIndex() creates a new, independent index.
+ *  The index does not copy the keys. The caller must make sure each
+ *  key string stays valid (and unchanged) as long as it is stored
+ *  in the index.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+#ifndef KEYINDEX_H
+#define KEYINDEX_H
+
+/* opaque pointer to an index */
+typedef void* KEY_INDEX_HANDLE;
+
+/* Create a new, empty index.
+ * Arguments
+ *   expectedCount  -  How many keys we expect to store. The index
+ *                     grows if more are added, but giving a good
+ *                     estimate avoids rehashing.
+ * Returns a handle for the index, or NULL if a memory allocation
+ * error occurs.
+ */
+KEY_INDEX_HANDLE newKeyIndex(int expectedCount);
+
+
+/* Free all memory associated with an index. Does not free
+ * the keys or the values.
+ * Arguments
+ *   index   -  Index to free. Not valid after this call.
+ */
+void keyIndexDestroy(KEY_INDEX_HANDLE index);
+
+
+/* Add a key and its value to the index.
+ * Arguments
+ *   index   -  Index to add to
+ *   key     -  Key string (not copied)
+ *   value   -  Pointer to associate with the key
+ * Returns 1 if successful, -1 if the key is already in the index,
+ * 0 if a memory allocation error occurs.
+ */
+int keyIndexInsert(KEY_INDEX_HANDLE index, char* key, void* value);
+
+
+/* Find the value associated with a key.
+ * Arguments
+ *   index   -  Index to search
+ *   key     -  Key we are looking for
+ * Returns the value, or NULL if the key is not in the index.
+ */
+void* keyIndexLookup(KEY_INDEX_HANDLE index, char* key);
+
+
+/* Remove a key from the index.
+ * Arguments
+ *   index   -  Index to remove from
+ *   key     -  Key to remove
+ * Returns the value that was associated with the key, or NULL
+ * if the key was not in the index.
+ */
+void* keyIndexRemove(KEY_INDEX_HANDLE index, char* key);
+
+
+/* Find out how many keys are in the index.
+ * Arguments
+ *   index   -  Index we are interested in
+ * Returns number of keys (could be zero)
+ */
+int keyIndexCount(KEY_INDEX_HANDLE index);
+
+#endif
@@ -10,6 +10,48 @@
  *  Each vertex has an integer weight and a pointer to a parent vertex 
  *  which can be used for route finding and spanning tree algorithms
  *
+ *  To find a vertex from its key quickly, we also keep a hash table
+ *  (keyIndex.c) that maps each key to its vertex. The vertex list is
+ *  doubly linked so that we can unlink a vertex found this way
+ *  without searching for its predecessor.
+ *
+ *  Each vertex also gets a small integer index when it is added, and
+ *  we keep a table that maps indices back to vertices. This lets us
+ *  use the general shortest path engine in shortestPath.c, which keeps
+ *  its working information in arrays indexed by vertex index.
+ *
+ *  In a directed network, each vertex also keeps a second list of
+ *  the edges that enter it. This lets the shortest path engine search
+ *  backward from the end vertex as well as forward from the start.
+ *
+ *  Optionally, the network can keep the shortest paths from one
+ *  source vertex up to date as edges change (see pathTree.h).
+ *  addEdge, removeEdge and removeVertex report each change to the
+ *  tree, which repairs only the part that is affected.
+ *
+ *  Some vertices may have tens of thousands of edges. Once a list
+ *  of edges gets longer than EDGE_INDEX_THRESHOLD, we add a hash
+ *  table (edgeIndex.c) that maps the vertex at the other end of each
+ *  edge to its list item, so finding or removing an edge does not
+ *  need to search the list. The lists are doubly linked so that an
+ *  item found this way can be unlinked directly.
+ *
+ *  Vertices and adjacency list items are not allocated one at a
+ *  time with calloc. Instead they come from two pools (nodePool.c),
+ *  which get memory in large slabs and reuse freed items. graphDestroy
+ *  gives back each pool as a whole instead of freeing every edge.
+ *
+ *  Everything about one network is kept in a NETWORK_T structure,
+ *  and the handle returned by newGraph() points to it. Traversals and
+ *  shortest path searches keep their working information (colors,
+ *  queues, distances) in storage of their own, so they do not change
+ *  the network and several threads can search it at once. A network
+ *  keeps one spare shortest path search so that a program making one
+ *  query after another does not allocate new storage every time.
+ *  Depth first traversals are done by depthFirst.c, which keeps its
+ *  own stack instead of using recursion, so very long chains of
+ *  vertices do not overflow the C stack.
+ *
  *  Key values are strings and are copied when vertices are inserted into
  *  the graph. Every vertex has a void* pointer to ancillary data which
  *  is simply stored. 
@@ -24,14 +66,30 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include "abstractNetwork.h"
-#include "abstractQueue.h"
+#include "shortestPath.h"
 #include "minPriorityQueue.h"
+#include "networkSnapshot.h"
+#include "pathBatch.h"
+#include "keyIndex.h"
+#include "pathTree.h"
+#include "edgeIndex.h"
+#include "nodePool.h"
+#include "depthFirst.h"
 
 #define WHITE 0
 #define GRAY  1
 #define BLACK 2
 
+/* Lists with at least this many edges get a hash index. The index
+ * is dropped again if the list shrinks to half this size. */
+#define EDGE_INDEX_THRESHOLD 32
+
+/* Number of records in each slab of the vertex and edge pools */
+#define VERTEX_SLAB_SIZE 1024
+#define EDGE_SLAB_SIZE 4096
+
 char *colorName[] = { "WHITE", "GRAY", "BLACK" };
 
 
@@ -45,153 +103,288 @@ typedef struct _adjacent
 				 */
     unsigned int weight;	/* weight of this edge */
     struct _adjacent *next;	/* next item in the ajacency list */
+    struct _adjacent *prev;	/* previous item in the ajacency list */
 } ADJACENT_T;
 
+/* A list of edges, with its optional index */
+typedef struct
+{
+    ADJACENT_T *head;		/* first item in the list */
+    ADJACENT_T *tail;		/* last item in the list */
+    int count;			/* number of items in the list */
+    EDGE_INDEX_HANDLE index;	/* maps vertex to item, or NULL if the
+				 * list is short */
+} EDGE_LIST_T;
+
 /* List items for the main vertex list.*/
 typedef struct _vertex
 {
     char *key;			/* key for this vertex */
     void *data;			/* ancillary data for this vertex */
-    int color;			/* used to mark nodes as visited */
-    int dValue;			/* sum of weights for shortest path so far to this vertex */
-    struct _vertex *parent;	/* pointer to parent found in Dijkstra's algorithm */
+    int index;			/* position of this vertex in vertexTable */
     struct _vertex *next;	/* next vertex in the list */
-    ADJACENT_T *adjacentHead;	/* pointer to the head of the
-				 * adjacent vertices list
-				 */
-    ADJACENT_T *adjacentTail;	/* pointer to the tail of the
-				 * adjacent vertices list
+    struct _vertex *prev;	/* previous vertex in the list */
+    EDGE_LIST_T adjacent;	/* adjacent vertices list */
+    EDGE_LIST_T reverse;	/* list of edges entering this vertex
+				 * (directed networks only). Each item
+				 * refers to the start vertex.
 				 */
 } VERTEX_T;
 
 
-VERTEX_T *vListHead = NULL;	/* head of the vertex list */
-VERTEX_T *vListTail = NULL;	/* tail of the vertex list */
-int bGraphDirected = 0;		/* if true, this is a directed graph */
-int weightSum = 0;		/* keep track of total of weights in the graph */
-int bHasNeg = 0;		/* check if we have negative weights */
-int vertexCount = 0;		/* keep track of how many vertices, */
+/* Working storage for a traversal. A vertex has been seen by
+ * the current traversal if its mark equals the epoch; marks left
+ * by earlier traversals are smaller, so nothing has to be cleared
+ * before a new one starts.
+ */
+typedef struct
+{
+    int capacity;		/* number of entries in each array */
+    unsigned int epoch;		/* mark value for the current traversal */
+    unsigned int *mark;		/* epoch when each vertex was queued */
+    VERTEX_T **queue;		/* vertices waiting to be visited by a
+				 * breadth first traversal */
+} TRAVERSAL_T;
+
+/* Structure holding one network */
+typedef struct
+{
+    VERTEX_T *vListHead;	/* head of the vertex list */
+    VERTEX_T *vListTail;	/* tail of the vertex list */
+    int bGraphDirected;		/* if true, this is a directed graph */
+    int weightSum;		/* keep track of total of weights in the graph */
+    int bHasNeg;		/* check if we have negative weights */
+    int vertexCount;		/* keep track of how many vertices, */
 			      /* for use in printPath */
+    VERTEX_T **vertexTable;	/* maps vertex index to vertex */
+    int tableSize;		/* allocated size of vertexTable */
+    int nextIndex;		/* index to give the next vertex added */
+    KEY_INDEX_HANDLE vertexIndex;	/* maps keys to vertices */
+    PATH_TREE_HANDLE pathTree;	/* shortest paths kept up to date */
+    NODE_POOL_HANDLE vertexPool;	/* storage for VERTEX_T records */
+    NODE_POOL_HANDLE edgePool;	/* storage for ADJACENT_T records */
+    PATH_SEARCH_HANDLE spareSearch;	/* working storage for Dijkstra that
+					 * no search is using, or NULL */
+    pthread_mutex_t searchLock;	/* protects spareSearch */
+    TRAVERSAL_T *spareTraversal;	/* traversal storage that no
+					 * traversal is using, or NULL */
+    pthread_mutex_t traversalLock;	/* protects spareTraversal */
+    NETWORK_SNAPSHOT_T *pBatchSnapshot;	/* frozen copy searched by
+					 * findShortestPathBatch, or NULL
+					 * if the network has changed */
+    pthread_mutex_t batchLock;	/* protects pBatchSnapshot */
+} NETWORK_T;
 
 /** Private functions */
 
 /* Finds the vertex that holds the passed key
  * (if any) and returns a pointer to that vertex.
+ * Uses the key index rather than searching the list.
  * Arguments
+ *       pNet   -  Network to search
  *       key    -  Key we are looking for
  *       pPred  -  used to return the predecessor if any
  * Returns pointer to the vertex structure if one is found       
  */
-VERTEX_T *findVertexByKey(char *key, VERTEX_T **pPred)
+VERTEX_T *findVertexByKey(NETWORK_T *pNet, char *key, VERTEX_T **pPred)
 {
-    VERTEX_T *pFoundVtx = NULL;
-    VERTEX_T *pCurVertex = vListHead;
+    VERTEX_T *pFoundVtx = (VERTEX_T *) keyIndexLookup(pNet->vertexIndex, key);
     *pPred = NULL;
-    /* while there are vertices left and we haven't found
-     * the one we want.
-     */
-    while ((pCurVertex != NULL) && (pFoundVtx == NULL))
-    {
-	if (strcmp(pCurVertex->key, key) == 0)
-	{
-	    pFoundVtx = pCurVertex;
-	}
-	else
-	{
-	    *pPred = pCurVertex;
-	    pCurVertex = pCurVertex->next;
-	}
-    }
+    if (pFoundVtx != NULL)
+	*pPred = pFoundVtx->prev;
     return pFoundVtx;
 }
 
-/* Free the adjacencyList for a vertex 
- * Argument
- *   pVertex    - vertex whose edges we want to delete 
+/* Free all the items in one list of edges, and its index.
+ * Arguments
+ *   pNet       - network the list belongs to
+ *   pList      - list to empty
  */
-void freeAdjacencyList(VERTEX_T *pVertex)
+void freeEdgeList(NETWORK_T *pNet, EDGE_LIST_T *pList)
 {
-    ADJACENT_T *pCurRef = pVertex->adjacentHead;
+    ADJACENT_T *pCurRef = pList->head;
     while (pCurRef != NULL)
     {
 	ADJACENT_T *pDelRef = pCurRef;
 	pCurRef = pCurRef->next;
-	free(pDelRef);
+	nodePoolFree(pNet->edgePool, pDelRef);
     }
-    pVertex->adjacentHead = NULL;
-    pVertex->adjacentTail = NULL;
+    edgeIndexDestroy(pList->index);
+    memset(pList, 0, sizeof(EDGE_LIST_T));
 }
 
-/* Check if there is already an edge between
- * two vertices. We do not want to add a duplicate.
+/* Free the adjacencyList for a vertex, and its list of
+ * entering edges if it has one.
  * Arguments
- *   pFrom        -  Start point of edge
- *   pTo          -  End point of edge
- * Return 1 if an edge already exists, 0 if it does
- * not.
+ *   pNet       - network the vertex belongs to
+ *   pVertex    - vertex whose edges we want to delete 
  */
-int edgeExists(VERTEX_T *pFrom, VERTEX_T *pTo)
+void freeAdjacencyList(NETWORK_T *pNet, VERTEX_T *pVertex)
 {
-    int bEdgeExists = 0;
-    ADJACENT_T *pCurRef = pFrom->adjacentHead;
-    while ((pCurRef != NULL) && (!bEdgeExists))
+    freeEdgeList(pNet, &pVertex->adjacent);
+    freeEdgeList(pNet, &pVertex->reverse);
+}
+
+/* Find the item referring to a particular vertex in a list
+ * of edges, using the index if the list has one.
+ * Arguments
+ *   pList      - list to search
+ *   pVertex    - vertex we are looking for
+ * Returns the item, or NULL if no item refers to pVertex.
+ */
+ADJACENT_T *findInEdgeList(EDGE_LIST_T *pList, VERTEX_T *pVertex)
+{
+    ADJACENT_T *pCurRef = NULL;
+    if (pList->index != NULL)
+	return (ADJACENT_T *) edgeIndexLookup(pList->index, pVertex);
+    pCurRef = pList->head;
+    /* compare vertex pointers rather than key strings */
+    while ((pCurRef != NULL) && (pCurRef->pVertex != pVertex))
+	pCurRef = pCurRef->next;
+    return pCurRef;
+}
+
+/* Build the index for a list that has become long. If there
+ * is not enough memory, the list just stays unindexed.
+ * Argument
+ *   pList      - list to index
+ */
+void buildEdgeIndex(EDGE_LIST_T *pList)
+{
+    ADJACENT_T *pCurRef = pList->head;
+    pList->index = newEdgeIndex(pList->count * 2);
+    while ((pCurRef != NULL) && (pList->index != NULL))
     {
-	if (pCurRef->pVertex == pTo)
+	if (edgeIndexInsert(pList->index, pCurRef->pVertex, pCurRef) != 1)
 	{
-	    bEdgeExists = 1;	/* the 'To' vertex is already in the
-				 * 'From' vertex's adjacency list */
+	    edgeIndexDestroy(pList->index);
+	    pList->index = NULL;
 	}
+	pCurRef = pCurRef->next;
+    }
+}
+
+/* Add a new item to the end of a list of edges.
+ * Arguments
+ *   pNet       - network the list belongs to
+ *   pList      - list to add to
+ *   pVertex    - vertex the new item refers to
+ *   weight     - weight of the edge
+ * Returns 1 if successful, 0 for a memory allocation error.
+ */
+int appendEdge(NETWORK_T *pNet, EDGE_LIST_T *pList, VERTEX_T *pVertex,
+	       int weight)
+{
+    ADJACENT_T *pNewRef = (ADJACENT_T *) nodePoolAlloc(pNet->edgePool);
+    if (pNewRef == NULL)
+	return 0;
+    if ((pList->index != NULL) &&
+	(edgeIndexInsert(pList->index, pVertex, pNewRef) != 1))
+    {
+	nodePoolFree(pNet->edgePool, pNewRef);
+	return 0;
+    }
+    pNewRef->pVertex = pVertex;
+    pNewRef->weight = weight;
+    pNewRef->prev = pList->tail;
+    if (pList->tail != NULL)
+	pList->tail->next = pNewRef;
+    else
+	pList->head = pNewRef;
+    pList->tail = pNewRef;
+    pList->count++;
+    if ((pList->index == NULL) && (pList->count >= EDGE_INDEX_THRESHOLD))
+	buildEdgeIndex(pList);
+    return 1;
+}
+
+/* Take the item referring to a particular vertex out of a list
+ * of edges. The caller must free the item, with nodePoolFree.
+ * Arguments
+ *   pList      - list to remove from
+ *   pVertex    - vertex whose item we want to remove
+ * Returns the item, or NULL if no item refers to pVertex.
+ */
+ADJACENT_T *unlinkEdge(EDGE_LIST_T *pList, VERTEX_T *pVertex)
+{
+    ADJACENT_T *pAdjacent = findInEdgeList(pList, pVertex);
+    if (pAdjacent != NULL)
+    {
+	if (pAdjacent->prev != NULL)
+	    pAdjacent->prev->next = pAdjacent->next;
+	else
+	    pList->head = pAdjacent->next;
+	if (pAdjacent->next != NULL)
+	    pAdjacent->next->prev = pAdjacent->prev;
 	else
+	    pList->tail = pAdjacent->prev;
+	pList->count--;
+	if (pList->index != NULL)
 	{
-	    pCurRef = pCurRef->next;
+	    edgeIndexRemove(pList->index, pVertex);
+	    if (pList->count < EDGE_INDEX_THRESHOLD / 2)
+	    {
+		edgeIndexDestroy(pList->index);
+		pList->index = NULL;
+	    }
 	}
     }
-    return bEdgeExists;
+    return pAdjacent;
+}
+
+/* Check if there is already an edge between
+ * two vertices. We do not want to add a duplicate.
+ * Arguments
+ *   pFrom        -  Start point of edge
+ *   pTo          -  End point of edge
+ * Return 1 if an edge already exists, 0 if it does
+ * not.
+ */
+int edgeExists(VERTEX_T *pFrom, VERTEX_T *pTo)
+{
+    return (findInEdgeList(&pFrom->adjacent, pTo) != NULL);
 }
 
 /* Component of removeVertex. Removes all references
  * to this vertex as the end point of edges in other
- * vertices' adjacency lists.
+ * vertices' adjacency lists, and as the start point of
+ * edges in their lists of entering edges.
+ * Only the vertices at the other end of this vertex's
+ * own edges can refer to it, so we visit just those,
+ * following its adjacency list and its list of entering
+ * edges (which is empty if the network is undirected,
+ * since then each edge is stored in both adjacency lists).
+ * Arguments
+ *   pNet       - network the vertex belongs to
+ *   pTarget    - vertex that is being removed
  */
-void removeReferences(VERTEX_T *pTarget)
+void removeReferences(NETWORK_T *pNet, VERTEX_T *pTarget)
 {
-    VERTEX_T *pCurrentVtx = vListHead;
-    while (pCurrentVtx != NULL)
+    ADJACENT_T *pRef = pTarget->adjacent.head;
+    while (pRef != NULL)
     {
-	if (pCurrentVtx != pTarget)
+	VERTEX_T *pOther = (VERTEX_T *) pRef->pVertex;
+	if (pOther != pTarget)
 	{
-	    /* skip the target vertex */
-	    ADJACENT_T *pAdjacent = pCurrentVtx->adjacentHead;
-	    ADJACENT_T *pPrevAdjacent = NULL;
-	    while (pAdjacent != NULL)
-	    {
-		if (pAdjacent->pVertex == pTarget)	
-                /* if this edge involves the target */
-		{
-		    if (pPrevAdjacent != NULL)
-		    {
-			pPrevAdjacent->next = pAdjacent->next;
-		    }
-		    else
-		    {
-			pCurrentVtx->adjacentHead = pAdjacent->next;
-		    }
-		    if (pAdjacent == pCurrentVtx->adjacentTail)
-		    {
-			pCurrentVtx->adjacentTail = NULL;
-		    }
-		    free(pAdjacent);
-		    pAdjacent = NULL;
-		    break;	/* can only show up once in the adjacency list */
-		}
-		else
-		{
-		    pPrevAdjacent = pAdjacent;
-		    pAdjacent = pAdjacent->next;
-		}
-	    }
+	    /* skip a loop on the target vertex. It can only show
+	     * up once in each list */
+	    if (pNet->bGraphDirected)
+		nodePoolFree(pNet->edgePool,
+			     unlinkEdge(&pOther->reverse, pTarget));
+	    else
+		nodePoolFree(pNet->edgePool,
+			     unlinkEdge(&pOther->adjacent, pTarget));
 	}
-	pCurrentVtx = pCurrentVtx->next;
+	pRef = pRef->next;
+    }
+    pRef = pTarget->reverse.head;
+    while (pRef != NULL)
+    {
+	VERTEX_T *pOther = (VERTEX_T *) pRef->pVertex;
+	if (pOther != pTarget)
+	    nodePoolFree(pNet->edgePool,
+			 unlinkEdge(&pOther->adjacent, pTarget));
+	pRef = pRef->next;
     }
 }
 
@@ -202,109 +395,285 @@ void removeReferences(VERTEX_T *pTarget)
  */
 int countAdjacent(VERTEX_T *pVertex)
 {
-    int count = 0;
-    ADJACENT_T *pAdjacent = pVertex->adjacentHead;
+    return pVertex->adjacent.count;
+}
+
+/* Give a new vertex the next free index and record it
+ * in the vertex table, growing the table if necessary.
+ * Arguments
+ *    pNet      -   Network the vertex belongs to
+ *    pVertex   -   Newly created vertex
+ * Returns 1 if successful, 0 if allocation fails.
+ */
+int addToVertexTable(NETWORK_T *pNet, VERTEX_T *pVertex)
+{
+    int bOk = 1;
+    if (pNet->nextIndex == pNet->tableSize)
+    {
+	int newSize = (pNet->tableSize == 0) ? 64 : pNet->tableSize * 2;
+	VERTEX_T **newTable =
+	    realloc(pNet->vertexTable, newSize * sizeof(VERTEX_T *));
+	if (newTable == NULL)
+	{
+	    bOk = 0;
+	}
+	else
+	{
+	    pNet->vertexTable = newTable;
+	    pNet->tableSize = newSize;
+	}
+    }
+    if (bOk)
+    {
+	pVertex->index = pNet->nextIndex;
+	pNet->vertexTable[pNet->nextIndex] = pVertex;
+	pNet->nextIndex++;
+    }
+    return bOk;
+}
+
+/* Edge walker for the shortest path engine. Calls the
+ * engine's relax function for every edge leaving a vertex.
+ * Arguments
+ *    pGraph     -  network to search (will be cast to NETWORK_T *)
+ *    fromIndex  -  index of the vertex whose edges we want
+ *    relax      -  function to call for each edge
+ *    pSearch    -  passed back to relax
+ */
+void walkAdjacentEdges(void *pGraph, int fromIndex,
+		       RELAX_FUNCTION_T relax, void *pSearch)
+{
+    NETWORK_T *pNet = (NETWORK_T *) pGraph;
+    ADJACENT_T *pAdjacent = pNet->vertexTable[fromIndex]->adjacent.head;
     while (pAdjacent != NULL)
     {
-	count += 1;
+	VERTEX_T *pTo = (VERTEX_T *) pAdjacent->pVertex;
+	(*relax) (pSearch, pTo->index, pAdjacent->weight);
 	pAdjacent = pAdjacent->next;
     }
-    return count;
 }
 
-/* Color all vertices to the passed color.
+/* Edge walker for searching backward. Calls the engine's
+ * relax function for every edge entering a vertex.
+ * Arguments
+ *    pGraph     -  network to search (will be cast to NETWORK_T *)
+ *    toIndex    -  index of the vertex whose entering edges we want
+ *    relax      -  function to call for each edge
+ *    pSearch    -  passed back to relax
+ */
+void walkEnteringEdges(void *pGraph, int toIndex,
+		       RELAX_FUNCTION_T relax, void *pSearch)
+{
+    NETWORK_T *pNet = (NETWORK_T *) pGraph;
+    ADJACENT_T *pAdjacent = pNet->vertexTable[toIndex]->reverse.head;
+    while (pAdjacent != NULL)
+    {
+	VERTEX_T *pFrom = (VERTEX_T *) pAdjacent->pVertex;
+	(*relax) (pSearch, pFrom->index, pAdjacent->weight);
+	pAdjacent = pAdjacent->next;
+    }
+}
+
+
+/* Free the working storage for a traversal.
  * Argument
- *    A color constant
+ *    pTraversal -  Storage returned by takeTraversal, or NULL
  */
-void colorAll(int color)
+void freeTraversal(TRAVERSAL_T *pTraversal)
 {
-    VERTEX_T *pVertex = vListHead;
-    while (pVertex != NULL)
+    if (pTraversal != NULL)
     {
-	pVertex->color = color;
-	pVertex = pVertex->next;
+	free(pTraversal->mark);
+	free(pTraversal->queue);
+	free(pTraversal);
     }
 }
 
-/* Initialize the dValue and parent for all
- * vertices. dValue should be very big, parent
- * will be set to NULL. Also add to the minPriority queue.
+/* Take the network's spare traversal storage, or create new
+ * storage if another traversal is using it, and start a new
+ * traversal in which every vertex is unseen. The storage grows
+ * if vertices have been added since it was last used.
+ * Argument
+ *    pNet      -   Network we are going to traverse
+ * Returns the storage, or NULL if allocation fails.
  */
-void initAll()
+TRAVERSAL_T *takeTraversal(NETWORK_T *pNet)
 {
-    VERTEX_T *pVertex = vListHead;
-    while (pVertex != NULL)
+    int count = pNet->nextIndex + 1;
+    TRAVERSAL_T *pTraversal = NULL;
+    pthread_mutex_lock(&pNet->traversalLock);
+    pTraversal = pNet->spareTraversal;
+    pNet->spareTraversal = NULL;
+    pthread_mutex_unlock(&pNet->traversalLock);
+    if (pTraversal == NULL)
+	pTraversal = calloc(1, sizeof(TRAVERSAL_T));
+    if (pTraversal == NULL)
+	return NULL;
+    if (pTraversal->capacity < count)
     {
-	pVertex->dValue = weightSum + 1;
-	pVertex->parent = NULL;
-	enqueueMin(pVertex);
-	pVertex = pVertex->next;
+	int newCapacity = (pTraversal->capacity > 0) ?
+	    pTraversal->capacity : 64;
+	unsigned int *newMark = NULL;
+	VERTEX_T **newQueue = NULL;
+	while (newCapacity < count)
+	    newCapacity *= 2;
+	/* the old marks are not needed, so start afresh */
+	newMark = calloc(newCapacity, sizeof(unsigned int));
+	newQueue = calloc(newCapacity, sizeof(VERTEX_T *));
+	if ((newMark == NULL) || (newQueue == NULL))
+	{
+	    free(newMark);
+	    free(newQueue);
+	    freeTraversal(pTraversal);
+	    return NULL;
+	}
+	free(pTraversal->mark);
+	free(pTraversal->queue);
+	pTraversal->mark = newMark;
+	pTraversal->queue = newQueue;
+	pTraversal->capacity = newCapacity;
+	pTraversal->epoch = 0;
+    }
+    pTraversal->epoch++;
+    if (pTraversal->epoch == 0)
+    {
+	/* wrapped around, so old marks could match again */
+	memset(pTraversal->mark, 0, pTraversal->capacity * sizeof(unsigned int));
+	pTraversal->epoch = 1;
     }
+    return pTraversal;
+}
+
+/* Give traversal storage back after using it. It becomes the
+ * network's spare unless another traversal has already given
+ * its storage back.
+ * Arguments
+ *    pNet       -   Network that was traversed
+ *    pTraversal -   Storage returned by takeTraversal
+ */
+void giveTraversal(NETWORK_T *pNet, TRAVERSAL_T *pTraversal)
+{
+    pthread_mutex_lock(&pNet->traversalLock);
+    if (pNet->spareTraversal == NULL)
+    {
+	pNet->spareTraversal = pTraversal;
+	pTraversal = NULL;
+    }
+    pthread_mutex_unlock(&pNet->traversalLock);
+    freeTraversal(pTraversal);
 }
 
 
 /* Execute a breadth first search from a vertex,
  * calling the function (*vFunction) on each vertex
- * as we visit it and color it black.
+ * as we visit it. Each vertex is marked with the current
+ * epoch when it is queued, so it is queued only once.
  * Arguments
+ *    pTraversal -  working storage from takeTraversal
  *    pVertex    -  starting vertex for traversal
  */
-void traverseBreadthFirst(VERTEX_T *pVertex, void (*vFunction) (VERTEX_T *))
+void traverseBreadthFirst(TRAVERSAL_T *pTraversal, VERTEX_T *pVertex,
+			  void (*vFunction) (VERTEX_T *))
 {
     VERTEX_T *pCurrentVertex = NULL;
     VERTEX_T *pAdjVertex = NULL;
-    queueClear();
-    colorAll(WHITE);
-    pVertex->color = GRAY;
-    enqueue(pVertex);
-    while (queueSize() > 0)
-    {
-	pCurrentVertex = (VERTEX_T *) dequeue();
-	if (pCurrentVertex->color != BLACK)
+    unsigned int *mark = pTraversal->mark;
+    unsigned int epoch = pTraversal->epoch;
+    int queueHead = 0;
+    int queueTail = 0;
+    mark[pVertex->index] = epoch;
+    pTraversal->queue[queueTail++] = pVertex;
+    while (queueHead < queueTail)
+    {
+	pCurrentVertex = pTraversal->queue[queueHead++];
+	(*vFunction) (pCurrentVertex);
+	ADJACENT_T *pAdjacent = pCurrentVertex->adjacent.head;
+	while (pAdjacent != NULL)
 	{
-	    (*vFunction) (pCurrentVertex);
-	    pCurrentVertex->color = BLACK;
-	    ADJACENT_T *pAdjacent = pCurrentVertex->adjacentHead;
-	    while (pAdjacent != NULL)
+	    pAdjVertex = (VERTEX_T *) pAdjacent->pVertex;
+	    if (mark[pAdjVertex->index] != epoch)
 	    {
-		pAdjVertex = (VERTEX_T *) pAdjacent->pVertex;
-		if (pAdjVertex->color != BLACK)
-		{
-		    pAdjVertex->color = GRAY;
-		    enqueue(pAdjVertex);
-		}
-		pAdjacent = pAdjacent->next;
+		mark[pAdjVertex->index] = epoch;
+		pTraversal->queue[queueTail++] = pAdjVertex;
 	    }
+	    pAdjacent = pAdjacent->next;
 	}
     }				/* end while queue has data */
 }
 
 
-/* Execute a breadth first search from a single vertex,
- * calling the function (*vFunction) on the lowest level
- * vertex we visit, and coloring it black.
+/* Start looking through the vertices adjacent to a vertex.
+ * Used by the depth first search engine.
  * Arguments
- *    pVertex    -  starting vertex for traversal
+ *    pNet      -  Network to look in (will be cast to NETWORK_T *)
+ *    index     -  Index of the vertex
+ *    pCursor   -  Set to the vertex's first adjacency list item
+ * Returns the index of the first adjacent vertex, or -1.
  */
-void traverseDepthFirst(VERTEX_T *pVertex, void (*vFunction) (VERTEX_T *))
+int firstAdjacent(void *pNet, int index, DFS_CURSOR_T *pCursor)
 {
-    VERTEX_T *pAdjVertex = NULL;
-    ADJACENT_T *pAdjacent = pVertex->adjacentHead;
-    while (pAdjacent != NULL)
+    VERTEX_T *pVertex = ((NETWORK_T *) pNet)->vertexTable[index];
+    ADJACENT_T *pAdjacent = pVertex->adjacent.head;
+    pCursor->pItem = pAdjacent;
+    return (pAdjacent != NULL) ? ((VERTEX_T *) pAdjacent->pVertex)->index : -1;
+}
+
+
+/* Move on to the next vertex adjacent to a vertex.
+ * Used by the depth first search engine.
+ * The list item is enough to find the next one, so the network
+ * and vertex are not needed.
+ * Arguments
+ *    pNet      -  Network to look in (not used)
+ *    index     -  Index of the vertex (not used)
+ *    pCursor   -  Current adjacency list item; moved to the next
+ * Returns the index of the next adjacent vertex, or -1.
+ */
+int nextAdjacent(void *pNet, int index, DFS_CURSOR_T *pCursor)
+{
+    ADJACENT_T *pAdjacent = ((ADJACENT_T *) pCursor->pItem)->next;
+    (void) pNet;
+    (void) index;
+    pCursor->pItem = pAdjacent;
+    return (pAdjacent != NULL) ? ((VERTEX_T *) pAdjacent->pVertex)->index : -1;
+}
+
+
+/* Take the network's spare shortest path search, or create a
+ * new one if another search is using it.
+ * Argument
+ *    pNet      -   Network we are going to search
+ * Returns the search, or NULL if allocation fails.
+ */
+PATH_SEARCH_HANDLE takePathSearch(NETWORK_T *pNet)
+{
+    PATH_SEARCH_HANDLE search = NULL;
+    pthread_mutex_lock(&pNet->searchLock);
+    search = pNet->spareSearch;
+    pNet->spareSearch = NULL;
+    pthread_mutex_unlock(&pNet->searchLock);
+    if (search == NULL)
+	search = newPathSearch(pNet->nextIndex);
+    return search;
+}
+
+/* Give a search back after using it. It becomes the network's
+ * spare search unless another search has already been given back.
+ * Arguments
+ *    pNet      -   Network that was searched
+ *    search    -   Search returned by takePathSearch
+ */
+void givePathSearch(NETWORK_T *pNet, PATH_SEARCH_HANDLE search)
+{
+    pthread_mutex_lock(&pNet->searchLock);
+    if (pNet->spareSearch == NULL)
     {
-	pAdjVertex = (VERTEX_T *) pAdjacent->pVertex;
-	if (pAdjVertex->color == WHITE)
-	{
-	    pAdjVertex->color = GRAY;
-	    traverseDepthFirst(pAdjVertex, vFunction);
-	}
-	pAdjacent = pAdjacent->next;
-    }				/* end while queue has data */
-    /* when we return from the bottom, call the 
-     * function and color this node black.
-     */
-    (*vFunction) (pVertex);
-    pVertex->color = BLACK;
+	pNet->spareSearch = search;
+	search = NULL;
+    }
+    pthread_mutex_unlock(&pNet->searchLock);
+    if (search != NULL)
+	pathSearchDestroy(search);
 }
 
 
@@ -319,56 +688,99 @@ void printVertexInfo(VERTEX_T *pVertex)
 }
 
 
+/* Throw away the frozen copy kept for batch searches, because
+ * the network has changed. The next batch freezes it again.
+ * Argument
+ *    pNet      -   Network that has changed
+ */
+void dropBatchSnapshot(NETWORK_T *pNet)
+{
+    pthread_mutex_lock(&pNet->batchLock);
+    if (pNet->pBatchSnapshot != NULL)
+    {
+	freeSnapshot(pNet->pBatchSnapshot);
+	pNet->pBatchSnapshot = NULL;
+    }
+    pthread_mutex_unlock(&pNet->batchLock);
+}
+
+
 /********************************/
 /** Public functions start here */
 /********************************/
 
-/* Initialize or reintialize the graph.
+/* Create a new, empty network.
  * Argument 
  *    maxVertices  - how many vertices can this graph
- *                   handle.
+ *                   handle. For a linked list network this
+ *                   is only used to size the key index.
  *    bDirected    - If true this is a directed graph.
  *                   Otherwise undirected.
- * Returns 1 unless there is a memory allocation error,
- * in which case it returns zero.
+ * Returns a handle for the network, or NULL if there is a
+ * memory allocation error.
  */
-int initGraph(int maxVertices, int bDirected)
+GRAPH_HANDLE newGraph(int maxVertices, int bDirected)
 {
-    /* for a linked list graph, we call
-     * clearGraph and then initialize bGraphDirected
-     */
-    clearGraph();
-    bGraphDirected = bDirected;
-    bHasNeg = 0;
-    weightSum = 0;
-    vertexCount = 0;
-    return 1;  /* this implementation of initGraph can never fail */
+    NETWORK_T *pNet = calloc(1, sizeof(NETWORK_T));
+    if (pNet != NULL)
+    {
+	pthread_mutex_init(&pNet->searchLock, NULL);
+	pthread_mutex_init(&pNet->traversalLock, NULL);
+	pthread_mutex_init(&pNet->batchLock, NULL);
+	pNet->bGraphDirected = bDirected;
+	/* size the key index for the expected number of vertices */
+	pNet->vertexIndex = newKeyIndex(maxVertices);
+	pNet->vertexPool = newNodePool(sizeof(VERTEX_T), VERTEX_SLAB_SIZE);
+	pNet->edgePool = newNodePool(sizeof(ADJACENT_T), EDGE_SLAB_SIZE);
+	if ((pNet->vertexIndex == NULL) || (pNet->vertexPool == NULL) ||
+	    (pNet->edgePool == NULL))
+	{
+	    graphDestroy(pNet);
+	    pNet = NULL;
+	}
+    }
+    return (GRAPH_HANDLE) pNet;
 }
 
 
-/* Free all memory associated with the graph and
- * reset all parameters.
+/* Free all memory associated with the network. Does not
+ * free the data stored with the vertices.
+ * Argument
+ *    graph  -  Network to free. Not valid after this call.
  */
-void clearGraph()
+void graphDestroy(GRAPH_HANDLE graph)
 {
-    VERTEX_T *pCurVertex = vListHead;
+    NETWORK_T *pNet = (NETWORK_T *) graph;
+    VERTEX_T *pCurVertex = NULL;
+    if (pNet == NULL)
+	return;
+    stopTrackingShortestPaths(pNet);
+    pCurVertex = pNet->vListHead;
     while (pCurVertex != NULL)
     {
-	freeAdjacencyList(pCurVertex);
-	VERTEX_T *pDelVtx = pCurVertex;
+	/* the list items and vertices themselves are freed
+	 * all at once when we destroy the pools below */
+	edgeIndexDestroy(pCurVertex->adjacent.index);
+	edgeIndexDestroy(pCurVertex->reverse.index);
+	free(pCurVertex->key);
 	pCurVertex = pCurVertex->next;
-	free(pDelVtx->key);
-	free(pDelVtx);
     }
-
-    vListHead = NULL;
-    vListTail = NULL;
-    bGraphDirected = 0;
-
+    nodePoolDestroy(pNet->edgePool);
+    nodePoolDestroy(pNet->vertexPool);
+    free(pNet->vertexTable);
+    keyIndexDestroy(pNet->vertexIndex);
+    pathSearchDestroy(pNet->spareSearch);
+    pthread_mutex_destroy(&pNet->searchLock);
+    freeTraversal(pNet->spareTraversal);
+    pthread_mutex_destroy(&pNet->traversalLock);
+    dropBatchSnapshot(pNet);
+    pthread_mutex_destroy(&pNet->batchLock);
+    free(pNet);
 }
 
 /* Add a vertex into the graph.
  * Arguments
+ *     graph -   Network returned by newGraph
  *     key   -   Key value or label for the 
  *               vertex
  *     pData -   Additional information that can
@@ -380,38 +792,51 @@ void clearGraph()
  * to add a vertex with a key that matches a vertex
  * already in the graph.
  */
-int addVertex(char *key, void *pData)
+int addVertex(GRAPH_HANDLE graph, char *key, void *pData)
 {
+    NETWORK_T *pNet = (NETWORK_T *) graph;
     int bOk = 1;
     VERTEX_T *pPred;
-    VERTEX_T *pFound = findVertexByKey(key, &pPred);
+    VERTEX_T *pFound = findVertexByKey(pNet, key, &pPred);
     if (pFound != NULL)		/* key is already in the graph */
     {
 	bOk = -1;
     }
     else
     {
-	VERTEX_T *pNewVtx = (VERTEX_T *) calloc(1, sizeof(VERTEX_T));
+	VERTEX_T *pNewVtx = (VERTEX_T *) nodePoolAlloc(pNet->vertexPool);
 	char *pKeyval = strdup(key);
-	if ((pNewVtx == NULL) || (pKeyval == NULL))
+	if ((pNewVtx == NULL) || (pKeyval == NULL) ||
+	    (keyIndexInsert(pNet->vertexIndex, pKeyval, pNewVtx) != 1))
 	{
+	    nodePoolFree(pNet->vertexPool, pNewVtx);
+	    free(pKeyval);
+	    bOk = 0;		/* allocation error */
+	}
+	else if (!addToVertexTable(pNet, pNewVtx))
+	{
+	    keyIndexRemove(pNet->vertexIndex, pKeyval);
+	    nodePoolFree(pNet->vertexPool, pNewVtx);
+	    free(pKeyval);
 	    bOk = 0;		/* allocation error */
 	}
 	else
 	{
 	    pNewVtx->key = pKeyval;
 	    pNewVtx->data = pData;
-	    if (vListHead == NULL)	/* first vertex */
+	    if (pNet->vListHead == NULL)	/* first vertex */
 	    {
-		vListHead = pNewVtx;
+		pNet->vListHead = pNewVtx;
 	    }
 	    else
 	    {
-		vListTail->next = pNewVtx;
+		pNet->vListTail->next = pNewVtx;
+		pNewVtx->prev = pNet->vListTail;
 	    }
-	    vListTail = pNewVtx;
+	    pNet->vListTail = pNewVtx;
+	    pNet->vertexCount++;
+	    dropBatchSnapshot(pNet);
 	}
-	vertexCount++;
     }
     return bOk;
 }
@@ -419,35 +844,48 @@ int addVertex(char *key, void *pData)
 
 /* Remove a vertex from the graph.
  * Arguments
+ *     graph -   Network returned by newGraph
  *     key   -   Key value or label for the 
  *               vertex to remove
  * Returns a pointer to the data stored at that
  * vertex, or NULL if the vertex could not be 
  * found.
  */
-void *removeVertex(char *key)
+void *removeVertex(GRAPH_HANDLE graph, char *key)
 {
+    NETWORK_T *pNet = (NETWORK_T *) graph;
     void *pData = NULL;		/* data to return */
     VERTEX_T *pPredVtx = NULL;
-    VERTEX_T *pRemoveVtx = findVertexByKey(key, &pPredVtx);
+    VERTEX_T *pRemoveVtx = findVertexByKey(pNet, key, &pPredVtx);
     if (pRemoveVtx != NULL)
     {
-	removeReferences(pRemoveVtx);
-	freeAdjacencyList(pRemoveVtx);
+	if ((pNet->pathTree != NULL) &&
+	    (pathTreeSource(pNet->pathTree) == pRemoveVtx->index))
+	    stopTrackingShortestPaths(pNet);
+	removeReferences(pNet, pRemoveVtx);
+	freeAdjacencyList(pNet, pRemoveVtx);
+	if ((pNet->pathTree != NULL) &&
+	    (!pathTreeVertexRemoved(pNet->pathTree, pRemoveVtx->index)))
+	    stopTrackingShortestPaths(pNet);
 	if (pPredVtx != NULL)
 	{
 	    pPredVtx->next = pRemoveVtx->next;
 	}
 	else			/* if there is no predecessor that means this was the head */
 	{
-	    vListHead = pRemoveVtx->next;
+	    pNet->vListHead = pRemoveVtx->next;
 	}
-	if (pRemoveVtx == vListTail)
-	    vListTail = pPredVtx;
+	if (pRemoveVtx->next != NULL)
+	    pRemoveVtx->next->prev = pPredVtx;
+	if (pRemoveVtx == pNet->vListTail)
+	    pNet->vListTail = pPredVtx;
+	pNet->vertexTable[pRemoveVtx->index] = NULL;
+	keyIndexRemove(pNet->vertexIndex, pRemoveVtx->key);
 	free(pRemoveVtx->key);
 	pData = pRemoveVtx->data;
-	free(pRemoveVtx);
-	vertexCount--;
+	nodePoolFree(pNet->vertexPool, pRemoveVtx);
+	pNet->vertexCount--;
+	dropBatchSnapshot(pNet);
     }
     return pData;
 }
@@ -455,6 +893,7 @@ void *removeVertex(char *key)
 
 /* Add an edge between two vertices
  * Arguments
+ *    graph -  Network returned by newGraph
  *    key1  -  Key for the first vertex in the edge
  *    key2  -  Key for the second vertex
  *    weight - weight for this edge
@@ -463,12 +902,13 @@ void *removeVertex(char *key)
  * is not found. Returns -1 if an edge already
  * exists in this direction.
  */
-int addEdge(char *key1, char *key2, int weight)
+int addEdge(GRAPH_HANDLE graph, char *key1, char *key2, int weight)
 {
+    NETWORK_T *pNet = (NETWORK_T *) graph;
     int bOk = 1;
     VERTEX_T *pDummy = NULL;
-    VERTEX_T *pFromVtx = findVertexByKey(key1, &pDummy);
-    VERTEX_T *pToVtx = findVertexByKey(key2, &pDummy);
+    VERTEX_T *pFromVtx = findVertexByKey(pNet, key1, &pDummy);
+    VERTEX_T *pToVtx = findVertexByKey(pNet, key2, &pDummy);
     if ((pFromVtx == NULL) || (pToVtx == NULL))
     {
 	bOk = 0;
@@ -479,51 +919,36 @@ int addEdge(char *key1, char *key2, int weight)
     }
     else
     {
-	weightSum = weightSum + weight;
-	if (weight < 0)
-	    bHasNeg = 1;
-	ADJACENT_T *pNewRef = (ADJACENT_T *) calloc(1, sizeof(ADJACENT_T));
-	if (pNewRef == NULL)
+	bOk = appendEdge(pNet, &pFromVtx->adjacent, pToVtx, weight);
+	/* If undirected, add an edge in the other direction. If
+	 * directed, add the edge to the list of edges entering pToVtx,
+	 * so we can search backward. */
+	if ((bOk == 1) && (!pNet->bGraphDirected) && (pFromVtx != pToVtx))
+	    bOk = appendEdge(pNet, &pToVtx->adjacent, pFromVtx, weight);
+	else if ((bOk == 1) && (pNet->bGraphDirected))
+	    bOk = appendEdge(pNet, &pToVtx->reverse, pFromVtx, weight);
+	if (bOk == 1)
 	{
-	    bOk = 0;
+	    pNet->weightSum = pNet->weightSum + weight;
+	    if (weight < 0)
+		pNet->bHasNeg = 1;
+	    dropBatchSnapshot(pNet);
 	}
-	else
+	else if (edgeExists(pFromVtx, pToVtx))
 	{
-	    pNewRef->pVertex = pToVtx;
-	    pNewRef->weight = weight;
-	    if (pFromVtx->adjacentTail != NULL)
-	    {
-		pFromVtx->adjacentTail->next = pNewRef;
-	    }
-	    else
-	    {
-		pFromVtx->adjacentHead = pNewRef;
-	    }
-	    pFromVtx->adjacentTail = pNewRef;
+	    /* only the other end failed, so take the first edge
+	     * back out and leave the network as it was */
+	    nodePoolFree(pNet->edgePool,
+			 unlinkEdge(&pFromVtx->adjacent, pToVtx));
 	}
     }
-    /* If undirected, add an edge in the other direction */
-    if ((bOk) && (!bGraphDirected))
+    /* Let the shortest path tree catch up, if we have one */
+    if ((bOk == 1) && (pNet->pathTree != NULL))
     {
-	ADJACENT_T *pNewRef2 = (ADJACENT_T *) calloc(1, sizeof(ADJACENT_T));
-	if (pNewRef2 == NULL)
-	{
-	    bOk = 0;
-	}
-	else
-	{
-	    pNewRef2->pVertex = pFromVtx;
-	    pNewRef2->weight = weight;
-	    if (pToVtx->adjacentTail != NULL)
-	    {
-		pToVtx->adjacentTail->next = pNewRef2;
-	    }
-	    else
-	    {
-		pToVtx->adjacentHead = pNewRef2;
-	    }
-	    pToVtx->adjacentTail = pNewRef2;
-	}
+	if ((weight < 0) ||
+	    (!pathTreeEdgeChanged(pNet->pathTree, pFromVtx->index,
+				  pToVtx->index, -1, weight)))
+	    stopTrackingShortestPaths(pNet);
     }
     return bOk;
 }
@@ -531,18 +956,20 @@ int addEdge(char *key1, char *key2, int weight)
 
 /* Remove an edge between two vertices
  * Arguments
+ *    graph -  Network returned by newGraph
  *    key1  -  Key for the first vertex in the edge
  *    key2  -  Key for the second vertex
  * Returns 1 if successful, 0 if failed 
  * because either vertex is not found or there
  * is no edge between these items.
  */
-int removeEdge(char *key1, char *key2)
+int removeEdge(GRAPH_HANDLE graph, char *key1, char *key2)
 {
+    NETWORK_T *pNet = (NETWORK_T *) graph;
     int bOk = 1;
     VERTEX_T *pDummy = NULL;
-    VERTEX_T *pFromVtx = findVertexByKey(key1, &pDummy);
-    VERTEX_T *pToVtx = findVertexByKey(key2, &pDummy);
+    VERTEX_T *pFromVtx = findVertexByKey(pNet, key1, &pDummy);
+    VERTEX_T *pToVtx = findVertexByKey(pNet, key2, &pDummy);
     if ((pFromVtx == NULL) || (pToVtx == NULL))
     {
 	bOk = 0;
@@ -553,79 +980,40 @@ int removeEdge(char *key1, char *key2)
     }
     else
     {
-	ADJACENT_T *pAdjacent = pFromVtx->adjacentHead;
-	ADJACENT_T *pPrevAdjacent = NULL;
-	while (pAdjacent != NULL)
-	{
-	    if (pAdjacent->pVertex == pToVtx)	/* if this edge involves the target */
-	    {
-		if (pPrevAdjacent != NULL)
-		{
-		    pPrevAdjacent->next = pAdjacent->next;
-		}
-		else
-		{
-		    pFromVtx->adjacentHead = pAdjacent->next;
-		}
-		if (pAdjacent == pFromVtx->adjacentTail)
-		{
-		    pFromVtx->adjacentTail = NULL;
-		}
-		weightSum = weightSum - pAdjacent->weight;
-		free(pAdjacent);
-		break;		/* can only show up once in the adjacency list */
-	    }
-	    else
-	    {
-		pPrevAdjacent = pAdjacent;
-		pAdjacent = pAdjacent->next;
-	    }
-	}
-	/* If undirected, remove edge in the other direction */
-	if ((bOk) && (!bGraphDirected))
-	{
-	    ADJACENT_T *pAdjacent2 = pToVtx->adjacentHead;
-	    ADJACENT_T *pPrevAdjacent2 = NULL;
-	    while (pAdjacent2 != NULL)
-	    {
-		if (pAdjacent2->pVertex == pFromVtx)
-		{
-		    if (pPrevAdjacent2 != NULL)
-		    {
-			pPrevAdjacent2->next = pAdjacent2->next;
-		    }
-		    else
-		    {
-			pToVtx->adjacentHead = pAdjacent2->next;
-		    }
-		    if (pAdjacent2 == pToVtx->adjacentTail)
-		    {
-			pToVtx->adjacentTail = NULL;
-		    }
-		    free(pAdjacent2);
-		    break;	/* can only show up once in the adjacency list */
-		}
-		else
-		{
-		    pPrevAdjacent2 = pAdjacent2;
-		    pAdjacent2 = pAdjacent2->next;
-		}
-	    }
-	}
+	ADJACENT_T *pAdjacent = unlinkEdge(&pFromVtx->adjacent, pToVtx);
+	int weight = pAdjacent->weight;
+	pNet->weightSum = pNet->weightSum - weight;
+	nodePoolFree(pNet->edgePool, pAdjacent);
+	/* If undirected, remove edge in the other direction. If
+	 * directed, remove it from the entering edges of pToVtx */
+	if (!pNet->bGraphDirected)
+	    nodePoolFree(pNet->edgePool,
+			 unlinkEdge(&pToVtx->adjacent, pFromVtx));
+	else
+	    nodePoolFree(pNet->edgePool,
+			 unlinkEdge(&pToVtx->reverse, pFromVtx));
+	dropBatchSnapshot(pNet);
+	if ((pNet->pathTree != NULL) &&
+	    (!pathTreeEdgeChanged(pNet->pathTree, pFromVtx->index,
+				  pToVtx->index, weight, -1)))
+	    stopTrackingShortestPaths(pNet);
     }
+    return bOk;
 }
 
 /* Find a vertex and return its data
  * Arguments
- *    key  -  Key for the vertex to find
+ *    graph -  Network returned by newGraph
+ *    key   -  Key for the vertex to find
  * Returns the data for the vertex or NULL
  * if not found.
  */
-void *findVertex(char *key)
+void *findVertex(GRAPH_HANDLE graph, char *key)
 {
+    NETWORK_T *pNet = (NETWORK_T *) graph;
     void *pData = NULL;
     VERTEX_T *pDummy = NULL;
-    VERTEX_T *pFoundVtx = findVertexByKey(key, &pDummy);
+    VERTEX_T *pFoundVtx = findVertexByKey(pNet, key, &pDummy);
     if (pFoundVtx != NULL)
     {
 	pData = pFoundVtx->data;
@@ -636,52 +1024,91 @@ void *findVertex(char *key)
 /* Find the edge between two vertices (if any) and return
  * its weight
  * Arguments
+ *    graph -  Network returned by newGraph
  *    key1  -  Key for the first vertex in the edge
  *    key2  -  Key for the second vertex
  * Returns weight if successful and edge exists.
  * Returns -1 if an edge is not found
  */
-int findEdge(char *key1, char *key2)
+int findEdge(GRAPH_HANDLE graph, char *key1, char *key2)
 {
+    NETWORK_T *pNet = (NETWORK_T *) graph;
     int weight = -1;
-    int bEdgeExists = 0;
     VERTEX_T *pDummy = NULL;
-    VERTEX_T *pFrom = findVertexByKey(key1, &pDummy);
-    ADJACENT_T *pCurRef = pFrom->adjacentHead;
-    while ((pCurRef != NULL) && (!bEdgeExists))
-    {
-	VERTEX_T *pFrom = (VERTEX_T *) pCurRef->pVertex;
-	if (strcmp(pFrom->key, key2) == 0)
-	{
-	    weight = pCurRef->weight;
-	    bEdgeExists = 1;
-	}
-	else
-	{
-	    pCurRef = pCurRef->next;
-	}
-    }
+    VERTEX_T *pFrom = findVertexByKey(pNet, key1, &pDummy);
+    VERTEX_T *pTo = findVertexByKey(pNet, key2, &pDummy);
+    ADJACENT_T *pCurRef = NULL;
+    if ((pFrom != NULL) && (pTo != NULL))
+	pCurRef = findInEdgeList(&pFrom->adjacent, pTo);
+    if (pCurRef != NULL)
+	weight = pCurRef->weight;
     return weight;
 }
 
 
+/* Change the weight of an existing edge.
+ * Arguments
+ *    graph  -  Network returned by newGraph
+ *    key1   -  Key for the first vertex in the edge
+ *    key2   -  Key for the second vertex
+ *    weight -  New weight for the edge
+ * Returns 1 if successful, 0 if either vertex is not
+ * found or there is no edge between them.
+ */
+int updateEdgeWeight(GRAPH_HANDLE graph, char *key1, char *key2, int weight)
+{
+    NETWORK_T *pNet = (NETWORK_T *) graph;
+    VERTEX_T *pDummy = NULL;
+    VERTEX_T *pFromVtx = findVertexByKey(pNet, key1, &pDummy);
+    VERTEX_T *pToVtx = findVertexByKey(pNet, key2, &pDummy);
+    ADJACENT_T *pAdjacent = NULL;
+    ADJACENT_T *pOther = NULL;
+    int oldWeight = 0;
+    if ((pFromVtx != NULL) && (pToVtx != NULL))
+	pAdjacent = findInEdgeList(&pFromVtx->adjacent, pToVtx);
+    if (pAdjacent == NULL)
+	return 0;
+    oldWeight = pAdjacent->weight;
+    pAdjacent->weight = weight;
+    pNet->weightSum = pNet->weightSum - oldWeight + weight;
+    if (weight < 0)
+	pNet->bHasNeg = 1;
+    /* The edge is also stored at the other end: in the other
+     * direction if undirected, or in the entering edges if directed */
+    if (!pNet->bGraphDirected)
+	pOther = findInEdgeList(&pToVtx->adjacent, pFromVtx);
+    else
+	pOther = findInEdgeList(&pToVtx->reverse, pFromVtx);
+    if (pOther != NULL)
+	pOther->weight = weight;
+    dropBatchSnapshot(pNet);
+    if ((pNet->pathTree != NULL) &&
+	((weight < 0) ||
+	 (!pathTreeEdgeChanged(pNet->pathTree, pFromVtx->index,
+			       pToVtx->index, oldWeight, weight))))
+	stopTrackingShortestPaths(pNet);
+    return 1;
+}
+
 
 /* Return an array of copies of the keys for all nodes
  * adjacent to a node. The array and its
  * contents should be freed by the caller when it 
  * is no longer needed.
  * Arguments
- *    key   -  Key for the node whose adjacents we want
+ *    graph  - Network returned by newGraph
+ *    key    - Key for the node whose adjacents we want
  *    pCount - Return number of elements in the array
  * Returns array of char* which are the keys of adjacent
  * nodes. Returns number of adjacent vertices in pCount.
  * If pCount holds -1, the vertex does not exist.
  */
-char **getAdjacentVertices(char *key, int *pCount)
+char **getAdjacentVertices(GRAPH_HANDLE graph, char *key, int *pCount)
 {
+    NETWORK_T *pNet = (NETWORK_T *) graph;
     char **keyArray = NULL;
     VERTEX_T *pDummy = NULL;
-    VERTEX_T *pFoundVtx = findVertexByKey(key, &pDummy);
+    VERTEX_T *pFoundVtx = findVertexByKey(pNet, key, &pDummy);
     if (pFoundVtx != NULL)
     {
 	*pCount = countAdjacent(pFoundVtx);
@@ -691,7 +1118,7 @@ char **getAdjacentVertices(char *key, int *pCount)
 	    keyArray = (char **) calloc(*pCount, sizeof(char *));
 	    if (keyArray != NULL)
 	    {
-		ADJACENT_T *pAdjacent = pFoundVtx->adjacentHead;
+		ADJACENT_T *pAdjacent = pFoundVtx->adjacent.head;
 		while (pAdjacent != NULL)
 		{
 		    VERTEX_T *pVertex = (VERTEX_T *) pAdjacent->pVertex;
@@ -713,108 +1140,341 @@ char **getAdjacentVertices(char *key, int *pCount)
 /* Print out all the nodes reachable from a node by a 
  * breadth-first search.
  * Arguments
+ *   graph      -  Network returned by newGraph
  *   startKey   -  Key for start vertex
  * Returns 1 if successful, -1 if the vertex does not exist.
  */
-int printBreadthFirst(char *startKey)
+int printBreadthFirst(GRAPH_HANDLE graph, char *startKey)
 {
+    NETWORK_T *pNet = (NETWORK_T *) graph;
     int retval = 1;
     VERTEX_T *pDummy = NULL;
-    VERTEX_T *pVertex = findVertexByKey(startKey, &pDummy);
+    VERTEX_T *pVertex = findVertexByKey(pNet, startKey, &pDummy);
+    TRAVERSAL_T *pTraversal = NULL;
     if (pVertex == NULL)
     {
 	retval = -1;
     }
+    else if ((pTraversal = takeTraversal(pNet)) == NULL)
+    {
+	printf("Allocation error in printBreadthFirst!\n");
+    }
     else
     {
-	traverseBreadthFirst(pVertex, &printVertexInfo);
+	traverseBreadthFirst(pTraversal, pVertex, &printVertexInfo);
+	giveTraversal(pNet, pTraversal);
     }
     return retval;
 }
 
 /* Print out all the nodes by a depth-first search.
+ * Each vertex is printed after all the vertices below it.
+ * Argument
+ *   graph      -  Network returned by newGraph
  */
-void printDepthFirst()
+void printDepthFirst(GRAPH_HANDLE graph)
 {
-    VERTEX_T *pVertex = vListHead;
+    NETWORK_T *pNet = (NETWORK_T *) graph;
+    VERTEX_T *pVertex = pNet->vListHead;
+    DFS_HANDLE search = NULL;
     if (pVertex == NULL)
     {
 	printf("The graph is empty\n");
     }
+    else if ((search = newDepthFirst(pNet->nextIndex)) == NULL)
+    {
+	printf("Allocation error in printDepthFirst!\n");
+    }
     else
     {
-	colorAll(WHITE);
+	DFS_GRAPH_T dfsGraph;
+	int *postOrder = NULL;
+	int postCount = 0;
+	int printed = 0;
+	dfsGraph.pGraph = pNet;
+	dfsGraph.vertexCount = pNet->nextIndex;
+	dfsGraph.firstAdjacent = &firstAdjacent;
+	dfsGraph.nextAdjacent = &nextAdjacent;
 	while (pVertex != NULL)
 	{
-	    if (pVertex->color == WHITE)
+	    if (depthFirstDiscovery(search, pVertex->index) < 0)
 	    {
 		printf("\nStarting new traversal from |%s|\n", pVertex->key);
-		pVertex->color = GRAY;
-		traverseDepthFirst(pVertex, &printVertexInfo);
+		if (depthFirstVisit(search, &dfsGraph, pVertex->index) < 0)
+		{
+		    printf("Allocation error in printDepthFirst!\n");
+		    break;
+		}
+		postOrder = depthFirstPostOrder(search, &postCount);
+		while (printed < postCount)
+		{
+		    printVertexInfo(pNet->vertexTable[postOrder[printed]]);
+		    printed++;
+		}
 	    }
 	    pVertex = pVertex->next;
 	}
+	depthFirstDestroy(search);
+    }
+}
+
+
+/* Print a path, given as an array of keys in order
+ * from the start vertex to the end vertex.
+ * Arguments
+ *    pathKeys   - keys of the vertices along the path
+ *    pathCount  - number of keys in the array
+ */
+void printPath(char **pathKeys, int pathCount)
+{
+    int i = 0;
+    for (i = 0; i < pathCount; i++)
+    {
+	printf(" %s ", pathKeys[i]);
+	if (i < pathCount - 1)
+	    printf("==>");
     }
+    printf("\n");
+}
+
+
+/* Information the A* heuristic adapter needs, passed to it
+ * through the shortest path engine.
+ */
+typedef struct
+{
+    int (*heuristic) (void *pData, void *pEndData);	/* caller's function */
+    void *pEndData;		/* data of the end vertex */
+    NETWORK_T *pNet;		/* network being searched */
+} HEURISTIC_ADAPTER_T;
+
+/* Heuristic function for the shortest path engine. Translates
+ * the vertex index into vertex data for the caller's function.
+ * Arguments
+ *    pAdapterArg  -  HEURISTIC_ADAPTER_T for this search
+ *    index        -  Index of the vertex to estimate from
+ * Returns the caller's estimate of the distance to the end vertex.
+ */
+int estimateFromData(void *pAdapterArg, int index)
+{
+    HEURISTIC_ADAPTER_T *pAdapter = (HEURISTIC_ADAPTER_T *) pAdapterArg;
+    return (*pAdapter->heuristic) (pAdapter->pNet->vertexTable[index]->data,
+				   pAdapter->pEndData);
+}
+
+/* Find the lowest weight path from one vertex to another
+ * through the network using Dijkstra's algorithm, without
+ * printing anything. The search stops as soon as the end
+ * vertex is reached.
+ * Arguments
+ *    graph       -  Network returned by newGraph
+ *    startKey    -  Key of start vertex
+ *    endKey      -  Key of ending vertex
+ *    pPathKeys   -  If not NULL, used to return an array holding the
+ *                   keys along the path, start first. The caller
+ *                   should free the array but not the keys, which
+ *                   belong to the network.
+ *    pPathCount  -  If not NULL, returns the number of keys in the path
+ * Returns the sum of the weights along the path.
+ * Returns -1 if either key is invalid. Returns -2
+ * if network is not directed. Returns -3 if the
+ * network has negative weights. Returns -4 if end is not 
+ * reachable from the start. Returns -5 for a memory
+ * allocation error.
+ */
+int findShortestPath(GRAPH_HANDLE graph, char *startKey, char *endKey,
+		     char ***pPathKeys, int *pPathCount)
+{
+    return findShortestPathUsing(graph, PATH_DIJKSTRA, startKey, endKey,
+				 NULL, pPathKeys, pPathCount, NULL);
 }
 
 
-/* Comparison function to send to the minPriorityQueue
+/* Find the lowest weight path from one vertex to another using
+ * plain Dijkstra, bidirectional Dijkstra or A* search.
+ * Each call uses its own working storage: the network's spare
+ * search if no other search is using it, otherwise a new one.
  * Arguments
- *   pV1     First vertex (will be cast to VERTEX_T *)
- *   pV2     Second vertex (will be cast to VERTEX_T *)
- * Compares dValues. Returns -1 if V1 < V2, 0 if dValues are
- * the same, 1 if V1 > V2.
+ *    graph         -  Network returned by newGraph
+ *    method        -  PATH_DIJKSTRA, PATH_BIDIRECTIONAL or PATH_ASTAR
+ *    startKey      -  Key of start vertex
+ *    endKey        -  Key of ending vertex
+ *    heuristic     -  For PATH_ASTAR, estimates the path weight
+ *                     between the data of two vertices
+ *    pPathKeys     -  As for findShortestPath
+ *    pPathCount    -  As for findShortestPath
+ *    pSettledCount -  If not NULL, returns the number of vertices settled
+ * Returns the sum of the weights along the path, or the same negative
+ * values as findShortestPath. Also returns -5 for a bad method.
  */
-int compareVertices(void *pV1, void *pV2)
+int findShortestPathUsing(GRAPH_HANDLE graph, int method,
+			  char *startKey, char *endKey,
+			  int (*heuristic) (void *pData, void *pEndData),
+			  char ***pPathKeys, int *pPathCount,
+			  int *pSettledCount)
 {
-    VERTEX_T *pVertex1 = (VERTEX_T *) pV1;
-    VERTEX_T *pVertex2 = (VERTEX_T *) pV2;
-    if (pVertex1->dValue < pVertex2->dValue)
+    NETWORK_T *pNet = (NETWORK_T *) graph;
+    int pathWeight = 0;
+    VERTEX_T *pDummy = NULL;
+    VERTEX_T *pStartVertex = findVertexByKey(pNet, startKey, &pDummy);
+    VERTEX_T *pEndVertex = findVertexByKey(pNet, endKey, &pDummy);
+    PATH_SEARCH_HANDLE pathSearch = NULL;
+    HEURISTIC_ADAPTER_T adapter;
+    if (pPathKeys != NULL)
+	*pPathKeys = NULL;
+    if (pPathCount != NULL)
+	*pPathCount = 0;
+    if (pSettledCount != NULL)
+	*pSettledCount = 0;
+    if ((pStartVertex == NULL) || (pEndVertex == NULL))
 	return -1;
-    else if (pVertex1->dValue > pVertex2->dValue)
-	return 1;
+    if (!pNet->bGraphDirected)
+	return -2;
+    if (pNet->bHasNeg)
+	return -3;
+    if ((method != PATH_DIJKSTRA) && (method != PATH_BIDIRECTIONAL) &&
+	(method != PATH_ASTAR))
+	return -5;
+    if ((method == PATH_ASTAR) && (heuristic == NULL))
+	return -5;
+    pathSearch = takePathSearch(pNet);
+    if (pathSearch == NULL)
+	return -5;
+    /* Each engine stops as soon as it knows the end vertex's distance */
+    if (method == PATH_DIJKSTRA)
+    {
+	pathWeight = pathSearchRun(pathSearch, pNet, &walkAdjacentEdges,
+				   pNet->nextIndex, pStartVertex->index,
+				   pEndVertex->index);
+    }
+    else if (method == PATH_BIDIRECTIONAL)
+    {
+	pathWeight = pathSearchRunBidirectional(pathSearch, pNet,
+						&walkAdjacentEdges,
+						&walkEnteringEdges,
+						pNet->nextIndex,
+						pStartVertex->index,
+						pEndVertex->index);
+    }
     else
-	return 0;
+    {
+	adapter.heuristic = heuristic;
+	adapter.pEndData = pEndVertex->data;
+	adapter.pNet = pNet;
+	pathWeight = pathSearchRunAStar(pathSearch, pNet, &walkAdjacentEdges,
+					pNet->nextIndex, pStartVertex->index,
+					pEndVertex->index, &estimateFromData,
+					&adapter);
+    }
+    if (pSettledCount != NULL)
+	*pSettledCount = pathSearchSettledCount(pathSearch);
+    if (pathWeight == -1)
+    {
+	pathWeight = -4;
+    }
+    else if (pathWeight < 0)
+    {
+	pathWeight = -5;
+    }
+    else if ((pPathKeys != NULL) || (pPathCount != NULL))
+    {
+	/* the path can be no longer than the number of vertices */
+	int *pathIndices = calloc(pNet->vertexCount, sizeof(int));
+	int pathCount = 0;
+	int i = 0;
+	if (pathIndices != NULL)
+	    pathCount = pathSearchGetPath(pathSearch, pEndVertex->index,
+					  pathIndices, pNet->vertexCount);
+	if (pathCount <= 0)
+	{
+	    pathWeight = -5;
+	}
+	else
+	{
+	    if (pPathKeys != NULL)
+	    {
+		*pPathKeys = calloc(pathCount, sizeof(char *));
+		if (*pPathKeys == NULL)
+		    pathWeight = -5;
+		for (i = 0; (i < pathCount) && (*pPathKeys != NULL); i++)
+		    (*pPathKeys)[i] = pNet->vertexTable[pathIndices[i]]->key;
+	    }
+	    if (pPathCount != NULL)
+		*pPathCount = pathCount;
+	}
+	free(pathIndices);
+    }
+    givePathSearch(pNet, pathSearch);
+    return pathWeight;
 }
 
 
-/* Print path to the end vertex passed as the argument.
- * This is called after executing Dijkstra's algorithm, which
- * will set the pFrom pointer on each vertex. To print
- * the path in the correct order, we put the items into
- * an array then read from the end.
+/* Find the lowest weight path distances for a whole batch of
+ * (start, end) pairs, running the searches in parallel. All the
+ * threads search the same compact read-only copy of the network,
+ * made by freezeNetwork(). The copy is kept, so later batches reuse
+ * it until the network changes. Batches on the same network take
+ * turns, since each one already uses several threads.
  * Arguments
- *    pEndVertex - end point of path we want to print. 
+ *    graph       -  Network returned by newGraph
+ *    startKeys   -  Key of the start vertex for each pair
+ *    endKeys     -  Key of the end vertex for each pair
+ *    pairCount   -  Number of pairs
+ *    distances   -  Array of pairCount values to fill in
+ *    threadCount -  Number of threads to use, zero or less for
+ *                   one per processor
+ * Returns 1 if successful, -2 if network is not directed,
+ * -3 if the network has negative weights, or -5 for a memory
+ * allocation error.
  */
-void printPath(VERTEX_T *pEndVertex)
+int findShortestPathBatch(GRAPH_HANDLE graph, char **startKeys,
+			  char **endKeys, int pairCount, int *distances,
+			  int threadCount)
 {
-    VERTEX_T **pathVertices = calloc(vertexCount, sizeof(VERTEX_T *));
-    /* this array is big enough to hold all the vertices we have */
-    int pathCount = 0;
-    if (pathVertices == NULL)
+    NETWORK_T *pNet = (NETWORK_T *) graph;
+    int status = 1;
+    int i = 0;
+    NETWORK_SNAPSHOT_T *pSnapshot = NULL;
+    int *startIndices = NULL;
+    int *endIndices = NULL;
+    if (!pNet->bGraphDirected)
+	return -2;
+    if (pNet->bHasNeg)
+	return -3;
+    pthread_mutex_lock(&pNet->batchLock);
+    if (pNet->pBatchSnapshot == NULL)
+	pNet->pBatchSnapshot = freezeNetwork(pNet);
+    pSnapshot = pNet->pBatchSnapshot;
+    startIndices = calloc(pairCount + 1, sizeof(int));
+    endIndices = calloc(pairCount + 1, sizeof(int));
+    if ((pSnapshot == NULL) || (startIndices == NULL) ||
+	(endIndices == NULL))
     {
-	printf("Allocation error in printPath!\n");
+	status = -5;
     }
     else
     {
-	int i = 0;
-	VERTEX_T *pCurrent = pEndVertex;
-	while (pCurrent != NULL)	/* traverse the parent links */
+	for (i = 0; i < pairCount; i++)
 	{
-	    pathVertices[pathCount] = pCurrent;
-	    pathCount++;
-	    pCurrent = pCurrent->parent;
+	    startIndices[i] = snapshotFindVertex(pSnapshot, startKeys[i]);
+	    endIndices[i] = snapshotFindVertex(pSnapshot, endKeys[i]);
 	}
-	/* Now start at the end of the array to print the path */
-	for (i = pathCount - 1; i >= 0; i--)
+	if (!snapshotShortestPathBatch(pSnapshot, pairCount, startIndices,
+				       endIndices, distances, threadCount))
+	    status = -5;
+	/* use the same values as findShortestPath */
+	for (i = 0; (status == 1) && (i < pairCount); i++)
 	{
-	    printf(" %s ", pathVertices[i]->key);
-	    if (i > 0)
-		printf("==>");
+	    if (distances[i] == -1)
+		distances[i] = -4;
+	    else if (distances[i] < 0)
+		distances[i] = -1;
 	}
-	printf("\n");
-	free(pathVertices);
     }
+    pthread_mutex_unlock(&pNet->batchLock);
+    free(startIndices);
+    free(endIndices);
+    return status;
 }
 
 
@@ -822,69 +1482,543 @@ void printPath(VERTEX_T *pEndVertex)
  * another through the network using Dijkstra's
  * algorithm. 
  * Arguments
+ *    graph       -  Network returned by newGraph
  *    startKey    -  Key of start vertex
  *    endKey      -  Key of ending vertex
  * Returns the sum of the weights along the path.
  * Returns -1 if either key is invalid. Returns -2
  * if network is not directed. Returns -3 if the
  * network has negative weights. Returns -4 if end is not 
- * reachable from the start.
+ * reachable from the start. Returns -5 for a memory
+ * allocation error.
  */
-int printShortestPath(char *startKey, char *endKey)
+int printShortestPath(GRAPH_HANDLE graph, char *startKey, char *endKey)
 {
-    int pathWeight = 0;
+    char **pathKeys = NULL;
+    int pathCount = 0;
+    int pathWeight = findShortestPath(graph, startKey, endKey,
+				      &pathKeys, &pathCount);
+    if (pathWeight >= 0)
+    {
+	printf("Minimum weight path from %s to %s:\n", startKey, endKey);
+	printPath(pathKeys, pathCount);
+	free(pathKeys);
+    }
+    return pathWeight;
+}
+
+
+/* Start keeping the shortest paths from one vertex up to date.
+ * Replaces any tree that was being kept before.
+ * Arguments
+ *    graph      -  Network returned by newGraph
+ *    sourceKey  -  Key of the source vertex
+ * Returns 1 if successful, -1 if the key is invalid, -2 if the
+ * network is not directed, -3 if it has negative weights, or -5
+ * for a memory allocation error.
+ */
+int trackShortestPaths(GRAPH_HANDLE graph, char *sourceKey)
+{
+    NETWORK_T *pNet = (NETWORK_T *) graph;
     VERTEX_T *pDummy = NULL;
-    VERTEX_T *pStartVertex = findVertexByKey(startKey, &pDummy);
-    VERTEX_T *pEndVertex = findVertexByKey(endKey, &pDummy);
-    VERTEX_T *pMinVertex = NULL;
-    VERTEX_T *pCurrentVertex = NULL;
-    if ((pStartVertex == NULL) || (pEndVertex == NULL))
+    VERTEX_T *pSource = findVertexByKey(pNet, sourceKey, &pDummy);
+    stopTrackingShortestPaths(pNet);
+    if (pSource == NULL)
 	return -1;
-    if (!bGraphDirected)
+    if (!pNet->bGraphDirected)
 	return -2;
-    if (bHasNeg)
+    if (pNet->bHasNeg)
 	return -3;
-    /* Return immediately if we have error conditions. Otherwise
-     * initialize the queue. 
-     */
-    queueMinInit(&compareVertices);
-    colorAll(WHITE);
-    initAll();
-    pStartVertex->dValue = 0;
-    while (queueMinSize() > 0)
-    {
-	pMinVertex = (VERTEX_T *) dequeueMin();
-	pMinVertex->color = BLACK;
-	ADJACENT_T *pAdjacentEdge = pMinVertex->adjacentHead;
-	while (pAdjacentEdge != NULL)
+    pNet->pathTree = newPathTree(pNet->nextIndex);
+    if ((pNet->pathTree == NULL) ||
+	(!pathTreeBuild(pNet->pathTree, pNet, &walkAdjacentEdges,
+			&walkEnteringEdges, pNet->nextIndex, pSource->index)))
+    {
+	stopTrackingShortestPaths(pNet);
+	return -5;
+    }
+    return 1;
+}
+
+
+/* Stop keeping the tree up to date, and free it.
+ * Argument
+ *    graph      -  Network returned by newGraph
+ */
+void stopTrackingShortestPaths(GRAPH_HANDLE graph)
+{
+    NETWORK_T *pNet = (NETWORK_T *) graph;
+    pathTreeDestroy(pNet->pathTree);
+    pNet->pathTree = NULL;
+}
+
+
+/* Find the lowest weight path from the tracked source to a vertex.
+ * Arguments
+ *    graph       -  Network returned by newGraph
+ *    endKey      -  Key of ending vertex
+ *    pPathKeys   -  If not NULL, used to return an array holding the
+ *                   keys along the path, source first. The caller
+ *                   should free the array but not the keys.
+ *    pPathCount  -  If not NULL, returns the number of keys in the path
+ * Returns the sum of the weights along the path, -1 if the key is
+ * invalid, -4 if the vertex is not reachable, -5 for a memory
+ * allocation error, or -6 if no source is being tracked.
+ */
+int findTrackedPath(GRAPH_HANDLE graph, char *endKey, char ***pPathKeys,
+		    int *pPathCount)
+{
+    NETWORK_T *pNet = (NETWORK_T *) graph;
+    PATH_TREE_HANDLE pathTree = pNet->pathTree;
+    VERTEX_T *pDummy = NULL;
+    VERTEX_T *pEndVertex = findVertexByKey(pNet, endKey, &pDummy);
+    int pathWeight = 0;
+    int *pathIndices = NULL;
+    int pathCount = 0;
+    int i = 0;
+    if (pPathKeys != NULL)
+	*pPathKeys = NULL;
+    if (pPathCount != NULL)
+	*pPathCount = 0;
+    if (pathTree == NULL)
+	return -6;
+    if (pEndVertex == NULL)
+	return -1;
+    /* the path can be no longer than the number of vertices */
+    pathIndices = calloc(pNet->vertexCount, sizeof(int));
+    if (pathIndices == NULL)
+	return -5;
+    pathCount = pathTreeGetPath(pathTree, pEndVertex->index,
+				pathIndices, pNet->vertexCount);
+    pathWeight = pathTreeDistance(pathTree, pEndVertex->index);
+    if (pathCount == 0)
+    {
+	pathWeight = -4;
+    }
+    else if (pathCount < 0)
+    {
+	pathWeight = -5;
+    }
+    else
+    {
+	if (pPathKeys != NULL)
+	{
+	    *pPathKeys = calloc(pathCount, sizeof(char *));
+	    if (*pPathKeys == NULL)
+		pathWeight = -5;
+	    for (i = 0; (i < pathCount) && (*pPathKeys != NULL); i++)
+		(*pPathKeys)[i] = pNet->vertexTable[pathIndices[i]]->key;
+	}
+	if (pPathCount != NULL)
+	    *pPathCount = pathCount;
+    }
+    free(pathIndices);
+    return pathWeight;
+}
+
+
+/* Copy the work counters of the tracked tree.
+ * Arguments
+ *    graph    -  Network returned by newGraph
+ *    pStats   -  Structure to fill in
+ * Returns 1 if successful, 0 if no source is being tracked.
+ */
+int getTrackedPathStats(GRAPH_HANDLE graph, PATH_TREE_STATS_T *pStats)
+{
+    NETWORK_T *pNet = (NETWORK_T *) graph;
+    if (pNet->pathTree == NULL)
+	return 0;
+    pathTreeGetStats(pNet->pathTree, pStats);
+    return 1;
+}
+
+
+/* Working information for Prim's algorithm, passed to
+ * primRelax through the edge walker.
+ */
+typedef struct
+{
+    int *cost;			/* cheapest edge found to each vertex */
+    int *treeParent;		/* other end of that edge, -1 if none */
+    unsigned char *state;	/* WHITE not seen, GRAY queued, BLACK in tree */
+    MIN_QUEUE_HANDLE queue;	/* queue of pointers into cost */
+    int currentIndex;		/* vertex just added to the tree */
+} PRIM_STATE_T;
+
+/* One edge collected for Kruskal's algorithm */
+typedef struct
+{
+    int fromIndex;		/* index of one end */
+    int toIndex;		/* index of the other end */
+    int weight;			/* weight of the edge */
+} INDEX_EDGE_T;
+
+
+/* Comparison function for the Prim queue. The items are
+ * pointers into the cost array.
+ * Arguments
+ *   pC1     First cost (will be cast to int *)
+ *   pC2     Second cost (will be cast to int *)
+ * Returns -1 if C1 < C2, 0 if they are the same, 1 if C1 > C2.
+ */
+int compareCosts(void *pC1, void *pC2)
+{
+    int c1 = *((int *) pC1);
+    int c2 = *((int *) pC2);
+    if (c1 < c2)
+	return -1;
+    else if (c1 > c2)
+	return 1;
+    else
+	return 0;
+}
+
+/* Look at one edge leaving the vertex just added to the tree.
+ * If it is the cheapest way found so far to reach a vertex not
+ * yet in the tree, remember it. Called through walkAdjacentEdges.
+ * Arguments
+ *    pStateArg  -  Prim state (will be cast to PRIM_STATE_T *)
+ *    toIndex    -  Vertex at the other end of the edge
+ *    weight     -  Weight of the edge
+ */
+void primRelax(void *pStateArg, int toIndex, int weight)
+{
+    PRIM_STATE_T *pState = (PRIM_STATE_T *) pStateArg;
+    if (pState->state[toIndex] == WHITE)
+    {
+	pState->cost[toIndex] = weight;
+	pState->treeParent[toIndex] = pState->currentIndex;
+	pState->state[toIndex] = GRAY;
+	minQueueEnqueue(pState->queue, &pState->cost[toIndex]);
+    }
+    else if ((pState->state[toIndex] == GRAY) &&
+	     (weight < pState->cost[toIndex]))
+    {
+	pState->cost[toIndex] = weight;
+	pState->treeParent[toIndex] = pState->currentIndex;
+	minQueueDecreaseKey(pState->queue, &pState->cost[toIndex]);
+    }
+}
+
+/* Prim's algorithm. Grows a tree from each vertex not yet
+ * reached, always adding the cheapest edge that leads out of
+ * the tree. The queue holds the vertices next to the tree.
+ * Arguments
+ *    pNet       -  Network to search
+ *    treeEdges  -  Array to fill in, with room for vertexCount edges
+ * Returns the number of tree edges, or -1 for a memory allocation error.
+ */
+int primSpanningTree(NETWORK_T *pNet, INDEX_EDGE_T *treeEdges)
+{
+    PRIM_STATE_T primState;
+    int edgeCount = 0;
+    int root = 0;
+    primState.cost = calloc(pNet->nextIndex + 1, sizeof(int));
+    primState.treeParent = calloc(pNet->nextIndex + 1, sizeof(int));
+    primState.state = calloc(pNet->nextIndex + 1, 1);
+    primState.queue = newMinQueue(&compareCosts);
+    if ((primState.cost == NULL) || (primState.treeParent == NULL) ||
+	(primState.state == NULL) || (primState.queue == NULL))
+    {
+	edgeCount = -1;
+    }
+    for (root = 0; (edgeCount >= 0) && (root < pNet->nextIndex); root++)
+    {
+	if ((pNet->vertexTable[root] == NULL) ||
+	    (primState.state[root] != WHITE))
+	    continue;
+	primState.cost[root] = 0;
+	primState.treeParent[root] = -1;
+	primState.state[root] = GRAY;
+	if (!minQueueEnqueue(primState.queue, &primState.cost[root]))
+	    edgeCount = -1;
+	while ((edgeCount >= 0) && (minQueueSize(primState.queue) > 0))
 	{
-	    VERTEX_T *pAdj = pAdjacentEdge->pVertex;
-	    /* if this adjacent vertex has not yet been added to the tree
-	     * and if this path is shorter than any previous path stored
-	     * in the adjacent vertex, adjust the dValue and set the parent.
-	     */
-	    int distance = pMinVertex->dValue + pAdjacentEdge->weight;
-	    if ((pAdj->color == WHITE) && (distance < pAdj->dValue))
+	    int *pMin = (int *) minQueueDequeue(primState.queue);
+	    int minIndex = (int) (pMin - primState.cost);
+	    primState.state[minIndex] = BLACK;
+	    if (primState.treeParent[minIndex] >= 0)
 	    {
-		pAdj->dValue = distance;
-		pAdj->parent = pMinVertex;
+		treeEdges[edgeCount].fromIndex = primState.treeParent[minIndex];
+		treeEdges[edgeCount].toIndex = minIndex;
+		treeEdges[edgeCount].weight = primState.cost[minIndex];
+		edgeCount++;
 	    }
-	    pAdjacentEdge = pAdjacentEdge->next;
+	    primState.currentIndex = minIndex;
+	    walkAdjacentEdges(pNet, minIndex, &primRelax, &primState);
 	}
     }
-    /* When we exit the loop, all reachable vertices will have their
-     * distance and parents set. We start at the destination (end)
-     * vertex and work backward to create the path. The easiest
-     * way to do this is to have a stack. */
-    pathWeight = pEndVertex->dValue;
-    if (pathWeight > weightSum)	/* never changed */
+    free(primState.cost);
+    free(primState.treeParent);
+    free(primState.state);
+    minQueueDestroy(primState.queue);
+    return edgeCount;
+}
+
+/* Comparison function for qsort, to sort edges by weight.
+ * Ties are broken by the vertex indices so the result
+ * does not depend on how qsort orders equal items.
+ * Arguments
+ *    pE1      First edge (will be cast to INDEX_EDGE_T *)
+ *    pE2      Second edge (will be cast to INDEX_EDGE_T *)
+ * Returns negative, zero or positive, like strcmp.
+ */
+int compareIndexEdges(const void *pE1, const void *pE2)
+{
+    const INDEX_EDGE_T *pEdge1 = (const INDEX_EDGE_T *) pE1;
+    const INDEX_EDGE_T *pEdge2 = (const INDEX_EDGE_T *) pE2;
+    if (pEdge1->weight != pEdge2->weight)
+	return (pEdge1->weight < pEdge2->weight) ? -1 : 1;
+    if (pEdge1->fromIndex != pEdge2->fromIndex)
+	return (pEdge1->fromIndex < pEdge2->fromIndex) ? -1 : 1;
+    return (pEdge1->toIndex > pEdge2->toIndex) -
+	(pEdge1->toIndex < pEdge2->toIndex);
+}
+
+/* Find the representative of the set holding a vertex, for
+ * Kruskal's algorithm. On the way we make every vertex we pass
+ * point to its grandparent (path halving), which keeps the
+ * trees very flat.
+ * Arguments
+ *    setParent  -  Parent of each vertex in the union-find forest
+ *    index      -  Vertex we are interested in
+ * Returns the index of the representative.
+ */
+int findSet(int *setParent, int index)
+{
+    while (setParent[index] != index)
     {
-	pathWeight = -4;
+	setParent[index] = setParent[setParent[index]];
+	index = setParent[index];
     }
+    return index;
+}
+
+/* Kruskal's algorithm. Sorts all the edges by weight, then adds
+ * each edge in turn unless its two ends are already connected.
+ * A union-find structure tells us which vertices are connected.
+ * Arguments
+ *    pNet       -  Network to search
+ *    treeEdges  -  Array to fill in, with room for vertexCount edges
+ * Returns the number of tree edges, or -1 for a memory allocation error.
+ */
+int kruskalSpanningTree(NETWORK_T *pNet, INDEX_EDGE_T *treeEdges)
+{
+    int edgeCount = 0;
+    int allCount = 0;
+    int i = 0;
+    VERTEX_T *pVertex = NULL;
+    int *setParent = calloc(pNet->nextIndex + 1, sizeof(int));
+    int *setRank = calloc(pNet->nextIndex + 1, sizeof(int));
+    INDEX_EDGE_T *allEdges = NULL;
+    /* each undirected edge is in both vertices' lists, so there
+     * are at most half as many edges as list items */
+    for (pVertex = pNet->vListHead; pVertex != NULL; pVertex = pVertex->next)
+	allCount += countAdjacent(pVertex);
+    allEdges = calloc(allCount / 2 + 1, sizeof(INDEX_EDGE_T));
+    if ((setParent == NULL) || (setRank == NULL) || (allEdges == NULL))
+    {
+	free(setParent);
+	free(setRank);
+	free(allEdges);
+	return -1;
+    }
+    allCount = 0;
+    for (pVertex = pNet->vListHead; pVertex != NULL; pVertex = pVertex->next)
+    {
+	ADJACENT_T *pAdjacent = pVertex->adjacent.head;
+	setParent[pVertex->index] = pVertex->index;
+	while (pAdjacent != NULL)
+	{
+	    VERTEX_T *pTo = (VERTEX_T *) pAdjacent->pVertex;
+	    if (pVertex->index < pTo->index)
+	    {
+		allEdges[allCount].fromIndex = pVertex->index;
+		allEdges[allCount].toIndex = pTo->index;
+		allEdges[allCount].weight = pAdjacent->weight;
+		allCount++;
+	    }
+	    pAdjacent = pAdjacent->next;
+	}
+    }
+    qsort(allEdges, allCount, sizeof(INDEX_EDGE_T), &compareIndexEdges);
+    for (i = 0; (i < allCount) && (edgeCount < pNet->vertexCount - 1); i++)
+    {
+	int set1 = findSet(setParent, allEdges[i].fromIndex);
+	int set2 = findSet(setParent, allEdges[i].toIndex);
+	if (set1 != set2)
+	{
+	    /* join the sets, putting the shorter tree under the taller */
+	    if (setRank[set1] < setRank[set2])
+	    {
+		setParent[set1] = set2;
+	    }
+	    else
+	    {
+		setParent[set2] = set1;
+		if (setRank[set1] == setRank[set2])
+		    setRank[set1]++;
+	    }
+	    treeEdges[edgeCount] = allEdges[i];
+	    edgeCount++;
+	}
+    }
+    free(setParent);
+    free(setRank);
+    free(allEdges);
+    return edgeCount;
+}
+
+
+/* Find a minimum spanning tree (or forest) of an undirected network.
+ * Prim's algorithm takes time proportional to E log V and does
+ * not need to sort all the edges, so it is better when there are
+ * many edges per vertex. Kruskal's algorithm takes time proportional
+ * to E log E, but with very simple steps, so it is better when the
+ * network is sparse.
+ * Arguments
+ *    graph         -  Network returned by newGraph
+ *    method        -  MST_PRIM, MST_KRUSKAL, or MST_AUTOMATIC
+ *    pTreeEdges    -  Used to return an array of the edges in the tree
+ *    pEdgeCount    -  Used to return the number of edges in the tree
+ *    pTotalWeight  -  Used to return the sum of the edge weights
+ * Returns 1 if successful, -2 if the network is directed,
+ * or -5 for a memory allocation error.
+ */
+int computeMinimumSpanningTree(GRAPH_HANDLE graph, int method,
+			       NETWORK_EDGE_T **pTreeEdges,
+			       int *pEdgeCount, int *pTotalWeight)
+{
+    NETWORK_T *pNet = (NETWORK_T *) graph;
+    INDEX_EDGE_T *indexEdges = NULL;
+    int edgeCount = 0;
+    int i = 0;
+    *pTreeEdges = NULL;
+    *pEdgeCount = 0;
+    *pTotalWeight = 0;
+    if (pNet->bGraphDirected)
+	return -2;
+    if (method == MST_AUTOMATIC)
+    {
+	/* compare the number of edges with V log V */
+	VERTEX_T *pVertex = NULL;
+	int listItems = 0;
+	int logV = 1;
+	while ((1 << logV) < pNet->vertexCount)
+	    logV++;
+	for (pVertex = pNet->vListHead; pVertex != NULL;
+	     pVertex = pVertex->next)
+	    listItems += countAdjacent(pVertex);
+	if (listItems / 2 > pNet->vertexCount * logV)
+	    method = MST_PRIM;
+	else
+	    method = MST_KRUSKAL;
+    }
+    indexEdges = calloc(pNet->vertexCount + 1, sizeof(INDEX_EDGE_T));
+    if (indexEdges == NULL)
+	return -5;
+    if (method == MST_PRIM)
+	edgeCount = primSpanningTree(pNet, indexEdges);
     else
+	edgeCount = kruskalSpanningTree(pNet, indexEdges);
+    if (edgeCount >= 0)
+	*pTreeEdges = calloc(edgeCount + 1, sizeof(NETWORK_EDGE_T));
+    if (*pTreeEdges == NULL)
     {
-	printf("Minimum weight path from %s to %s:\n", startKey, endKey);
-	printPath(pEndVertex);
+	free(indexEdges);
+	return -5;
     }
-    return pathWeight;
+    for (i = 0; i < edgeCount; i++)
+    {
+	(*pTreeEdges)[i].fromKey =
+	    pNet->vertexTable[indexEdges[i].fromIndex]->key;
+	(*pTreeEdges)[i].toKey = pNet->vertexTable[indexEdges[i].toIndex]->key;
+	(*pTreeEdges)[i].weight = indexEdges[i].weight;
+	*pTotalWeight += indexEdges[i].weight;
+    }
+    *pEdgeCount = edgeCount;
+    free(indexEdges);
+    return 1;
+}
+
+
+/* Make a compressed sparse row snapshot of the current network.
+ * The snapshot renumbers the vertices 0 to vertexCount-1 in the
+ * order of the vertex list, and copies the edges of each vertex
+ * in adjacency list order, so traversals of the snapshot visit
+ * vertices in the same order as traversals of the network.
+ * Argument
+ *    graph      -  Network returned by newGraph
+ * Returns a new snapshot, or NULL if a memory allocation error
+ * occurs. Call freeSnapshot() when it is no longer needed.
+ */
+NETWORK_SNAPSHOT_T *freezeNetwork(GRAPH_HANDLE graph)
+{
+    NETWORK_T *pNet = (NETWORK_T *) graph;
+    NETWORK_SNAPSHOT_T *pSnapshot = calloc(1, sizeof(NETWORK_SNAPSHOT_T));
+    int32_t *newIndex = calloc(pNet->nextIndex + 1, sizeof(int32_t));
+    VERTEX_T *pVertex = NULL;
+    int32_t vCount = 0;
+    int32_t eCount = 0;
+    size_t poolSize = 0;
+    int bOk = ((pSnapshot != NULL) && (newIndex != NULL));
+    /* First pass - count everything and work out the new numbering */
+    for (pVertex = pNet->vListHead; (bOk) && (pVertex != NULL);
+	 pVertex = pVertex->next)
+    {
+	newIndex[pVertex->index] = vCount;
+	vCount++;
+	eCount += countAdjacent(pVertex);
+	poolSize += strlen(pVertex->key) + 1;
+    }
+    if (bOk)
+    {
+	pSnapshot->vertexCount = vCount;
+	pSnapshot->edgeCount = eCount;
+	pSnapshot->bDirected = pNet->bGraphDirected;
+	pSnapshot->offsets = calloc(vCount + 1, sizeof(int32_t));
+	pSnapshot->targets = calloc(eCount + 1, sizeof(int32_t));
+	pSnapshot->weights = calloc(eCount + 1, sizeof(int32_t));
+	pSnapshot->keys = calloc(vCount + 1, sizeof(char *));
+	pSnapshot->data = calloc(vCount + 1, sizeof(void *));
+	pSnapshot->keyPool = calloc(poolSize + 1, 1);
+	bOk = ((pSnapshot->offsets != NULL) && (pSnapshot->targets != NULL)
+	       && (pSnapshot->weights != NULL) && (pSnapshot->keys != NULL)
+	       && (pSnapshot->data != NULL) && (pSnapshot->keyPool != NULL));
+    }
+    if (bOk)
+    {
+	/* Second pass - copy the keys, data and edges */
+	int32_t v = 0;
+	int32_t e = 0;
+	char *pNextKey = pSnapshot->keyPool;
+	for (pVertex = pNet->vListHead; pVertex != NULL;
+	     pVertex = pVertex->next)
+	{
+	    ADJACENT_T *pAdjacent = pVertex->adjacent.head;
+	    pSnapshot->offsets[v] = e;
+	    strcpy(pNextKey, pVertex->key);
+	    pSnapshot->keys[v] = pNextKey;
+	    pNextKey += strlen(pNextKey) + 1;
+	    pSnapshot->data[v] = pVertex->data;
+	    while (pAdjacent != NULL)
+	    {
+		VERTEX_T *pTo = (VERTEX_T *) pAdjacent->pVertex;
+		pSnapshot->targets[e] = newIndex[pTo->index];
+		pSnapshot->weights[e] = pAdjacent->weight;
+		e++;
+		pAdjacent = pAdjacent->next;
+	    }
+	    v++;
+	}
+	pSnapshot->offsets[v] = e;
+	bOk = snapshotBuildLookup(pSnapshot);
+    }
+    if ((!bOk) && (pSnapshot != NULL))
+    {
+	freeSnapshot(pSnapshot);
+	pSnapshot = NULL;
+    }
+    free(newIndex);
+    return pSnapshot;
 }
@@ -1,9 +1,18 @@
 /*
- *   minPriorityQueue.c 
+ *   minPriorityQueue.c
  *
- *   Linked list implementation of an abstract min priority queue
- *   This implementation is not at all efficient as it uses
- *   a linear search to find the minimum item
+ *   Binary heap implementation of an abstract min priority queue.
+ *   The items are kept in an array organized as a binary heap, so
+ *   the minimum item is always at index 0. Finding it is O(1) and
+ *   removing it or adding a new item is O(log n).
+ *
+ *   Because the queue holds pointers to the caller's own structures,
+ *   the caller may change the value that the compare function looks
+ *   at (for instance, the dValue of a vertex in Dijkstra's algorithm).
+ *   When that happens the caller must call decreaseKeyMin() so the item
+ *   can be moved to its correct place in the heap. To do this in
+ *   O(log n) we also keep a small open addressing hash table that
+ *   maps each data pointer to its current position in the heap array.
  *
  *   Created by Sally Goldin, 18 January 2012, for CPE 113
  *  Modified 20 April 2018 to use JavaDoc keywords in comments
@@ -12,172 +21,462 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 #include "minPriorityQueue.h"
 
+#define INITIAL_CAPACITY 64	/* starting size for the heap array */
+#define EMPTY_SLOT -1		/* marks an unused slot in the position table */
 
-/* Structure that represents one item of the list */
-typedef struct _listitem
+/* Structure that holds all the information for one queue */
+typedef struct
 {
-    void *data;			/* Pointer to the data for this node */
-    struct _listitem *next;	/* Link to the next item in the list */
-} LISTITEM_T;
+    void **heap;		/* array of data pointers organized as a heap */
+    int count;			/* number of items in the queue */
+    int capacity;		/* allocated size of the heap array */
+    void **posKeys;		/* position table - data pointers */
+    int *posValues;		/* position table - heap index for each key */
+    int posSize;		/* number of slots in the position table,
+				 * always a power of two */
+    /* Comparison function that must work like strcmp.
+     *  Returns -1 if data1 < data2, 0 if they are equivalent,
+     *  1 if data1 > data2 */
+    int (*compare) (void *data1, void *data2);
+} MINQUEUE_T;
 
-static int count = 0;		/* number of items in the queue */
-static LISTITEM_T *head = NULL;	/* front item in the queue */
-static LISTITEM_T *tail = NULL;	/* end item in the queue */
+static MINQUEUE_T queue = { NULL, 0, 0, NULL, NULL, 0, NULL };
 
-/* Comparison function that must work like strcmp.
- *  Returns -1 if data1 < data2, 0 if they are equivalent, 
- *  1 if data1 > data2 */
-int (*compare) (void *data1, void *data2) = NULL;
 
+/* Compute the starting slot in the position table for a pointer.
+ * Arguments
+ *     pQueue   Queue whose table we are using
+ *     data     Pointer we want to look up
+ * Returns slot index in the range 0 to posSize-1
+ */
+static int hashPointer(MINQUEUE_T * pQueue, void *data)
+{
+    uintptr_t value = (uintptr_t) data;
+    /* the low bits of a pointer are mostly zero, so mix them */
+    value = (value >> 4) ^ (value >> 16);
+    value = value * 2654435761u;
+    return (int) (value & (uintptr_t) (pQueue->posSize - 1));
+}
 
-/* Use the comparison function to find the smallest
- * item currently in the list
+/* Find the slot in the position table that holds a pointer.
  * Arguments
- *     pPredecessor Used to return the previous item so 
- *       we can unlink the minimum
- *  Returns A pointer to the minimum item, or null if the queue is empty.
+ *     pQueue   Queue whose table we are using
+ *     data     Pointer we want to look up
+ * Returns the slot index or -1 if the pointer is not in the table
  */
-LISTITEM_T *findMinimum(LISTITEM_T **pPredecessor)
+static int findSlot(MINQUEUE_T * pQueue, void *data)
 {
-    LISTITEM_T *pMinItem = NULL;
-    LISTITEM_T *pCurrentItem = NULL;
-    LISTITEM_T *pPredItem = NULL;
-    *pPredecessor = NULL;
-    if (count == 1)
+    int slot = -1;
+    if (pQueue->posSize > 0)
     {
-	pMinItem = head;
-    }
-    else if (count > 1)
-    {
-	pCurrentItem = head;
-	while (pCurrentItem != NULL)
+	int i = hashPointer(pQueue, data);
+	while (pQueue->posValues[i] != EMPTY_SLOT)
 	{
-	    /* if this is the first item in the list, or
-	     * this item is less than the current min
-	     */
-	    if ((pMinItem == NULL) ||
-		((*compare) (pCurrentItem->data, pMinItem->data) < 0))
+	    if (pQueue->posKeys[i] == data)
 	    {
-		pMinItem = pCurrentItem;
-		*pPredecessor = pPredItem;
-		/* reset current min and also set predecessor */
+		slot = i;
+		break;
 	    }
-	    pPredItem = pCurrentItem;
-	    pCurrentItem = pCurrentItem->next;
+	    i = (i + 1) & (pQueue->posSize - 1);
 	}
     }
-    return pMinItem;
+    return slot;
 }
 
-/*
- * Add a data item to the queue (end of the list)
+/* Store or update the heap position for a pointer. The table
+ * is always at least twice as large as the heap, so there is
+ * always an empty slot to stop the probing.
  * Arguments
- *      data    Pointer to generic data we want to add to queue   
- *  Returns 1 if successful, 0 if we have run out of space.
+ *     pQueue   Queue whose table we are using
+ *     data     Pointer to store
+ *     position Its index in the heap array
  */
-int enqueueMin(void *data)
+static void setPosition(MINQUEUE_T * pQueue, void *data, int position)
+{
+    int i = hashPointer(pQueue, data);
+    while ((pQueue->posValues[i] != EMPTY_SLOT) &&
+	   (pQueue->posKeys[i] != data))
+    {
+	i = (i + 1) & (pQueue->posSize - 1);
+    }
+    pQueue->posKeys[i] = data;
+    pQueue->posValues[i] = position;
+}
+
+/* Remove a pointer from the position table. Because we use
+ * linear probing, we shift later items in the same run back
+ * so that lookups never stop early at the hole we leave.
+ * Arguments
+ *     pQueue   Queue whose table we are using
+ *     slot     Slot to empty
+ */
+static void clearSlot(MINQUEUE_T * pQueue, int slot)
+{
+    int mask = pQueue->posSize - 1;
+    int hole = slot;
+    int i = (slot + 1) & mask;
+    while (pQueue->posValues[i] != EMPTY_SLOT)
+    {
+	int home = hashPointer(pQueue, pQueue->posKeys[i]);
+	/* move this item into the hole if its home slot is not
+	 * between the hole and its current slot (cyclically) */
+	if (((i - home) & mask) >= ((i - hole) & mask))
+	{
+	    pQueue->posKeys[hole] = pQueue->posKeys[i];
+	    pQueue->posValues[hole] = pQueue->posValues[i];
+	    hole = i;
+	}
+	i = (i + 1) & mask;
+    }
+    pQueue->posKeys[hole] = NULL;
+    pQueue->posValues[hole] = EMPTY_SLOT;
+}
+
+/* Make the heap array and position table big enough for one
+ * more item.
+ * Arguments
+ *     pQueue   Queue to grow
+ * Returns 1 if successful, 0 for a memory allocation error.
+ */
+static int growQueue(MINQUEUE_T * pQueue)
 {
     int bOk = 1;
-    LISTITEM_T *newItem = (LISTITEM_T *) calloc(1, sizeof(LISTITEM_T));
-    if (newItem == NULL)
+    if (pQueue->count == pQueue->capacity)
     {
-	bOk = 0;
+	int newCapacity = (pQueue->capacity == 0) ?
+	    INITIAL_CAPACITY : pQueue->capacity * 2;
+	void **newHeap = realloc(pQueue->heap, newCapacity * sizeof(void *));
+	if (newHeap == NULL)
+	{
+	    bOk = 0;
+	}
+	else
+	{
+	    pQueue->heap = newHeap;
+	    pQueue->capacity = newCapacity;
+	}
     }
-    else
+    if ((bOk) && (pQueue->posSize < 2 * (pQueue->count + 1)))
     {
-	newItem->data = data;	/* store the data */
-	if (head == NULL)	/* nothing in the queue yet */
+	int i = 0;
+	int newSize = (pQueue->posSize == 0) ?
+	    2 * INITIAL_CAPACITY : pQueue->posSize * 2;
+	void **newKeys = calloc(newSize, sizeof(void *));
+	int *newValues = malloc(newSize * sizeof(int));
+	if ((newKeys == NULL) || (newValues == NULL))
 	{
-	    head = newItem;
+	    free(newKeys);
+	    free(newValues);
+	    bOk = 0;
 	}
 	else
 	{
-	    tail->next = newItem;	/* add to the end of the queue */
+	    for (i = 0; i < newSize; i++)
+		newValues[i] = EMPTY_SLOT;
+	    free(pQueue->posKeys);
+	    free(pQueue->posValues);
+	    pQueue->posKeys = newKeys;
+	    pQueue->posValues = newValues;
+	    pQueue->posSize = newSize;
+	    /* rehash everything currently in the heap */
+	    for (i = 0; i < pQueue->count; i++)
+		setPosition(pQueue, pQueue->heap[i], i);
 	}
-	tail = newItem;		/* either way the new item is now the end */
-	count++;
     }
     return bOk;
 }
 
+/* Put an item at a heap index and record its new position.
+ * Arguments
+ *     pQueue   Queue we are working on
+ *     index    Position in the heap array
+ *     data     Item to store there
+ */
+static void placeItem(MINQUEUE_T * pQueue, int index, void *data)
+{
+    pQueue->heap[index] = data;
+    setPosition(pQueue, data, index);
+}
+
+/* Move an item up toward the root until its parent is not larger.
+ * Arguments
+ *     pQueue   Queue we are working on
+ *     index    Current position of the item
+ * Returns the final position of the item.
+ */
+static int siftUp(MINQUEUE_T * pQueue, int index)
+{
+    void *data = pQueue->heap[index];
+    while (index > 0)
+    {
+	int parent = (index - 1) / 2;
+	if ((*pQueue->compare) (data, pQueue->heap[parent]) >= 0)
+	    break;
+	placeItem(pQueue, index, pQueue->heap[parent]);
+	index = parent;
+    }
+    placeItem(pQueue, index, data);
+    return index;
+}
 
-/* Get the next item in the queue. This is the minimum 
- * element as defined by applying the compareFunction. 
+/* Move an item down toward the leaves until neither child is smaller.
+ * Arguments
+ *     pQueue   Queue we are working on
+ *     index    Current position of the item
+ */
+static void siftDown(MINQUEUE_T * pQueue, int index)
+{
+    void *data = pQueue->heap[index];
+    while (2 * index + 1 < pQueue->count)
+    {
+	int child = 2 * index + 1;
+	if ((child + 1 < pQueue->count) &&
+	    ((*pQueue->compare) (pQueue->heap[child + 1],
+				 pQueue->heap[child]) < 0))
+	{
+	    child++;		/* right child is the smaller one */
+	}
+	if ((*pQueue->compare) (pQueue->heap[child], data) >= 0)
+	    break;
+	placeItem(pQueue, index, pQueue->heap[child]);
+	index = child;
+    }
+    placeItem(pQueue, index, data);
+}
+
+/********************************/
+/** Public functions start here */
+/********************************/
+
+/* Create a new, empty queue with its own storage. Queues
+ * created this way are independent, so different threads
+ * can each use their own queue at the same time.
+ * Arguments
+ *      compareFunction  Function that compares two items, like strcmp
+ * Returns a handle for the queue, or NULL if a memory
+ * allocation error occurs.
+ */
+MIN_QUEUE_HANDLE newMinQueue(int (*compareFunction) (void *data1,
+						      void *data2))
+{
+    MINQUEUE_T *pQueue = calloc(1, sizeof(MINQUEUE_T));
+    if (pQueue != NULL)
+	pQueue->compare = compareFunction;
+    return (MIN_QUEUE_HANDLE) pQueue;
+}
+
+
+/* Free all memory associated with a queue. Does not free
+ * the data items.
+ * Arguments
+ *      minQueue   Handle returned by newMinQueue. Not valid
+ *                 after this call.
+ */
+void minQueueDestroy(MIN_QUEUE_HANDLE minQueue)
+{
+    MINQUEUE_T *pQueue = (MINQUEUE_T *) minQueue;
+    if (pQueue != NULL)
+    {
+	free(pQueue->heap);
+	free(pQueue->posKeys);
+	free(pQueue->posValues);
+	free(pQueue);
+    }
+}
+
+
+/*
+ * Add a data item to the queue. If the item is already in
+ * the queue, it is simply moved to its correct position.
+ * Arguments
+ *      minQueue   Queue to add to
+ *      data       Pointer to generic data we want to add to queue
+ *  Returns 1 if successful, 0 if we have run out of space.
+ */
+int minQueueEnqueue(MIN_QUEUE_HANDLE minQueue, void *data)
+{
+    int bOk = 1;
+    MINQUEUE_T *pQueue = (MINQUEUE_T *) minQueue;
+    int slot = findSlot(pQueue, data);
+    if (slot >= 0)		/* already queued - just reposition it */
+    {
+	int index = siftUp(pQueue, pQueue->posValues[slot]);
+	siftDown(pQueue, index);
+    }
+    else if (!growQueue(pQueue))
+    {
+	bOk = 0;
+    }
+    else
+    {
+	pQueue->heap[pQueue->count] = data;
+	pQueue->count++;
+	siftUp(pQueue, pQueue->count - 1);
+    }
+    return bOk;
+}
+
+
+/* Get the next item in the queue. This is the minimum
+ * element as defined by applying the compareFunction.
  * Also removes that item from the queue.
+ * Arguments
+ *      minQueue   Queue to remove from
  *  Returns the data stored in the minimum item or  NULL if the queue is empty.
  */
-void *dequeueMin()
+void *minQueueDequeue(MIN_QUEUE_HANDLE minQueue)
 {
     void *returnData = NULL;
-    if (count > 0)
+    MINQUEUE_T *pQueue = (MINQUEUE_T *) minQueue;
+    if (pQueue->count > 0)
     {
-	LISTITEM_T *pPredItem = NULL;	/* preceding item */
-	LISTITEM_T *pMinItem = findMinimum(&pPredItem);
-	returnData = pMinItem->data;
-	if (pPredItem != NULL)
+	returnData = pQueue->heap[0];
+	clearSlot(pQueue, findSlot(pQueue, returnData));
+	pQueue->count--;
+	if (pQueue->count > 0)
 	{
-	    pPredItem->next = pMinItem->next;
+	    /* move the last item to the root and let it sink */
+	    pQueue->heap[0] = pQueue->heap[pQueue->count];
+	    siftDown(pQueue, 0);
 	}
-	if (pMinItem == head)
-	{
-	    head = pMinItem->next;
-	}
-	if (pMinItem == tail)
-	{
-	    tail = pPredItem;
-	}
-	free(pMinItem);
-	count--;
     }
     return returnData;
 }
 
 
+/* Look at the minimum item without removing it.
+ * Arguments
+ *      minQueue   Queue to look at
+ *  Returns the data stored in the minimum item or NULL if the queue is empty.
+ */
+void *minQueuePeek(MIN_QUEUE_HANDLE minQueue)
+{
+    MINQUEUE_T *pQueue = (MINQUEUE_T *) minQueue;
+    return (pQueue->count > 0) ? pQueue->heap[0] : NULL;
+}
+
+
+/* Tell the queue that the value used by the compare function
+ * for an item has gotten smaller, so the item may need to move
+ * toward the front of the queue.
+ * Arguments
+ *      minQueue   Queue holding the item
+ *      data       Pointer to an item already in the queue
+ * Returns 1 if successful, 0 if the item is not in the queue.
+ */
+int minQueueDecreaseKey(MIN_QUEUE_HANDLE minQueue, void *data)
+{
+    int bOk = 0;
+    MINQUEUE_T *pQueue = (MINQUEUE_T *) minQueue;
+    int slot = findSlot(pQueue, data);
+    if (slot >= 0)
+    {
+	siftUp(pQueue, pQueue->posValues[slot]);
+	bOk = 1;
+    }
+    return bOk;
+}
+
+
+/*  Find out how many items are currently in a queue.
+ *  Returns number of items in the queue (could be zero)
+ */
+int minQueueSize(MIN_QUEUE_HANDLE minQueue)
+{
+    return ((MINQUEUE_T *) minQueue)->count;
+}
+
+
+/* Empty a queue so we can reuse it. We keep the arrays we
+ * have already allocated, since the next use of the queue
+ * is likely to need about the same space.
+ */
+void minQueueClear(MIN_QUEUE_HANDLE minQueue)
+{
+    int i = 0;
+    MINQUEUE_T *pQueue = (MINQUEUE_T *) minQueue;
+    for (i = 0; i < pQueue->count; i++)
+	clearSlot(pQueue, findSlot(pQueue, pQueue->heap[i]));
+    pQueue->count = 0;
+}
+
+
+/* The functions below work on a single queue owned by this
+ * module, for programs that only need one queue.
+ */
+
+/*
+ * Add a data item to the queue. If the item is already in
+ * the queue, it is simply moved to its correct position.
+ * Arguments
+ *      data    Pointer to generic data we want to add to queue
+ *  Returns 1 if successful, 0 if we have run out of space.
+ */
+int enqueueMin(void *data)
+{
+    return minQueueEnqueue(&queue, data);
+}
+
+
+/* Get the next item in the queue. This is the minimum
+ * element as defined by applying the compareFunction.
+ * Also removes that item from the queue.
+ *  Returns the data stored in the minimum item or  NULL if the queue is empty.
+ */
+void *dequeueMin()
+{
+    return minQueueDequeue(&queue);
+}
+
+
+/* Tell the queue that the value used by the compare function
+ * for an item has gotten smaller, so the item may need to move
+ * toward the front of the queue.
+ * Arguments
+ *      data    Pointer to an item already in the queue
+ * Returns 1 if successful, 0 if the item is not in the queue.
+ */
+int decreaseKeyMin(void *data)
+{
+    return minQueueDecreaseKey(&queue, data);
+}
+
+
 /*  Find out how many items are currently in the queue.
  *  Returns number of items in the queue (could be zero)
  */
 int queueMinSize()
 {
-    return count;
+    return queue.count;
 }
 
 
-/* Clear so we can reuse, and reinitialize 
+/* Clear so we can reuse, and reinitialize. We keep the
+ * arrays we have already allocated, since the next use
+ * of the queue is likely to need about the same space.
  */
 void queueMinInit(int (*compareFunction) (void *data1, void *data2))
 {
-    int i = 0;
-    compare = compareFunction;
-    LISTITEM_T *item = head;
-    LISTITEM_T *freeItem = NULL;
-    while (item != NULL)
-    {
-	freeItem = item;
-	item = item->next;
-	free(freeItem);
-    }
-    /* reset head, tail and count */
-    head = NULL;
-    tail = NULL;
-    count = 0;
+    queue.compare = compareFunction;
+    minQueueClear(&queue);
 }
 
 
 /* DEBUGGING FUNCTION PRINTS SOME INFO ABOUT THE QUEUE **/
 void queueMinDebug()
 {
-    int i, j;
-    printf("count = %d   head = %p  tail = %p\n", count, head, tail);
-    if (count > 0)
+    int i;
+    printf("count = %d   capacity = %d  table size = %d\n",
+	   queue.count, queue.capacity, queue.posSize);
+    if (queue.count > 0)
     {
-	printf("Contents: \n");
-	LISTITEM_T *item = head;
-	while (item != NULL)
+	printf("Contents (heap order): \n");
+	for (i = 0; i < queue.count; i++)
 	{
-	    printf("\t\t%s\n", item->data);
-	    item = item->next;
+	    printf("\t\t%s\n", (char *) queue.heap[i]);
 	}
     }
 }
@@ -17,8 +17,68 @@
 #ifndef MINPRIORITYQUEUE_H
 #define MINPRIORITYQUEUE_H
 
+/* opaque pointer to a queue created by newMinQueue */
+typedef void* MIN_QUEUE_HANDLE;
+
+/* Create a new, empty queue with its own storage. Each queue
+ * is independent, so different threads can each use their own.
+ * Arguments:
+ *   compareFunction  -  Function that compares two items. Must
+ *                       return -1, 0 or 1, like strcmp.
+ * Returns a handle for the queue, or NULL if a memory
+ * allocation error occurs.
+ */
+MIN_QUEUE_HANDLE newMinQueue(int (*compareFunction)(void* data1, void* data2));
+
+/* Free all memory associated with a queue. Does not free
+ * the data items.
+ * Arguments:
+ *   minQueue  -  Queue to free. Not valid after this call.
+ */
+void minQueueDestroy(MIN_QUEUE_HANDLE minQueue);
+
+/* Add a data item to a queue. Works like enqueueMin.
+ * Arguments:
+ *   minQueue  -  Queue to add to
+ *   data      -  Pointer to the item we want to add
+ * Returns 1 if successful, 0 if we have run out of space.
+ */
+int minQueueEnqueue(MIN_QUEUE_HANDLE minQueue, void* data);
+
+/* Remove and return the smallest item in a queue. Works like dequeueMin.
+ * Returns NULL if the queue is empty.
+ */
+void* minQueueDequeue(MIN_QUEUE_HANDLE minQueue);
+
+/* Return the smallest item in a queue without removing it.
+ * Returns NULL if the queue is empty.
+ */
+void* minQueuePeek(MIN_QUEUE_HANDLE minQueue);
+
+/* Tell a queue that an item's value has become smaller.
+ * Works like decreaseKeyMin.
+ * Returns 1 if successful, 0 if the item is not in the queue.
+ */
+int minQueueDecreaseKey(MIN_QUEUE_HANDLE minQueue, void* data);
+
+/* Find out how many items are in a queue.
+ * Returns number of items in the queue (could be zero)
+ */
+int minQueueSize(MIN_QUEUE_HANDLE minQueue);
+
+/* Empty a queue so it can be reused.
+ */
+void minQueueClear(MIN_QUEUE_HANDLE minQueue);
+
+
+/* The functions below use a single queue that belongs to
+ * the module, for programs that only need one queue.
+ */
+
 /**
- * Add a data item to the queue (end of the list)
+ * Add a data item to the queue. Each item can be in the queue
+ * only once; adding an item that is already there just moves it
+ * to the correct position.
  * Arguments:
  *   data      -   Pointer to string we want to add to queue   
  * Returns 1 if successful, 0 if we have run out of space.
@@ -32,6 +92,16 @@ int enqueueMin(void* data);
  */
 void* dequeueMin();
 
+/* Tell the queue that the value the compare function looks at
+ * for an item has become smaller. This must be called whenever the
+ * caller reduces that value for an item that is still queued,
+ * for instance after lowering a vertex's dValue in Dijkstra's algorithm.
+ * Arguments:
+ *   data      -   Pointer to an item already in the queue
+ * Returns 1 if successful, 0 if the item is not in the queue.
+ */
+int decreaseKeyMin(void* data);
+
 /* Find out how many items are currently in the queue.
  * Return number of items in the queue (could be zero)
  */
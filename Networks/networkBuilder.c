@@ -14,9 +14,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 #include "abstractNetwork.h"
 #include "networkBuilder.h"
 
+#define MAXKEYLEN 64		/* same limit as the buffers in processCommand */
+
 /*********************************************************************
  The network definition file is a text file. Its format is as follows.
 
@@ -48,7 +58,7 @@
  */
 
 
-void processCommand(char *command, int bVerbose);
+void processCommand(GRAPH_HANDLE graph, char *command, int bVerbose);
 
 
 /* Opens and reads a network definition file that is supposed to follow
@@ -58,9 +68,10 @@ void processCommand(char *command, int bVerbose);
  *       filename    Filename to read, with path
  *       bVerbose    If non-zero, print messages as processing goes on
  *                     if zero, prints only error messages
+ *       pGraph      Used to return the new network, or NULL
  * Returns  1 if successful, -1 if any error occurs.
  */
-int readNetworkDefinition(char *filename, int bVerbose)
+int readNetworkDefinition(char *filename, int bVerbose, GRAPH_HANDLE * pGraph)
 {
     int status = 1;
     FILE *pFp = NULL;
@@ -70,6 +81,7 @@ int readNetworkDefinition(char *filename, int bVerbose)
     int weight = 0;
     int vertexCount = 0;
     int bDirected = 0;
+    *pGraph = NULL;
     pFp = fopen(filename, "r");
     if (pFp == NULL)
     {
@@ -88,7 +100,7 @@ int readNetworkDefinition(char *filename, int bVerbose)
 		status = -1;
 		fprintf(stderr, "Error - file %s has bad format\n", filename);
 	    }
-	    else if (initGraph(vertexCount, bDirected))
+	    else if ((*pGraph = newGraph(vertexCount, bDirected)) != NULL)
 	    {
 		if (bVerbose)
 		    fprintf(stdout,
@@ -98,7 +110,7 @@ int readNetworkDefinition(char *filename, int bVerbose)
 		while (fgets(inputline, sizeof(inputline), pFp) != NULL)
 		{
 		    inputline[strlen(inputline) - 1] = '\0';
-		    processCommand(inputline, bVerbose);
+		    processCommand(*pGraph, inputline, bVerbose);
 		}
 	    }
 	    else
@@ -107,6 +119,11 @@ int readNetworkDefinition(char *filename, int bVerbose)
 		fprintf(stderr, "Error - cannot initialize network\n");
 	    }
 	}
+	else			/* empty file */
+	{
+	    status = -1;
+	    fprintf(stderr, "Error - file %s has bad format\n", filename);
+	}
 	fclose(pFp);
     }
     return status;
@@ -117,10 +134,11 @@ int readNetworkDefinition(char *filename, int bVerbose)
  * function as appropriate. Handle errors and 
  * give feed back if bVerbose is set to true.
  * Arguments
+ *      graph        Network we are building
  *      command      Line read from network builder file
  *      bVerbose     If true, give information about all operations executed
  */
-void processCommand(char *command, int bVerbose)
+void processCommand(GRAPH_HANDLE graph, char *command, int bVerbose)
 {
     char keystring1[64] = "";
     char keystring2[64] = "";
@@ -142,7 +160,7 @@ void processCommand(char *command, int bVerbose)
 	{
 	    key = strdup(keystring1);
 	    newString = strdup(keystring1);	/* use the key as data as well */
-	    retval = addVertex(key, newString);
+	    retval = addVertex(graph, key, newString);
 	    if (retval == 1)
 	    {
 		if (bVerbose)
@@ -189,7 +207,7 @@ void processCommand(char *command, int bVerbose)
 	}
 	else
 	{
-	    retval = addEdge(keystring1, keystring2, weight);
+	    retval = addEdge(graph, keystring1, keystring2, weight);
 	    if (retval == 1)
 	    {
 		if (bVerbose)
@@ -217,3 +235,729 @@ void processCommand(char *command, int bVerbose)
 	fprintf(stderr, "  |%s|\n", command);
     }
 }
+
+
+/**************************************************************************
+ * Fast loader. Instead of reading the file a line at a time with fgets
+ * and parsing each line with sscanf, we map the whole file into memory
+ * and pick out the words ("tokens") by walking along the characters
+ * ourselves. Nothing is copied except the keys, which must be passed
+ * to the network functions as C strings.
+ **************************************************************************/
+
+/* Structure that describes one token: where it starts in the
+ * file contents and how many characters it has.
+ */
+typedef struct
+{
+    const char *start;		/* first character of the token */
+    int length;			/* number of characters, 0 if no token */
+} TOKEN_T;
+
+/* Get the entire contents of a file. Where possible we memory map it,
+ * which avoids copying the file into a buffer of our own.
+ * Arguments
+ *    filename    -   file to read
+ *    pSize       -   used to return the number of bytes
+ *    pbMapped    -   used to return 1 if mapped, 0 if read into a buffer
+ * Returns pointer to the contents, or NULL if the file cannot be read.
+ */
+static char *loadFileContents(char *filename, size_t * pSize, int *pbMapped)
+{
+    char *contents = NULL;
+    *pSize = 0;
+    *pbMapped = 0;
+#ifndef _WIN32
+    int fd = open(filename, O_RDONLY);
+    if (fd >= 0)
+    {
+	struct stat info;
+	if ((fstat(fd, &info) == 0) && (info.st_size > 0))
+	{
+	    void *pMap = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE,
+			      fd, 0);
+	    if (pMap != MAP_FAILED)
+	    {
+		/* tell the OS we will read straight through */
+		madvise(pMap, info.st_size, MADV_SEQUENTIAL);
+		contents = (char *) pMap;
+		*pSize = info.st_size;
+		*pbMapped = 1;
+	    }
+	}
+	close(fd);
+    }
+#endif
+    if (contents == NULL)
+    {
+	/* fall back to reading the whole file into memory */
+	FILE *pFp = fopen(filename, "rb");
+	if (pFp != NULL)
+	{
+	    fseek(pFp, 0, SEEK_END);
+	    long size = ftell(pFp);
+	    fseek(pFp, 0, SEEK_SET);
+	    if (size > 0)
+	    {
+		contents = malloc(size);
+		if ((contents != NULL) &&
+		    (fread(contents, 1, size, pFp) != (size_t) size))
+		{
+		    free(contents);
+		    contents = NULL;
+		}
+		else
+		{
+		    *pSize = size;
+		}
+	    }
+	    fclose(pFp);
+	}
+    }
+    return contents;
+}
+
+/* Release the contents returned by loadFileContents.
+ * Arguments
+ *    contents    -   pointer returned by loadFileContents
+ *    size        -   size returned by loadFileContents
+ *    bMapped     -   mapping flag returned by loadFileContents
+ */
+static void releaseFileContents(char *contents, size_t size, int bMapped)
+{
+#ifndef _WIN32
+    if (bMapped)
+    {
+	munmap(contents, size);
+	return;
+    }
+#endif
+    free(contents);
+}
+
+/* Find the next token on a line. Tokens are separated by
+ * spaces or tabs.
+ * Arguments
+ *    pPos      -   current position; updated to just after the token
+ *    lineEnd   -   first character past the end of the line
+ * Returns the token. Its length is zero if there are no more tokens.
+ */
+static TOKEN_T nextToken(const char **pPos, const char *lineEnd)
+{
+    TOKEN_T token;
+    const char *p = *pPos;
+    while ((p < lineEnd) && ((*p == ' ') || (*p == '\t') || (*p == '\r')))
+	p++;
+    token.start = p;
+    while ((p < lineEnd) && (*p != ' ') && (*p != '\t') && (*p != '\r'))
+	p++;
+    token.length = (int) (p - token.start);
+    *pPos = p;
+    return token;
+}
+
+/* Check whether a token is a particular word.
+ * Arguments
+ *    token    -   token to check
+ *    word     -   word to compare with
+ * Returns 1 if they are the same, 0 otherwise.
+ */
+static int tokenIs(TOKEN_T token, const char *word)
+{
+    return (token.length == (int) strlen(word)) &&
+	(strncmp(token.start, word, token.length) == 0);
+}
+
+/* Copy a token into a buffer as a C string.
+ * Arguments
+ *    token    -   token to copy
+ *    buffer   -   where to put it, must hold MAXKEYLEN characters
+ * Returns 1 if successful, 0 if the token is too long.
+ */
+static int tokenToString(TOKEN_T token, char *buffer)
+{
+    if (token.length >= MAXKEYLEN)
+	return 0;
+    memcpy(buffer, token.start, token.length);
+    buffer[token.length] = '\0';
+    return 1;
+}
+
+/* Convert a token holding an integer, with optional sign.
+ * Arguments
+ *    token    -   token to convert
+ *    pValue   -   used to return the value
+ * Returns 1 if the token is a valid integer, 0 if not or if
+ * the value is too big for an int.
+ */
+static int tokenToInt(TOKEN_T token, int *pValue)
+{
+    int i = 0;
+    int sign = 1;
+    int value = 0;
+    if ((token.length > 0) && ((token.start[0] == '-') ||
+			       (token.start[0] == '+')))
+    {
+	sign = (token.start[0] == '-') ? -1 : 1;
+	i = 1;
+    }
+    if (i >= token.length)
+	return 0;
+    for (; i < token.length; i++)
+    {
+	int digit = token.start[i] - '0';
+	if ((digit < 0) || (digit > 9))
+	    return 0;
+	if (value > (INT_MAX - digit) / 10)
+	    return 0;
+	value = value * 10 + digit;
+    }
+    *pValue = sign * value;
+    return 1;
+}
+
+/* Process one line of the file for the fast loader. Reports the
+ * same errors as processCommand, but adds the line number.
+ * Arguments
+ *    graph        -   network we are building
+ *    lineStart    -   first character of the line
+ *    lineEnd      -   first character past the end of the line
+ *    lineNumber   -   line number, for messages
+ *    bVerbose     -   if true, give information about all operations
+ */
+static void processLine(GRAPH_HANDLE graph, const char *lineStart,
+			const char *lineEnd, int lineNumber, int bVerbose)
+{
+    char keystring1[MAXKEYLEN] = "";
+    char keystring2[MAXKEYLEN] = "";
+    const char *pos = lineStart;
+    TOKEN_T command = nextToken(&pos, lineEnd);
+    int length = (int) (lineEnd - lineStart);
+    int retval = 0;
+    if ((length > 0) && (lineStart[length - 1] == '\r'))
+	length--;
+    if (command.length == 0)
+    {
+	/* blank line - nothing to do */
+    }
+    else if (tokenIs(command, "VERTEX"))
+    {
+	TOKEN_T key = nextToken(&pos, lineEnd);
+	if (key.length == 0)
+	{
+	    fprintf(stderr, "Error (line %d): Missing key\n  |%.*s|\n",
+		    lineNumber, length, lineStart);
+	}
+	else if (!tokenToString(key, keystring1))
+	{
+	    fprintf(stderr, "Error (line %d): Key is too long\n  |%.*s|\n",
+		    lineNumber, length, lineStart);
+	}
+	else
+	{
+	    /* addVertex copies the key, so the only allocation
+	     * here is the copy we use as the vertex data */
+	    char *newString = strdup(keystring1);
+	    retval = (newString != NULL) ? addVertex(graph, keystring1, newString) : 0;
+	    if (retval == 1)
+	    {
+		if (bVerbose)
+		    fprintf(stdout, "Vertex |%s| added\n", keystring1);
+	    }
+	    else if (retval < 0)
+	    {
+		fprintf(stderr,
+			"Error (line %d): Vertex with key |%s| already exists in graph\n",
+			lineNumber, keystring1);
+		free(newString);
+	    }
+	    else
+	    {
+		fprintf(stderr,
+			"Error (line %d): Trying to insert vertex with |%s|- allocation error or graph full\n",
+			lineNumber, keystring1);
+		free(newString);
+	    }
+	}
+    }
+    else if (tokenIs(command, "EDGE"))
+    {
+	TOKEN_T key1 = nextToken(&pos, lineEnd);
+	TOKEN_T key2 = nextToken(&pos, lineEnd);
+	TOKEN_T weightToken = nextToken(&pos, lineEnd);
+	int weight = -1;
+	if ((key1.length == 0) || (key2.length == 0))
+	{
+	    fprintf(stderr,
+		    "Error (line %d): At least one key missing in edge command\n  |%.*s|\n",
+		    lineNumber, length, lineStart);
+	}
+	else if ((!tokenToString(key1, keystring1)) ||
+		 (!tokenToString(key2, keystring2)))
+	{
+	    fprintf(stderr, "Error (line %d): Key is too long\n  |%.*s|\n",
+		    lineNumber, length, lineStart);
+	}
+	else if (strcmp(keystring1, keystring2) == 0)
+	{
+	    fprintf(stderr,
+		    "Error (line %d): 'From' and 'To' vertices are the same\n  |%.*s|\n",
+		    lineNumber, length, lineStart);
+	}
+	else if ((!tokenToInt(weightToken, &weight)) || (weight < 0))
+	{
+	    fprintf(stderr,
+		    "Error (line %d): weight must be specified as non negative integer\n  |%.*s|\n",
+		    lineNumber, length, lineStart);
+	}
+	else
+	{
+	    retval = addEdge(graph, keystring1, keystring2, weight);
+	    if (retval == 1)
+	    {
+		if (bVerbose)
+		    fprintf(stdout,
+			    "Added edge from |%s| to |%s| with weight %d\n",
+			    keystring1, keystring2, weight);
+	    }
+	    else if (retval < 0)
+	    {
+		fprintf(stderr,
+			"Error (line %d): Edge from |%s| to |%s| already exists\n  |%.*s|\n",
+			lineNumber, keystring1, keystring2, length, lineStart);
+	    }
+	    else
+	    {
+		fprintf(stderr,
+			"Error (line %d): At least one vertex doesn't exist or memory allocation error\n  |%.*s|\n",
+			lineNumber, length, lineStart);
+	    }
+	}
+    }
+    else
+    {
+	fprintf(stderr,
+		"Incorrect command found in file (line %d) - ignoring\n",
+		lineNumber);
+	fprintf(stderr, "  |%.*s|\n", length, lineStart);
+    }
+}
+
+
+/* Reads a network definition file in the same format as
+ * readNetworkDefinition, but much faster for large files.
+ * See networkBuilder.h for details.
+ * Arguments
+ *       filename    Filename to read, with path
+ *       bVerbose    If non-zero, print messages as processing goes on
+ *                     if zero, prints only error messages
+ *       pGraph      Used to return the new network, or NULL
+ * Returns  1 if successful, -1 if any error occurs.
+ */
+int readNetworkDefinitionFast(char *filename, int bVerbose,
+			      GRAPH_HANDLE * pGraph)
+{
+    int status = 1;
+    size_t size = 0;
+    int bMapped = 0;
+    char *contents = loadFileContents(filename, &size, &bMapped);
+    *pGraph = NULL;
+    if (contents == NULL)
+    {
+	status = -1;
+	fprintf(stderr, "Error - cannot open file %s\n", filename);
+    }
+    else
+    {
+	const char *end = contents + size;
+	const char *lineStart = contents;
+	const char *lineEnd = memchr(lineStart, '\n', end - lineStart);
+	const char *pos = lineStart;
+	int vertexCount = 0;
+	int bDirected = 0;
+	int lineNumber = 1;
+	if (bVerbose)
+	    fprintf(stdout, ">> Successfully opened file %s\n", filename);
+	if (lineEnd == NULL)
+	    lineEnd = end;
+	/* header line: NumVertices bDirected */
+	if ((!tokenToInt(nextToken(&pos, lineEnd), &vertexCount)) ||
+	    (vertexCount <= 0) ||
+	    (!tokenToInt(nextToken(&pos, lineEnd), &bDirected)))
+	{
+	    status = -1;
+	    fprintf(stderr, "Error - file %s has bad format\n", filename);
+	}
+	else if ((*pGraph = newGraph(vertexCount, bDirected)) != NULL)
+	{
+	    /* newGraph has sized the vertex index for vertexCount keys */
+	    if (bVerbose)
+		fprintf(stdout,
+			"Successfully initialized %s network with %d vertices\n",
+			(bDirected ? "DIRECTED" : "UNDIRECTED"), vertexCount);
+	    while (lineEnd < end)
+	    {
+		lineStart = lineEnd + 1;
+		lineEnd = memchr(lineStart, '\n', end - lineStart);
+		if (lineEnd == NULL)
+		    lineEnd = end;
+		lineNumber++;
+		processLine(*pGraph, lineStart, lineEnd, lineNumber, bVerbose);
+	    }
+	}
+	else
+	{
+	    status = -1;
+	    fprintf(stderr, "Error - cannot initialize network\n");
+	}
+	releaseFileContents(contents, size, bMapped);
+    }
+    return status;
+}
+
+
+/**************************************************************************
+ * Binary network files. See networkBuilder.h for the layout.
+ **************************************************************************/
+
+#define BINARY_VERSION 1
+
+/* Header at the start of a binary network file */
+typedef struct
+{
+    char identifier[4];		/* always "NETB" */
+    int32_t version;		/* BINARY_VERSION */
+    int32_t bDirected;		/* 1 if directed */
+    int32_t vertexCount;	/* number of vertices */
+    int32_t edgeCount;		/* number of entries in targets/weights */
+    int32_t poolSize;		/* number of bytes in the key pool */
+} BINARY_HEADER_T;
+
+/* Check whether a file is a binary network file.
+ * Arguments
+ *    filename    -   filename to check, with path
+ * Returns 1 if the file starts with the binary file identifier,
+ * 0 if it does not or cannot be read.
+ */
+int isNetworkBinary(char *filename)
+{
+    char identifier[4];
+    int bBinary = 0;
+    FILE *pFp = fopen(filename, "rb");
+    if (pFp != NULL)
+    {
+	bBinary = ((fread(identifier, 1, 4, pFp) == 4) &&
+		   (memcmp(identifier, "NETB", 4) == 0));
+	fclose(pFp);
+    }
+    return bBinary;
+}
+
+
+/* Save a network as a binary network file.
+ * We freeze the network first, so the CSR arrays are already
+ * built, then write them out one after another.
+ * Arguments
+ *    graph       -   network to save
+ *    filename    -   filename to write, with path
+ *    bVerbose    -   if non-zero, print a message when done
+ * Returns 1 if successful, -1 if any error occurs.
+ */
+int writeNetworkBinary(GRAPH_HANDLE graph, char *filename, int bVerbose)
+{
+    int status = -1;
+    BINARY_HEADER_T header;
+    int32_t *keyOffsets = NULL;
+    int32_t i = 0;
+    FILE *pFp = NULL;
+    NETWORK_SNAPSHOT_T *pSnapshot = freezeNetwork(graph);
+    if (pSnapshot == NULL)
+    {
+	fprintf(stderr, "Error - cannot make snapshot of network\n");
+	return -1;
+    }
+    memset(&header, 0, sizeof(header));
+    memcpy(header.identifier, "NETB", 4);
+    header.version = BINARY_VERSION;
+    header.bDirected = pSnapshot->bDirected;
+    header.vertexCount = pSnapshot->vertexCount;
+    header.edgeCount = pSnapshot->edgeCount;
+    keyOffsets = calloc(pSnapshot->vertexCount + 1, sizeof(int32_t));
+    if (keyOffsets != NULL)
+    {
+	/* the keys are packed one after another in the pool */
+	for (i = 0; i < pSnapshot->vertexCount; i++)
+	{
+	    keyOffsets[i] = header.poolSize;
+	    header.poolSize += strlen(pSnapshot->keys[i]) + 1;
+	}
+	pFp = fopen(filename, "wb");
+    }
+    if (pFp == NULL)
+    {
+	fprintf(stderr, "Error - cannot open file %s for writing\n",
+		filename);
+    }
+    else
+    {
+	int bOk = (fwrite(&header, sizeof(header), 1, pFp) == 1);
+	size_t vCount = pSnapshot->vertexCount;
+	size_t eCount = pSnapshot->edgeCount;
+	bOk = bOk && (fwrite(pSnapshot->offsets, sizeof(int32_t), vCount + 1,
+			     pFp) == vCount + 1);
+	bOk = bOk && (fwrite(pSnapshot->targets, sizeof(int32_t), eCount,
+			     pFp) == eCount);
+	bOk = bOk && (fwrite(pSnapshot->weights, sizeof(int32_t), eCount,
+			     pFp) == eCount);
+	bOk = bOk && (fwrite(keyOffsets, sizeof(int32_t), vCount, pFp) ==
+		      vCount);
+	bOk = bOk && (fwrite(pSnapshot->sortedOrder, sizeof(int32_t), vCount,
+			     pFp) == vCount);
+	for (i = 0; (bOk) && (i < pSnapshot->vertexCount); i++)
+	{
+	    size_t length = strlen(pSnapshot->keys[i]) + 1;
+	    bOk = (fwrite(pSnapshot->keys[i], 1, length, pFp) == length);
+	}
+	if (fclose(pFp) != 0)
+	    bOk = 0;
+	if (bOk)
+	{
+	    status = 1;
+	    if (bVerbose)
+		fprintf(stdout,
+			"Wrote network with %d vertices and %d edges to %s\n",
+			header.vertexCount, header.edgeCount, filename);
+	}
+	else
+	{
+	    fprintf(stderr, "Error - cannot write file %s\n", filename);
+	}
+    }
+    free(keyOffsets);
+    freeSnapshot(pSnapshot);
+    return status;
+}
+
+
+/* Check that the arrays of a loaded binary file make sense, so that
+ * a damaged file cannot make the traversal functions read outside
+ * the arrays.
+ * Arguments
+ *    pSnapshot   -   snapshot whose arrays point into the file
+ *    keyOffsets  -   positions of the keys in the pool
+ *    poolSize    -   number of bytes in the pool
+ * Returns 1 if everything is consistent, 0 if not.
+ */
+static int checkBinaryArrays(NETWORK_SNAPSHOT_T * pSnapshot,
+			     int32_t * keyOffsets, int32_t poolSize)
+{
+    int32_t i = 0;
+    if ((pSnapshot->offsets[0] != 0) ||
+	(pSnapshot->offsets[pSnapshot->vertexCount] !=
+	 pSnapshot->edgeCount))
+	return 0;
+    for (i = 0; i < pSnapshot->vertexCount; i++)
+    {
+	if ((pSnapshot->offsets[i] > pSnapshot->offsets[i + 1]) ||
+	    (keyOffsets[i] < 0) || (keyOffsets[i] >= poolSize) ||
+	    (pSnapshot->sortedOrder[i] < 0) ||
+	    (pSnapshot->sortedOrder[i] >= pSnapshot->vertexCount))
+	    return 0;
+    }
+    for (i = 0; i < pSnapshot->edgeCount; i++)
+    {
+	if ((pSnapshot->targets[i] < 0) ||
+	    (pSnapshot->targets[i] >= pSnapshot->vertexCount))
+	    return 0;
+    }
+    /* the last key must be terminated inside the pool */
+    return ((poolSize == 0) || (pSnapshot->keyPool[poolSize - 1] == '\0'));
+}
+
+
+/* Load a binary network file as a read-only snapshot.
+ * Arguments
+ *    filename    -   filename to read, with path
+ * Returns the snapshot, or NULL if the file cannot be read, has an
+ * unsupported version, or is not valid.
+ */
+NETWORK_SNAPSHOT_T *readNetworkBinary(char *filename)
+{
+    NETWORK_SNAPSHOT_T *pSnapshot = NULL;
+    BINARY_HEADER_T *pHeader = NULL;
+    int32_t *keyOffsets = NULL;
+    int32_t *pNext = NULL;
+    int32_t i = 0;
+    size_t size = 0;
+    size_t expected = 0;
+    int bMapped = 0;
+    char *contents = loadFileContents(filename, &size, &bMapped);
+    if (contents == NULL)
+    {
+	fprintf(stderr, "Error - cannot open file %s\n", filename);
+	return NULL;
+    }
+    pHeader = (BINARY_HEADER_T *) contents;
+    if ((size < sizeof(BINARY_HEADER_T)) ||
+	(memcmp(pHeader->identifier, "NETB", 4) != 0))
+    {
+	fprintf(stderr, "Error - file %s is not a binary network file\n",
+		filename);
+    }
+    else if (pHeader->version != BINARY_VERSION)
+    {
+	fprintf(stderr, "Error - file %s has unsupported version %d\n",
+		filename, pHeader->version);
+    }
+    else
+    {
+	if ((pHeader->vertexCount >= 0) && (pHeader->edgeCount >= 0) &&
+	    (pHeader->poolSize >= 0))
+	{
+	    expected = sizeof(BINARY_HEADER_T) + sizeof(int32_t) *
+		(3 * (size_t) pHeader->vertexCount + 1 +
+		 2 * (size_t) pHeader->edgeCount) + pHeader->poolSize;
+	}
+	if ((expected == 0) || (expected != size))
+	    fprintf(stderr, "Error - file %s has bad format\n", filename);
+	else
+	    pSnapshot = calloc(1, sizeof(NETWORK_SNAPSHOT_T));
+    }
+    if (pSnapshot != NULL)
+    {
+	/* point the arrays at the right places in the file */
+	pSnapshot->vertexCount = pHeader->vertexCount;
+	pSnapshot->edgeCount = pHeader->edgeCount;
+	pSnapshot->bDirected = pHeader->bDirected;
+	pSnapshot->fileContents = contents;
+	pSnapshot->fileSize = size;
+	pSnapshot->bMapped = bMapped;
+	pNext = (int32_t *) (contents + sizeof(BINARY_HEADER_T));
+	pSnapshot->offsets = pNext;
+	pNext += pHeader->vertexCount + 1;
+	pSnapshot->targets = pNext;
+	pNext += pHeader->edgeCount;
+	pSnapshot->weights = pNext;
+	pNext += pHeader->edgeCount;
+	keyOffsets = pNext;
+	pNext += pHeader->vertexCount;
+	pSnapshot->sortedOrder = pNext;
+	pNext += pHeader->vertexCount;
+	pSnapshot->keyPool = (char *) pNext;
+	/* the only allocations are the per-vertex pointer arrays */
+	pSnapshot->keys = calloc(pSnapshot->vertexCount + 1, sizeof(char *));
+	pSnapshot->data = calloc(pSnapshot->vertexCount + 1, sizeof(void *));
+	if ((pSnapshot->keys == NULL) || (pSnapshot->data == NULL))
+	{
+	    fprintf(stderr, "Error - memory allocation error reading %s\n",
+		    filename);
+	    freeSnapshot(pSnapshot);
+	    pSnapshot = NULL;
+	}
+	else if (!checkBinaryArrays(pSnapshot, keyOffsets,
+				    pHeader->poolSize))
+	{
+	    fprintf(stderr, "Error - file %s has bad format\n", filename);
+	    freeSnapshot(pSnapshot);
+	    pSnapshot = NULL;
+	}
+	else
+	{
+	    for (i = 0; i < pSnapshot->vertexCount; i++)
+	    {
+		pSnapshot->keys[i] = pSnapshot->keyPool + keyOffsets[i];
+		pSnapshot->data[i] = pSnapshot->keys[i];
+	    }
+	}
+    }
+    else
+    {
+	releaseFileContents(contents, size, bMapped);
+    }
+    return pSnapshot;
+}
+
+
+/* Free a network that buildNetworkFromSnapshot could not finish,
+ * including the data strings of the vertices it added.
+ * Arguments
+ *    graph       -   network to free
+ *    pSnapshot   -   snapshot it was being built from
+ *    addedCount  -   number of vertices added so far
+ */
+static void discardNetwork(GRAPH_HANDLE graph,
+			   NETWORK_SNAPSHOT_T * pSnapshot, int32_t addedCount)
+{
+    int32_t v = 0;
+    for (v = 0; v < addedCount; v++)
+	free(findVertex(graph, pSnapshot->keys[v]));
+    graphDestroy(graph);
+}
+
+
+/* Build a new network from a snapshot.
+ * Arguments
+ *    pSnapshot   -   snapshot to copy
+ *    bVerbose    -   if non-zero, print messages as processing goes on
+ *    pGraph      -   used to return the new network, or NULL
+ *                    if any error occurs
+ * Returns 1 if successful, -1 if any error occurs.
+ */
+int buildNetworkFromSnapshot(NETWORK_SNAPSHOT_T * pSnapshot, int bVerbose,
+			     GRAPH_HANDLE * pGraph)
+{
+    int32_t v = 0;
+    int32_t e = 0;
+    int edgesAdded = 0;
+    GRAPH_HANDLE graph = newGraph(pSnapshot->vertexCount,
+				  pSnapshot->bDirected);
+    *pGraph = NULL;
+    if (graph == NULL)
+    {
+	fprintf(stderr, "Error - cannot initialize network\n");
+	return -1;
+    }
+    if (bVerbose)
+	fprintf(stdout,
+		"Successfully initialized %s network with %d vertices\n",
+		(pSnapshot->bDirected ? "DIRECTED" : "UNDIRECTED"),
+		pSnapshot->vertexCount);
+    for (v = 0; v < pSnapshot->vertexCount; v++)
+    {
+	char *newString = strdup(pSnapshot->keys[v]);
+	if ((newString == NULL) ||
+	    (addVertex(graph, pSnapshot->keys[v], newString) != 1))
+	{
+	    fprintf(stderr, "Error: Cannot add vertex |%s|\n",
+		    pSnapshot->keys[v]);
+	    free(newString);
+	    discardNetwork(graph, pSnapshot, v);
+	    return -1;
+	}
+    }
+    for (v = 0; v < pSnapshot->vertexCount; v++)
+    {
+	for (e = pSnapshot->offsets[v]; e < pSnapshot->offsets[v + 1]; e++)
+	{
+	    int32_t to = pSnapshot->targets[e];
+	    /* an undirected edge appears in both vertices' lists,
+	     * but addEdge adds both directions at once */
+	    if ((!pSnapshot->bDirected) && (to < v))
+		continue;
+	    if (addEdge(graph, pSnapshot->keys[v], pSnapshot->keys[to],
+			pSnapshot->weights[e]) != 1)
+	    {
+		fprintf(stderr, "Error: Cannot add edge from |%s| to |%s|\n",
+			pSnapshot->keys[v], pSnapshot->keys[to]);
+		discardNetwork(graph, pSnapshot, pSnapshot->vertexCount);
+		return -1;
+	    }
+	    edgesAdded++;
+	}
+    }
+    if (bVerbose)
+	fprintf(stdout, "Added %d vertices and %d edges\n",
+		pSnapshot->vertexCount, edgesAdded);
+    *pGraph = graph;
+    return 1;
+}
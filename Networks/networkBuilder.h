@@ -13,6 +13,10 @@
  */
 #ifndef NETWORKBUILDER_H
 #define NETWORKBUILDER_H
+
+#include "abstractNetwork.h"
+#include "networkSnapshot.h"
+
 /*********************************************************************
  The network definition file is a text file. Its format is as follows.
 
@@ -45,14 +49,95 @@
  */
 
 /* Opens and reads a network definition file that is supposed to follow
- * the structure explained above. If 'bVerbose' is true, displays messages
- * as it processes the file, explaining what it is doing.
+ * the structure explained above, and builds a new network from it.
+ * If 'bVerbose' is true, displays messages as it processes the file,
+ * explaining what it is doing.
  * Arguments
  *    filename    -   filename to read, with path
  *    bVerbose    -   if non-zero, print messages as processing goes on
  *                    if zero, prints only error messages
+ *    pGraph      -   used to return the new network, or NULL if it
+ *                    could not be created. Free it with graphDestroy().
  * Returns 1 if successful, -1 if any error occurs.
  */  
-int readNetworkDefinition(char* filename, int bVerbose);
+int readNetworkDefinition(char* filename, int bVerbose, GRAPH_HANDLE* pGraph);
+
+/* Reads a network definition file with the same format, and the
+ * same results, as readNetworkDefinition. This version is intended
+ * for very large files. It memory maps the whole file and splits
+ * the lines into words itself instead of using fgets and sscanf,
+ * and it does not limit the length of a line. Error messages for
+ * bad lines include the line number.
+ * Arguments
+ *    filename    -   filename to read, with path
+ *    bVerbose    -   if non-zero, print messages as processing goes on
+ *                    if zero, prints only error messages
+ *    pGraph      -   used to return the new network, as for
+ *                    readNetworkDefinition
+ * Returns 1 if successful, -1 if any error occurs.
+ */
+int readNetworkDefinitionFast(char* filename, int bVerbose,
+                              GRAPH_HANDLE* pGraph);
+
+/*********************************************************************
+ A network can also be saved in a binary file, which can be loaded much
+ faster than the text format because nothing needs to be parsed. The
+ file holds a frozen snapshot of the network (see networkSnapshot.h).
+ All values are 32 bit integers, in the byte order of the computer that
+ wrote the file.
+
+  Header              "NETB" version bDirected vertexCount edgeCount poolSize
+  offsets             vertexCount+1 values
+  targets             edgeCount values
+  weights             edgeCount values
+  keyOffsets          vertexCount values - position of each key in the pool
+  sortedOrder         vertexCount values - vertex indices in key order
+  key pool            poolSize bytes - all the keys, each ending with '\0'
+
+  Each key is stored once in the pool, and the edges refer to vertices
+  only by index.
+ **************************************************************************
+ */
+
+/* Check whether a file is a binary network file.
+ * Arguments
+ *    filename    -   filename to check, with path
+ * Returns 1 if the file starts with the binary file identifier,
+ * 0 if it does not or cannot be read.
+ */
+int isNetworkBinary(char* filename);
+
+/* Save a network as a binary network file.
+ * Arguments
+ *    graph       -   network to save
+ *    filename    -   filename to write, with path
+ *    bVerbose    -   if non-zero, print a message when done
+ * Returns 1 if successful, -1 if any error occurs.
+ */
+int writeNetworkBinary(GRAPH_HANDLE graph, char* filename, int bVerbose);
+
+/* Load a binary network file as a read-only snapshot. The file is
+ * memory mapped and the snapshot's arrays point directly into it, so
+ * nothing is allocated for the edges. The vertex data for each vertex
+ * is its key. Call freeSnapshot() when the snapshot is no longer needed.
+ * Arguments
+ *    filename    -   filename to read, with path
+ * Returns the snapshot, or NULL if the file cannot be read, has an
+ * unsupported version, or is not valid.
+ */
+NETWORK_SNAPSHOT_T* readNetworkBinary(char* filename);
+
+/* Build a new network from a snapshot, for example one returned
+ * by readNetworkBinary(). As in readNetworkDefinition(), the data
+ * for each vertex is a copy of its key.
+ * Arguments
+ *    pSnapshot   -   snapshot to copy
+ *    bVerbose    -   if non-zero, print messages as processing goes on
+ *    pGraph      -   used to return the new network, as for
+ *                    readNetworkDefinition
+ * Returns 1 if successful, -1 if any error occurs.
+ */
+int buildNetworkFromSnapshot(NETWORK_SNAPSHOT_T* pSnapshot, int bVerbose,
+                             GRAPH_HANDLE* pGraph);
 
 #endif
@@ -0,0 +1,39 @@
+/*
+ *  networkConverter.c
+ *
+ *  Converts a text network definition file (see networkBuilder.h)
+ *  into the binary network file format, which loads much faster.
+ *
+ *  Usage:  networkConverter textfile binaryfile
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abstractNetwork.h"
+#include "networkBuilder.h"
+
+/* Read the text file, then save the network in binary form */
+int main(int argc, char *argv[])
+{
+    int retval = 0;
+    GRAPH_HANDLE graph = NULL;
+    if (argc < 3)
+    {
+	fprintf(stderr, "Usage: %s textfile binaryfile\n", argv[0]);
+	exit(1);
+    }
+    retval = readNetworkDefinitionFast(argv[1], 0, &graph);
+    if (retval == 1)
+    {
+	retval = writeNetworkBinary(graph, argv[2], 1);
+    }
+    graphDestroy(graph);
+    return (retval == 1) ? 0 : 1;
+}
@@ -0,0 +1,381 @@
+/*
+ *  networkPublisher.c
+ *
+ *  Publishes snapshots of a changing network to reader threads,
+ *  freeing old snapshots with epoch-based reclamation. See
+ *  networkPublisher.h for how the epochs work.
+ *
+ *  All the atomic operations use the default, sequentially
+ *  consistent ordering. This matters in pinSnapshot(): the store
+ *  to the reader's slot must be seen by the writer before the reader
+ *  loads the current snapshot pointer, or the writer could free a
+ *  snapshot that the reader is just about to use.
+ *
+ *  Note this module needs to be linked with networkSnapshot.c and
+ *  with the network module, which provides freezeNetwork().
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include "networkPublisher.h"
+
+#define CACHE_LINE 64		/* bytes in a cache line */
+
+/* One reader's slot. Padded so that each slot fills a cache line */
+typedef struct
+{
+    atomic_ulong epoch;		/* epoch when the reader pinned its
+				 * snapshot, 0 if nothing is pinned */
+    atomic_int bInUse;		/* 1 if registered to a reader */
+    char padding[CACHE_LINE - sizeof(atomic_ulong) - sizeof(atomic_int)];
+} READER_SLOT_T;
+
+/* Vertex data waiting to be freed */
+typedef struct _retiredData
+{
+    void *pData;		/* data to free */
+    struct _retiredData *next;	/* next item in the list */
+} RETIRED_DATA_T;
+
+/* A snapshot that has been replaced but may still be in use */
+typedef struct _retired
+{
+    NETWORK_SNAPSHOT_T *pSnapshot;	/* the old snapshot */
+    unsigned long epoch;	/* epoch during which it was replaced */
+    RETIRED_DATA_T *dataList;	/* data to free along with it */
+    struct _retired *next;	/* next (newer) retired snapshot */
+} RETIRED_T;
+
+typedef struct
+{
+    GRAPH_HANDLE graph;		/* network being published */
+    _Atomic(NETWORK_SNAPSHOT_T *) current;	/* what readers get */
+    atomic_ulong epoch;		/* global epoch, starts at 1 */
+    void *slotMemory;		/* memory holding the slots */
+    READER_SLOT_T *slots;	/* reader slots, aligned to a cache line */
+    int maxReaders;		/* number of slots */
+    RETIRED_DATA_T *currentData;	/* data retired since the current
+					 * snapshot was published */
+    RETIRED_T *retiredHead;	/* oldest retired snapshot */
+    RETIRED_T *retiredTail;	/* newest retired snapshot */
+    long published;		/* counters, see PUBLISHER_STATS_T */
+    long reclaimed;
+    int pending;
+} PUBLISHER_T;
+
+
+/* Free a list of retired vertex data.
+ * Arguments
+ *    pItem      -  First item in the list (may be NULL)
+ */
+static void freeDataList(RETIRED_DATA_T * pItem)
+{
+    while (pItem != NULL)
+    {
+	RETIRED_DATA_T *pNext = pItem->next;
+	free(pItem->pData);
+	free(pItem);
+	pItem = pNext;
+    }
+}
+
+
+/* Find the oldest epoch in which some reader pinned a snapshot.
+ * Arguments
+ *    pPublisher -  Publisher whose slots we check
+ * Returns the smallest epoch in any slot, or ULONG_MAX if no
+ * reader has a snapshot pinned.
+ */
+static unsigned long oldestPinnedEpoch(PUBLISHER_T * pPublisher)
+{
+    unsigned long oldest = ULONG_MAX;
+    int i = 0;
+    for (i = 0; i < pPublisher->maxReaders; i++)
+    {
+	unsigned long epoch = atomic_load(&pPublisher->slots[i].epoch);
+	if ((epoch != 0) && (epoch < oldest))
+	    oldest = epoch;
+    }
+    return oldest;
+}
+
+
+/* Check that a reader number is valid.
+ * Arguments
+ *    pPublisher -  Publisher the number should belong to
+ *    readerId   -  Number to check
+ * Returns 1 if it is a registered reader number, else 0.
+ */
+static int validReader(PUBLISHER_T * pPublisher, int readerId)
+{
+    return ((readerId >= 0) && (readerId < pPublisher->maxReaders) &&
+	    (atomic_load(&pPublisher->slots[readerId].bInUse)));
+}
+
+
+/********************************/
+/** Public functions start here */
+/********************************/
+
+/* Create a publisher for a network and publish its first snapshot.
+ * Arguments
+ *    graph       -  Network returned by newGraph
+ *    maxReaders  -  Largest number of reader threads that will be
+ *                   registered at the same time
+ * Returns the new publisher, or NULL if maxReaders is not positive
+ * or a memory allocation error occurs.
+ */
+PUBLISHER_HANDLE newPublisher(GRAPH_HANDLE graph, int maxReaders)
+{
+    PUBLISHER_T *pPublisher = NULL;
+    NETWORK_SNAPSHOT_T *pSnapshot = NULL;
+    int i = 0;
+    if (maxReaders <= 0)
+	return NULL;
+    pPublisher = calloc(1, sizeof(PUBLISHER_T));
+    if (pPublisher == NULL)
+	return NULL;
+    /* one extra slot's worth of memory so we can align the slots */
+    pPublisher->slotMemory = calloc(maxReaders + 1, sizeof(READER_SLOT_T));
+    pSnapshot = freezeNetwork(graph);
+    if ((pPublisher->slotMemory == NULL) || (pSnapshot == NULL))
+    {
+	if (pSnapshot != NULL)
+	    freeSnapshot(pSnapshot);
+	free(pPublisher->slotMemory);
+	free(pPublisher);
+	return NULL;
+    }
+    pPublisher->slots = (READER_SLOT_T *)
+	(((uintptr_t) pPublisher->slotMemory + CACHE_LINE - 1) &
+	 ~((uintptr_t) CACHE_LINE - 1));
+    for (i = 0; i < maxReaders; i++)
+    {
+	atomic_init(&pPublisher->slots[i].epoch, 0);
+	atomic_init(&pPublisher->slots[i].bInUse, 0);
+    }
+    pPublisher->graph = graph;
+    pPublisher->maxReaders = maxReaders;
+    atomic_init(&pPublisher->epoch, 1);
+    atomic_init(&pPublisher->current, pSnapshot);
+    pPublisher->published = 1;
+    return (PUBLISHER_HANDLE) pPublisher;
+}
+
+
+/* Free the publisher and all its snapshots, and any data passed to
+ * publisherRetireData(). Does not free the network.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher. Not valid
+ *                   after this call.
+ */
+void publisherDestroy(PUBLISHER_HANDLE publisher)
+{
+    PUBLISHER_T *pPublisher = (PUBLISHER_T *) publisher;
+    RETIRED_T *pRetired = NULL;
+    if (pPublisher == NULL)
+	return;
+    pRetired = pPublisher->retiredHead;
+    while (pRetired != NULL)
+    {
+	RETIRED_T *pNext = pRetired->next;
+	freeSnapshot(pRetired->pSnapshot);
+	freeDataList(pRetired->dataList);
+	free(pRetired);
+	pRetired = pNext;
+    }
+    freeSnapshot(atomic_load(&pPublisher->current));
+    freeDataList(pPublisher->currentData);
+    free(pPublisher->slotMemory);
+    free(pPublisher);
+}
+
+
+/* Freeze the network as it is now and make that the current
+ * snapshot, retiring the one it replaces.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ * Returns 1 if successful, 0 if a memory allocation error occurs.
+ */
+int publishNetwork(PUBLISHER_HANDLE publisher)
+{
+    PUBLISHER_T *pPublisher = (PUBLISHER_T *) publisher;
+    NETWORK_SNAPSHOT_T *pSnapshot = freezeNetwork(pPublisher->graph);
+    RETIRED_T *pRetired = calloc(1, sizeof(RETIRED_T));
+    if ((pSnapshot == NULL) || (pRetired == NULL))
+    {
+	if (pSnapshot != NULL)
+	    freeSnapshot(pSnapshot);
+	free(pRetired);
+	return 0;
+    }
+    pRetired->pSnapshot = atomic_exchange(&pPublisher->current, pSnapshot);
+    /* A reader that sees the new epoch value pinned after the
+     * exchange, so it can only have the new snapshot */
+    pRetired->epoch = atomic_fetch_add(&pPublisher->epoch, 1);
+    pRetired->dataList = pPublisher->currentData;
+    pPublisher->currentData = NULL;
+    if (pPublisher->retiredTail == NULL)
+	pPublisher->retiredHead = pRetired;
+    else
+	pPublisher->retiredTail->next = pRetired;
+    pPublisher->retiredTail = pRetired;
+    pPublisher->published++;
+    pPublisher->pending++;
+    publisherReclaim(publisher);
+    return 1;
+}
+
+
+/* Hand over vertex data to be freed once no snapshot that might
+ * point to it is still in use.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ *    pData       -  Data to free later. NULL is ignored.
+ * Returns 1 if successful, 0 if a memory allocation error occurs.
+ */
+int publisherRetireData(PUBLISHER_HANDLE publisher, void *pData)
+{
+    PUBLISHER_T *pPublisher = (PUBLISHER_T *) publisher;
+    RETIRED_DATA_T *pItem = NULL;
+    if (pData == NULL)
+	return 1;
+    pItem = calloc(1, sizeof(RETIRED_DATA_T));
+    if (pItem == NULL)
+	return 0;
+    /* The current snapshot is the newest one that can point to the
+     * data, and snapshots are freed oldest first, so the data can go
+     * when the current snapshot does. */
+    pItem->pData = pData;
+    pItem->next = pPublisher->currentData;
+    pPublisher->currentData = pItem;
+    return 1;
+}
+
+
+/* Free any old snapshots that readers have finished with.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ * Returns the number of old snapshots still waiting for readers.
+ */
+int publisherReclaim(PUBLISHER_HANDLE publisher)
+{
+    PUBLISHER_T *pPublisher = (PUBLISHER_T *) publisher;
+    unsigned long oldest = 0;
+    if (pPublisher->retiredHead == NULL)
+	return 0;
+    oldest = oldestPinnedEpoch(pPublisher);
+    /* the list is in epoch order, so stop at the first one in use */
+    while ((pPublisher->retiredHead != NULL) &&
+	   (pPublisher->retiredHead->epoch < oldest))
+    {
+	RETIRED_T *pRetired = pPublisher->retiredHead;
+	pPublisher->retiredHead = pRetired->next;
+	freeSnapshot(pRetired->pSnapshot);
+	freeDataList(pRetired->dataList);
+	free(pRetired);
+	pPublisher->reclaimed++;
+	pPublisher->pending--;
+    }
+    if (pPublisher->retiredHead == NULL)
+	pPublisher->retiredTail = NULL;
+    return pPublisher->pending;
+}
+
+
+/* Get a reader number for the calling thread.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ * Returns a reader number, or -1 if all the slots are taken.
+ */
+int registerReader(PUBLISHER_HANDLE publisher)
+{
+    PUBLISHER_T *pPublisher = (PUBLISHER_T *) publisher;
+    int i = 0;
+    for (i = 0; i < pPublisher->maxReaders; i++)
+    {
+	int expected = 0;
+	if (atomic_compare_exchange_strong(&pPublisher->slots[i].bInUse,
+					   &expected, 1))
+	    return i;
+    }
+    return -1;
+}
+
+
+/* Give back a reader number.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ *    readerId    -  Number returned by registerReader
+ */
+void unregisterReader(PUBLISHER_HANDLE publisher, int readerId)
+{
+    PUBLISHER_T *pPublisher = (PUBLISHER_T *) publisher;
+    if (validReader(pPublisher, readerId))
+    {
+	atomic_store(&pPublisher->slots[readerId].epoch, 0);
+	atomic_store(&pPublisher->slots[readerId].bInUse, 0);
+    }
+}
+
+
+/* Get the current snapshot and keep it from being freed until
+ * unpinSnapshot() is called.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ *    readerId    -  Number returned by registerReader
+ * Returns the current snapshot, or NULL if readerId is invalid.
+ */
+NETWORK_SNAPSHOT_T *pinSnapshot(PUBLISHER_HANDLE publisher, int readerId)
+{
+    PUBLISHER_T *pPublisher = (PUBLISHER_T *) publisher;
+    if (!validReader(pPublisher, readerId))
+	return NULL;
+    atomic_store(&pPublisher->slots[readerId].epoch,
+		 atomic_load(&pPublisher->epoch));
+    return atomic_load(&pPublisher->current);
+}
+
+
+/* Say that the reader is done with the snapshot it pinned.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ *    readerId    -  Number returned by registerReader
+ */
+void unpinSnapshot(PUBLISHER_HANDLE publisher, int readerId)
+{
+    PUBLISHER_T *pPublisher = (PUBLISHER_T *) publisher;
+    if (validReader(pPublisher, readerId))
+	atomic_store(&pPublisher->slots[readerId].epoch, 0);
+}
+
+
+/* Get the publisher's counters.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ *    pStats      -  Structure to fill in
+ */
+void getPublisherStats(PUBLISHER_HANDLE publisher,
+		       PUBLISHER_STATS_T * pStats)
+{
+    PUBLISHER_T *pPublisher = (PUBLISHER_T *) publisher;
+    int i = 0;
+    pStats->published = pPublisher->published;
+    pStats->reclaimed = pPublisher->reclaimed;
+    pStats->pending = pPublisher->pending;
+    pStats->readers = 0;
+    for (i = 0; i < pPublisher->maxReaders; i++)
+    {
+	if (atomic_load(&pPublisher->slots[i].bInUse))
+	    pStats->readers++;
+    }
+}
@@ -0,0 +1,170 @@
+/**
+ *  networkPublisher.h
+ *
+ *  Declarations for sharing a changing network between one writer
+ *  thread and many reader threads, without making the readers wait.
+ *
+ *  Readers never look at the network itself. Instead, the writer
+ *  makes its changes with the usual functions in abstractNetwork.h
+ *  and then calls publishNetwork(), which freezes the network into a
+ *  new snapshot (see networkSnapshot.h) and makes it the current one
+ *  with a single atomic store. Snapshots never change, so readers can
+ *  search them without any locking.
+ *
+ *  The hard part is knowing when an old snapshot can be freed, since
+ *  a reader may still be using it. This is done with epochs, in the
+ *  style of read-copy-update (RCU):
+ *
+ *    - The publisher keeps a global epoch counter, which goes up by
+ *      one each time a snapshot is published.
+ *
+ *    - Before getting the current snapshot, a reader "pins" it by
+ *      recording the global epoch in its own slot. When it is done,
+ *      it clears the slot. Both steps are single atomic stores; a
+ *      reader never waits for anything.
+ *
+ *    - A snapshot replaced during epoch E can only be in use by
+ *      readers whose slots show E or less. Once every slot is clear
+ *      or shows a later epoch, the snapshot is freed.
+ *
+ *  Each reader slot has a cache line to itself, so readers do not
+ *  slow each other down by writing to the same line.
+ *
+ *  Only one thread at a time may change the network and call
+ *  publishNetwork(), publisherRetireData() and publisherReclaim().
+ *  Any number of threads may call pinSnapshot() and unpinSnapshot(),
+ *  each with its own reader number.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+#ifndef NETWORKPUBLISHER_H
+#define NETWORKPUBLISHER_H
+
+#include "abstractNetwork.h"
+#include "networkSnapshot.h"
+
+/* opaque pointer to a publisher */
+typedef void* PUBLISHER_HANDLE;
+
+/* Counters kept by each publisher */
+typedef struct
+{
+    long published;      /* snapshots published, including the first */
+    long reclaimed;      /* old snapshots freed so far */
+    int pending;         /* old snapshots still waiting for readers */
+    int readers;         /* reader numbers currently registered */
+} PUBLISHER_STATS_T;
+
+
+/* Create a publisher for a network and publish its first snapshot.
+ * Arguments
+ *    graph       -  Network returned by newGraph. From now on, only
+ *                   the writer thread should use it.
+ *    maxReaders  -  Largest number of reader threads that will be
+ *                   registered at the same time
+ * Returns the new publisher, or NULL if maxReaders is not positive
+ * or a memory allocation error occurs.
+ */
+PUBLISHER_HANDLE newPublisher(GRAPH_HANDLE graph, int maxReaders);
+
+
+/* Free the publisher and all its snapshots, and any data passed to
+ * publisherRetireData(). Does not free the network. All the reader
+ * threads must have finished before this is called.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher. Not valid
+ *                   after this call.
+ */
+void publisherDestroy(PUBLISHER_HANDLE publisher);
+
+
+/* Freeze the network as it is now and make that the current
+ * snapshot. Readers that pin a snapshot after this returns will see
+ * all the changes made so far. The snapshot it replaces is freed as
+ * soon as no reader can be using it. Writer thread only.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ * Returns 1 if successful, 0 if a memory allocation error occurs
+ * (in which case the old snapshot stays current).
+ */
+int publishNetwork(PUBLISHER_HANDLE publisher);
+
+
+/* Hand over vertex data that the writer no longer needs, for
+ * example the data returned by removeVertex(). Snapshots published
+ * before the vertex was removed still point to the data, so it is
+ * freed (with free()) only when those snapshots have been freed.
+ * Writer thread only.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ *    pData       -  Data to free later. NULL is ignored.
+ * Returns 1 if successful, 0 if a memory allocation error occurs
+ * (in which case the caller still owns the data).
+ */
+int publisherRetireData(PUBLISHER_HANDLE publisher, void* pData);
+
+
+/* Free any old snapshots that readers have finished with.
+ * publishNetwork() does this too, but a writer that publishes
+ * rarely may want to call it from time to time. Writer thread only.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ * Returns the number of old snapshots still waiting for readers.
+ */
+int publisherReclaim(PUBLISHER_HANDLE publisher);
+
+
+/* Get a reader number for the calling thread. Each reader thread
+ * needs its own number, which it passes to pinSnapshot() and
+ * unpinSnapshot().
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ * Returns a reader number, or -1 if maxReaders readers are
+ * already registered.
+ */
+int registerReader(PUBLISHER_HANDLE publisher);
+
+
+/* Give back a reader number when the thread no longer needs it.
+ * The reader must not have a snapshot pinned.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ *    readerId    -  Number returned by registerReader
+ */
+void unregisterReader(PUBLISHER_HANDLE publisher, int readerId);
+
+
+/* Get the current snapshot and keep it from being freed until
+ * unpinSnapshot() is called. Never waits. A reader may only have
+ * one snapshot pinned at a time, and should not keep it pinned
+ * for long, since old snapshots cannot be freed meanwhile.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ *    readerId    -  Number returned by registerReader
+ * Returns the current snapshot, or NULL if readerId is invalid.
+ */
+NETWORK_SNAPSHOT_T* pinSnapshot(PUBLISHER_HANDLE publisher, int readerId);
+
+
+/* Say that the reader is done with the snapshot it pinned.
+ * The snapshot must not be used after this call.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ *    readerId    -  Number returned by registerReader
+ */
+void unpinSnapshot(PUBLISHER_HANDLE publisher, int readerId);
+
+
+/* Get the publisher's counters. Writer thread only.
+ * Arguments
+ *    publisher   -  Handle returned by newPublisher
+ *    pStats      -  Structure to fill in
+ */
+void getPublisherStats(PUBLISHER_HANDLE publisher,
+                       PUBLISHER_STATS_T* pStats);
+
+#endif
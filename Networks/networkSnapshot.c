@@ -0,0 +1,333 @@
+/*
+ *  networkSnapshot.c
+ *
+ *  Operations on a frozen, read-only compressed sparse row (CSR)
+ *  copy of a network. See networkSnapshot.h for a description of
+ *  the arrays. The snapshot itself is created by freezeNetwork(),
+ *  in the network module.
+ *
+ *  Note this module needs to be linked with shortestPath.c,
+ *  minPriorityQueue.c and depthFirst.c
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+#include "networkSnapshot.h"
+#include "shortestPath.h"
+#include "depthFirst.h"
+
+#define WHITE 0
+#define GRAY  1
+#define BLACK 2
+
+
+/* Edge walker for the shortest path engine. The edges for
+ * a vertex are simply a range of the targets and weights arrays.
+ * Arguments
+ *    pGraph     -  the snapshot (will be cast to NETWORK_SNAPSHOT_T *)
+ *    fromIndex  -  index of the vertex whose edges we want
+ *    relax      -  function to call for each edge
+ *    pSearch    -  passed back to relax
+ */
+static void walkSnapshotEdges(void *pGraph, int fromIndex,
+			      RELAX_FUNCTION_T relax, void *pSearch)
+{
+    NETWORK_SNAPSHOT_T *pSnapshot = (NETWORK_SNAPSHOT_T *) pGraph;
+    int32_t e = 0;
+    for (e = pSnapshot->offsets[fromIndex];
+	 e < pSnapshot->offsets[fromIndex + 1]; e++)
+    {
+	(*relax) (pSearch, pSnapshot->targets[e], pSnapshot->weights[e]);
+    }
+}
+
+
+/* Adjacency functions for the depth first search engine. The
+ * cursor holds the offset of the current edge in the targets array.
+ * Arguments
+ *    pGraph     -  the snapshot (will be cast to NETWORK_SNAPSHOT_T *)
+ *    vertex     -  index of the vertex whose edges we want
+ *    pCursor    -  where we are in the vertex's edges
+ * Return the index of the adjacent vertex, or -1 if there are no more.
+ */
+static int firstSnapshotAdjacent(void *pGraph, int vertex,
+				 DFS_CURSOR_T * pCursor)
+{
+    NETWORK_SNAPSHOT_T *pSnapshot = (NETWORK_SNAPSHOT_T *) pGraph;
+    pCursor->position = pSnapshot->offsets[vertex];
+    if (pCursor->position >= pSnapshot->offsets[vertex + 1])
+	return -1;
+    return pSnapshot->targets[pCursor->position];
+}
+
+static int nextSnapshotAdjacent(void *pGraph, int vertex,
+				DFS_CURSOR_T * pCursor)
+{
+    NETWORK_SNAPSHOT_T *pSnapshot = (NETWORK_SNAPSHOT_T *) pGraph;
+    pCursor->position++;
+    if (pCursor->position >= pSnapshot->offsets[vertex + 1])
+	return -1;
+    return pSnapshot->targets[pCursor->position];
+}
+
+
+/* Item used to sort the keys when building the lookup array */
+typedef struct
+{
+    char *key;			/* key of the vertex */
+    int32_t index;		/* index of the vertex */
+} KEY_ENTRY_T;
+
+/* Comparison function for qsort, to put key entries in key order.
+ * Arguments
+ *    pE1      First entry (will be cast to KEY_ENTRY_T *)
+ *    pE2      Second entry (will be cast to KEY_ENTRY_T *)
+ * Returns the result of strcmp on the keys.
+ */
+static int compareKeyEntries(const void *pE1, const void *pE2)
+{
+    return strcmp(((KEY_ENTRY_T *) pE1)->key, ((KEY_ENTRY_T *) pE2)->key);
+}
+
+
+/********************************/
+/** Public functions start here */
+/********************************/
+
+/* Fill in the sortedOrder array so that snapshotFindVertex()
+ * can be used. Called by functions that build snapshots, after
+ * the keys have been stored.
+ * Arguments
+ *    pSnapshot  -  Snapshot whose keys are already set
+ * Returns 1 if successful, 0 for a memory allocation error.
+ */
+int snapshotBuildLookup(NETWORK_SNAPSHOT_T * pSnapshot)
+{
+    int bOk = 0;
+    int32_t i = 0;
+    KEY_ENTRY_T *entries =
+	calloc(pSnapshot->vertexCount + 1, sizeof(KEY_ENTRY_T));
+    free(pSnapshot->sortedOrder);
+    pSnapshot->sortedOrder =
+	calloc(pSnapshot->vertexCount + 1, sizeof(int32_t));
+    if ((entries != NULL) && (pSnapshot->sortedOrder != NULL))
+    {
+	for (i = 0; i < pSnapshot->vertexCount; i++)
+	{
+	    entries[i].key = pSnapshot->keys[i];
+	    entries[i].index = i;
+	}
+	qsort(entries, pSnapshot->vertexCount, sizeof(KEY_ENTRY_T),
+	      &compareKeyEntries);
+	for (i = 0; i < pSnapshot->vertexCount; i++)
+	    pSnapshot->sortedOrder[i] = entries[i].index;
+	bOk = 1;
+    }
+    free(entries);
+    return bOk;
+}
+
+
+/* Free all memory associated with a snapshot. Does not free
+ * the vertex data, which still belongs to the network.
+ * If the snapshot was loaded from a binary file, most of its
+ * arrays are part of the file contents, so we release those instead.
+ * Arguments
+ *    pSnapshot  -  Snapshot to free. Not valid after this call.
+ */
+void freeSnapshot(NETWORK_SNAPSHOT_T * pSnapshot)
+{
+    if (pSnapshot != NULL)
+    {
+	if (pSnapshot->fileContents == NULL)
+	{
+	    free(pSnapshot->offsets);
+	    free(pSnapshot->targets);
+	    free(pSnapshot->weights);
+	    free(pSnapshot->sortedOrder);
+	    free(pSnapshot->keyPool);
+	}
+#ifndef _WIN32
+	else if (pSnapshot->bMapped)
+	{
+	    munmap(pSnapshot->fileContents, pSnapshot->fileSize);
+	}
+#endif
+	else
+	{
+	    free(pSnapshot->fileContents);
+	}
+	free(pSnapshot->keys);
+	free(pSnapshot->data);
+	free(pSnapshot);
+    }
+}
+
+
+/* Find the index of the vertex with a particular key.
+ * We do a binary search of the sortedOrder array.
+ * Arguments
+ *    pSnapshot  -  Snapshot to search
+ *    key        -  Key we are looking for
+ * Returns the vertex index or -1 if the key is not found.
+ */
+int snapshotFindVertex(NETWORK_SNAPSHOT_T * pSnapshot, char *key)
+{
+    int found = -1;
+    int low = 0;
+    int high = pSnapshot->vertexCount - 1;
+    while ((low <= high) && (found < 0))
+    {
+	int middle = (low + high) / 2;
+	int index = pSnapshot->sortedOrder[middle];
+	int comparison = strcmp(key, pSnapshot->keys[index]);
+	if (comparison == 0)
+	    found = index;
+	else if (comparison < 0)
+	    high = middle - 1;
+	else
+	    low = middle + 1;
+    }
+    return found;
+}
+
+
+/* Visit all the vertices reachable from a vertex by a
+ * breadth-first search, calling a function for each.
+ * Since we know how many vertices there are, the queue is
+ * just an array of indices that we never need to wrap around.
+ * Arguments
+ *    pSnapshot  -  Snapshot to traverse
+ *    startIndex -  Index of the start vertex
+ *    vFunction  -  Function to call with each vertex index
+ * Returns the number of vertices visited, or -1 if the start
+ * index is invalid or a memory allocation error occurs.
+ */
+int snapshotBreadthFirst(NETWORK_SNAPSHOT_T * pSnapshot, int startIndex,
+			 void (*vFunction) (NETWORK_SNAPSHOT_T *, int))
+{
+    int head = 0;
+    int tail = 0;
+    int32_t *queue = NULL;
+    unsigned char *color = NULL;
+    if ((startIndex < 0) || (startIndex >= pSnapshot->vertexCount))
+	return -1;
+    queue = malloc(pSnapshot->vertexCount * sizeof(int32_t));
+    color = calloc(pSnapshot->vertexCount, 1);
+    if ((queue == NULL) || (color == NULL))
+    {
+	free(queue);
+	free(color);
+	return -1;
+    }
+    color[startIndex] = GRAY;
+    queue[tail++] = startIndex;
+    while (head < tail)
+    {
+	int32_t current = queue[head++];
+	int32_t e = 0;
+	(*vFunction) (pSnapshot, current);
+	color[current] = BLACK;
+	for (e = pSnapshot->offsets[current];
+	     e < pSnapshot->offsets[current + 1]; e++)
+	{
+	    int32_t adjacent = pSnapshot->targets[e];
+	    if (color[adjacent] == WHITE)
+	    {
+		color[adjacent] = GRAY;
+		queue[tail++] = adjacent;
+	    }
+	}
+    }
+    free(queue);
+    free(color);
+    return tail;		/* every vertex enqueued was visited */
+}
+
+
+/* Visit all the vertices by depth-first searches, starting a new
+ * search at each vertex not yet visited. As in printDepthFirst(),
+ * the function is called for a vertex after all the vertices below
+ * it have been visited.
+ *
+ * The search itself is done by the engine in depthFirst.c. After each
+ * new root, the vertices it finished are the ones added to the end of
+ * the post-order, so we call the function for those.
+ * Arguments
+ *    pSnapshot  -  Snapshot to traverse
+ *    vFunction  -  Function to call with each vertex index
+ *    startFunction - If not NULL, called with the index of the
+ *                    vertex at the root of each new search
+ * Returns 1 if successful, 0 for a memory allocation error.
+ */
+int snapshotDepthFirst(NETWORK_SNAPSHOT_T * pSnapshot,
+		       void (*vFunction) (NETWORK_SNAPSHOT_T *, int),
+		       void (*startFunction) (NETWORK_SNAPSHOT_T *, int))
+{
+    DFS_GRAPH_T dfsGraph;
+    DFS_HANDLE search = NULL;
+    int *postOrder = NULL;
+    int finished = 0;		/* post-order entries already reported */
+    int count = 0;
+    int32_t root = 0;
+    int bOk = 1;
+    search = newDepthFirst(pSnapshot->vertexCount);
+    if (search == NULL)
+	return 0;
+    dfsGraph.pGraph = pSnapshot;
+    dfsGraph.vertexCount = pSnapshot->vertexCount;
+    dfsGraph.firstAdjacent = &firstSnapshotAdjacent;
+    dfsGraph.nextAdjacent = &nextSnapshotAdjacent;
+    for (root = 0; (root < pSnapshot->vertexCount) && (bOk); root++)
+    {
+	if (depthFirstDiscovery(search, root) >= 0)
+	    continue;
+	if (startFunction != NULL)
+	    (*startFunction) (pSnapshot, root);
+	if (depthFirstVisit(search, &dfsGraph, root) < 0)
+	{
+	    bOk = 0;
+	    break;
+	}
+	postOrder = depthFirstPostOrder(search, &count);
+	for (; finished < count; finished++)
+	    (*vFunction) (pSnapshot, postOrder[finished]);
+    }
+    depthFirstDestroy(search);
+    return bOk;
+}
+
+
+/* Find the lowest weight path between two vertices of a
+ * snapshot using the shortest path engine.
+ * Arguments
+ *    pSnapshot  -  Snapshot to search
+ *    search     -  Working storage from newPathSearch()
+ *    startIndex -  Index of start vertex
+ *    endIndex   -  Index of end vertex
+ * Returns the total weight of the path, -1 if the end vertex
+ * is not reachable, or -2 for an invalid index (including -1,
+ * as returned by snapshotFindVertex for an unknown key) or
+ * memory allocation error.
+ */
+int snapshotShortestPath(NETWORK_SNAPSHOT_T * pSnapshot,
+			 PATH_SEARCH_HANDLE search,
+			 int startIndex, int endIndex)
+{
+    /* the engine reads an end index of -1 as "settle every
+     * vertex", but here it means the end key was not found */
+    if (endIndex < 0)
+	return -2;
+    return pathSearchRun(search, pSnapshot, &walkSnapshotEdges,
+			 pSnapshot->vertexCount, startIndex, endIndex);
+}
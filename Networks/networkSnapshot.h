@@ -0,0 +1,139 @@
+/**
+ *  networkSnapshot.h
+ *
+ *  Declarations for a "frozen" read-only copy of a network, stored
+ *  in compressed sparse row (CSR) form. Instead of separately allocated
+ *  vertex and adjacency list nodes, all the edges are packed into a
+ *  few contiguous arrays:
+ *
+ *     The edges leaving vertex i are stored in positions
+ *     offsets[i] up to (but not including) offsets[i+1] of the
+ *     targets and weights arrays.
+ *
+ *  Vertices are identified by integer indices from 0 to vertexCount-1.
+ *  Traversals and path searches on a snapshot just walk these arrays,
+ *  which is much friendlier to the cache than following pointers.
+ *
+ *  A snapshot does not change when the network it was made from
+ *  changes. To see the changes, free it and freeze the network again.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+#ifndef NETWORKSNAPSHOT_H
+#define NETWORKSNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "shortestPath.h"
+#include "abstractNetwork.h"
+
+typedef struct
+{
+    int32_t vertexCount;   /* number of vertices */
+    int32_t edgeCount;     /* number of entries in targets/weights */
+    int bDirected;         /* copied from the network */
+    int32_t* offsets;      /* vertexCount+1 entries, see above */
+    int32_t* targets;      /* index of the vertex at the end of each edge */
+    int32_t* weights;      /* weight of each edge */
+    char** keys;           /* key for each vertex (points into keyPool) */
+    void** data;           /* ancillary data for each vertex (not copied) */
+    int32_t* sortedOrder;  /* vertex indices sorted by key, for lookup */
+    char* keyPool;         /* storage for all the key strings */
+    char* fileContents;    /* if not NULL, the arrays above (except keys
+                            * and data) point into this copy of a binary
+                            * network file, see readNetworkBinary() */
+    size_t fileSize;       /* number of bytes in fileContents */
+    int bMapped;           /* 1 if fileContents is memory mapped */
+} NETWORK_SNAPSHOT_T;
+
+
+/* Make a snapshot of a network. This function is
+ * implemented by the network module (linkedListNetwork.c)
+ * since it needs to see the network's internal structures.
+ * Argument
+ *    graph      -  Network returned by newGraph
+ * Returns a new snapshot, or NULL if a memory allocation error
+ * occurs. Call freeSnapshot() when it is no longer needed.
+ */
+NETWORK_SNAPSHOT_T* freezeNetwork(GRAPH_HANDLE graph);
+
+
+/* Fill in the sortedOrder array so that snapshotFindVertex()
+ * can be used. Called by functions that build snapshots, after
+ * the keys have been stored.
+ * Arguments
+ *    pSnapshot  -  Snapshot whose keys are already set
+ * Returns 1 if successful, 0 for a memory allocation error.
+ */
+int snapshotBuildLookup(NETWORK_SNAPSHOT_T* pSnapshot);
+
+
+/* Free all memory associated with a snapshot. Does not free
+ * the vertex data, which still belongs to the network.
+ * Arguments
+ *    pSnapshot  -  Snapshot to free. Not valid after this call.
+ */
+void freeSnapshot(NETWORK_SNAPSHOT_T* pSnapshot);
+
+
+/* Find the index of the vertex with a particular key.
+ * Arguments
+ *    pSnapshot  -  Snapshot to search
+ *    key        -  Key we are looking for
+ * Returns the vertex index or -1 if the key is not found.
+ */
+int snapshotFindVertex(NETWORK_SNAPSHOT_T* pSnapshot, char* key);
+
+
+/* Visit all the vertices reachable from a vertex by a
+ * breadth-first search, calling a function for each.
+ * Arguments
+ *    pSnapshot  -  Snapshot to traverse
+ *    startIndex -  Index of the start vertex
+ *    vFunction  -  Function to call with each vertex index
+ * Returns the number of vertices visited, or -1 if the start
+ * index is invalid or a memory allocation error occurs.
+ */
+int snapshotBreadthFirst(NETWORK_SNAPSHOT_T* pSnapshot, int startIndex,
+                         void (*vFunction)(NETWORK_SNAPSHOT_T*, int));
+
+
+/* Visit all the vertices by depth-first searches, starting a new
+ * search at each vertex not yet visited. As in printDepthFirst(),
+ * the function is called for a vertex after all the vertices below
+ * it have been visited. Uses the engine in depthFirst.c, so it
+ * does not recurse.
+ * Arguments
+ *    pSnapshot  -  Snapshot to traverse
+ *    vFunction  -  Function to call with each vertex index
+ *    startFunction - If not NULL, called with the index of the
+ *                    vertex at the root of each new search
+ * Returns 1 if successful, 0 for a memory allocation error.
+ */
+int snapshotDepthFirst(NETWORK_SNAPSHOT_T* pSnapshot,
+                       void (*vFunction)(NETWORK_SNAPSHOT_T*, int),
+                       void (*startFunction)(NETWORK_SNAPSHOT_T*, int));
+
+
+/* Find the lowest weight path between two vertices of a
+ * snapshot using the shortest path engine. Afterwards, use
+ * the pathSearchXXX functions in shortestPath.h to get the path.
+ * Arguments
+ *    pSnapshot  -  Snapshot to search
+ *    search     -  Working storage from newPathSearch()
+ *    startIndex -  Index of start vertex
+ *    endIndex   -  Index of end vertex
+ * Returns the total weight of the path, -1 if the end vertex
+ * is not reachable, or -2 for an invalid index (including -1,
+ * as returned by snapshotFindVertex for an unknown key) or
+ * memory allocation error.
+ */
+int snapshotShortestPath(NETWORK_SNAPSHOT_T* pSnapshot,
+                         PATH_SEARCH_HANDLE search,
+                         int startIndex, int endIndex);
+
+#endif
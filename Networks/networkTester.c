@@ -16,12 +16,88 @@
 #include <string.h>
 #include "abstractNetwork.h"
 #include "networkBuilder.h"
+#include "pathTree.h"
 
 int getMenuOption();
 
+/* Heuristic for A* search. If the data for both vertices
+ * holds two integer coordinates ("x y"), returns the city block
+ * distance between them, otherwise zero. This never overestimates
+ * as long as no edge weight is smaller than the city block
+ * distance between its ends.
+ * Arguments
+ *    pData     -  Data of some vertex (a string)
+ *    pEndData  -  Data of the end vertex (a string)
+ * Returns the estimated path weight.
+ */
+int cityBlockDistance(void *pData, void *pEndData)
+{
+    int x1, y1, x2, y2;
+    if ((sscanf((char *) pData, "%d %d", &x1, &y1) != 2) ||
+	(sscanf((char *) pEndData, "%d %d", &x2, &y2) != 2))
+	return 0;
+    return abs(x1 - x2) + abs(y1 - y2);
+}
+
+/* Print a vertex of a snapshot, in the same format as
+ * printBreadthFirst() and printDepthFirst() use.
+ * Arguments
+ *    pSnapshot  -  Snapshot holding the vertex
+ *    index      -  Index of the vertex in the snapshot
+ */
+void printSnapshotVertex(NETWORK_SNAPSHOT_T *pSnapshot, int index)
+{
+    printf("== Vertex key |%s| - data |%s|\n",
+	   pSnapshot->keys[index], (char *) pSnapshot->data[index]);
+}
+
+/* Print the root of each new depth first search of a snapshot.
+ * Arguments
+ *    pSnapshot  -  Snapshot being traversed
+ *    index      -  Index of the root vertex in the snapshot
+ */
+void printSnapshotRoot(NETWORK_SNAPSHOT_T *pSnapshot, int index)
+{
+    printf("\nStarting new traversal from |%s|\n", pSnapshot->keys[index]);
+}
+
+/* Freeze the network, then print a breadth first traversal from
+ * one vertex and a complete depth first traversal of the frozen
+ * copy. The output should be the same as for option 7 without
+ * the snapshot.
+ * Arguments
+ *    graph      -  Network to freeze
+ *    startKey   -  Key of the vertex to start the breadth first
+ *                  traversal from
+ */
+void printSnapshotTraversals(GRAPH_HANDLE graph, char *startKey)
+{
+    NETWORK_SNAPSHOT_T *pSnapshot = freezeNetwork(graph);
+    int startIndex = -1;
+    if (pSnapshot == NULL)
+    {
+	printf(">> Memory allocation error\n");
+	return;
+    }
+    startIndex = snapshotFindVertex(pSnapshot, startKey);
+    if (startIndex < 0)
+	printf(">>> Vertex |%s| does not exist\n", startKey);
+    else if (snapshotBreadthFirst(pSnapshot, startIndex,
+				  &printSnapshotVertex) < 0)
+	printf(">> Memory allocation error\n");
+    printf("\nDepth first:\n");
+    if (pSnapshot->vertexCount == 0)
+	printf("The graph is empty\n");
+    else if (!snapshotDepthFirst(pSnapshot, &printSnapshotVertex,
+				 &printSnapshotRoot))
+	printf(">> Memory allocation error\n");
+    freeSnapshot(pSnapshot);
+}
+
 /* Loop asking for actions until the user chooses to exit */
 int main(int argc, char *argv[])
 {
+    GRAPH_HANDLE graph = NULL;
     int maxVertices = 0;
     int bDirected = 0;
     char input[64];
@@ -34,26 +110,47 @@ int main(int argc, char *argv[])
     int weight = 0;
     int i = 0;
     int choice = 0;
+    char trackedKey[64] = "";	/* source of the tracked shortest paths */
 
     if (argc > 1)		/* assume that they gave a graph file name */
     {
 	fprintf(stdout, "Found argument %s on command line\n", argv[1]);
 	memset(input, 0, sizeof(input));
-	printf("Build network from this file (Y or N)? ");
+	printf("Build network from this file (Y, N, or F for fast loader)? ");
 	fgets(input, sizeof(input), stdin);
-	if ((input[0] == 'Y') || (input[0] == 'y'))
+	if (((input[0] == 'Y') || (input[0] == 'y')) &&
+	    (isNetworkBinary(argv[1])))
+	{
+	    NETWORK_SNAPSHOT_T *pSnapshot = readNetworkBinary(argv[1]);
+	    if (pSnapshot != NULL)
+	    {
+		retval = buildNetworkFromSnapshot(pSnapshot, 1, &graph);
+		freeSnapshot(pSnapshot);
+	    }
+	}
+	else if ((input[0] == 'Y') || (input[0] == 'y'))
+	{
+	    retval = readNetworkDefinition(argv[1], 1, &graph);
+	}
+	else if ((input[0] == 'F') || (input[0] == 'f'))
 	{
-	    retval = readNetworkDefinition(argv[1], 1);
+	    retval = readNetworkDefinitionFast(argv[1], 1, &graph);
 	}
     }
 
     choice = getMenuOption();
-    while (choice != 9)
+    while (choice != 10)
     {
 	memset(keystring1, 0, sizeof(keystring1));
 	memset(keystring2, 0, sizeof(keystring2));
 	newString = key = NULL;
 	weight = -1;
+	if ((choice > 1) && (graph == NULL))
+	{
+	    printf(">>> Error! Create the graph first (option 1)\n");
+	    choice = getMenuOption();
+	    continue;
+	}
 	switch (choice)
 	{
 	case 1:		/* create the graph */
@@ -72,8 +169,10 @@ int main(int argc, char *argv[])
 		    bDirected = 1;
 		else
 		    bDirected = 0;
-		clearGraph();
-		if (!initGraph(maxVertices, bDirected))
+		graphDestroy(graph);
+		graph = newGraph(maxVertices, bDirected);
+		strcpy(trackedKey, "");
+		if (graph == NULL)
 		{
 		    printf(">>> Error! Cannot initialize graph\n");
 		}
@@ -99,7 +198,7 @@ int main(int argc, char *argv[])
 	    }
 	    else
 	    {
-		retval = addVertex(key, newString);
+		retval = addVertex(graph, key, newString);
 		if (retval == 1)
 		{
 		    printf("Vertex |%s| added\n", key);
@@ -144,7 +243,7 @@ int main(int argc, char *argv[])
 	    //   }
 	    else
 	    {
-		retval = addEdge(keystring1, keystring2, weight);
+		retval = addEdge(graph, keystring1, keystring2, weight);
 		if (retval == 1)
 		{
 		    printf("Added edge from |%s| to |%s| with weight %d\n",
@@ -154,6 +253,13 @@ int main(int argc, char *argv[])
 		{
 		    printf(">>> Edge from |%s| to |%s| already exists!\n",
 			   keystring1, keystring2);
+		    printf("Change its weight to %d (Y or N)? ", weight);
+		    fgets(input, sizeof(input), stdin);
+		    if (((input[0] == 'Y') || (input[0] == 'y')) &&
+			(updateEdgeWeight(graph, keystring1, keystring2,
+					  weight)))
+			printf("Changed weight of edge from |%s| to |%s| "
+			       "to %d\n", keystring1, keystring2, weight);
 		}
 		else
 		{
@@ -168,7 +274,7 @@ int main(int argc, char *argv[])
 	    fgets(input, sizeof(input), stdin);
 	    input[strlen(input) - 1] = '\0';
 	    sscanf(input, "%s", keystring1);
-	    char *returnData = removeVertex(keystring1);
+	    char *returnData = removeVertex(graph, keystring1);
 	    if (returnData != NULL)
 	    {
 		printf
@@ -194,7 +300,7 @@ int main(int argc, char *argv[])
 	    fgets(input, sizeof(input), stdin);
 	    input[strlen(input) - 1] = '\0';
 	    sscanf(input, "%s", keystring2);
-	    retval = removeEdge(keystring1, keystring2);
+	    retval = removeEdge(graph, keystring1, keystring2);
 	    if (retval == 1)
 	    {
 		printf("Removed edge from |%s| to |%s|\n",
@@ -215,7 +321,7 @@ int main(int argc, char *argv[])
 		fgets(input, sizeof(input), stdin);
 		input[strlen(input) - 1] = '\0';
 		sscanf(input, "%s", keystring1);
-		adjacentKeys = getAdjacentVertices(keystring1, &count);
+		adjacentKeys = getAdjacentVertices(graph, keystring1, &count);
 		if (count == 0)
 		{
 		    printf(">>> Vertex |%s| has no adjacent vertices\n",
@@ -233,7 +339,7 @@ int main(int argc, char *argv[])
 		    for (i = 0; i < count; i++)
 		    {
 			printf("     %s ", adjacentKeys[i]);
-			weight = findEdge(keystring1, adjacentKeys[i]);
+			weight = findEdge(graph, keystring1, adjacentKeys[i]);
 			printf(" (weight %d)\n", weight);
 			free(adjacentKeys[i]);
 		    }
@@ -243,15 +349,23 @@ int main(int argc, char *argv[])
 	    }
 	case 7:		/* breadth first traversal */
 	    memset(input, 0, sizeof(input));
-	    printf("Want breadth first (Y or N, N=depth first)? ");
+	    printf("Want breadth first (Y or N, N=depth first, S=both on a frozen snapshot)? ");
 	    fgets(input, sizeof(input), stdin);
-	    if ((input[0] == 'Y') || (input[0] == 'y'))
+	    if ((input[0] == 'S') || (input[0] == 's'))
+	    {
+		printf("Start breadth first traversal at what vertex? ");
+		fgets(input, sizeof(input), stdin);
+		input[strlen(input) - 1] = '\0';
+		sscanf(input, "%s", keystring1);
+		printSnapshotTraversals(graph, keystring1);
+	    }
+	    else if ((input[0] == 'Y') || (input[0] == 'y'))
 	    {
 		printf("Start traversal at what vertex? ");
 		fgets(input, sizeof(input), stdin);
 		input[strlen(input) - 1] = '\0';
 		sscanf(input, "%s", keystring1);
-		retval = printBreadthFirst(keystring1);
+		retval = printBreadthFirst(graph, keystring1);
 		if (retval < 0)
 		{
 		    printf(">>> Vertex |%s| does not exist\n", keystring1);
@@ -259,7 +373,7 @@ int main(int argc, char *argv[])
 	    }
 	    else
 	    {
-		printDepthFirst();
+		printDepthFirst(graph);
 	    }
 	    break;
 	case 8:		/* do Dijkstra's algorithm to find shortest path */
@@ -273,7 +387,78 @@ int main(int argc, char *argv[])
 	    fgets(input, sizeof(input), stdin);
 	    input[strlen(input) - 1] = '\0';
 	    sscanf(input, "%s", keystring2);
-	    weight = printShortestPath(keystring1, keystring2);
+	    memset(input, 0, sizeof(input));
+	    printf("Use Dijkstra, bidirectional, A* or tracked paths "
+		   "(D, B, A or T)? ");
+	    fgets(input, sizeof(input), stdin);
+	    if ((input[0] == 'T') || (input[0] == 't'))
+	    {
+		char **pathKeys = NULL;
+		int pathCount = 0;
+		PATH_TREE_STATS_T stats;
+		/* the tree is kept up to date as long as the source stays
+		 * the same, so we only build it when the source changes */
+		weight = -6;
+		if (strcmp(trackedKey, keystring1) == 0)
+		    weight = findTrackedPath(graph, keystring2, &pathKeys,
+					     &pathCount);
+		if (weight == -6)
+		{
+		    weight = trackShortestPaths(graph, keystring1);
+		    strcpy(trackedKey, (weight == 1) ? keystring1 : "");
+		    if (weight == 1)
+			weight = findTrackedPath(graph, keystring2, &pathKeys,
+						 &pathCount);
+		}
+		if (weight >= 0)
+		{
+		    printf("Minimum weight path from %s to %s:\n",
+			   keystring1, keystring2);
+		    for (i = 0; i < pathCount; i++)
+			printf(" %s %s", pathKeys[i],
+			       (i < pathCount - 1) ? "==>" : "\n");
+		    free(pathKeys);
+		}
+		if (getTrackedPathStats(graph, &stats))
+		{
+		    printf("Tree built in %ld us, %d edges examined\n",
+			   stats.buildMicroseconds, stats.buildEdgeScans);
+		    printf("%ld changes since then (%ld repaired): "
+			   "%ld vertices and %ld edges, %ld us in total\n",
+			   stats.updateCount, stats.repairCount,
+			   stats.affectedTotal, stats.edgeScanTotal,
+			   stats.updateMicroseconds);
+		    printf("%ld queries, %ld us in total\n",
+			   stats.queryCount, stats.queryMicroseconds);
+		}
+	    }
+	    else if ((input[0] == 'B') || (input[0] == 'b') ||
+		(input[0] == 'A') || (input[0] == 'a'))
+	    {
+		char **pathKeys = NULL;
+		int pathCount = 0;
+		int settledCount = 0;
+		int method = ((input[0] == 'B') || (input[0] == 'b')) ?
+		    PATH_BIDIRECTIONAL : PATH_ASTAR;
+		weight = findShortestPathUsing(graph, method, keystring1,
+					       keystring2, &cityBlockDistance,
+					       &pathKeys, &pathCount,
+					       &settledCount);
+		if (weight >= 0)
+		{
+		    printf("Minimum weight path from %s to %s:\n",
+			   keystring1, keystring2);
+		    for (i = 0; i < pathCount; i++)
+			printf(" %s %s", pathKeys[i],
+			       (i < pathCount - 1) ? "==>" : "\n");
+		    printf("(search settled %d vertices)\n", settledCount);
+		    free(pathKeys);
+		}
+	    }
+	    else
+	    {
+		weight = printShortestPath(graph, keystring1, keystring2);
+	    }
 	    if (weight == -1)
 		printf
 		    (">>> At least one key value does not exist in network\n");
@@ -285,16 +470,55 @@ int main(int argc, char *argv[])
 	    else if (weight == -4)
 		printf(">> Vertex '%s' is not reachable from '%s'\n",
 		       keystring2, keystring1);
+	    else if (weight == -5)
+		printf(">> Memory allocation error\n");
 	    else
 		printf("Shortest distance from '%s' to '%s' is %d\n",
 		       keystring1, keystring2, weight);
 	    break;
+	case 9:		/* minimum spanning tree */
+	    {
+		NETWORK_EDGE_T *treeEdges = NULL;
+		int edgeCount = 0;
+		int method = MST_AUTOMATIC;
+		memset(input, 0, sizeof(input));
+		printf("Use Prim, Kruskal or automatic choice (P, K or A)? ");
+		fgets(input, sizeof(input), stdin);
+		if ((input[0] == 'P') || (input[0] == 'p'))
+		    method = MST_PRIM;
+		else if ((input[0] == 'K') || (input[0] == 'k'))
+		    method = MST_KRUSKAL;
+		retval = computeMinimumSpanningTree(graph, method, &treeEdges,
+						    &edgeCount, &weight);
+		if (retval == -2)
+		{
+		    printf(">>> Network must be undirected to find a spanning tree\n");
+		}
+		else if (retval < 0)
+		{
+		    printf(">> Memory allocation error\n");
+		}
+		else
+		{
+		    printf("Minimum spanning tree has %d edges:\n", edgeCount);
+		    for (i = 0; i < edgeCount; i++)
+		    {
+			printf("     %s - %s (weight %d)\n",
+			       treeEdges[i].fromKey, treeEdges[i].toKey,
+			       treeEdges[i].weight);
+		    }
+		    printf("Total weight is %d\n", weight);
+		    free(treeEdges);
+		}
+		break;
+	    }
 	default:
 	    printf("Invalid option - we should never get here!\n");
 	}			/* end switch  */
 	choice = getMenuOption();
     }				/* end while loop */
 
+    graphDestroy(graph);
 /* exit here - we're done */
 }
 
@@ -315,14 +539,15 @@ int getMenuOption()
 	printf("  5 - Remove an edge from the graph\n");
 	printf("  6 - Get adjacent vertices\n");
 	printf("  7 - Print breadth first or depth first\n");
-	printf("  8 - Print shortest path (Dijkstra's algorithm)\n");
-	printf("  9 - Exit\n");
+	printf("  8 - Print shortest path (Dijkstra, bidirectional, A* or tracked)\n");
+	printf("  9 - Find minimum spanning tree\n");
+	printf(" 10 - Exit\n");
 	printf("Which option? ");
 	fgets(input, sizeof(input), stdin);
 	sscanf(input, "%d", &option);
-	if ((option > 9) || (option < 1))
+	if ((option > 10) || (option < 1))
 	{
-	    printf("Invalid selection - choose 1 to 9\n");
+	    printf("Invalid selection - choose 1 to 10\n");
 	    option = -1;
 	}
     }
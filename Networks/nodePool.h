@@ -0,0 +1,74 @@
+/**
+ *  nodePool.h
+ *
+ *  Header file for a pool allocator for small records that are all
+ *  the same size, such as the vertex and adjacency list items of
+ *  the linked list graph and network.
+ *
+ *  Calling calloc and free for every item is slow when a graph has
+ *  millions of edges, and scatters the items around the heap. A pool
+ *  instead gets memory from the system in large blocks ("slabs"),
+ *  each holding many records, and hands them out one after another.
+ *  Freed records go on a free list and are reused by later
+ *  allocations. Destroying the pool gives back all the slabs at
+ *  once, without visiting the records one by one.
+ *
+ *  Each call to newNodePool() creates a new, independent pool.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+
+/* opaque pointer to a pool */
+typedef void* NODE_POOL_HANDLE;
+
+/* Create a new, empty pool. No slab is allocated until the
+ * first record is requested.
+ * Arguments
+ *   recordSize   -  Size in bytes of each record
+ *   slabRecords  -  Number of records in each slab
+ * Returns a handle for the pool, or NULL if a memory allocation
+ * error occurs.
+ */
+NODE_POOL_HANDLE newNodePool(int recordSize, int slabRecords);
+
+
+/* Free all memory associated with a pool, including every record
+ * allocated from it, whether or not it has been freed.
+ * Arguments
+ *   pool    -  Pool to free. Not valid after this call.
+ */
+void nodePoolDestroy(NODE_POOL_HANDLE pool);
+
+
+/* Get a record from the pool. Like calloc, the record is
+ * filled with zeros.
+ * Arguments
+ *   pool    -  Pool to allocate from
+ * Returns a pointer to the record, or NULL if a memory allocation
+ * error occurs.
+ */
+void* nodePoolAlloc(NODE_POOL_HANDLE pool);
+
+
+/* Give a record back to the pool so it can be reused.
+ * Arguments
+ *   pool    -  Pool the record came from
+ *   pRecord -  Record to free. Like free, does nothing if NULL.
+ */
+void nodePoolFree(NODE_POOL_HANDLE pool, void* pRecord);
+
+
+/* Find out how many records are currently allocated from a pool.
+ * Arguments
+ *   pool    -  Pool we are interested in
+ * Returns number of records (could be zero)
+ */
+int nodePoolCount(NODE_POOL_HANDLE pool);
+
+#endif
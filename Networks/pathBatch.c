@@ -0,0 +1,138 @@
+/*
+ *  pathBatch.c
+ *
+ *  Runs batches of shortest path queries on a network snapshot
+ *  in parallel, using POSIX threads. See pathBatch.h.
+ *
+ *  The next query to be done is kept in a counter that all the
+ *  threads share. A thread that is ready for more work adds
+ *  BATCH_CHUNK to the counter with one atomic operation, and
+ *  then does the queries from the old value up to the new one.
+ *  Each query writes only its own element of the results array,
+ *  so no other synchronization is needed.
+ *
+ *  Note this module needs to be linked with networkSnapshot.c,
+ *  shortestPath.c and minPriorityQueue.c, and with -lpthread.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "pathBatch.h"
+#include "shortestPath.h"
+
+#define BATCH_CHUNK 16		/* number of queries a thread takes at once */
+#define MAX_THREADS 64		/* upper limit on the number of threads */
+
+/* Information shared by all the threads working on one batch */
+typedef struct
+{
+    NETWORK_SNAPSHOT_T *pSnapshot;	/* network to search */
+    int pairCount;		/* number of queries */
+    int *startIndices;		/* start vertex for each query */
+    int *endIndices;		/* end vertex for each query */
+    int *distances;		/* results */
+    atomic_int nextPair;	/* first query not yet taken by a thread */
+} BATCH_T;
+
+
+/* Work done by each thread. Takes groups of queries until
+ * there are none left.
+ * Arguments
+ *    pArg   -  The batch (will be cast to BATCH_T *)
+ * Returns NULL.
+ */
+static void *batchWorker(void *pArg)
+{
+    BATCH_T *pBatch = (BATCH_T *) pArg;
+    /* every thread has its own arrays and its own heap */
+    PATH_SEARCH_HANDLE search =
+	newPathSearch(pBatch->pSnapshot->vertexCount);
+    if (search == NULL)
+	return NULL;		/* leave the work for the other threads */
+    while (1)
+    {
+	int first = atomic_fetch_add(&pBatch->nextPair, BATCH_CHUNK);
+	int last = first + BATCH_CHUNK;
+	int i = 0;
+	if (first >= pBatch->pairCount)
+	    break;
+	if (last > pBatch->pairCount)
+	    last = pBatch->pairCount;
+	for (i = first; i < last; i++)
+	{
+	    pBatch->distances[i] =
+		snapshotShortestPath(pBatch->pSnapshot, search,
+				     pBatch->startIndices[i],
+				     pBatch->endIndices[i]);
+	}
+    }
+    pathSearchDestroy(search);
+    return NULL;
+}
+
+
+/********************************/
+/** Public functions start here */
+/********************************/
+
+/* Find the lowest weight path distance for each of a set of
+ * (start, end) pairs of vertex indices.
+ * Arguments
+ *    pSnapshot    -  Snapshot to search (edge weights must not be negative)
+ *    pairCount    -  Number of pairs
+ *    startIndices -  Index of the start vertex for each pair
+ *    endIndices   -  Index of the end vertex for each pair
+ *    distances    -  Array of pairCount values to fill in
+ *    threadCount  -  Number of threads to use. If zero or less, uses
+ *                    one thread per processor.
+ * Returns 1 if successful, 0 if a memory allocation error occurs
+ * or the threads cannot be started.
+ */
+int snapshotShortestPathBatch(NETWORK_SNAPSHOT_T * pSnapshot, int pairCount,
+			      int *startIndices, int *endIndices,
+			      int *distances, int threadCount)
+{
+    BATCH_T batch;
+    pthread_t threads[MAX_THREADS];
+    int started = 0;
+    int i = 0;
+    if (threadCount <= 0)
+	threadCount = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    /* no point having threads that will never get a chunk */
+    if (threadCount > (pairCount + BATCH_CHUNK - 1) / BATCH_CHUNK)
+	threadCount = (pairCount + BATCH_CHUNK - 1) / BATCH_CHUNK;
+    if (threadCount > MAX_THREADS)
+	threadCount = MAX_THREADS;
+    if (threadCount < 1)
+	threadCount = 1;
+    batch.pSnapshot = pSnapshot;
+    batch.pairCount = pairCount;
+    batch.startIndices = startIndices;
+    batch.endIndices = endIndices;
+    batch.distances = distances;
+    atomic_init(&batch.nextPair, 0);
+    /* the calling thread does its share too */
+    for (i = 1; i < threadCount; i++)
+    {
+	if (pthread_create(&threads[started], NULL, &batchWorker, &batch)
+	    != 0)
+	    break;
+	started++;
+    }
+    batchWorker(&batch);
+    for (i = 0; i < started; i++)
+	pthread_join(threads[i], NULL);
+    /* if some threads could not start or allocate their storage,
+     * the others did their work, so we only fail if every thread
+     * failed and some queries were never taken */
+    return (atomic_load(&batch.nextPair) >= pairCount);
+}
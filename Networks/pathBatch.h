@@ -0,0 +1,46 @@
+/**
+ *  pathBatch.h
+ *
+ *  Runs a large batch of shortest path queries on a network snapshot
+ *  (see networkSnapshot.h), using several threads at once.
+ *
+ *  The snapshot is shared by all the threads; it is never modified,
+ *  so no locking is needed to read it. Each thread has its own search
+ *  handle from shortestPath.h, which holds its own distance and parent
+ *  arrays and its own priority queue. The threads take the queries in
+ *  small groups, so a thread that gets easy queries simply does more
+ *  of them.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+#ifndef PATHBATCH_H
+#define PATHBATCH_H
+
+#include "networkSnapshot.h"
+
+/* Find the lowest weight path distance for each of a set of
+ * (start, end) pairs of vertex indices.
+ * Arguments
+ *    pSnapshot    -  Snapshot to search (edge weights must not be negative)
+ *    pairCount    -  Number of pairs
+ *    startIndices -  Index of the start vertex for each pair
+ *    endIndices   -  Index of the end vertex for each pair
+ *    distances    -  Array of pairCount values to fill in. Each is set to
+ *                    the path weight, -1 if the end vertex is not
+ *                    reachable, or -2 if either index is invalid
+ *                    (for instance -1 for a key that
+ *                    snapshotFindVertex did not find).
+ *    threadCount  -  Number of threads to use. If zero or less, uses
+ *                    one thread per processor.
+ * Returns 1 if successful, 0 if a memory allocation error occurs
+ * or the threads cannot be started.
+ */
+int snapshotShortestPathBatch(NETWORK_SNAPSHOT_T* pSnapshot, int pairCount,
+                              int* startIndices, int* endIndices,
+                              int* distances, int threadCount);
+
+#endif
@@ -0,0 +1,572 @@
+/*
+ *  pathTree.c
+ *
+ *  Dynamic single-source shortest path tree. See pathTree.h for
+ *  an explanation of how the tree is repaired after each change.
+ *
+ *  As in shortestPath.c, all per-vertex information is kept in
+ *  arrays indexed by vertex index. To find the vertices below an
+ *  edge quickly, we also keep the tree itself: each vertex has a
+ *  list of its children, linked through the nextSibling and
+ *  prevSibling arrays, so moving a vertex to a new parent takes
+ *  constant time.
+ *
+ *  The priority queue holds pointers to elements of the dValue
+ *  array, like the one in shortestPath.c.
+ *
+ *  Note this module needs to be linked with minPriorityQueue.c
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/time.h>
+#include "pathTree.h"
+#include "minPriorityQueue.h"
+
+#define INFINITE INT_MAX	/* distance of a vertex we cannot reach */
+
+#define IDLE    0		/* not in the queue */
+#define QUEUED  1		/* waiting in the queue */
+
+/* Structure holding one tree and its working storage */
+typedef struct
+{
+    int capacity;		/* size of the arrays below */
+    int indexCount;		/* vertex indices in use */
+    int *dValue;		/* distance from the source, or INFINITE */
+    int *parent;		/* parent in the tree, -1 if none */
+    int *firstChild;		/* first child in the tree, -1 if none */
+    int *nextSibling;		/* next child of the same parent */
+    int *prevSibling;		/* previous child of the same parent */
+    int *affected;		/* list of vertices being repaired */
+    unsigned char *state;	/* IDLE or QUEUED */
+    MIN_QUEUE_HANDLE queue;	/* vertices whose distance has changed */
+    void *pGraph;		/* passed through to the edge walkers */
+    EDGE_WALKER_T walker;	/* reports the edges leaving a vertex */
+    EDGE_WALKER_T reverseWalker;	/* reports the edges entering a vertex */
+    int sourceIndex;		/* root of the tree */
+    int currentIndex;		/* vertex whose edges are being walked */
+    int edgeScans;		/* edges examined by the current operation */
+    PATH_TREE_STATS_T stats;	/* work counters */
+} PATH_TREE_T;
+
+
+/* Comparison function to send to the minPriorityQueue.
+ * The items in the queue are pointers into the dValue array.
+ * Arguments
+ *   pD1     First distance (will be cast to int *)
+ *   pD2     Second distance (will be cast to int *)
+ * Returns -1 if D1 < D2, 0 if they are the same, 1 if D1 > D2.
+ */
+static int compareDistances(void *pD1, void *pD2)
+{
+    int d1 = *((int *) pD1);
+    int d2 = *((int *) pD2);
+    if (d1 < d2)
+	return -1;
+    else if (d1 > d2)
+	return 1;
+    else
+	return 0;
+}
+
+/* Find out how many microseconds have passed since a given time.
+ * Arguments
+ *   pStart  -  Time returned by gettimeofday earlier
+ * Returns the elapsed time in microseconds.
+ */
+static long elapsedMicroseconds(struct timeval *pStart)
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - pStart->tv_sec) * 1000000L
+	+ (now.tv_usec - pStart->tv_usec);
+}
+
+/* Grow one integer array to hold 'count' items.
+ * Arguments
+ *   pArray   -  Address of the array pointer, updated if successful
+ *   count    -  Number of items needed
+ * Returns 1 if successful, 0 if allocation fails.
+ */
+static int growArray(int **pArray, int count)
+{
+    int *newArray = realloc(*pArray, count * sizeof(int));
+    if (newArray == NULL)
+	return 0;
+    *pArray = newArray;
+    return 1;
+}
+
+/* Make sure the arrays can hold at least 'count' vertices. New
+ * vertices start out unreachable and outside the tree.
+ * Arguments
+ *   pTree    -  Tree structure
+ *   count    -  Number of vertex indices needed
+ * Returns 1 if successful, 0 if allocation fails.
+ */
+static int ensureCapacity(PATH_TREE_T * pTree, int count)
+{
+    int i = 0;
+    if (count > pTree->capacity)
+    {
+	int newCapacity = (pTree->capacity > 0) ? pTree->capacity : 16;
+	unsigned char *newState = NULL;
+	while (newCapacity < count)
+	    newCapacity *= 2;
+	if (!growArray(&pTree->dValue, newCapacity) ||
+	    !growArray(&pTree->parent, newCapacity) ||
+	    !growArray(&pTree->firstChild, newCapacity) ||
+	    !growArray(&pTree->nextSibling, newCapacity) ||
+	    !growArray(&pTree->prevSibling, newCapacity) ||
+	    !growArray(&pTree->affected, newCapacity))
+	    return 0;
+	newState = realloc(pTree->state, newCapacity);
+	if (newState == NULL)
+	    return 0;
+	pTree->state = newState;
+	pTree->capacity = newCapacity;
+    }
+    for (i = pTree->indexCount; i < count; i++)
+    {
+	pTree->dValue[i] = INFINITE;
+	pTree->parent[i] = -1;
+	pTree->firstChild[i] = -1;
+	pTree->nextSibling[i] = -1;
+	pTree->prevSibling[i] = -1;
+	pTree->state[i] = IDLE;
+    }
+    if (count > pTree->indexCount)
+	pTree->indexCount = count;
+    return 1;
+}
+
+/* Move a vertex to a new parent in the tree.
+ * Arguments
+ *   pTree      -  Tree structure
+ *   index      -  Vertex to move
+ *   newParent  -  Its new parent, or -1 to take it out of the tree
+ */
+static void setParent(PATH_TREE_T * pTree, int index, int newParent)
+{
+    int oldParent = pTree->parent[index];
+    int prev = pTree->prevSibling[index];
+    int next = pTree->nextSibling[index];
+    if (oldParent >= 0)
+    {
+	if (prev >= 0)
+	    pTree->nextSibling[prev] = next;
+	else
+	    pTree->firstChild[oldParent] = next;
+	if (next >= 0)
+	    pTree->prevSibling[next] = prev;
+    }
+    pTree->parent[index] = newParent;
+    pTree->prevSibling[index] = -1;
+    pTree->nextSibling[index] = -1;
+    if (newParent >= 0)
+    {
+	next = pTree->firstChild[newParent];
+	pTree->nextSibling[index] = next;
+	if (next >= 0)
+	    pTree->prevSibling[next] = index;
+	pTree->firstChild[newParent] = index;
+    }
+}
+
+/* Put a vertex whose distance just got shorter into the queue,
+ * or move it forward if it is already there.
+ * Arguments
+ *   pTree    -  Tree structure
+ *   index    -  Vertex whose distance changed
+ */
+static void queueVertex(PATH_TREE_T * pTree, int index)
+{
+    if (pTree->state[index] == QUEUED)
+    {
+	minQueueDecreaseKey(pTree->queue, &pTree->dValue[index]);
+    }
+    else
+    {
+	pTree->state[index] = QUEUED;
+	minQueueEnqueue(pTree->queue, &pTree->dValue[index]);
+    }
+}
+
+/* Relax one edge leaving the current vertex, if it gives a
+ * shorter distance to the vertex at the other end.
+ * Arguments
+ *    pTreeArg   -  Tree structure (will be cast to PATH_TREE_T *)
+ *    toIndex    -  Vertex at the other end of the edge
+ *    weight     -  Weight of the edge
+ */
+static void relaxLeaving(void *pTreeArg, int toIndex, int weight)
+{
+    PATH_TREE_T *pTree = (PATH_TREE_T *) pTreeArg;
+    int distance = pTree->dValue[pTree->currentIndex] + weight;
+    pTree->edgeScans++;
+    if (distance < pTree->dValue[toIndex])
+    {
+	pTree->dValue[toIndex] = distance;
+	setParent(pTree, toIndex, pTree->currentIndex);
+	queueVertex(pTree, toIndex);
+    }
+}
+
+/* Relax one edge entering the current vertex, if the vertex at
+ * the other end gives the current vertex a shorter distance.
+ * Arguments
+ *    pTreeArg   -  Tree structure (will be cast to PATH_TREE_T *)
+ *    fromIndex  -  Vertex at the other end of the edge
+ *    weight     -  Weight of the edge
+ */
+static void relaxEntering(void *pTreeArg, int fromIndex, int weight)
+{
+    PATH_TREE_T *pTree = (PATH_TREE_T *) pTreeArg;
+    int index = pTree->currentIndex;
+    pTree->edgeScans++;
+    if ((pTree->dValue[fromIndex] != INFINITE) &&
+	(pTree->dValue[fromIndex] + weight < pTree->dValue[index]))
+    {
+	pTree->dValue[index] = pTree->dValue[fromIndex] + weight;
+	setParent(pTree, index, fromIndex);
+    }
+}
+
+/* Run Dijkstra's algorithm on whatever is in the queue, until
+ * no more distances get shorter.
+ * Arguments
+ *   pTree    -  Tree structure
+ * Returns the number of vertices settled.
+ */
+static int runQueue(PATH_TREE_T * pTree)
+{
+    int settledCount = 0;
+    while (minQueueSize(pTree->queue) > 0)
+    {
+	int *pMin = (int *) minQueueDequeue(pTree->queue);
+	int minIndex = (int) (pMin - pTree->dValue);
+	pTree->state[minIndex] = IDLE;
+	pTree->currentIndex = minIndex;
+	(*pTree->walker) (pTree->pGraph, minIndex, &relaxLeaving, pTree);
+	settledCount++;
+    }
+    return settledCount;
+}
+
+/* Recompute the distances of a vertex and everything below
+ * it in the tree, after the edge into it got heavier or went away.
+ * Arguments
+ *   pTree        -  Tree structure
+ *   rootIndex    -  Top of the subtree to repair
+ *   removedIndex -  A vertex that no longer exists and must stay
+ *                   unreachable, or -1
+ * Returns the number of vertices in the subtree.
+ */
+static int repairSubtree(PATH_TREE_T * pTree, int rootIndex,
+			 int removedIndex)
+{
+    int count = 1;
+    int i = 0;
+    int child = -1;
+    /* collect the subtree, breadth first */
+    pTree->affected[0] = rootIndex;
+    for (i = 0; i < count; i++)
+    {
+	for (child = pTree->firstChild[pTree->affected[i]]; child >= 0;
+	     child = pTree->nextSibling[child])
+	{
+	    pTree->affected[count] = child;
+	    count++;
+	}
+    }
+    /* forget everything we knew about these vertices */
+    for (i = 0; i < count; i++)
+    {
+	pTree->dValue[pTree->affected[i]] = INFINITE;
+	setParent(pTree, pTree->affected[i], -1);
+    }
+    /* give each one the best distance through an edge entering it */
+    for (i = 0; i < count; i++)
+    {
+	int index = pTree->affected[i];
+	if (index != removedIndex)
+	{
+	    pTree->currentIndex = index;
+	    (*pTree->reverseWalker) (pTree->pGraph, index,
+				     &relaxEntering, pTree);
+	    if (pTree->dValue[index] != INFINITE)
+		queueVertex(pTree, index);
+	}
+    }
+    runQueue(pTree);
+    return count;
+}
+
+/* Add the work done by one change to the counters.
+ * Arguments
+ *   pTree     -  Tree structure
+ *   affected  -  Number of vertices whose distance was recomputed
+ *   pStart    -  Time when the change started
+ */
+static void recordUpdate(PATH_TREE_T * pTree, int affected,
+			 struct timeval *pStart)
+{
+    pTree->stats.updateCount++;
+    if (affected > 0)
+	pTree->stats.repairCount++;
+    pTree->stats.affectedTotal += affected;
+    pTree->stats.edgeScanTotal += pTree->edgeScans;
+    pTree->stats.lastAffected = affected;
+    pTree->stats.lastEdgeScans = pTree->edgeScans;
+    pTree->stats.updateMicroseconds += elapsedMicroseconds(pStart);
+}
+
+
+/********************************/
+/** Public functions start here */
+/********************************/
+
+/* Create an empty shortest path tree.
+ * Arguments
+ *    maxVertices  -  Initial number of vertex indices to allow for.
+ *                    The storage grows later if needed.
+ * Returns a handle to use in the other functions, or NULL
+ * if a memory allocation error occurs.
+ */
+PATH_TREE_HANDLE newPathTree(int maxVertices)
+{
+    PATH_TREE_T *pTree = calloc(1, sizeof(PATH_TREE_T));
+    if (pTree != NULL)
+    {
+	pTree->sourceIndex = -1;
+	pTree->queue = newMinQueue(&compareDistances);
+    }
+    if ((pTree != NULL) && ((pTree->queue == NULL) ||
+			    (!ensureCapacity(pTree, maxVertices))))
+    {
+	pathTreeDestroy(pTree);
+	pTree = NULL;
+    }
+    return (PATH_TREE_HANDLE) pTree;
+}
+
+
+/* Free all memory associated with a tree.
+ * Arguments
+ *    tree   -  Handle returned by newPathTree. Not valid
+ *              after this call.
+ */
+void pathTreeDestroy(PATH_TREE_HANDLE tree)
+{
+    PATH_TREE_T *pTree = (PATH_TREE_T *) tree;
+    if (pTree != NULL)
+    {
+	free(pTree->dValue);
+	free(pTree->parent);
+	free(pTree->firstChild);
+	free(pTree->nextSibling);
+	free(pTree->prevSibling);
+	free(pTree->affected);
+	free(pTree->state);
+	minQueueDestroy(pTree->queue);
+	free(pTree);
+    }
+}
+
+
+/* Compute the whole tree from scratch, using Dijkstra's algorithm,
+ * and remember the network for later repairs. Resets the counters.
+ * Arguments
+ *    tree          -  Handle returned by newPathTree
+ *    pGraph        -  Passed through to both edge walkers
+ *    walker        -  Edge walker reporting the edges leaving a vertex
+ *    reverseWalker -  Edge walker reporting the edges entering a vertex
+ *    indexCount    -  Vertex indices run from 0 to indexCount-1
+ *    sourceIndex   -  Index of the source vertex
+ * Returns 1 if successful, 0 if the source index is out of range
+ * or memory allocation fails.
+ */
+int pathTreeBuild(PATH_TREE_HANDLE tree, void *pGraph, EDGE_WALKER_T walker,
+		  EDGE_WALKER_T reverseWalker, int indexCount,
+		  int sourceIndex)
+{
+    PATH_TREE_T *pTree = (PATH_TREE_T *) tree;
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    if ((sourceIndex < 0) || (sourceIndex >= indexCount))
+	return 0;
+    /* start again with every vertex unreachable */
+    pTree->indexCount = 0;
+    if (!ensureCapacity(pTree, indexCount))
+	return 0;
+    pTree->pGraph = pGraph;
+    pTree->walker = walker;
+    pTree->reverseWalker = reverseWalker;
+    pTree->sourceIndex = sourceIndex;
+    memset(&pTree->stats, 0, sizeof(PATH_TREE_STATS_T));
+    minQueueClear(pTree->queue);
+    pTree->edgeScans = 0;
+    pTree->dValue[sourceIndex] = 0;
+    queueVertex(pTree, sourceIndex);
+    pTree->stats.buildVertices = runQueue(pTree);
+    pTree->stats.buildEdgeScans = pTree->edgeScans;
+    pTree->stats.buildMicroseconds = elapsedMicroseconds(&start);
+    return 1;
+}
+
+
+/* Repair the tree after one edge was added, removed or changed weight.
+ * Arguments
+ *    tree       -  Handle used in pathTreeBuild
+ *    fromIndex  -  Index of the start vertex of the edge
+ *    toIndex    -  Index of the end vertex of the edge
+ *    oldWeight  -  Weight before the change, or -1 if the edge is new
+ *    newWeight  -  Weight after the change, or -1 if it was removed
+ * Returns 1 if successful, 0 if memory allocation fails (in which
+ * case the tree should be built again).
+ */
+int pathTreeEdgeChanged(PATH_TREE_HANDLE tree, int fromIndex, int toIndex,
+			int oldWeight, int newWeight)
+{
+    PATH_TREE_T *pTree = (PATH_TREE_T *) tree;
+    int affected = 0;
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    if (!ensureCapacity(pTree, ((fromIndex > toIndex) ? fromIndex :
+				toIndex) + 1))
+	return 0;
+    pTree->edgeScans = 0;
+    if ((newWeight >= 0) && (pTree->dValue[fromIndex] != INFINITE) &&
+	(pTree->dValue[fromIndex] + newWeight < pTree->dValue[toIndex]))
+    {
+	/* the edge gives a shorter path - carry on from its end */
+	pTree->dValue[toIndex] = pTree->dValue[fromIndex] + newWeight;
+	setParent(pTree, toIndex, fromIndex);
+	queueVertex(pTree, toIndex);
+	affected = runQueue(pTree);
+    }
+    else if ((oldWeight >= 0) && (pTree->parent[toIndex] == fromIndex) &&
+	     ((newWeight < 0) || (newWeight > oldWeight)))
+    {
+	/* a tree edge got worse - everything below it may change */
+	affected = repairSubtree(pTree, toIndex, -1);
+    }
+    recordUpdate(pTree, affected, &start);
+    return 1;
+}
+
+
+/* Repair the tree after a vertex was removed from the network.
+ * Its edges must already be gone, and its index must not be
+ * used again while the tree is in use.
+ * Arguments
+ *    tree     -  Handle used in pathTreeBuild
+ *    index    -  Index of the vertex that was removed
+ * Returns 1 if successful, 0 if memory allocation fails.
+ */
+int pathTreeVertexRemoved(PATH_TREE_HANDLE tree, int index)
+{
+    PATH_TREE_T *pTree = (PATH_TREE_T *) tree;
+    int affected = 0;
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    if (!ensureCapacity(pTree, index + 1))
+	return 0;
+    pTree->edgeScans = 0;
+    if (pTree->dValue[index] != INFINITE)
+	affected = repairSubtree(pTree, index, index);
+    recordUpdate(pTree, affected, &start);
+    return 1;
+}
+
+
+/* Get the distance from the source to a vertex.
+ * Arguments
+ *    tree     -  Handle used in pathTreeBuild
+ *    index    -  Vertex index we are interested in
+ * Returns the distance, or -1 if the vertex cannot be reached.
+ */
+int pathTreeDistance(PATH_TREE_HANDLE tree, int index)
+{
+    PATH_TREE_T *pTree = (PATH_TREE_T *) tree;
+    int distance = -1;
+    if ((index >= 0) && (index < pTree->indexCount) &&
+	(pTree->dValue[index] != INFINITE))
+	distance = pTree->dValue[index];
+    return distance;
+}
+
+
+/* Copy the path from the source to a vertex into an array,
+ * in order from the source. Counted as a query in the statistics.
+ * Arguments
+ *    tree        -  Handle used in pathTreeBuild
+ *    endIndex    -  Last vertex in the path
+ *    pathIndices -  Array to fill in with vertex indices
+ *    maxCount    -  Size of the pathIndices array
+ * Returns the number of vertices in the path, 0 if the end vertex
+ * cannot be reached, or -1 if the array is too small.
+ */
+int pathTreeGetPath(PATH_TREE_HANDLE tree, int endIndex,
+		    int *pathIndices, int maxCount)
+{
+    PATH_TREE_T *pTree = (PATH_TREE_T *) tree;
+    int pathCount = 0;
+    int current = endIndex;
+    int i = 0;
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    if (pathTreeDistance(tree, endIndex) >= 0)
+    {
+	/* follow the parent links back to the source, then reverse */
+	while ((current >= 0) && (pathCount >= 0))
+	{
+	    if (pathCount >= maxCount)
+	    {
+		pathCount = -1;
+	    }
+	    else
+	    {
+		pathIndices[pathCount] = current;
+		pathCount++;
+		current = pTree->parent[current];
+	    }
+	}
+	for (i = 0; i < pathCount / 2; i++)
+	{
+	    int temp = pathIndices[i];
+	    pathIndices[i] = pathIndices[pathCount - 1 - i];
+	    pathIndices[pathCount - 1 - i] = temp;
+	}
+    }
+    pTree->stats.queryCount++;
+    pTree->stats.queryMicroseconds += elapsedMicroseconds(&start);
+    return pathCount;
+}
+
+
+/* Get the source vertex index given to pathTreeBuild */
+int pathTreeSource(PATH_TREE_HANDLE tree)
+{
+    return ((PATH_TREE_T *) tree)->sourceIndex;
+}
+
+
+/* Copy the work counters of a tree.
+ * Arguments
+ *    tree     -  Handle used in pathTreeBuild
+ *    pStats   -  Structure to fill in
+ */
+void pathTreeGetStats(PATH_TREE_HANDLE tree, PATH_TREE_STATS_T * pStats)
+{
+    *pStats = ((PATH_TREE_T *) tree)->stats;
+}
@@ -0,0 +1,211 @@
+/**
+ *  pathTree.h
+ *
+ *  Declarations for a dynamic single-source shortest path tree.
+ *
+ *  Running Dijkstra's algorithm again every time one edge changes
+ *  wastes a lot of work, since usually only a few distances change.
+ *  This engine keeps the distance and parent of every vertex,
+ *  as seen from one source vertex, and repairs them after each
+ *  change, in the style of Ramalingam and Reps:
+ *
+ *    - If an edge is added, or gets lighter, we only need to
+ *      continue Dijkstra's algorithm from its end vertex, through
+ *      the vertices whose distances actually get shorter.
+ *
+ *    - If an edge in the tree is removed, or gets heavier, only
+ *      the vertices below it in the tree can be affected. We throw
+ *      away their distances, give each one the best distance it can
+ *      get directly from an unaffected vertex, and then run Dijkstra's
+ *      algorithm over the affected vertices only. Changes to edges
+ *      that are not in the tree cannot make any distance longer.
+ *
+ *  Like shortestPath.c, the engine works with vertex indices and
+ *  asks the network for edges through edge walkers. It needs two:
+ *  one for the edges leaving a vertex and one for the edges entering
+ *  it. The network must call pathTreeEdgeChanged after every change,
+ *  and the walkers must already show the network after the change.
+ *
+ *  The engine counts how much work each repair does and how long
+ *  queries take, so the cost of repairs can be compared with the
+ *  cost of building the tree from scratch.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+#ifndef PATHTREE_H
+#define PATHTREE_H
+
+#include "shortestPath.h"
+#include "abstractNetwork.h"
+
+/* opaque pointer to a shortest path tree */
+typedef void* PATH_TREE_HANDLE;
+
+/* Work counters kept by each tree */
+typedef struct
+{
+    int buildVertices;       /* vertices reached by the last full build */
+    int buildEdgeScans;      /* edges examined by the last full build */
+    long buildMicroseconds;  /* time taken by the last full build */
+    long updateCount;        /* edge changes reported since the build */
+    long repairCount;        /* changes that altered some distance */
+    long affectedTotal;      /* vertices whose distance was recomputed */
+    long edgeScanTotal;      /* edges examined by all the repairs */
+    int lastAffected;        /* vertices recomputed for the last change */
+    int lastEdgeScans;       /* edges examined for the last change */
+    long updateMicroseconds; /* total time spent in repairs */
+    long queryCount;         /* number of path queries answered */
+    long queryMicroseconds;  /* total time spent answering queries */
+} PATH_TREE_STATS_T;
+
+
+/* Create an empty shortest path tree.
+ * Arguments
+ *    maxVertices  -  Initial number of vertex indices to allow for.
+ *                    The storage grows later if needed.
+ * Returns a handle to use in the other functions, or NULL
+ * if a memory allocation error occurs.
+ */
+PATH_TREE_HANDLE newPathTree(int maxVertices);
+
+
+/* Free all memory associated with a tree.
+ * Arguments
+ *    tree   -  Handle returned by newPathTree. Not valid
+ *              after this call.
+ */
+void pathTreeDestroy(PATH_TREE_HANDLE tree);
+
+
+/* Compute the whole tree from scratch, using Dijkstra's algorithm,
+ * and remember the network for later repairs. Resets the counters.
+ * Arguments
+ *    tree          -  Handle returned by newPathTree
+ *    pGraph        -  Passed through to both edge walkers
+ *    walker        -  Edge walker reporting the edges leaving a vertex
+ *    reverseWalker -  Edge walker reporting the edges entering a vertex
+ *    indexCount    -  Vertex indices run from 0 to indexCount-1
+ *    sourceIndex   -  Index of the source vertex
+ * Returns 1 if successful, 0 if the source index is out of range
+ * or memory allocation fails.
+ */
+int pathTreeBuild(PATH_TREE_HANDLE tree, void* pGraph, EDGE_WALKER_T walker,
+                  EDGE_WALKER_T reverseWalker, int indexCount,
+                  int sourceIndex);
+
+
+/* Repair the tree after one edge was added, removed or changed weight.
+ * Arguments
+ *    tree       -  Handle used in pathTreeBuild
+ *    fromIndex  -  Index of the start vertex of the edge
+ *    toIndex    -  Index of the end vertex of the edge
+ *    oldWeight  -  Weight before the change, or -1 if the edge is new
+ *    newWeight  -  Weight after the change, or -1 if it was removed
+ * Returns 1 if successful, 0 if memory allocation fails (in which
+ * case the tree should be built again).
+ */
+int pathTreeEdgeChanged(PATH_TREE_HANDLE tree, int fromIndex, int toIndex,
+                        int oldWeight, int newWeight);
+
+
+/* Repair the tree after a vertex was removed from the network.
+ * Its edges must already be gone, and its index must not be
+ * used again while the tree is in use.
+ * Arguments
+ *    tree     -  Handle used in pathTreeBuild
+ *    index    -  Index of the vertex that was removed
+ * Returns 1 if successful, 0 if memory allocation fails.
+ */
+int pathTreeVertexRemoved(PATH_TREE_HANDLE tree, int index);
+
+
+/* Get the distance from the source to a vertex.
+ * Arguments
+ *    tree     -  Handle used in pathTreeBuild
+ *    index    -  Vertex index we are interested in
+ * Returns the distance, or -1 if the vertex cannot be reached.
+ */
+int pathTreeDistance(PATH_TREE_HANDLE tree, int index);
+
+
+/* Copy the path from the source to a vertex into an array,
+ * in order from the source. Counted as a query in the statistics.
+ * Arguments
+ *    tree        -  Handle used in pathTreeBuild
+ *    endIndex    -  Last vertex in the path
+ *    pathIndices -  Array to fill in with vertex indices
+ *    maxCount    -  Size of the pathIndices array
+ * Returns the number of vertices in the path, 0 if the end vertex
+ * cannot be reached, or -1 if the array is too small.
+ */
+int pathTreeGetPath(PATH_TREE_HANDLE tree, int endIndex,
+                    int* pathIndices, int maxCount);
+
+
+/* Get the source vertex index given to pathTreeBuild */
+int pathTreeSource(PATH_TREE_HANDLE tree);
+
+
+/* Copy the work counters of a tree.
+ * Arguments
+ *    tree     -  Handle used in pathTreeBuild
+ *    pStats   -  Structure to fill in
+ */
+void pathTreeGetStats(PATH_TREE_HANDLE tree, PATH_TREE_STATS_T* pStats);
+
+
+/* The following functions are implemented by the network module
+ * (linkedListNetwork.c). Each network can keep one tree up to date
+ * as its edges and vertices change. Since findTrackedPath updates
+ * the tree's counters, it should not be called by several threads
+ * at once.
+ */
+
+/* Start keeping the shortest paths from one vertex up to date.
+ * Replaces any tree that was being kept before.
+ * Arguments
+ *    graph      -  Network returned by newGraph
+ *    sourceKey  -  Key of the source vertex
+ * Returns 1 if successful, -1 if the key is invalid, -2 if the
+ * network is not directed, -3 if it has negative weights, or -5
+ * for a memory allocation error.
+ */
+int trackShortestPaths(GRAPH_HANDLE graph, char* sourceKey);
+
+
+/* Stop keeping the tree up to date, and free it.
+ * Argument
+ *    graph      -  Network returned by newGraph
+ */
+void stopTrackingShortestPaths(GRAPH_HANDLE graph);
+
+
+/* Find the lowest weight path from the tracked source to a vertex.
+ * Arguments
+ *    graph       -  Network returned by newGraph
+ *    endKey      -  Key of ending vertex
+ *    pPathKeys   -  If not NULL, used to return an array holding the
+ *                   keys along the path, source first. The caller
+ *                   should free the array but not the keys.
+ *    pPathCount  -  If not NULL, returns the number of keys in the path
+ * Returns the sum of the weights along the path, -1 if the key is
+ * invalid, -4 if the vertex is not reachable, -5 for a memory
+ * allocation error, or -6 if no source is being tracked.
+ */
+int findTrackedPath(GRAPH_HANDLE graph, char* endKey, char*** pPathKeys,
+                    int* pPathCount);
+
+
+/* Copy the work counters of the tracked tree.
+ * Arguments
+ *    graph    -  Network returned by newGraph
+ *    pStats   -  Structure to fill in
+ * Returns 1 if successful, 0 if no source is being tracked.
+ */
+int getTrackedPathStats(GRAPH_HANDLE graph, PATH_TREE_STATS_T* pStats);
+
+#endif
@@ -0,0 +1,693 @@
+/*
+ *  shortestPath.c
+ *
+ *  General single-pair shortest path engine using Dijkstra's
+ *  algorithm. See shortestPath.h for an explanation of how a network
+ *  implementation connects to the engine.
+ *
+ *  All per-vertex information (distance, parent, color) is kept in
+ *  arrays indexed by vertex index, inside the search structure,
+ *  rather than in the network's own vertex structures. The colors
+ *  are stamped with the number (epoch) of the run that set them, so
+ *  a new run starts by moving to the next epoch instead of clearing
+ *  the arrays. A query that settles a handful of vertices then costs
+ *  the same on a network of ten vertices or ten million.
+ *
+ *  Each search has its own min priority queue, so searches using
+ *  different handles can run at the same time in different threads.
+ *  The queue holds pointers to elements of the dValue
+ *  array. The compare function can then simply compare the two
+ *  integers, and we can recover the vertex index from the pointer.
+ *
+ *  The same structure also supports two variations that usually
+ *  settle far fewer vertices on large networks. The bidirectional
+ *  search grows a second tree backward from the end vertex, using
+ *  a second queue and a second set of arrays, and stops when the
+ *  two frontiers together cannot improve on the best path seen
+ *  where they meet. The A* search orders the queue by distance plus
+ *  a caller-supplied estimate of the distance still to go; its
+ *  queue holds pointers into a separate priority array.
+ *
+ *  Note this module needs to be linked with minPriorityQueue.c
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "shortestPath.h"
+#include "minPriorityQueue.h"
+
+#define WHITE 0			/* not yet discovered */
+#define GRAY  1			/* discovered, waiting in the queue */
+#define BLACK 2			/* settled - distance is final */
+#define ON_PATH 3		/* temporary mark used when joining two trees */
+#define EPOCH_STEP 4		/* more than the largest color */
+
+/* Structure holding the working storage for a search */
+typedef struct
+{
+    int capacity;		/* size of the arrays below */
+    int indexCount;		/* number of indices used by the last run */
+    int *dValue;		/* distance found so far for each vertex */
+    int *parent;		/* index of parent vertex, -1 if none */
+    unsigned int epoch;		/* mark value meaning WHITE in this run */
+    unsigned int *mark;		/* epoch plus color, see colorOf() */
+    MIN_QUEUE_HANDLE queue;	/* frontier of discovered vertices */
+    int currentIndex;		/* vertex whose edges are being relaxed */
+    int settledCount;		/* number of vertices settled in last run */
+    int *dValueB;		/* backward search: distance to the end vertex */
+    int *parentB;		/* backward search: next vertex toward the end */
+    unsigned int *markB;	/* backward search: epoch plus color */
+    MIN_QUEUE_HANDLE queueB;	/* backward search: frontier */
+    int bestDistance;		/* shortest start-to-end distance seen, or -1 */
+    int meetIndex;		/* vertex where that path crosses between trees */
+    int *priority;		/* A*: distance so far plus heuristic estimate */
+    HEURISTIC_FUNCTION_T heuristic;	/* A*: caller's estimate function */
+    void *pHeuristicData;	/* A*: passed through to the heuristic */
+} PATH_SEARCH_T;
+
+
+/* Comparison function to send to the minPriorityQueue.
+ * The items in the queue are pointers into the dValue array.
+ * Arguments
+ *   pD1     First distance (will be cast to int *)
+ *   pD2     Second distance (will be cast to int *)
+ * Returns -1 if D1 < D2, 0 if they are the same, 1 if D1 > D2.
+ */
+static int compareDistances(void *pD1, void *pD2)
+{
+    int d1 = *((int *) pD1);
+    int d2 = *((int *) pD2);
+    if (d1 < d2)
+	return -1;
+    else if (d1 > d2)
+	return 1;
+    else
+	return 0;
+}
+
+/* Grow one array to hold 'count' items of 'itemSize' bytes.
+ * Arguments
+ *   pArray   -  Address of the array pointer, updated if successful
+ *   count    -  Number of items needed
+ *   itemSize -  Size of each item
+ * Returns 1 if successful, 0 if allocation fails (the old array
+ * is left alone in that case).
+ */
+static int growArray(void **pArray, int count, size_t itemSize)
+{
+    void *newArray = realloc(*pArray, count * itemSize);
+    if (newArray == NULL)
+	return 0;
+    *pArray = newArray;
+    return 1;
+}
+
+/* Get the color of a vertex in the current run. Colors are kept
+ * as marks: the epoch of the run that set the color, plus the
+ * color. Marks left by earlier runs are less than the current
+ * epoch and read as WHITE, so a run does not need to clear the
+ * arrays before it starts.
+ * Arguments
+ *   pSearch  -  Search structure
+ *   mark     -  Mark array for the forward or backward search
+ *   index    -  Vertex we want the color of
+ * Returns WHITE, GRAY, BLACK or ON_PATH.
+ */
+static int colorOf(PATH_SEARCH_T * pSearch, unsigned int *mark, int index)
+{
+    if (mark[index] < pSearch->epoch)
+	return WHITE;
+    return (int) (mark[index] - pSearch->epoch);
+}
+
+/* Set the color of a vertex in the current run.
+ * Arguments
+ *   pSearch  -  Search structure
+ *   mark     -  Mark array for the forward or backward search
+ *   index    -  Vertex whose color we are setting
+ *   color    -  New color
+ */
+static void setColor(PATH_SEARCH_T * pSearch, unsigned int *mark,
+		     int index, int color)
+{
+    mark[index] = pSearch->epoch + color;
+}
+
+/* Start a new run, so that every vertex is WHITE. This only
+ * changes the epoch, unless the epoch is about to wrap around,
+ * in which case we clear the marks once.
+ * Argument
+ *   pSearch  -  Search structure
+ */
+static void startEpoch(PATH_SEARCH_T * pSearch)
+{
+    if (pSearch->epoch > UINT_MAX - 2 * EPOCH_STEP)
+    {
+	memset(pSearch->mark, 0, pSearch->capacity * sizeof(unsigned int));
+	memset(pSearch->markB, 0, pSearch->capacity * sizeof(unsigned int));
+	pSearch->epoch = 0;
+    }
+    pSearch->epoch += EPOCH_STEP;
+}
+
+/* Make sure the arrays can hold at least 'count' vertices.
+ * Arguments
+ *   pSearch  -  Search structure
+ *   count    -  Number of vertex indices needed
+ * Returns 1 if successful, 0 if allocation fails.
+ */
+static int ensureCapacity(PATH_SEARCH_T * pSearch, int count)
+{
+    int bOk = 1;
+    if (count > pSearch->capacity)
+    {
+	int newCapacity = (pSearch->capacity > 0) ? pSearch->capacity : 16;
+	while (newCapacity < count)
+	    newCapacity *= 2;
+	bOk = growArray((void **) &pSearch->dValue, newCapacity, sizeof(int))
+	    && growArray((void **) &pSearch->parent, newCapacity, sizeof(int))
+	    && growArray((void **) &pSearch->mark, newCapacity,
+			 sizeof(unsigned int))
+	    && growArray((void **) &pSearch->dValueB, newCapacity, sizeof(int))
+	    && growArray((void **) &pSearch->parentB, newCapacity, sizeof(int))
+	    && growArray((void **) &pSearch->markB, newCapacity,
+			 sizeof(unsigned int))
+	    && growArray((void **) &pSearch->priority, newCapacity,
+			 sizeof(int));
+	if (bOk)
+	{
+	    /* new marks must read as WHITE in every later run */
+	    int added = newCapacity - pSearch->capacity;
+	    memset(pSearch->mark + pSearch->capacity, 0,
+		   added * sizeof(unsigned int));
+	    memset(pSearch->markB + pSearch->capacity, 0,
+		   added * sizeof(unsigned int));
+	    pSearch->capacity = newCapacity;
+	}
+    }
+    return bOk;
+}
+
+/* Relax one edge leaving the current vertex. This is the
+ * function we hand to the network's edge walker.
+ * Arguments
+ *    pSearchArg -  Search structure (will be cast to PATH_SEARCH_T *)
+ *    toIndex    -  Vertex at the other end of the edge
+ *    weight     -  Weight of the edge
+ */
+static void relaxEdge(void *pSearchArg, int toIndex, int weight)
+{
+    PATH_SEARCH_T *pSearch = (PATH_SEARCH_T *) pSearchArg;
+    int fromIndex = pSearch->currentIndex;
+    int distance = pSearch->dValue[fromIndex] + weight;
+    int color = colorOf(pSearch, pSearch->mark, toIndex);
+    if (color == WHITE)
+    {
+	/* first time we have seen this vertex - add it to the frontier */
+	pSearch->dValue[toIndex] = distance;
+	pSearch->parent[toIndex] = fromIndex;
+	setColor(pSearch, pSearch->mark, toIndex, GRAY);
+	minQueueEnqueue(pSearch->queue, &pSearch->dValue[toIndex]);
+    }
+    else if ((color == GRAY) &&
+	     (distance < pSearch->dValue[toIndex]))
+    {
+	/* found a shorter path to a vertex still in the frontier */
+	pSearch->dValue[toIndex] = distance;
+	pSearch->parent[toIndex] = fromIndex;
+	minQueueDecreaseKey(pSearch->queue, &pSearch->dValue[toIndex]);
+    }
+}
+
+/* Relax one edge for either half of a bidirectional search. For the
+ * backward half, the edge really runs from toIndex to the current
+ * vertex. Whenever a vertex gets a shorter distance and the other
+ * half has already reached it, we have found a start-to-end path,
+ * which may be the best one so far.
+ * Arguments
+ *    pSearch    -  Search structure
+ *    bBackward  -  1 for the backward half, 0 for the forward half
+ *    toIndex    -  Vertex at the other end of the edge
+ *    weight     -  Weight of the edge
+ */
+static void relaxEdgeBidirectional(PATH_SEARCH_T * pSearch, int bBackward,
+				   int toIndex, int weight)
+{
+    int *dValue = bBackward ? pSearch->dValueB : pSearch->dValue;
+    int *parent = bBackward ? pSearch->parentB : pSearch->parent;
+    unsigned int *mark = bBackward ? pSearch->markB : pSearch->mark;
+    MIN_QUEUE_HANDLE queue = bBackward ? pSearch->queueB : pSearch->queue;
+    int *otherD = bBackward ? pSearch->dValue : pSearch->dValueB;
+    unsigned int *otherMark = bBackward ? pSearch->mark : pSearch->markB;
+    int distance = dValue[pSearch->currentIndex] + weight;
+    int color = colorOf(pSearch, mark, toIndex);
+    if (color == WHITE)
+    {
+	dValue[toIndex] = distance;
+	parent[toIndex] = pSearch->currentIndex;
+	setColor(pSearch, mark, toIndex, GRAY);
+	minQueueEnqueue(queue, &dValue[toIndex]);
+    }
+    else if ((color == GRAY) && (distance < dValue[toIndex]))
+    {
+	dValue[toIndex] = distance;
+	parent[toIndex] = pSearch->currentIndex;
+	minQueueDecreaseKey(queue, &dValue[toIndex]);
+    }
+    else
+	return;			/* nothing changed */
+    if (colorOf(pSearch, otherMark, toIndex) != WHITE)
+    {
+	distance = dValue[toIndex] + otherD[toIndex];
+	if ((pSearch->bestDistance < 0) || (distance < pSearch->bestDistance))
+	{
+	    pSearch->bestDistance = distance;
+	    pSearch->meetIndex = toIndex;
+	}
+    }
+}
+
+/* Relax function for the forward half of a bidirectional search */
+static void relaxForward(void *pSearchArg, int toIndex, int weight)
+{
+    relaxEdgeBidirectional((PATH_SEARCH_T *) pSearchArg, 0, toIndex, weight);
+}
+
+/* Relax function for the backward half of a bidirectional search */
+static void relaxBackward(void *pSearchArg, int toIndex, int weight)
+{
+    relaxEdgeBidirectional((PATH_SEARCH_T *) pSearchArg, 1, toIndex, weight);
+}
+
+/* Join the backward tree onto the forward tree at the meeting vertex,
+ * so that pathSearchGetPath and pathSearchDistance work as they do
+ * after an ordinary search.
+ * Arguments
+ *    pSearch    -  Search structure, after a successful search
+ */
+static void joinTrees(PATH_SEARCH_T * pSearch)
+{
+    int meet = pSearch->meetIndex;
+    int current = -1;
+    int next = -1;
+    /* With zero weight edges the backward part of the path may pass
+     * through a vertex that is already on the forward part. If so,
+     * cross over at the last such vertex instead, to avoid a loop. */
+    for (current = meet; current >= 0; current = pSearch->parent[current])
+	setColor(pSearch, pSearch->mark, current, ON_PATH);
+    for (current = meet; current >= 0; current = pSearch->parentB[current])
+    {
+	if (colorOf(pSearch, pSearch->mark, current) == ON_PATH)
+	    meet = current;
+    }
+    for (current = pSearch->meetIndex; current >= 0;
+	 current = pSearch->parent[current])
+	setColor(pSearch, pSearch->mark, current, BLACK);
+    /* now copy the rest of the path into the forward arrays */
+    current = meet;
+    next = pSearch->parentB[current];
+    while (next >= 0)
+    {
+	pSearch->parent[next] = current;
+	pSearch->dValue[next] = pSearch->bestDistance - pSearch->dValueB[next];
+	setColor(pSearch, pSearch->mark, next, BLACK);
+	current = next;
+	next = pSearch->parentB[current];
+    }
+}
+
+/* Relax one edge during an A* search. The queue is ordered by the
+ * priority array, which holds each vertex's distance plus the
+ * heuristic estimate. Since the estimate for a vertex never
+ * changes, we can keep it implicitly as priority minus distance.
+ * A settled vertex is put back into the queue if we find a shorter
+ * path to it, so the result is correct even if the heuristic
+ * is admissible but not consistent.
+ * Arguments
+ *    pSearchArg -  Search structure (will be cast to PATH_SEARCH_T *)
+ *    toIndex    -  Vertex at the other end of the edge
+ *    weight     -  Weight of the edge
+ */
+static void relaxEdgeAStar(void *pSearchArg, int toIndex, int weight)
+{
+    PATH_SEARCH_T *pSearch = (PATH_SEARCH_T *) pSearchArg;
+    int distance = pSearch->dValue[pSearch->currentIndex] + weight;
+    int color = colorOf(pSearch, pSearch->mark, toIndex);
+    if (color == WHITE)
+    {
+	pSearch->dValue[toIndex] = distance;
+	pSearch->parent[toIndex] = pSearch->currentIndex;
+	setColor(pSearch, pSearch->mark, toIndex, GRAY);
+	pSearch->priority[toIndex] = distance +
+	    (*pSearch->heuristic) (pSearch->pHeuristicData, toIndex);
+	minQueueEnqueue(pSearch->queue, &pSearch->priority[toIndex]);
+    }
+    else if (distance < pSearch->dValue[toIndex])
+    {
+	pSearch->priority[toIndex] -= pSearch->dValue[toIndex] - distance;
+	pSearch->dValue[toIndex] = distance;
+	pSearch->parent[toIndex] = pSearch->currentIndex;
+	if (color == GRAY)
+	{
+	    minQueueDecreaseKey(pSearch->queue, &pSearch->priority[toIndex]);
+	}
+	else
+	{
+	    setColor(pSearch, pSearch->mark, toIndex, GRAY);
+	    minQueueEnqueue(pSearch->queue, &pSearch->priority[toIndex]);
+	}
+    }
+}
+
+
+/********************************/
+/** Public functions start here */
+/********************************/
+
+/* Create the working storage for shortest path searches.
+ * Arguments
+ *    maxVertices  -  Initial number of vertex indices to allow for.
+ *                    The storage grows later if needed.
+ * Returns a handle to use in the other functions, or NULL
+ * if a memory allocation error occurs.
+ */
+PATH_SEARCH_HANDLE newPathSearch(int maxVertices)
+{
+    PATH_SEARCH_T *pSearch = calloc(1, sizeof(PATH_SEARCH_T));
+    if (pSearch != NULL)
+    {
+	pSearch->queue = newMinQueue(&compareDistances);
+	pSearch->queueB = newMinQueue(&compareDistances);
+    }
+    if ((pSearch != NULL) && ((pSearch->queue == NULL) ||
+			      (pSearch->queueB == NULL) ||
+			      (!ensureCapacity(pSearch, maxVertices))))
+    {
+	pathSearchDestroy(pSearch);
+	pSearch = NULL;
+    }
+    return (PATH_SEARCH_HANDLE) pSearch;
+}
+
+
+/* Free all memory associated with a search.
+ * Arguments
+ *    search   -  Handle returned by newPathSearch. Not valid
+ *                after this call.
+ */
+void pathSearchDestroy(PATH_SEARCH_HANDLE search)
+{
+    PATH_SEARCH_T *pSearch = (PATH_SEARCH_T *) search;
+    if (pSearch != NULL)
+    {
+	free(pSearch->dValue);
+	free(pSearch->parent);
+	free(pSearch->mark);
+	free(pSearch->dValueB);
+	free(pSearch->parentB);
+	free(pSearch->markB);
+	free(pSearch->priority);
+	minQueueDestroy(pSearch->queue);
+	minQueueDestroy(pSearch->queueB);
+	free(pSearch);
+    }
+}
+
+
+/* Find the lowest weight path between two vertices.
+ * Arguments
+ *    search     -  Handle returned by newPathSearch
+ *    pGraph     -  Passed through to the edge walker
+ *    walker     -  Edge walker for this network
+ *    indexCount -  Vertex indices run from 0 to indexCount-1
+ *    startIndex -  Index of start vertex
+ *    endIndex   -  Index of end vertex. If this is -1, the search
+ *                  continues until every reachable vertex is settled.
+ * Returns the total weight of the path, -1 if the end vertex is
+ * not reachable, or -2 if an index is out of range or memory
+ * allocation fails. If endIndex is -1, returns 0 once every
+ * reachable vertex has been settled.
+ */
+int pathSearchRun(PATH_SEARCH_HANDLE search, void *pGraph,
+		  EDGE_WALKER_T walker, int indexCount,
+		  int startIndex, int endIndex)
+{
+    PATH_SEARCH_T *pSearch = (PATH_SEARCH_T *) search;
+    int result = (endIndex < 0) ? 0 : -1;
+    if ((pSearch == NULL) || (startIndex < 0) || (startIndex >= indexCount)
+	|| (endIndex < -1) || (endIndex >= indexCount))
+	return -2;
+    if (!ensureCapacity(pSearch, indexCount))
+	return -2;
+    startEpoch(pSearch);
+    pSearch->indexCount = indexCount;
+    pSearch->settledCount = 0;
+    minQueueClear(pSearch->queue);
+    /* only the start vertex goes into the queue at first */
+    pSearch->dValue[startIndex] = 0;
+    pSearch->parent[startIndex] = -1;
+    setColor(pSearch, pSearch->mark, startIndex, GRAY);
+    minQueueEnqueue(pSearch->queue, &pSearch->dValue[startIndex]);
+    while (minQueueSize(pSearch->queue) > 0)
+    {
+	int *pMin = (int *) minQueueDequeue(pSearch->queue);
+	int minIndex = (int) (pMin - pSearch->dValue);
+	setColor(pSearch, pSearch->mark, minIndex, BLACK);
+	pSearch->settledCount++;
+	if (minIndex == endIndex)
+	{
+	    /* the end vertex is settled, so its distance is final */
+	    result = pSearch->dValue[minIndex];
+	    break;
+	}
+	pSearch->currentIndex = minIndex;
+	(*walker) (pGraph, minIndex, &relaxEdge, pSearch);
+    }
+    return result;
+}
+
+
+/* Find the lowest weight path between two vertices by searching
+ * forward from the start and backward from the end at the same time.
+ * Arguments
+ *    search        -  Handle returned by newPathSearch
+ *    pGraph        -  Passed through to both edge walkers
+ *    walker        -  Edge walker reporting the edges leaving a vertex
+ *    reverseWalker -  Edge walker reporting the edges entering a vertex
+ *                     (for an undirected network, the same as walker)
+ *    indexCount    -  Vertex indices run from 0 to indexCount-1
+ *    startIndex    -  Index of start vertex
+ *    endIndex      -  Index of end vertex
+ * Returns the total weight of the path, -1 if the end vertex is
+ * not reachable, or -2 if an index is out of range or memory
+ * allocation fails.
+ */
+int pathSearchRunBidirectional(PATH_SEARCH_HANDLE search, void *pGraph,
+			       EDGE_WALKER_T walker,
+			       EDGE_WALKER_T reverseWalker, int indexCount,
+			       int startIndex, int endIndex)
+{
+    PATH_SEARCH_T *pSearch = (PATH_SEARCH_T *) search;
+    if ((pSearch == NULL) || (startIndex < 0) || (startIndex >= indexCount)
+	|| (endIndex < 0) || (endIndex >= indexCount))
+	return -2;
+    if (!ensureCapacity(pSearch, indexCount))
+	return -2;
+    startEpoch(pSearch);
+    pSearch->indexCount = indexCount;
+    pSearch->settledCount = 0;
+    pSearch->bestDistance = -1;
+    minQueueClear(pSearch->queue);
+    minQueueClear(pSearch->queueB);
+    pSearch->dValue[startIndex] = 0;
+    pSearch->parent[startIndex] = -1;
+    setColor(pSearch, pSearch->mark, startIndex, GRAY);
+    minQueueEnqueue(pSearch->queue, &pSearch->dValue[startIndex]);
+    pSearch->dValueB[endIndex] = 0;
+    pSearch->parentB[endIndex] = -1;
+    setColor(pSearch, pSearch->markB, endIndex, GRAY);
+    minQueueEnqueue(pSearch->queueB, &pSearch->dValueB[endIndex]);
+    if (startIndex == endIndex)
+    {
+	pSearch->bestDistance = 0;
+	pSearch->meetIndex = startIndex;
+    }
+    /* If either queue is empty, every vertex on that side has been
+     * settled, so every possible meeting has already been seen. */
+    while ((minQueueSize(pSearch->queue) > 0) &&
+	   (minQueueSize(pSearch->queueB) > 0))
+    {
+	int topF = *((int *) minQueuePeek(pSearch->queue));
+	int topB = *((int *) minQueuePeek(pSearch->queueB));
+	int *pMin = NULL;
+	if ((pSearch->bestDistance >= 0) &&
+	    (topF + topB >= pSearch->bestDistance))
+	    break;		/* no path through the frontiers can be shorter */
+	if (topF <= topB)
+	{
+	    pMin = (int *) minQueueDequeue(pSearch->queue);
+	    pSearch->currentIndex = (int) (pMin - pSearch->dValue);
+	    setColor(pSearch, pSearch->mark, pSearch->currentIndex, BLACK);
+	    (*walker) (pGraph, pSearch->currentIndex, &relaxForward, pSearch);
+	}
+	else
+	{
+	    pMin = (int *) minQueueDequeue(pSearch->queueB);
+	    pSearch->currentIndex = (int) (pMin - pSearch->dValueB);
+	    setColor(pSearch, pSearch->markB, pSearch->currentIndex, BLACK);
+	    (*reverseWalker) (pGraph, pSearch->currentIndex,
+			      &relaxBackward, pSearch);
+	}
+	pSearch->settledCount++;
+    }
+    if (pSearch->bestDistance >= 0)
+	joinTrees(pSearch);
+    return pSearch->bestDistance;
+}
+
+
+/* Find the lowest weight path between two vertices using A* search.
+ * Arguments
+ *    search         -  Handle returned by newPathSearch
+ *    pGraph         -  Passed through to the edge walker
+ *    walker         -  Edge walker for this network
+ *    indexCount     -  Vertex indices run from 0 to indexCount-1
+ *    startIndex     -  Index of start vertex
+ *    endIndex       -  Index of end vertex
+ *    heuristic      -  Function estimating the distance from a vertex
+ *                      to the end vertex. It must never overestimate.
+ *    pHeuristicData -  Passed through to the heuristic
+ * Returns the total weight of the path, -1 if the end vertex is
+ * not reachable, or -2 if an argument is bad or memory
+ * allocation fails.
+ */
+int pathSearchRunAStar(PATH_SEARCH_HANDLE search, void *pGraph,
+		       EDGE_WALKER_T walker, int indexCount,
+		       int startIndex, int endIndex,
+		       HEURISTIC_FUNCTION_T heuristic, void *pHeuristicData)
+{
+    PATH_SEARCH_T *pSearch = (PATH_SEARCH_T *) search;
+    int result = -1;
+    if ((pSearch == NULL) || (heuristic == NULL) || (startIndex < 0)
+	|| (startIndex >= indexCount) || (endIndex < 0)
+	|| (endIndex >= indexCount))
+	return -2;
+    if (!ensureCapacity(pSearch, indexCount))
+	return -2;
+    startEpoch(pSearch);
+    pSearch->indexCount = indexCount;
+    pSearch->settledCount = 0;
+    pSearch->heuristic = heuristic;
+    pSearch->pHeuristicData = pHeuristicData;
+    minQueueClear(pSearch->queue);
+    pSearch->dValue[startIndex] = 0;
+    pSearch->parent[startIndex] = -1;
+    setColor(pSearch, pSearch->mark, startIndex, GRAY);
+    pSearch->priority[startIndex] = (*heuristic) (pHeuristicData, startIndex);
+    minQueueEnqueue(pSearch->queue, &pSearch->priority[startIndex]);
+    while (minQueueSize(pSearch->queue) > 0)
+    {
+	int *pMin = (int *) minQueueDequeue(pSearch->queue);
+	int minIndex = (int) (pMin - pSearch->priority);
+	setColor(pSearch, pSearch->mark, minIndex, BLACK);
+	pSearch->settledCount++;
+	if (minIndex == endIndex)
+	{
+	    result = pSearch->dValue[minIndex];
+	    break;
+	}
+	pSearch->currentIndex = minIndex;
+	(*walker) (pGraph, minIndex, &relaxEdgeAStar, pSearch);
+    }
+    return result;
+}
+
+
+/* Get the distance found for a vertex by the last search.
+ * Arguments
+ *    search   -  Handle used for the search
+ *    index    -  Vertex index we are interested in
+ * Returns the distance, or -1 if the vertex was not reached.
+ */
+int pathSearchDistance(PATH_SEARCH_HANDLE search, int index)
+{
+    PATH_SEARCH_T *pSearch = (PATH_SEARCH_T *) search;
+    int distance = -1;
+    if ((index >= 0) && (index < pSearch->indexCount)
+	&& (colorOf(pSearch, pSearch->mark, index) != WHITE))
+	distance = pSearch->dValue[index];
+    return distance;
+}
+
+
+/* Get the parent of a vertex in the tree found by the last search.
+ * Arguments
+ *    search   -  Handle used for the search
+ *    index    -  Vertex index we are interested in
+ * Returns the parent index, or -1 for the start vertex and
+ * for vertices that were not reached.
+ */
+int pathSearchParent(PATH_SEARCH_HANDLE search, int index)
+{
+    PATH_SEARCH_T *pSearch = (PATH_SEARCH_T *) search;
+    int parent = -1;
+    if ((index >= 0) && (index < pSearch->indexCount)
+	&& (colorOf(pSearch, pSearch->mark, index) != WHITE))
+	parent = pSearch->parent[index];
+    return parent;
+}
+
+
+/* Copy the path found by the last search into an array,
+ * in order from the start vertex to the end vertex.
+ * Arguments
+ *    search      -  Handle used for the search
+ *    endIndex    -  Last vertex in the path
+ *    pathIndices -  Array to fill in with vertex indices
+ *    maxCount    -  Size of the pathIndices array
+ * Returns the number of vertices in the path, 0 if the end vertex
+ * was not reached, or -1 if the array is too small.
+ */
+int pathSearchGetPath(PATH_SEARCH_HANDLE search, int endIndex,
+		      int *pathIndices, int maxCount)
+{
+    int pathCount = 0;
+    int current = endIndex;
+    int i = 0;
+    if (pathSearchDistance(search, endIndex) < 0)
+	return 0;
+    /* follow the parent links back to the start, filling the
+     * array from the end, then reverse it */
+    while (current >= 0)
+    {
+	if (pathCount >= maxCount)
+	    return -1;
+	pathIndices[pathCount] = current;
+	pathCount++;
+	current = pathSearchParent(search, current);
+    }
+    for (i = 0; i < pathCount / 2; i++)
+    {
+	int temp = pathIndices[i];
+	pathIndices[i] = pathIndices[pathCount - 1 - i];
+	pathIndices[pathCount - 1 - i] = temp;
+    }
+    return pathCount;
+}
+
+
+/* Find out how many vertices the last search settled (counting
+ * both halves of a bidirectional search). Useful for measuring how much work a query did.
+ */
+int pathSearchSettledCount(PATH_SEARCH_HANDLE search)
+{
+    return ((PATH_SEARCH_T *) search)->settledCount;
+}
@@ -0,0 +1,194 @@
+/**
+ *  shortestPath.h
+ *
+ *  Declarations for a general single-pair shortest path engine
+ *  (Dijkstra's algorithm) that can be used by any network
+ *  implementation.
+ *
+ *  The engine works with integer vertex indices rather than keys.
+ *  It does not know how the network is stored. Instead, the caller
+ *  supplies an "edge walker" function which, given a vertex index,
+ *  calls back into the engine once for every edge leaving that vertex.
+ *
+ *  The search is "lazy": only the start vertex is put into the
+ *  priority queue at first, other vertices are added as they are
+ *  discovered, and the search stops as soon as the end vertex
+ *  is settled. Nothing is printed; the caller asks for the distance
+ *  and the path afterwards.
+ *
+ *  All the working storage, including the priority queue, belongs to
+ *  the handle returned by newPathSearch(). Several threads can run
+ *  searches at the same time, as long as each uses its own handle
+ *  and the edge walkers only read the network.
+ *
+ *  Besides plain Dijkstra, the engine offers a bidirectional search
+ *  (which needs a second walker that reports the edges entering a
+ *  vertex) and an A* search (which needs a function estimating the
+ *  remaining distance to the end vertex). Both find the same
+ *  distances as Dijkstra but usually settle fewer vertices.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+#ifndef SHORTESTPATH_H
+#define SHORTESTPATH_H
+
+/* opaque pointer to the working storage for a search */
+typedef void* PATH_SEARCH_HANDLE;
+
+/* Function supplied by the engine. The edge walker must call it
+ * once for each edge leaving the vertex it was asked about.
+ * Arguments
+ *    pSearch   -  Pass back the pSearch value given to the walker
+ *    toIndex   -  Index of the vertex at the other end of the edge
+ *    weight    -  Weight of the edge (must not be negative)
+ */
+typedef void (*RELAX_FUNCTION_T)(void* pSearch, int toIndex, int weight);
+
+/* Function supplied by the network implementation.
+ * Arguments
+ *    pGraph    -  Whatever the network implementation needs to find
+ *                 its data (may be NULL)
+ *    fromIndex -  Index of the vertex whose edges we want
+ *    relax     -  Function to call for each edge
+ *    pSearch   -  Value to pass as the first argument to relax
+ */
+typedef void (*EDGE_WALKER_T)(void* pGraph, int fromIndex,
+                              RELAX_FUNCTION_T relax, void* pSearch);
+
+/* Function supplied by the caller of an A* search.
+ * Arguments
+ *    pHeuristicData -  Whatever the function needs (may be NULL)
+ *    index          -  Index of a vertex
+ * Returns an estimate of the distance from that vertex to the end
+ * vertex. To get correct results the estimate must never be more
+ * than the real distance (for instance, the straight line distance
+ * between two points on a map).
+ */
+typedef int (*HEURISTIC_FUNCTION_T)(void* pHeuristicData, int index);
+
+
+/* Create the working storage for shortest path searches.
+ * Arguments
+ *    maxVertices  -  Initial number of vertex indices to allow for.
+ *                    The storage grows later if needed.
+ * Returns a handle to use in the other functions, or NULL
+ * if a memory allocation error occurs.
+ */
+PATH_SEARCH_HANDLE newPathSearch(int maxVertices);
+
+
+/* Free all memory associated with a search.
+ * Arguments
+ *    search   -  Handle returned by newPathSearch. Not valid
+ *                after this call.
+ */
+void pathSearchDestroy(PATH_SEARCH_HANDLE search);
+
+
+/* Find the lowest weight path between two vertices.
+ * Arguments
+ *    search     -  Handle returned by newPathSearch
+ *    pGraph     -  Passed through to the edge walker
+ *    walker     -  Edge walker for this network
+ *    indexCount -  Vertex indices run from 0 to indexCount-1
+ *    startIndex -  Index of start vertex
+ *    endIndex   -  Index of end vertex. If this is -1, the search
+ *                  continues until every reachable vertex is settled.
+ * Returns the total weight of the path, -1 if the end vertex is
+ * not reachable, or -2 if an index is out of range or memory
+ * allocation fails. If endIndex is -1, returns 0 once every
+ * reachable vertex has been settled.
+ */
+int pathSearchRun(PATH_SEARCH_HANDLE search, void* pGraph,
+                  EDGE_WALKER_T walker, int indexCount,
+                  int startIndex, int endIndex);
+
+
+/* Find the lowest weight path between two vertices by searching
+ * forward from the start and backward from the end at the same time.
+ * Arguments
+ *    search        -  Handle returned by newPathSearch
+ *    pGraph        -  Passed through to both edge walkers
+ *    walker        -  Edge walker reporting the edges leaving a vertex
+ *    reverseWalker -  Edge walker reporting the edges entering a vertex
+ *                     (for an undirected network, the same as walker)
+ *    indexCount    -  Vertex indices run from 0 to indexCount-1
+ *    startIndex    -  Index of start vertex
+ *    endIndex      -  Index of end vertex
+ * Returns the total weight of the path, -1 if the end vertex is
+ * not reachable, or -2 if an index is out of range or memory
+ * allocation fails. Afterwards pathSearchGetPath and pathSearchDistance
+ * work for the end vertex and the vertices on its path.
+ */
+int pathSearchRunBidirectional(PATH_SEARCH_HANDLE search, void* pGraph,
+                               EDGE_WALKER_T walker,
+                               EDGE_WALKER_T reverseWalker, int indexCount,
+                               int startIndex, int endIndex);
+
+
+/* Find the lowest weight path between two vertices using A* search.
+ * Arguments
+ *    search         -  Handle returned by newPathSearch
+ *    pGraph         -  Passed through to the edge walker
+ *    walker         -  Edge walker for this network
+ *    indexCount     -  Vertex indices run from 0 to indexCount-1
+ *    startIndex     -  Index of start vertex
+ *    endIndex       -  Index of end vertex
+ *    heuristic      -  Function estimating the distance from a vertex
+ *                      to the end vertex. It must never overestimate.
+ *    pHeuristicData -  Passed through to the heuristic
+ * Returns the total weight of the path, -1 if the end vertex is
+ * not reachable, or -2 if an argument is bad or memory
+ * allocation fails.
+ */
+int pathSearchRunAStar(PATH_SEARCH_HANDLE search, void* pGraph,
+                       EDGE_WALKER_T walker, int indexCount,
+                       int startIndex, int endIndex,
+                       HEURISTIC_FUNCTION_T heuristic, void* pHeuristicData);
+
+
+/* Get the distance found for a vertex by the last search.
+ * Arguments
+ *    search   -  Handle used for the search
+ *    index    -  Vertex index we are interested in
+ * Returns the distance, or -1 if the vertex was not reached.
+ * (If the search stopped early, distances for vertices other
+ * than the end vertex may not be final.)
+ */
+int pathSearchDistance(PATH_SEARCH_HANDLE search, int index);
+
+
+/* Get the parent of a vertex in the tree found by the last search.
+ * Arguments
+ *    search   -  Handle used for the search
+ *    index    -  Vertex index we are interested in
+ * Returns the parent index, or -1 for the start vertex and
+ * for vertices that were not reached.
+ */
+int pathSearchParent(PATH_SEARCH_HANDLE search, int index);
+
+
+/* Copy the path found by the last search into an array,
+ * in order from the start vertex to the end vertex.
+ * Arguments
+ *    search      -  Handle used for the search
+ *    endIndex    -  Last vertex in the path
+ *    pathIndices -  Array to fill in with vertex indices
+ *    maxCount    -  Size of the pathIndices array
+ * Returns the number of vertices in the path, 0 if the end vertex
+ * was not reached, or -1 if the array is too small.
+ */
+int pathSearchGetPath(PATH_SEARCH_HANDLE search, int endIndex,
+                      int* pathIndices, int maxCount);
+
+
+/* Find out how many vertices the last search settled (counting
+ * both halves of a bidirectional search). Useful for measuring how much work a query did.
+ */
+int pathSearchSettledCount(PATH_SEARCH_HANDLE search);
+
+#endif
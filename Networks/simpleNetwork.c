@@ -1,10 +1,16 @@
 /*  simpleNetwork.c
  *
  *  This module implements a simple, non-general adjacency matrix-based network.
- *  It shows how to implement Dijstra's algorithm using much simpler
- *  data structures.
+ *  It shows how a general shortest path engine (shortestPath.c) can
+ *  be connected even to this very simple data structure: all we need
+ *  to supply is a function that reports the edges leaving a vertex.
  *
- *  Note this module needs to be linked with minPriorityQueue.c
+ *  Since the matrix holds every possible edge, it is also easy to
+ *  find the shortest paths between all pairs of vertices at once
+ *  (allPairs.c), after which each query is just a table lookup.
+ *
+ *  Note this module needs to be linked with shortestPath.c,
+ *  minPriorityQueue.c and allPairs.c, and with -lpthread
  *
  *  Copyright 2020 by Sally E. Goldin
  *
@@ -16,57 +22,59 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "minPriorityQueue.h"
-
-#define MAXVERT 20
-#define HUGEVALUE 99999
-#define WHITE 0
-#define BLACK 1
+#include "shortestPath.h"
+#include "allPairs.h"
 
 typedef struct
 {
     int keyValue;		/* this network uses numeric keys */
     int myIndex;		/* simplify the translation from a pointer */
     /* back to an integer index */
-    int dValue;			/* total weight so far, for Dijkstra's algo */
-    int parentIndex;		/* index in the vertices array for the vertex */
-    /* from which we reached this vertex */
-    /* Should be initialized to -1 before computation */
-    int color;			/* used for coloring the vertices during traversal */
 } VERTEX_T;
 
-/* Array of vertex structures  */
-VERTEX_T vertices[MAXVERT];
+/* Array of vertex structures, allocated once we know the size  */
+VERTEX_T *vertices = NULL;
+
+/* maximum number of vertices, chosen by the user */
+int maxVertices = 0;
 
 
 /* keep track of how many vertices we have */
 int vertexCount = 0;
 
 
-/* Matrix of edges.
- * edges[x][y] is an edge between the xth and yth vertex
+/* Matrix of edges, stored row by row in one allocation.
+ * EDGE(x,y) is an edge between the xth and yth vertex
  * in the vertices array. If the value is 0, no edge
  * exists. Otherwise the array holds the weight of the edge
  */
-int edges[MAXVERT][MAXVERT];
+int *edges = NULL;
+#define EDGE(x,y) edges[(x) * maxVertices + (y)]
+
+/* Working storage for the shortest path engine */
+PATH_SEARCH_HANDLE pathSearch = NULL;
+
+/* Distance and next hop tables for all pairs of vertices,
+ * if the user chooses to use them */
+ALL_PAIRS_HANDLE allPairs = NULL;
 
-/* comparison function for the min priority queue
- * based on current dValue.
- * Arguments 
- *   V1            first vertex
- *   V2            second vertex
- * Returns 1 if V1 > V2, -1 if V1 < V2, else 0
+/* Edge walker for the shortest path engine. Looks along
+ * one row of the matrix and reports every edge it finds.
+ * Arguments
+ *    pGraph      -  not used, since the matrix is global
+ *    fromIndex   -  index of the vertex whose edges we want
+ *    relax       -  engine function to call for each edge
+ *    pSearch     -  passed back to relax
  */
-int vertexCompare(void *V1, void *V2)
+void walkMatrixRow(void *pGraph, int fromIndex,
+		   RELAX_FUNCTION_T relax, void *pSearch)
 {
-    VERTEX_T *vertex1 = (VERTEX_T *) V1;
-    VERTEX_T *vertex2 = (VERTEX_T *) V2;
-    if (vertex1->dValue > vertex2->dValue)
-	return 1;
-    else if (vertex1->dValue < vertex2->dValue)
-	return -1;
-    else
-	return 0;
+    int i;
+    for (i = 0; i < vertexCount; i++)
+    {
+	if (EDGE(fromIndex, i) > 0)
+	    (*relax) (pSearch, i, EDGE(fromIndex, i));
+    }
 }
 
 /* Check to see if the vertices array
@@ -86,102 +94,80 @@ int findVertex(int key)
     return found;
 }
 
-/* Reinitialize all dValues, parentIndex and color
- */
-void clearVertices()
-{
-    int i;
-    for (i = 0; i < vertexCount; i++)
-    {
-	vertices[i].color = WHITE;
-	vertices[i].dValue = HUGEVALUE;
-	vertices[i].parentIndex = -1;
-    }
-}
-
-
-/* Print the path and total weight from index1 to index 2.
+/* Print the path and total weight from index1 to index 2,
+ * using the results of the last shortest path search, or
+ * the all-pairs tables if we have them.
  * Arguments
  *    index1    Index of start vertex in path
  *    index2    Index of end vertex in path.
+ *    weight    Total weight returned by the search
  */
-void printPathAndWeight(int index1, int index2)
+void printPathAndWeight(int index1, int index2, int weight)
 {
-    int pathKeys[MAXVERT];	/* save the keys along path */
+    int *pathIndices = NULL;	/* save the indices along path */
     int pathCount = 0;		/* number of vertices in the path */
-    int parent;			/* index of parent */
     int i;
-    if (vertices[index2].dValue == HUGEVALUE)
+    if (weight < 0)
     {
 	printf("Vertex '%d' is not reachable from vertex '%d'\n",
 	       vertices[index2].keyValue, vertices[index1].keyValue);
     }
     else
     {
-	printf("Min total weight of shortest path: %d\n",
-	       vertices[index2].dValue);
-	pathKeys[pathCount] = vertices[index2].keyValue;
-	pathCount++;
-	parent = vertices[index2].parentIndex;
-	while (parent >= 0)
+	printf("Min total weight of shortest path: %d\n", weight);
+	pathIndices = calloc(vertexCount, sizeof(int));
+	if (pathIndices == NULL)
 	{
-	    pathKeys[pathCount] = vertices[parent].keyValue;
-	    pathCount++;
-	    parent = vertices[parent].parentIndex;
+	    printf("Memory allocation error!\n");
+	    return;
 	}
+	if (allPairs != NULL)
+	    pathCount = allPairsGetPath(allPairs, index1, index2,
+					pathIndices, vertexCount);
+	else
+	    pathCount = pathSearchGetPath(pathSearch, index2,
+					  pathIndices, vertexCount);
 	printf("Path: \n");
-	for (i = pathCount - 1; i >= 0; i--)
+	for (i = 0; i < pathCount; i++)
 	{
-	    printf("'%d' ", pathKeys[i]);
-	    if (i > 0)
+	    printf("'%d' ", vertices[pathIndices[i]].keyValue);
+	    if (i < pathCount - 1)
 		printf(" ==> ");
 	}
 	printf("\n");
+	free(pathIndices);
     }
 }
 
 /* Find and print the shortest (minimum total weight) path
- * between two vertices using Dijkstra's algorithm.
+ * between two vertices using Dijkstra's algorithm, or by
+ * looking in the all-pairs tables if they have been computed.
  * Arguments
  *     index1     Index value (not key!) of start vertex
  *     index2     Index value of end vertex
  */
 void printShortestPath(int index1, int index2)
 {
-    VERTEX_T *currentVtx = NULL;
-    int i;
-    int currentIndex;
     int weight;
-    queueMinInit(&vertexCompare);	/* tell the queue how to do comparisons */
-    clearVertices();		/* reset dValue, color, parent */
-    vertices[index1].dValue = 0;	/* so the start vertex will dequeue first */
-    for (i = 0; i < vertexCount; i++)
+    if (allPairs != NULL)
     {
-	enqueueMin(&vertices[i]);
+	/* everything was computed already - just look it up */
+	weight = allPairsDistance(allPairs, index1, index2);
+	printPathAndWeight(index1, index2, weight);
+	return;
     }
-    while (queueMinSize() > 0)
+    if (pathSearch == NULL)
+	pathSearch = newPathSearch(vertexCount);
+    if (pathSearch == NULL)
     {
-	currentVtx = dequeueMin();
-	currentIndex = currentVtx->myIndex;
-	vertices[currentIndex].color = BLACK;
-	for (i = 0; i < vertexCount; i++)
-	{
-	    if (edges[currentIndex][i] > 0)
-	    {
-		weight = edges[currentIndex][i];
-		if ((vertices[i].color == WHITE) &&
-		    (vertices[currentIndex].dValue + weight <
-		     vertices[i].dValue))
-		{
-		    vertices[i].dValue =
-			vertices[currentIndex].dValue + weight;
-		    vertices[i].parentIndex = currentIndex;
-		}		/* end if white and shorter path */
-	    }			/* end if edge exists */
-	}			/* end loop through all possible edges */
-    }				/* end while queue still holds items */
-
-    printPathAndWeight(index1, index2);
+	printf("Memory allocation error!\n");
+    }
+    else
+    {
+	weight = pathSearchRun(pathSearch, NULL, &walkMatrixRow,
+			       vertexCount, index1, index2);
+	printPathAndWeight(index1, index2, weight);
+    }
 }
 
 
@@ -192,7 +178,21 @@ int main()
     int key1, key2;
     int startIndex, endIndex;
     int weight;
-    memset(vertices, 0, sizeof(vertices));	/* zero everything */
+    while (maxVertices <= 0)
+    {
+	printf("How many vertices do you want to allow? ");
+	if (fgets(inputline, sizeof(inputline), stdin) == NULL)
+	    exit(0);
+	sscanf(inputline, "%d", &maxVertices);
+    }
+    /* calloc zeros everything, so there are no edges yet */
+    vertices = calloc(maxVertices, sizeof(VERTEX_T));
+    edges = calloc((size_t) maxVertices * maxVertices, sizeof(int));
+    if ((vertices == NULL) || (edges == NULL))
+    {
+	printf("Memory allocation error!\n");
+	exit(1);
+    }
     printf("First let's create some vertices!\n");
     while (!bDone)
     {
@@ -201,7 +201,7 @@ int main()
 	sscanf(inputline, "%d", &key1);
 	if (key1 < 0)
 	    bDone = 1;
-	else if (vertexCount < MAXVERT)
+	else if (vertexCount < maxVertices)
 	{
 	    vertices[vertexCount].keyValue = key1;
 	    vertices[vertexCount].myIndex = vertexCount;
@@ -240,7 +240,7 @@ int main()
 		    sscanf(inputline, "%d", &weight);
 
 		    printf("Creating edge from '%d' to '%d'\n", key1, key2);
-		    edges[startIndex][endIndex] = weight;
+		    EDGE(startIndex, endIndex) = weight;
 		}
 		else
 		    printf("End vertex does not exist!\n");
@@ -251,7 +251,25 @@ int main()
     }
 
     bDone = 0;
-    printf("\nFind shortest paths using Dijstra's algorithm\n");
+    printf("\nCompute shortest paths between all pairs now (Y or N)? ");
+    fgets(inputline, sizeof(inputline), stdin);
+    if (((inputline[0] == 'Y') || (inputline[0] == 'y')) &&
+	(vertexCount > 0))
+    {
+	/* the edges will not change any more, so we only do this once */
+	allPairs = newAllPairs(vertexCount);
+	if ((allPairs == NULL) ||
+	    (!allPairsCompute(allPairs, edges, maxVertices, 0)))
+	{
+	    printf("Cannot compute all pairs - using Dijkstra instead\n");
+	    allPairsDestroy(allPairs);
+	    allPairs = NULL;
+	}
+    }
+    if (allPairs != NULL)
+	printf("\nFind shortest paths using the all-pairs tables\n");
+    else
+	printf("\nFind shortest paths using Dijstra's algorithm\n");
     while (!bDone)
     {
 	printf("Enter key for starting vertex (negative to stop): ");
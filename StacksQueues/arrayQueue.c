@@ -1,8 +1,21 @@
 /*
- *   arrayQueue.c 
+ *   arrayQueue.c
  *
  *   "Circular" array implementation of an abstract queue
  *
+ *   The items are kept in a ring buffer whose size is always a
+ *   power of two, so the position of an item is found by masking
+ *   with (capacity - 1) rather than with the % operator. When the
+ *   buffer is full it is doubled, and the items are unwrapped so
+ *   they start at the beginning of the new buffer. The buffer is
+ *   kept when the queue is emptied or cleared, so once it has grown
+ *   to the largest size needed, enqueue and dequeue never allocate.
+ *
+ *   The queue does not own the data items. queueClear() forgets
+ *   them but does not free them, so a caller can clear a queue that
+ *   still holds pointers into some other structure (such as the
+ *   nodes of a tree).
+ *
  *  Copyright 2020 by Sally E. Goldin
  *
  *  May be freely copied and modified for educational purposes
@@ -13,41 +26,73 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "abstractQueue.h"
 
-#define MAXSIZE 10
+#define INITIAL_CAPACITY 16	/* must be a power of two */
+
+/* Structure holding the queue */
+typedef struct
+{
+    void **items;		/* ring buffer of data items */
+    int capacity;		/* size of items, a power of two or 0 */
+    int head;			/* position of the front item */
+    int count;			/* number of items in the queue */
+} RING_QUEUE_T;
+
+static RING_QUEUE_T ring = { NULL, 0, 0, 0 };
 
-int headIndex = 0;
-int tailIndex = -1;
-int count = 0;
+/* Double the size of the ring buffer (or create it, if
+ * we do not have one yet), keeping the items in order.
+ * Returns 1 if successful, 0 if memory allocation fails.
+ */
+static int growRing()
+{
+    int newCapacity = (ring.capacity > 0) ?
+	ring.capacity * 2 : INITIAL_CAPACITY;
+    void **newItems = NULL;
+    int firstPart = 0;
+    if (newCapacity <= 0)	/* would overflow */
+	return 0;
+    newItems = calloc(newCapacity, sizeof(void *));
+    if (newItems == NULL)
+	return 0;
+    if (ring.count > 0)
+    {
+	/* copy the items from the head to the end of the old
+	 * buffer, then the ones that wrapped around to the start */
+	firstPart = ring.capacity - ring.head;
+	if (firstPart > ring.count)
+	    firstPart = ring.count;
+	memcpy(newItems, ring.items + ring.head, firstPart * sizeof(void *));
+	memcpy(newItems + firstPart, ring.items,
+	       (ring.count - firstPart) * sizeof(void *));
+    }
+    free(ring.items);
+    ring.items = newItems;
+    ring.capacity = newCapacity;
+    ring.head = 0;
+    return 1;
+}
 
-void *queue[MAXSIZE] = { NULL };
 
 /**
  * Add a data item to the queue (end of the list)
  * Arguments:
- *   data      -   Pointer to generic data we want to add to queue   
+ *   data      -   Pointer to generic data we want to add to queue
  * Returns 1 if successful, 0 if we have run out of space.
  */
 int enqueue(void *data)
 {
-    int bOk = 1;
-    /* If there is room */
-    if (count < MAXSIZE)
-    {
-	tailIndex = (tailIndex + 1) % MAXSIZE;
-	queue[tailIndex] = data;
-	count++;
-    }
-    else
-    {
-	bOk = 0;
-    }
-    return bOk;
+    if ((ring.count == ring.capacity) && (!growRing()))
+	return 0;
+    ring.items[(ring.head + ring.count) & (ring.capacity - 1)] = data;
+    ring.count++;
+    return 1;
 }
 
 
-/* Get the next item in the queue. This is the element 
+/* Get the next item in the queue. This is the element
  * at the front of the queue.
  * Returns the data stored at the front of the queue.
  * Also removes that item from the queue.
@@ -56,12 +101,11 @@ int enqueue(void *data)
 void *dequeue()
 {
     void *returnData = NULL;
-    if (count > 0)
+    if (ring.count > 0)
     {
-        returnData = queue[headIndex];
-        queue[headIndex] = NULL;
-        headIndex = (headIndex + 1) % MAXSIZE;
-        count--;
+	returnData = ring.items[ring.head];
+	ring.head = (ring.head + 1) & (ring.capacity - 1);
+	ring.count--;
     }
     return returnData;
 }
@@ -72,43 +116,33 @@ void *dequeue()
  */
 int queueSize()
 {
-    return count;
+    return ring.count;
 }
 
 
-/* Clear so we can reuse 
+/* Clear so we can reuse. The data items are not freed,
+ * and the buffer is kept for the next items.
  */
 void queueClear()
 {
-    int i = 0;
-    for (i = 0; i < MAXSIZE; i++)
-    {
-        if (queue[i] != NULL)
-            free(queue[i]);
-        queue[i] = NULL;
-    }
-    /* reset head, tail and count */
-    headIndex = 0;
-    tailIndex = -1;
-    count = 0;
+    ring.head = 0;
+    ring.count = 0;
 }
 
 
 /** DEBUGGING FUNCTION PRINTS SOME INFO ABOUT THE QUEUE **/
 void printDebug()
 {
-    int i, j;
-    printf("arrayQueue - MAXSIZE is %d\n", MAXSIZE);
-    printf("count = %d   headIndex=%d  tailIndex=%d\n",
-	   count, headIndex, tailIndex);
-    if (count > 0)
+    int j;
+    printf("arrayQueue - capacity is %d\n", ring.capacity);
+    printf("count = %d   head=%d\n", ring.count, ring.head);
+    if (ring.count > 0)
     {
-	   printf("Contents: \n");
-	   i = headIndex;
-	   for (j = 0; j < count; j++)
-	   {
-            printf("\t\t%s\n", (char *) queue[i]);
-            i = (i + 1) % MAXSIZE;
-	   }
+	printf("Contents: \n");
+	for (j = 0; j < ring.count; j++)
+	{
+	    printf("\t\t%s\n",
+		   (char *) ring.items[(ring.head + j) & (ring.capacity - 1)]);
+	}
     }
 }
@@ -0,0 +1,224 @@
+/*
+ *   mpmcQueue.c
+ *
+ *   Lock-free implementation of an abstract queue that any number
+ *   of producer and consumer threads can use at the same time.
+ *
+ *   This is Dmitry Vyukov's bounded queue. The items are kept in a
+ *   fixed size ring buffer, and each slot has a sequence number that
+ *   says whose turn it is to use the slot:
+ *     - equal to the position being filled: a producer may write it
+ *     - one more than that: a consumer may read it
+ *   A producer claims a position by advancing the tail with a
+ *   compare-and-swap, writes its item, then sets the sequence number
+ *   to position + 1. A consumer does the same with the head, and
+ *   then sets the sequence number to position + QUEUE_CAPACITY, the
+ *   position that the slot will be filled for next time round. So a
+ *   thread never waits for a lock, and threads only compete when
+ *   they are after the same end of the queue. Producers only fail
+ *   when the queue is full, and consumers when it is empty.
+ *
+ *   A slot's sequence number starts out equal to its own index.
+ *   Rather than needing an initialization function that every user
+ *   would have to call first, each slot stores its sequence number
+ *   minus its index, which is zero to start with, like all static
+ *   memory.
+ *
+ *   The head and the tail are on separate cache lines, so producers
+ *   and consumers do not slow each other down by sharing a line.
+ *
+ *   queueSize() gives a snapshot that may already be out of date.
+ *   queueClear() dequeues until the queue looks empty, so it is
+ *   safe to call at any time, but producers may add more items
+ *   straight away. The queue does not own the data items and never
+ *   frees them. Because dequeue() returns NULL for an empty queue,
+ *   NULL should not be enqueued.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include "abstractQueue.h"
+
+#define CACHE_LINE 64		/* bytes in a cache line */
+#define QUEUE_CAPACITY 1024	/* must be a power of two */
+
+/* One slot in the ring buffer */
+typedef struct
+{
+    atomic_ulong turn;		/* sequence number minus slot index */
+    void *data;			/* the item, if the slot is full */
+} SLOT_T;
+
+/* One end of the queue. Padded so that each end fills a cache line */
+typedef struct
+{
+    atomic_ulong position;	/* next position to use at this end */
+    char padding[CACHE_LINE - sizeof(atomic_ulong)];
+} QUEUE_END_T;
+
+static _Alignas(CACHE_LINE) QUEUE_END_T tail;	/* shared by producers */
+static _Alignas(CACHE_LINE) QUEUE_END_T head;	/* shared by consumers */
+static _Alignas(CACHE_LINE) SLOT_T slots[QUEUE_CAPACITY];
+
+
+/* Read the sequence number of the slot for a position.
+ * Arguments
+ *   index     -   Slot index (position masked)
+ * Returns the sequence number.
+ */
+static unsigned long getSequence(unsigned long index)
+{
+    return atomic_load_explicit(&slots[index].turn,
+				memory_order_acquire) + index;
+}
+
+/* Set the sequence number of a slot, handing it on to
+ * the next thread that will use it.
+ * Arguments
+ *   index     -   Slot index (position masked)
+ *   sequence  -   New sequence number
+ */
+static void setSequence(unsigned long index, unsigned long sequence)
+{
+    atomic_store_explicit(&slots[index].turn, sequence - index,
+			  memory_order_release);
+}
+
+
+/**
+ * Add a data item to the queue (end of the list)
+ * Arguments:
+ *   data      -   Pointer to generic data we want to add to queue
+ * Returns 1 if successful, 0 if we have run out of space.
+ */
+int enqueue(void *data)
+{
+    unsigned long position =
+	atomic_load_explicit(&tail.position, memory_order_relaxed);
+    unsigned long index = 0;
+    long difference = 0;
+    while (1)
+    {
+	index = position & (QUEUE_CAPACITY - 1);
+	difference = (long) (getSequence(index) - position);
+	if (difference == 0)
+	{
+	    /* the slot is free - try to claim it. If this fails,
+	     * position is set to the new tail and we try again */
+	    if (atomic_compare_exchange_weak_explicit(&tail.position,
+						      &position, position + 1,
+						      memory_order_relaxed,
+						      memory_order_relaxed))
+		break;
+	}
+	else if (difference < 0)
+	{
+	    /* still holds an item from the last time round */
+	    return 0;
+	}
+	else
+	{
+	    /* another producer got here first */
+	    position =
+		atomic_load_explicit(&tail.position, memory_order_relaxed);
+	}
+    }
+    slots[index].data = data;
+    setSequence(index, position + 1);
+    return 1;
+}
+
+
+/* Get the next item in the queue. This is the element
+ * at the front of the queue.
+ * Returns the data stored at the front of the queue.
+ * Also removes that item from the queue.
+ * Returns NULL if the queue is empty.
+ */
+void *dequeue()
+{
+    void *returnData = NULL;
+    unsigned long position =
+	atomic_load_explicit(&head.position, memory_order_relaxed);
+    unsigned long index = 0;
+    long difference = 0;
+    while (1)
+    {
+	index = position & (QUEUE_CAPACITY - 1);
+	difference = (long) (getSequence(index) - (position + 1));
+	if (difference == 0)
+	{
+	    if (atomic_compare_exchange_weak_explicit(&head.position,
+						      &position, position + 1,
+						      memory_order_relaxed,
+						      memory_order_relaxed))
+		break;
+	}
+	else if (difference < 0)
+	{
+	    /* not filled yet, so the queue is empty */
+	    return NULL;
+	}
+	else
+	{
+	    /* another consumer got here first */
+	    position =
+		atomic_load_explicit(&head.position, memory_order_relaxed);
+	}
+    }
+    returnData = slots[index].data;
+    setSequence(index, position + QUEUE_CAPACITY);
+    return returnData;
+}
+
+
+/* Find out how many items are currently in the queue.
+ * Return number of items in the queue (could be zero)
+ */
+int queueSize()
+{
+    unsigned long first = atomic_load(&head.position);
+    unsigned long last = atomic_load(&tail.position);
+    long count = (long) (last - first);
+    /* the two loads are not made at the same moment */
+    if (count < 0)
+	count = 0;
+    else if (count > QUEUE_CAPACITY)
+	count = QUEUE_CAPACITY;
+    return (int) count;
+}
+
+
+/* Clear so we can reuse. The data items are not freed.
+ */
+void queueClear()
+{
+    while (dequeue() != NULL)
+	;
+}
+
+
+/** DEBUGGING FUNCTION PRINTS SOME INFO ABOUT THE QUEUE **/
+void printDebug()
+{
+    unsigned long first = atomic_load(&head.position);
+    unsigned long last = atomic_load(&tail.position);
+    unsigned long i;
+    printf("mpmcQueue - capacity is %d\n", QUEUE_CAPACITY);
+    printf("count = %d   head=%lu  tail=%lu\n", queueSize(), first, last);
+    if (last > first)
+    {
+	printf("Contents: \n");
+	for (i = first; i < last; i++)
+	    printf("\t\t%s\n",
+		   (char *) slots[i & (QUEUE_CAPACITY - 1)].data);
+    }
+}
@@ -0,0 +1,301 @@
+/*
+ *  queueBench.c
+ *
+ *  Multithreaded stress test and throughput benchmark for the
+ *  thread-safe implementations of the abstract queue.
+ *
+ *  For each thread count, some producer threads enqueue a fixed
+ *  number of items between them while the same number of consumer
+ *  threads dequeue them. A thread that finds the queue full (or
+ *  empty) yields the processor and tries again. Each item records
+ *  which producer made it and in what order. The consumers tick off
+ *  every item they receive in an array with one flag per item, and
+ *  check that the items from any one producer reach them in the
+ *  order they were sent. Afterwards every flag must have been set
+ *  exactly once, so an item that was lost or delivered twice is
+ *  caught even if the total count comes out right. The
+ *  program then prints the number of operations (enqueues plus
+ *  dequeues) per second, in total and per thread.
+ *
+ *  Usage:  queueBench [items [maxProducers]]
+ *
+ *  The number of producers doubles from 1 up to maxProducers
+ *  (default 4). When compiled with SINGLE_PRODUCER defined, for use
+ *  with spscQueue.c, there is only ever one producer and one
+ *  consumer.
+ *
+ *  Note this module needs to be linked with a thread-safe queue
+ *  (spscQueue.c or mpmcQueue.c) and with -lpthread
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/time.h>
+#include "abstractQueue.h"
+
+#define MAX_PRODUCERS 64	/* upper limit on producer threads */
+
+/* Information shared by all the threads in one run */
+typedef struct
+{
+    int producerCount;		/* number of producers (and consumers) */
+    long perProducer;		/* items each producer sends */
+    atomic_int producersDone;	/* producers that have sent everything */
+    atomic_uchar *seen;		/* 1 for each item received, by number */
+} SHARED_T;
+
+/* Information for one thread */
+typedef struct
+{
+    SHARED_T *pShared;		/* shared by all the threads */
+    int id;			/* producer number, for producers */
+    long received;		/* items dequeued, for consumers */
+    int bError;			/* 1 if a consumer saw an item out of order,
+				 * twice or not sent at all */
+    long *lastSeen;		/* consumers: last sequence number seen
+				 * from each producer, or -1 */
+} WORKER_T;
+
+
+/* Make the item that a producer sends. It is never 0, so
+ * never looks like the NULL that means the queue is empty.
+ * Arguments
+ *   producer   -  Producer number
+ *   sequence   -  Number of items this producer sent before
+ *   count      -  Number of producers
+ * Returns the item, disguised as a pointer.
+ */
+void *makeItem(int producer, long sequence, int count)
+{
+    return (void *) (uintptr_t) (sequence * count + producer + 1);
+}
+
+
+/* Work done by each producer thread.
+ * Arguments
+ *    pArg   -  The thread's information (will be cast to WORKER_T *)
+ * Returns NULL.
+ */
+void *producerThread(void *pArg)
+{
+    WORKER_T *pWorker = (WORKER_T *) pArg;
+    SHARED_T *pShared = pWorker->pShared;
+    long i = 0;
+    for (i = 0; i < pShared->perProducer; i++)
+    {
+	void *item = makeItem(pWorker->id, i, pShared->producerCount);
+	while (!enqueue(item))
+	    sched_yield();	/* full - let a consumer run */
+    }
+    atomic_fetch_add(&pShared->producersDone, 1);
+    return NULL;
+}
+
+
+/* Work done by each consumer thread. Runs until all the
+ * producers have finished and the queue is empty.
+ * Arguments
+ *    pArg   -  The thread's information (will be cast to WORKER_T *)
+ * Returns NULL.
+ */
+void *consumerThread(void *pArg)
+{
+    WORKER_T *pWorker = (WORKER_T *) pArg;
+    SHARED_T *pShared = pWorker->pShared;
+    int count = pShared->producerCount;
+    while (1)
+    {
+	uintptr_t value = (uintptr_t) dequeue();
+	if (value == 0)
+	{
+	    /* the producers finished all their enqueues before they
+	     * said they were done, so if the queue is still empty
+	     * after that, there is nothing left for us */
+	    if (atomic_load(&pShared->producersDone) == count)
+	    {
+		value = (uintptr_t) dequeue();
+		if (value == 0)
+		    break;
+	    }
+	    else
+	    {
+		sched_yield();	/* empty - let a producer run */
+		continue;
+	    }
+	}
+	int producer = (int) ((value - 1) % count);
+	long sequence = (long) ((value - 1) / count);
+	if (sequence >= pShared->perProducer)
+	{
+	    pWorker->bError = 1;	/* no producer sent this */
+	    continue;
+	}
+	if (atomic_exchange_explicit(&pShared->seen[value - 1], 1,
+				     memory_order_relaxed) != 0)
+	    pWorker->bError = 1;	/* already received */
+	if (sequence <= pWorker->lastSeen[producer])
+	    pWorker->bError = 1;
+	pWorker->lastSeen[producer] = sequence;
+	pWorker->received++;
+    }
+    return NULL;
+}
+
+
+/* Run the benchmark once.
+ * Arguments
+ *    producerCount -  Number of producers, and of consumers
+ *    items         -  Total number of items to send
+ * Returns 1 if every item arrived exactly once and in order, 0 if not,
+ * or -1 if a memory allocation error occurs.
+ */
+int runBenchmark(int producerCount, long items)
+{
+    SHARED_T shared;
+    WORKER_T *workers = NULL;
+    pthread_t *threads = NULL;
+    struct timeval start;
+    struct timeval end;
+    double seconds = 0;
+    double opsPerSecond = 0;
+    long received = 0;
+    long total = 0;
+    int threadCount = 2 * producerCount;
+    int bOk = 1;
+    int i = 0;
+    long j = 0;
+
+    shared.producerCount = producerCount;
+    shared.perProducer = items / producerCount;
+    total = shared.perProducer * producerCount;
+    atomic_init(&shared.producersDone, 0);
+    shared.seen = calloc(total, sizeof(atomic_uchar));
+    workers = calloc(threadCount, sizeof(WORKER_T));
+    threads = calloc(threadCount, sizeof(pthread_t));
+    if ((shared.seen == NULL) || (workers == NULL) || (threads == NULL))
+    {
+	free(shared.seen);
+	free(workers);
+	free(threads);
+	return -1;
+    }
+    for (i = 0; i < threadCount; i++)
+    {
+	workers[i].pShared = &shared;
+	workers[i].id = i;
+	if (i >= producerCount)
+	{
+	    workers[i].lastSeen = calloc(producerCount, sizeof(long));
+	    if (workers[i].lastSeen == NULL)
+		bOk = -1;
+	    else
+		for (j = 0; j < producerCount; j++)
+		    workers[i].lastSeen[j] = -1;
+	}
+    }
+    if (bOk < 0)
+    {
+	for (i = 0; i < threadCount; i++)
+	    free(workers[i].lastSeen);
+	free(shared.seen);
+	free(workers);
+	free(threads);
+	return -1;
+    }
+
+    queueClear();
+    gettimeofday(&start, NULL);
+    /* start the consumers first, so the producers do not
+     * just fill the queue and wait */
+    for (i = threadCount - 1; i >= 0; i--)
+    {
+	if (pthread_create(&threads[i], NULL,
+			   (i < producerCount) ? &producerThread :
+			   &consumerThread, &workers[i]) != 0)
+	{
+	    /* we cannot tidy up threads that are waiting for work
+	     * that will never come, so give up altogether */
+	    fprintf(stderr, "Cannot start %d threads\n", threadCount);
+	    exit(1);
+	}
+    }
+    for (i = 0; i < threadCount; i++)
+	pthread_join(threads[i], NULL);
+    gettimeofday(&end, NULL);
+
+    for (i = producerCount; i < threadCount; i++)
+    {
+	received += workers[i].received;
+	if (workers[i].bError)
+	    bOk = 0;
+	free(workers[i].lastSeen);
+    }
+    if (received != total)
+	bOk = 0;
+    /* any item received twice was caught by a consumer, so
+     * now we just look for items that never came */
+    for (j = 0; (j < total) && (bOk); j++)
+    {
+	if (atomic_load_explicit(&shared.seen[j], memory_order_relaxed) == 0)
+	    bOk = 0;
+    }
+
+    seconds = (end.tv_sec - start.tv_sec) +
+	(end.tv_usec - start.tv_usec) / 1000000.0;
+    if (seconds > 0)
+	opsPerSecond = 2.0 * received / seconds;
+    printf("%9d %9d %12ld %9.3f %14.0f %14.0f   %s\n",
+	   producerCount, producerCount, received, seconds,
+	   opsPerSecond, opsPerSecond / threadCount,
+	   (bOk) ? "ok" : "ITEMS LOST, REPEATED OR OUT OF ORDER");
+    free(shared.seen);
+    free(workers);
+    free(threads);
+    return bOk;
+}
+
+
+/* Run the benchmark for each number of threads */
+int main(int argc, char *argv[])
+{
+    long items = (argc > 1) ? atol(argv[1]) : 2000000;
+    int maxProducers = (argc > 2) ? atoi(argv[2]) : 4;
+    int producerCount = 1;
+    int bAllOk = 1;
+
+#ifdef SINGLE_PRODUCER
+    maxProducers = 1;
+#endif
+    if ((items < 1) || (maxProducers < 1) || (maxProducers > MAX_PRODUCERS))
+    {
+	fprintf(stderr, "Usage: %s [items [maxProducers]]\n", argv[0]);
+	fprintf(stderr, "  (maxProducers can be at most %d)\n",
+		MAX_PRODUCERS);
+	exit(1);
+    }
+    printf("%9s %9s %12s %9s %14s %14s\n", "producers", "consumers",
+	   "items", "seconds", "ops/sec", "ops/sec/thread");
+    for (producerCount = 1; producerCount <= maxProducers;
+	 producerCount *= 2)
+    {
+	int retval = runBenchmark(producerCount, items);
+	if (retval < 0)
+	{
+	    fprintf(stderr, "Memory allocation error\n");
+	    exit(1);
+	}
+	if (retval == 0)
+	    bAllOk = 0;
+    }
+    return (bAllOk) ? 0 : 1;
+}
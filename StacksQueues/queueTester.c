@@ -61,6 +61,9 @@ int main(int arc, char *argv[])
 	    	}
 			case 3:
 	    	{
+				/* the queue does not free the strings */
+				while ((removedString = dequeue()) != NULL)
+		    		free(removedString);
 				queueClear();
 				break;
 	    	}
@@ -0,0 +1,143 @@
+/*
+ *   spscQueue.c
+ *
+ *   Lock-free implementation of an abstract queue, for handing data
+ *   from exactly one producer thread to exactly one consumer thread.
+ *
+ *   The items are kept in a fixed size ring buffer. The producer is
+ *   the only thread that changes the tail, and the consumer is the
+ *   only one that changes the head, so neither needs a lock or even
+ *   a compare-and-swap: each one publishes its own position with a
+ *   release store and reads the other's with an acquire load. The
+ *   positions count up forever and are masked to find a slot, so
+ *   tail - head is always the number of items in the queue.
+ *
+ *   The head and the tail are on separate cache lines, so the two
+ *   threads do not keep stealing the same line from each other.
+ *   Each side also remembers the last position it saw for the other
+ *   side, and only reads the other side's line again when that old
+ *   value makes the queue look full (or empty).
+ *
+ *   enqueue() may only be called by the producer, and dequeue(),
+ *   queueClear() and printDebug() only by the consumer. queueSize()
+ *   may be called by either, but the answer may be out of date by
+ *   the time it is used. The queue does not own the data items and
+ *   never frees them. Because dequeue() returns NULL for an empty
+ *   queue, NULL should not be enqueued.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include "abstractQueue.h"
+
+#define CACHE_LINE 64		/* bytes in a cache line */
+#define QUEUE_CAPACITY 1024	/* must be a power of two */
+
+/* One end of the queue. Padded so that each end fills a cache line */
+typedef struct
+{
+    atomic_ulong position;	/* next slot to use at this end */
+    unsigned long otherPosition;	/* last value seen for the other end */
+    char padding[CACHE_LINE - sizeof(atomic_ulong) - sizeof(unsigned long)];
+} QUEUE_END_T;
+
+static _Alignas(CACHE_LINE) QUEUE_END_T tail;	/* used by the producer */
+static _Alignas(CACHE_LINE) QUEUE_END_T head;	/* used by the consumer */
+static _Alignas(CACHE_LINE) void *items[QUEUE_CAPACITY];
+
+
+/**
+ * Add a data item to the queue (end of the list)
+ * Only the producer thread may call this.
+ * Arguments:
+ *   data      -   Pointer to generic data we want to add to queue
+ * Returns 1 if successful, 0 if we have run out of space.
+ */
+int enqueue(void *data)
+{
+    unsigned long position =
+	atomic_load_explicit(&tail.position, memory_order_relaxed);
+    if (position - tail.otherPosition == QUEUE_CAPACITY)
+    {
+	/* looks full, but the consumer may have moved on */
+	tail.otherPosition =
+	    atomic_load_explicit(&head.position, memory_order_acquire);
+	if (position - tail.otherPosition == QUEUE_CAPACITY)
+	    return 0;
+    }
+    items[position & (QUEUE_CAPACITY - 1)] = data;
+    atomic_store_explicit(&tail.position, position + 1, memory_order_release);
+    return 1;
+}
+
+
+/* Get the next item in the queue. This is the element
+ * at the front of the queue. Only the consumer thread
+ * may call this.
+ * Returns the data stored at the front of the queue.
+ * Also removes that item from the queue.
+ * Returns NULL if the queue is empty.
+ */
+void *dequeue()
+{
+    void *returnData = NULL;
+    unsigned long position =
+	atomic_load_explicit(&head.position, memory_order_relaxed);
+    if (position == head.otherPosition)
+    {
+	/* looks empty, but the producer may have added more */
+	head.otherPosition =
+	    atomic_load_explicit(&tail.position, memory_order_acquire);
+	if (position == head.otherPosition)
+	    return NULL;
+    }
+    returnData = items[position & (QUEUE_CAPACITY - 1)];
+    atomic_store_explicit(&head.position, position + 1, memory_order_release);
+    return returnData;
+}
+
+
+/* Find out how many items are currently in the queue.
+ * Return number of items in the queue (could be zero)
+ */
+int queueSize()
+{
+    unsigned long first = atomic_load(&head.position);
+    unsigned long last = atomic_load(&tail.position);
+    return (int) (last - first);
+}
+
+
+/* Clear so we can reuse. Only the consumer thread may call
+ * this. The data items are not freed.
+ */
+void queueClear()
+{
+    head.otherPosition = atomic_load(&tail.position);
+    atomic_store(&head.position, head.otherPosition);
+}
+
+
+/** DEBUGGING FUNCTION PRINTS SOME INFO ABOUT THE QUEUE **/
+void printDebug()
+{
+    unsigned long first = atomic_load(&head.position);
+    unsigned long last = atomic_load(&tail.position);
+    unsigned long i;
+    printf("spscQueue - capacity is %d\n", QUEUE_CAPACITY);
+    printf("count = %lu   head=%lu  tail=%lu\n", last - first, first, last);
+    if (last > first)
+    {
+	printf("Contents: \n");
+	for (i = first; i < last; i++)
+	    printf("\t\t%s\n", (char *) items[i & (QUEUE_CAPACITY - 1)]);
+    }
+}
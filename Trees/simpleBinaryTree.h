@@ -94,4 +94,12 @@ void printLeafData(TREE_T * pTree);
  */ 
 int maxTreeDepth(TREE_T * pTree);
 
+/* Traverse a tree (in order traversal) and execute the
+ * function 'nodeFunction' on each element
+ * Arguments
+ *    pCurrent     -   current node (not NULL)
+ *    nodeFunction -   function to execute on each node
+ */
+void traverseInOrder(NODE_T * pCurrent, void (*nodeFunction)(NODE_T * pNode));
+
 #endif
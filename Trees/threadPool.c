@@ -0,0 +1,409 @@
+/*
+ *  threadPool.c
+ *
+ *  Fixed size pool of worker threads that share out tasks by
+ *  work stealing. See threadPool.h.
+ *
+ *  The pool counts the tasks that have been submitted but have not
+ *  finished. A task is counted before it is queued and uncounted
+ *  only after it has run, so while any task is running the count
+ *  cannot reach zero, even if every deque is momentarily empty.
+ *  A worker that finds nothing to do keeps looking for a while
+ *  (giving up the processor between tries), since a running task may
+ *  be about to submit more. If it still finds nothing after
+ *  MAX_FAILED_TRIES tries, or the count is zero, it sleeps on a
+ *  condition variable, so one long task does not keep the other
+ *  workers busy doing nothing.
+ *
+ *  Every submission adds one to a signal counter. A worker reads the
+ *  counter before it looks for work, and only goes to sleep if the
+ *  counter has not changed since, checking while it holds the pool's
+ *  lock. A submitter adds to the counter first and then looks at the
+ *  number of sleeping workers, which workers change only while
+ *  holding the lock. So either the worker sees the new signal and looks
+ *  again, or the submitter sees the sleeper and takes the lock to
+ *  wake it, which it cannot do until the worker is really waiting.
+ *  No wakeup is lost. Workers submitting tasks only take the lock
+ *  when someone is asleep.
+ *
+ *  Tasks submitted from outside the pool go on a list protected by
+ *  the lock. The workers check an atomic copy of the list's length
+ *  first, so they only take the lock when there is something there.
+ *
+ *  Note this module needs to be linked with workDeque.c and with
+ *  -lpthread
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include "workDeque.h"
+#include "threadPool.h"
+
+#define DEQUE_CAPACITY 256	/* starting size of each worker's deque */
+#define MAX_FAILED_TRIES 64	/* times an idle worker looks for a task
+				 * before it goes to sleep */
+
+/* One task waiting to run */
+typedef struct
+{
+    void (*function) (void *);	/* function to call */
+    void *arg;			/* argument to pass it */
+} TASK_T;
+
+struct _pool;
+
+/* Information for one worker thread */
+typedef struct
+{
+    struct _pool *pPool;	/* pool the worker belongs to */
+    int id;			/* index in the pool's worker array */
+    WORK_DEQUE_HANDLE deque;	/* tasks submitted by this worker */
+    unsigned int seed;		/* for choosing who to steal from */
+    pthread_t thread;		/* the thread itself */
+} WORKER_T;
+
+typedef struct _pool
+{
+    int threadCount;		/* number of workers */
+    int startedCount;		/* number of worker threads started */
+    WORKER_T *workers;		/* array of workers */
+    atomic_long pending;	/* tasks submitted and not finished */
+    atomic_int bStop;		/* set to 1 to make the workers exit */
+    atomic_ulong signals;	/* one added for each task submitted */
+    atomic_int sleeping;	/* workers waiting on workCond; only
+				 * changed while holding lock */
+    pthread_mutex_t lock;	/* protects the submitted list and
+				 * the sleeping workers */
+    pthread_cond_t workCond;	/* signalled when a task is submitted
+				 * and a worker is asleep, or at shutdown */
+    pthread_cond_t doneCond;	/* signalled when pending reaches 0 */
+    TASK_T **submitted;		/* tasks submitted from outside */
+    int submittedCapacity;	/* allocated size of submitted */
+    atomic_int submittedCount;	/* number of tasks in submitted */
+} POOL_T;
+
+/* The worker that is running on this thread, or NULL if
+ * this thread is not one of a pool's workers */
+static _Thread_local WORKER_T *currentWorker = NULL;
+
+
+/* Take a task from the list of those submitted from outside.
+ * Argument
+ *    pPool      -  Pool
+ * Returns the task, or NULL if the list is empty.
+ */
+static TASK_T *takeSubmitted(POOL_T * pPool)
+{
+    TASK_T *pTask = NULL;
+    int count = 0;
+    if (atomic_load(&pPool->submittedCount) == 0)
+	return NULL;
+    pthread_mutex_lock(&pPool->lock);
+    count = atomic_load(&pPool->submittedCount);
+    if (count > 0)
+    {
+	pTask = pPool->submitted[count - 1];
+	atomic_store(&pPool->submittedCount, count - 1);
+    }
+    pthread_mutex_unlock(&pPool->lock);
+    return pTask;
+}
+
+/* Try to steal a task from each of the other workers in turn,
+ * starting with a random one.
+ * Argument
+ *    pWorker    -  Worker that is looking for a task
+ * Returns the task, or NULL if there was nothing to steal.
+ */
+static TASK_T *stealTask(WORKER_T * pWorker)
+{
+    POOL_T *pPool = pWorker->pPool;
+    int count = pPool->threadCount;
+    int start = rand_r(&pWorker->seed) % count;
+    int i = 0;
+    for (i = 0; i < count; i++)
+    {
+	WORKER_T *pVictim = &pPool->workers[(start + i) % count];
+	if (pVictim != pWorker)
+	{
+	    TASK_T *pTask = workDequeSteal(pVictim->deque);
+	    if (pTask != NULL)
+		return pTask;
+	}
+    }
+    return NULL;
+}
+
+/* Run a task, free it and count it as finished.
+ * Arguments
+ *    pPool      -  Pool
+ *    pTask      -  Task to run
+ */
+static void runTask(POOL_T * pPool, TASK_T * pTask)
+{
+    (*pTask->function) (pTask->arg);
+    free(pTask);
+    if (atomic_fetch_sub(&pPool->pending, 1) == 1)
+    {
+	/* that was the last one - tell anyone who is waiting */
+	pthread_mutex_lock(&pPool->lock);
+	pthread_cond_broadcast(&pPool->doneCond);
+	pthread_mutex_unlock(&pPool->lock);
+    }
+}
+
+/* Work done by each worker thread. Runs tasks until the
+ * pool is stopped.
+ * Argument
+ *    pArg   -  The worker's information (will be cast to WORKER_T *)
+ * Returns NULL.
+ */
+static void *workerThread(void *pArg)
+{
+    WORKER_T *pWorker = (WORKER_T *) pArg;
+    POOL_T *pPool = pWorker->pPool;
+    TASK_T *pTask = NULL;
+    unsigned long seen = 0;	/* signal count before we last looked */
+    int failedTries = 0;
+    int bStop = 0;
+    currentWorker = pWorker;
+    while (!bStop)
+    {
+	seen = atomic_load(&pPool->signals);
+	pTask = workDequePop(pWorker->deque);
+	if (pTask == NULL)
+	    pTask = takeSubmitted(pPool);
+	if (pTask == NULL)
+	    pTask = stealTask(pWorker);
+	if (pTask != NULL)
+	{
+	    runTask(pPool, pTask);
+	    failedTries = 0;
+	    continue;
+	}
+	failedTries++;
+	if ((failedTries < MAX_FAILED_TRIES) &&
+	    (atomic_load(&pPool->pending) > 0))
+	{
+	    sched_yield();	/* another worker has the work for now */
+	    continue;
+	}
+	/* nothing to do - sleep until a new task is submitted */
+	pthread_mutex_lock(&pPool->lock);
+	atomic_fetch_add(&pPool->sleeping, 1);
+	while ((atomic_load(&pPool->signals) == seen) &&
+	       (!atomic_load(&pPool->bStop)))
+	    pthread_cond_wait(&pPool->workCond, &pPool->lock);
+	atomic_fetch_sub(&pPool->sleeping, 1);
+	bStop = atomic_load(&pPool->bStop);
+	pthread_mutex_unlock(&pPool->lock);
+	failedTries = 0;
+    }
+    currentWorker = NULL;
+    return NULL;
+}
+
+
+/** Public functions start here **/
+
+/* Create a pool and start its threads.
+ * Argument
+ *    threadCount  -  Number of worker threads (at least 1)
+ * Returns a handle for the pool, or NULL if a memory allocation
+ * error occurs or the threads cannot be started.
+ */
+THREAD_POOL_HANDLE newThreadPool(int threadCount)
+{
+    POOL_T *pPool = NULL;
+    int started = 0;
+    int i = 0;
+    if (threadCount < 1)
+	return NULL;
+    pPool = calloc(1, sizeof(POOL_T));
+    if (pPool == NULL)
+	return NULL;
+    pPool->threadCount = threadCount;
+    atomic_init(&pPool->pending, 0);
+    atomic_init(&pPool->bStop, 0);
+    atomic_init(&pPool->signals, 0);
+    atomic_init(&pPool->sleeping, 0);
+    atomic_init(&pPool->submittedCount, 0);
+    pthread_mutex_init(&pPool->lock, NULL);
+    pthread_cond_init(&pPool->workCond, NULL);
+    pthread_cond_init(&pPool->doneCond, NULL);
+    pPool->workers = calloc(threadCount, sizeof(WORKER_T));
+    if (pPool->workers != NULL)
+    {
+	for (i = 0; i < threadCount; i++)
+	{
+	    pPool->workers[i].pPool = pPool;
+	    pPool->workers[i].id = i;
+	    pPool->workers[i].seed = i + 1;
+	    pPool->workers[i].deque = newWorkDeque(DEQUE_CAPACITY);
+	    if (pPool->workers[i].deque == NULL)
+		break;
+	}
+	/* only start the threads if all the deques were created */
+	if (i == threadCount)
+	{
+	    for (started = 0; started < threadCount; started++)
+	    {
+		if (pthread_create(&pPool->workers[started].thread, NULL,
+				   &workerThread,
+				   &pPool->workers[started]) != 0)
+		    break;
+	    }
+	}
+    }
+    pPool->startedCount = started;
+    if (started < threadCount)
+    {
+	/* stop the threads we did start, then free everything */
+	threadPoolDestroy(pPool);
+	pPool = NULL;
+    }
+    return (THREAD_POOL_HANDLE) pPool;
+}
+
+
+/* Submit a task to run in the pool. This may be called by any
+ * thread, including the pool's own tasks.
+ * Arguments
+ *    pool       -  Pool returned by newThreadPool
+ *    function   -  Function to run
+ *    arg        -  Argument to pass to the function
+ * Returns 1 if successful, 0 if a memory allocation error occurs.
+ */
+int threadPoolSubmit(THREAD_POOL_HANDLE pool, void (*function) (void *),
+		     void *arg)
+{
+    POOL_T *pPool = (POOL_T *) pool;
+    TASK_T *pTask = malloc(sizeof(TASK_T));
+    int bOk = 1;
+    if (pTask == NULL)
+	return 0;
+    pTask->function = function;
+    pTask->arg = arg;
+    if ((currentWorker != NULL) && (currentWorker->pPool == pPool))
+    {
+	/* our own task is still running, so this cannot
+	 * be the change from no pending tasks to one */
+	atomic_fetch_add(&pPool->pending, 1);
+	if (!workDequePush(currentWorker->deque, pTask))
+	{
+	    atomic_fetch_sub(&pPool->pending, 1);
+	    bOk = 0;
+	}
+	else
+	{
+	    /* signal first, then check for sleepers; see the top */
+	    atomic_fetch_add(&pPool->signals, 1);
+	    if (atomic_load(&pPool->sleeping) > 0)
+	    {
+		pthread_mutex_lock(&pPool->lock);
+		pthread_cond_signal(&pPool->workCond);
+		pthread_mutex_unlock(&pPool->lock);
+	    }
+	}
+    }
+    else
+    {
+	pthread_mutex_lock(&pPool->lock);
+	int count = atomic_load(&pPool->submittedCount);
+	if (count == pPool->submittedCapacity)
+	{
+	    int newCapacity = (count > 0) ? count * 2 : 16;
+	    TASK_T **newList = realloc(pPool->submitted,
+				       newCapacity * sizeof(TASK_T *));
+	    if (newList == NULL)
+	    {
+		bOk = 0;
+	    }
+	    else
+	    {
+		pPool->submitted = newList;
+		pPool->submittedCapacity = newCapacity;
+	    }
+	}
+	if (bOk)
+	{
+	    pPool->submitted[count] = pTask;
+	    atomic_fetch_add(&pPool->pending, 1);
+	    atomic_store(&pPool->submittedCount, count + 1);
+	    atomic_fetch_add(&pPool->signals, 1);
+	    pthread_cond_broadcast(&pPool->workCond);
+	}
+	pthread_mutex_unlock(&pPool->lock);
+    }
+    if (!bOk)
+	free(pTask);
+    return bOk;
+}
+
+
+/* Wait until every task submitted to the pool has finished,
+ * including the tasks they submitted. Must not be called by
+ * one of the pool's own tasks.
+ * Argument
+ *    pool       -  Pool returned by newThreadPool
+ */
+void threadPoolWait(THREAD_POOL_HANDLE pool)
+{
+    POOL_T *pPool = (POOL_T *) pool;
+    pthread_mutex_lock(&pPool->lock);
+    while (atomic_load(&pPool->pending) > 0)
+	pthread_cond_wait(&pPool->doneCond, &pPool->lock);
+    pthread_mutex_unlock(&pPool->lock);
+}
+
+
+/* Get the number of worker threads in a pool.
+ * Argument
+ *    pool       -  Pool returned by newThreadPool
+ * Returns the number of threads.
+ */
+int threadPoolSize(THREAD_POOL_HANDLE pool)
+{
+    return ((POOL_T *) pool)->threadCount;
+}
+
+
+/* Wait for all the tasks to finish, then stop the threads and
+ * free the pool. Must not be called by one of the pool's tasks.
+ * Argument
+ *    pool       -  Pool to free, or NULL. Not valid after this call.
+ */
+void threadPoolDestroy(THREAD_POOL_HANDLE pool)
+{
+    POOL_T *pPool = (POOL_T *) pool;
+    int i = 0;
+    if (pPool == NULL)
+	return;
+    threadPoolWait(pPool);
+    pthread_mutex_lock(&pPool->lock);
+    atomic_store(&pPool->bStop, 1);
+    pthread_cond_broadcast(&pPool->workCond);
+    pthread_mutex_unlock(&pPool->lock);
+    for (i = 0; i < pPool->startedCount; i++)
+	pthread_join(pPool->workers[i].thread, NULL);
+    if (pPool->workers != NULL)
+    {
+	for (i = 0; i < pPool->threadCount; i++)
+	    workDequeDestroy(pPool->workers[i].deque);
+    }
+    free(pPool->workers);
+    free(pPool->submitted);
+    pthread_cond_destroy(&pPool->doneCond);
+    pthread_cond_destroy(&pPool->workCond);
+    pthread_mutex_destroy(&pPool->lock);
+    free(pPool);
+}
@@ -0,0 +1,74 @@
+/*
+ *  threadPool.h
+ *
+ *  Declarations for a fixed size pool of worker threads that run
+ *  tasks submitted to it. A task is a function and an argument to
+ *  pass to it. Tasks may submit more tasks, so a recursive job such
+ *  as a tree traversal can be split into a task for each subtree.
+ *
+ *  Each worker keeps its own work-stealing deque (see workDeque.h).
+ *  A task submitted by a worker goes on that worker's deque, and the
+ *  worker runs the newest task on its deque first, which keeps
+ *  related work on one processor. A worker whose deque is empty
+ *  takes a task submitted from outside the pool, or steals the
+ *  oldest task from another worker. The oldest tasks are usually the
+ *  biggest ones, so steals are rare.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+/* opaque pointer to a thread pool */
+typedef void *THREAD_POOL_HANDLE;
+
+/* Create a pool and start its threads.
+ * Argument
+ *    threadCount  -  Number of worker threads (at least 1)
+ * Returns a handle for the pool, or NULL if a memory allocation
+ * error occurs or the threads cannot be started.
+ */
+THREAD_POOL_HANDLE newThreadPool(int threadCount);
+
+
+/* Submit a task to run in the pool. This may be called by any
+ * thread, including the pool's own tasks.
+ * Arguments
+ *    pool       -  Pool returned by newThreadPool
+ *    function   -  Function to run
+ *    arg        -  Argument to pass to the function
+ * Returns 1 if successful, 0 if a memory allocation error occurs.
+ */
+int threadPoolSubmit(THREAD_POOL_HANDLE pool, void (*function) (void *),
+		     void *arg);
+
+
+/* Wait until every task submitted to the pool has finished,
+ * including the tasks they submitted. Must not be called by
+ * one of the pool's own tasks.
+ * Argument
+ *    pool       -  Pool returned by newThreadPool
+ */
+void threadPoolWait(THREAD_POOL_HANDLE pool);
+
+
+/* Get the number of worker threads in a pool.
+ * Argument
+ *    pool       -  Pool returned by newThreadPool
+ * Returns the number of threads.
+ */
+int threadPoolSize(THREAD_POOL_HANDLE pool);
+
+
+/* Wait for all the tasks to finish, then stop the threads and
+ * free the pool. Must not be called by one of the pool's tasks.
+ * Argument
+ *    pool       -  Pool to free, or NULL. Not valid after this call.
+ */
+void threadPoolDestroy(THREAD_POOL_HANDLE pool);
+
+#endif
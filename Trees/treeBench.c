@@ -0,0 +1,276 @@
+/*
+ *  treeBench.c
+ *
+ *  Benchmark comparing a serial in order traversal of a large
+ *  binary tree with a parallel one that runs on the work-stealing
+ *  thread pool in threadPool.c.
+ *
+ *  The program builds a tree with the same shape that insertItem()
+ *  in simpleBinaryTree.c gives (filled level by level, left to
+ *  right). It builds it directly, since insertItem() searches from
+ *  the root for every new node. The work done at each node is to
+ *  hash the node's data a number of times; the hashes of all the
+ *  nodes are added up, so we can check that the parallel traversal
+ *  visited every node exactly once.
+ *
+ *  The parallel traversal starts with one task for the root. A task
+ *  for a big subtree processes its own node and submits one task for
+ *  each child. A task for a small subtree just calls
+ *  traverseInOrder() on it, as the serial version does for the whole
+ *  tree. The nodes are therefore not visited in order, which does not
+ *  matter for a sum.
+ *
+ *  For each number of threads, the program prints the time taken and
+ *  the speedup compared with the serial traversal.
+ *
+ *  Usage:  treeBench [nodes [maxThreads [hashesPerNode]]]
+ *
+ *  Note this module needs to be linked with simpleBinaryTree.c,
+ *  threadPool.c, workDeque.c and a queue module, and with -lpthread
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <sys/time.h>
+#include "simpleBinaryTree.h"
+#include "threadPool.h"
+
+#define SERIAL_HEIGHT 10	/* subtrees this high or lower are
+				 * traversed by a single task */
+#define MAX_THREADS 64		/* upper limit on threads */
+
+/* Information shared by all the tasks of one traversal */
+typedef struct
+{
+    THREAD_POOL_HANDLE pool;	/* pool running the tasks */
+    atomic_ulong hashSum;	/* total of the node hashes */
+    atomic_int bFailed;		/* 1 if a task could not be submitted */
+} TRAVERSAL_T;
+
+/* One task: a subtree to traverse */
+typedef struct
+{
+    TRAVERSAL_T *pTraversal;	/* traversal the task is part of */
+    NODE_T *pNode;		/* root of the subtree */
+} SUBTREE_T;
+
+static int hashesPerNode = 20;	/* work done at each node */
+
+/* Total of the hashes of the nodes visited by this thread */
+static _Thread_local unsigned long threadHashSum = 0;
+
+
+/* Get the time in seconds */
+double now()
+{
+    struct timeval time;
+    gettimeofday(&time, NULL);
+    return time.tv_sec + time.tv_usec / 1000000.0;
+}
+
+
+/* Build a subtree with the shape given by insertItem(). Node i
+ * of the tree has children 2i+1 and 2i+2, and its data is i as
+ * a string.
+ * Arguments
+ *    index    -  Number of the node at the root of the subtree
+ *    count    -  Number of nodes in the whole tree
+ * Returns the root of the subtree, or NULL if index is past the
+ * end of the tree. Exits if memory allocation fails.
+ */
+NODE_T *buildSubtree(long index, long count)
+{
+    NODE_T *pNode = NULL;
+    char data[32];
+    if (index >= count)
+	return NULL;
+    pNode = calloc(1, sizeof(NODE_T));
+    sprintf(data, "%ld", index);
+    if ((pNode == NULL) || ((pNode->data = strdup(data)) == NULL))
+    {
+	fprintf(stderr, "Memory allocation error building the tree\n");
+	exit(1);
+    }
+    pNode->count = 1;
+    pNode->left = buildSubtree(2 * index + 1, count);
+    pNode->right = buildSubtree(2 * index + 2, count);
+    return pNode;
+}
+
+
+/* Work done at each node: hash its data (FNV-1a) several times
+ * and add the result to this thread's total.
+ * Argument
+ *    pNode   -  Node to process
+ */
+void hashNode(NODE_T *pNode)
+{
+    unsigned long hash = 14695981039346656037UL;
+    int i = 0;
+    char *pChar = NULL;
+    for (i = 0; i < hashesPerNode; i++)
+    {
+	for (pChar = pNode->data; *pChar != '\0'; pChar++)
+	{
+	    hash ^= (unsigned char) *pChar;
+	    hash *= 1099511628211UL;
+	}
+    }
+    threadHashSum += hash;
+}
+
+
+/* Find the height of a subtree. Since the tree is filled level by
+ * level, this is the length of the path down the left edge.
+ * Argument
+ *    pNode   -  Root of the subtree
+ * Returns the number of levels.
+ */
+int subtreeHeight(NODE_T *pNode)
+{
+    int height = 0;
+    for (; pNode != NULL; pNode = pNode->left)
+	height++;
+    return height;
+}
+
+
+/* Submit a task to traverse a subtree, unless it is empty.
+ * Arguments
+ *    pTraversal  -  Traversal the task is part of
+ *    pNode       -  Root of the subtree, or NULL
+ */
+void submitSubtree(TRAVERSAL_T *pTraversal, NODE_T *pNode);
+
+/* Task that traverses a subtree. Small subtrees are traversed
+ * with traverseInOrder(); big ones are split into a task for
+ * each child.
+ * Argument
+ *    pArg    -  The subtree (will be cast to SUBTREE_T *, and freed)
+ */
+void traverseTask(void *pArg)
+{
+    SUBTREE_T *pSubtree = (SUBTREE_T *) pArg;
+    TRAVERSAL_T *pTraversal = pSubtree->pTraversal;
+    NODE_T *pNode = pSubtree->pNode;
+    free(pSubtree);
+    threadHashSum = 0;
+    if (subtreeHeight(pNode) <= SERIAL_HEIGHT)
+    {
+	traverseInOrder(pNode, &hashNode);
+    }
+    else
+    {
+	submitSubtree(pTraversal, pNode->left);
+	submitSubtree(pTraversal, pNode->right);
+	hashNode(pNode);
+    }
+    atomic_fetch_add(&pTraversal->hashSum, threadHashSum);
+}
+
+void submitSubtree(TRAVERSAL_T *pTraversal, NODE_T *pNode)
+{
+    SUBTREE_T *pSubtree = NULL;
+    if (pNode == NULL)
+	return;
+    pSubtree = malloc(sizeof(SUBTREE_T));
+    if (pSubtree != NULL)
+    {
+	pSubtree->pTraversal = pTraversal;
+	pSubtree->pNode = pNode;
+	if (threadPoolSubmit(pTraversal->pool, &traverseTask, pSubtree))
+	    return;
+	free(pSubtree);
+    }
+    atomic_store(&pTraversal->bFailed, 1);
+}
+
+
+/* Build the tree, then time the serial and parallel traversals */
+int main(int argc, char *argv[])
+{
+    long nodeCount = (argc > 1) ? atol(argv[1]) : 1000000;
+    int maxThreads = (argc > 2) ? atoi(argv[2]) : 4;
+    TREE_T *pTree = NULL;
+    TRAVERSAL_T traversal;
+    unsigned long serialSum = 0;
+    double serialTime = 0;
+    double start = 0;
+    double seconds = 0;
+    int threadCount = 0;
+    int bAllOk = 1;
+
+    if (argc > 3)
+	hashesPerNode = atoi(argv[3]);
+    if ((nodeCount < 1) || (maxThreads < 1) || (maxThreads > MAX_THREADS)
+	|| (hashesPerNode < 1))
+    {
+	fprintf(stderr, "Usage: %s [nodes [maxThreads [hashesPerNode]]]\n",
+		argv[0]);
+	fprintf(stderr, "  (maxThreads can be at most %d)\n", MAX_THREADS);
+	exit(1);
+    }
+    pTree = createTree();
+    if (pTree == NULL)
+    {
+	fprintf(stderr, "Memory allocation error creating the tree\n");
+	exit(1);
+    }
+    pTree->root = buildSubtree(0, nodeCount);
+    pTree->itemcount = nodeCount;
+    printf("Tree has %ld nodes and %d levels, %d hashes per node\n",
+	   nodeCount, subtreeHeight(pTree->root), hashesPerNode);
+
+    threadHashSum = 0;
+    start = now();
+    traverseInOrder(pTree->root, &hashNode);
+    serialTime = now() - start;
+    serialSum = threadHashSum;
+    printf("%8s %10s %8s\n", "threads", "seconds", "speedup");
+    printf("%8s %10.4f %8s\n", "serial", serialTime, "1.00");
+
+    for (threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+	traversal.pool = newThreadPool(threadCount);
+	if (traversal.pool == NULL)
+	{
+	    fprintf(stderr, "Cannot start a pool of %d threads\n",
+		    threadCount);
+	    exit(1);
+	}
+	atomic_init(&traversal.hashSum, 0);
+	atomic_init(&traversal.bFailed, 0);
+	start = now();
+	submitSubtree(&traversal, pTree->root);
+	threadPoolWait(traversal.pool);
+	seconds = now() - start;
+	threadPoolDestroy(traversal.pool);
+	if (atomic_load(&traversal.bFailed))
+	{
+	    printf("%8d  memory allocation error submitting tasks\n",
+		   threadCount);
+	    bAllOk = 0;
+	}
+	else if (atomic_load(&traversal.hashSum) != serialSum)
+	{
+	    printf("%8d  WRONG RESULT - nodes missed or visited twice\n",
+		   threadCount);
+	    bAllOk = 0;
+	}
+	else
+	{
+	    printf("%8d %10.4f %8.2f\n", threadCount, seconds,
+		   (seconds > 0) ? serialTime / seconds : 0.0);
+	}
+    }
+    freeTree(pTree);
+    return (bAllOk) ? 0 : 1;
+}
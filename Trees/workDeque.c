@@ -0,0 +1,286 @@
+/*
+ *  workDeque.c
+ *
+ *  Chase-Lev work-stealing deque. See workDeque.h.
+ *
+ *  The items are kept in a ring buffer. 'bottom' is where the owner
+ *  pushes the next item and 'top' is the next item a thief would
+ *  take; both only ever count up, and are masked to find a slot.
+ *  The owner is the only thread that changes 'bottom'. Thieves
+ *  advance 'top' with a compare-and-swap, and so does the owner when
+ *  it pops the last item, so exactly one thread gets that item.
+ *
+ *  The memory orderings follow Le, Pop, Cohen and Zappa Nardelli,
+ *  "Correct and Efficient Work-Stealing for Weak Memory Models"
+ *  (PPoPP 2013), except that workDequePush() publishes the new
+ *  bottom with a release store instead of a release fence followed
+ *  by a relaxed store, which comes to the same thing. The full
+ *  fences in workDequePop() and workDequeSteal() make sure that the
+ *  owner and a thief cannot both think they have the last item.
+ *
+ *  When the ring is full the owner copies the items to one twice
+ *  the size. A thief may still be reading the old ring, so it is not
+ *  freed until the deque is destroyed. The rings double in size, so
+ *  the old ones take less memory than the current one.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "workDeque.h"
+
+#define CACHE_LINE 64		/* bytes in a cache line */
+
+/* One ring buffer */
+typedef struct _ring
+{
+    long capacity;		/* number of slots, a power of two */
+    struct _ring *older;	/* ring this one replaced, or NULL */
+    _Atomic(void *) items[];	/* the slots */
+} RING_T;
+
+/* The deque. 'top' and 'bottom' are on separate cache lines, since
+ * thieves change the first and the owner changes the second. */
+typedef struct
+{
+    _Alignas(CACHE_LINE) atomic_long top;	/* next item to steal */
+    _Alignas(CACHE_LINE) atomic_long bottom;	/* next slot to push into */
+    _Atomic(RING_T *) ring;	/* current ring buffer */
+} DEQUE_T;
+
+
+/* Create a ring buffer.
+ * Argument
+ *    capacity  -  Number of slots, a power of two
+ * Returns the ring, or NULL if a memory allocation error occurs.
+ */
+static RING_T *newRing(long capacity)
+{
+    RING_T *pRing = calloc(1, sizeof(RING_T) + capacity * sizeof(void *));
+    if (pRing != NULL)
+	pRing->capacity = capacity;
+    return pRing;
+}
+
+/* Read the item in a slot.
+ * Arguments
+ *    pRing     -  Ring buffer
+ *    position  -  Position (not yet masked)
+ * Returns the item.
+ */
+static void *getItem(RING_T * pRing, long position)
+{
+    return atomic_load_explicit(&pRing->items[position &
+					      (pRing->capacity - 1)],
+				memory_order_relaxed);
+}
+
+/* Write the item in a slot.
+ * Arguments
+ *    pRing     -  Ring buffer
+ *    position  -  Position (not yet masked)
+ *    item      -  Item to store
+ */
+static void setItem(RING_T * pRing, long position, void *item)
+{
+    atomic_store_explicit(&pRing->items[position & (pRing->capacity - 1)],
+			  item, memory_order_relaxed);
+}
+
+/* Replace the ring with one twice the size, holding the same
+ * items at the same positions. Only called by the owner.
+ * Arguments
+ *    pDeque    -  Deque
+ *    pRing     -  Current ring
+ *    top       -  Position of the oldest item
+ *    bottom    -  Position after the newest item
+ * Returns the new ring, or NULL if a memory allocation error occurs.
+ */
+static RING_T *growRing(DEQUE_T * pDeque, RING_T * pRing, long top,
+			long bottom)
+{
+    RING_T *pNew = newRing(pRing->capacity * 2);
+    long i = 0;
+    if (pNew == NULL)
+	return NULL;
+    for (i = top; i < bottom; i++)
+	setItem(pNew, i, getItem(pRing, i));
+    pNew->older = pRing;
+    atomic_store_explicit(&pDeque->ring, pNew, memory_order_release);
+    return pNew;
+}
+
+
+/** Public functions start here **/
+
+/* Create a new, empty deque.
+ * Argument
+ *    capacity   -  Number of items it can hold to start with.
+ *                  Rounded up to a power of two.
+ * Returns a handle for the deque, or NULL if a memory allocation
+ * error occurs.
+ */
+WORK_DEQUE_HANDLE newWorkDeque(int capacity)
+{
+    DEQUE_T *pDeque = NULL;
+    RING_T *pRing = NULL;
+    long size = 1;
+    while (size < capacity)
+	size *= 2;
+    pRing = newRing(size);
+    /* aligned so that top and bottom really are on different lines */
+    pDeque = aligned_alloc(CACHE_LINE, sizeof(DEQUE_T));
+    if ((pRing == NULL) || (pDeque == NULL))
+    {
+	free(pRing);
+	free(pDeque);
+	return NULL;
+    }
+    atomic_init(&pDeque->top, 0);
+    atomic_init(&pDeque->bottom, 0);
+    atomic_init(&pDeque->ring, pRing);
+    return (WORK_DEQUE_HANDLE) pDeque;
+}
+
+
+/* Free a deque. No other thread may be using it.
+ * Argument
+ *    deque    -  Deque to free, or NULL
+ */
+void workDequeDestroy(WORK_DEQUE_HANDLE deque)
+{
+    DEQUE_T *pDeque = (DEQUE_T *) deque;
+    RING_T *pRing = NULL;
+    RING_T *pOlder = NULL;
+    if (pDeque == NULL)
+	return;
+    pRing = atomic_load(&pDeque->ring);
+    while (pRing != NULL)
+    {
+	pOlder = pRing->older;
+	free(pRing);
+	pRing = pOlder;
+    }
+    free(pDeque);
+}
+
+
+/* Add an item at the bottom of the deque. Only the owner
+ * may call this.
+ * Arguments
+ *    deque    -  Deque returned by newWorkDeque
+ *    item     -  Item to add (not NULL)
+ * Returns 1 if successful, 0 if the deque was full and a memory
+ * allocation error occurred while making it larger.
+ */
+int workDequePush(WORK_DEQUE_HANDLE deque, void *item)
+{
+    DEQUE_T *pDeque = (DEQUE_T *) deque;
+    long bottom = atomic_load_explicit(&pDeque->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&pDeque->top, memory_order_acquire);
+    RING_T *pRing = atomic_load_explicit(&pDeque->ring, memory_order_relaxed);
+    if (bottom - top > pRing->capacity - 1)
+    {
+	pRing = growRing(pDeque, pRing, top, bottom);
+	if (pRing == NULL)
+	    return 0;
+    }
+    setItem(pRing, bottom, item);
+    /* release, so a thief that sees the new bottom sees the item */
+    atomic_store_explicit(&pDeque->bottom, bottom + 1, memory_order_release);
+    return 1;
+}
+
+
+/* Take the item from the bottom of the deque (the one
+ * pushed most recently). Only the owner may call this.
+ * Argument
+ *    deque    -  Deque returned by newWorkDeque
+ * Returns the item, or NULL if the deque is empty.
+ */
+void *workDequePop(WORK_DEQUE_HANDLE deque)
+{
+    DEQUE_T *pDeque = (DEQUE_T *) deque;
+    long bottom =
+	atomic_load_explicit(&pDeque->bottom, memory_order_relaxed) - 1;
+    RING_T *pRing = atomic_load_explicit(&pDeque->ring, memory_order_relaxed);
+    long top = 0;
+    void *item = NULL;
+    /* claim the bottom item before looking at what thieves have done */
+    atomic_store_explicit(&pDeque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    top = atomic_load_explicit(&pDeque->top, memory_order_relaxed);
+    if (top <= bottom)
+    {
+	item = getItem(pRing, bottom);
+	if (top == bottom)
+	{
+	    /* the last item - a thief may be after it too */
+	    if (!atomic_compare_exchange_strong_explicit(&pDeque->top, &top,
+							 top + 1,
+							 memory_order_seq_cst,
+							 memory_order_relaxed))
+		item = NULL;
+	    atomic_store_explicit(&pDeque->bottom, bottom + 1,
+				  memory_order_relaxed);
+	}
+    }
+    else
+    {
+	/* it was already empty */
+	atomic_store_explicit(&pDeque->bottom, bottom + 1,
+			      memory_order_relaxed);
+    }
+    return item;
+}
+
+
+/* Take the item from the top of the deque (the oldest one).
+ * Any thread may call this.
+ * Argument
+ *    deque    -  Deque returned by newWorkDeque
+ * Returns the item, or NULL if the deque is empty or another
+ * thread took the item first.
+ */
+void *workDequeSteal(WORK_DEQUE_HANDLE deque)
+{
+    DEQUE_T *pDeque = (DEQUE_T *) deque;
+    long top = atomic_load_explicit(&pDeque->top, memory_order_acquire);
+    long bottom = 0;
+    void *item = NULL;
+    atomic_thread_fence(memory_order_seq_cst);
+    bottom = atomic_load_explicit(&pDeque->bottom, memory_order_acquire);
+    if (top < bottom)
+    {
+	RING_T *pRing =
+	    atomic_load_explicit(&pDeque->ring, memory_order_acquire);
+	item = getItem(pRing, top);
+	if (!atomic_compare_exchange_strong_explicit(&pDeque->top, &top,
+						     top + 1,
+						     memory_order_seq_cst,
+						     memory_order_relaxed))
+	    item = NULL;	/* lost the race to the owner or a thief */
+    }
+    return item;
+}
+
+
+/* Find out about how many items are in the deque. If other
+ * threads are using it, the answer may be out of date.
+ * Argument
+ *    deque    -  Deque returned by newWorkDeque
+ * Returns the number of items.
+ */
+int workDequeSize(WORK_DEQUE_HANDLE deque)
+{
+    DEQUE_T *pDeque = (DEQUE_T *) deque;
+    long bottom = atomic_load(&pDeque->bottom);
+    long top = atomic_load(&pDeque->top);
+    return (bottom > top) ? (int) (bottom - top) : 0;
+}
@@ -0,0 +1,85 @@
+/*
+ *  workDeque.h
+ *
+ *  Declarations for a work-stealing deque (double-ended queue), as
+ *  described by Chase and Lev. Each deque has one owner thread,
+ *  which pushes and pops items at the bottom end, like a stack.
+ *  Any other thread may steal items from the top end, so a thread
+ *  with nothing to do can take the oldest work from a busy one.
+ *
+ *  The owner's operations do not use any locks, and only need an
+ *  atomic compare-and-swap when the deque is down to its last item.
+ *  Thieves use a compare-and-swap to decide which of them gets an
+ *  item. The deque grows as needed.
+ *
+ *  Items are pointers to anything, but may not be NULL, since NULL
+ *  means that there was nothing to pop or steal.
+ *
+ *  Copyright 2020 by Sally E. Goldin
+ *
+ *  May be freely copied and modified for educational purposes
+ *  as long as this notice is retained in the header.
+ *  Note this code is not intended for real-world applications.
+ */
+#ifndef WORKDEQUE_H
+#define WORKDEQUE_H
+
+/* opaque pointer to a work-stealing deque */
+typedef void *WORK_DEQUE_HANDLE;
+
+/* Create a new, empty deque.
+ * Argument
+ *    capacity   -  Number of items it can hold to start with.
+ *                  Rounded up to a power of two.
+ * Returns a handle for the deque, or NULL if a memory allocation
+ * error occurs.
+ */
+WORK_DEQUE_HANDLE newWorkDeque(int capacity);
+
+
+/* Free a deque. No other thread may be using it.
+ * Argument
+ *    deque    -  Deque to free, or NULL
+ */
+void workDequeDestroy(WORK_DEQUE_HANDLE deque);
+
+
+/* Add an item at the bottom of the deque. Only the owner
+ * may call this.
+ * Arguments
+ *    deque    -  Deque returned by newWorkDeque
+ *    item     -  Item to add (not NULL)
+ * Returns 1 if successful, 0 if the deque was full and a memory
+ * allocation error occurred while making it larger.
+ */
+int workDequePush(WORK_DEQUE_HANDLE deque, void *item);
+
+
+/* Take the item from the bottom of the deque (the one
+ * pushed most recently). Only the owner may call this.
+ * Argument
+ *    deque    -  Deque returned by newWorkDeque
+ * Returns the item, or NULL if the deque is empty.
+ */
+void *workDequePop(WORK_DEQUE_HANDLE deque);
+
+
+/* Take the item from the top of the deque (the oldest one).
+ * Any thread may call this.
+ * Argument
+ *    deque    -  Deque returned by newWorkDeque
+ * Returns the item, or NULL if the deque is empty or another
+ * thread took the item first.
+ */
+void *workDequeSteal(WORK_DEQUE_HANDLE deque);
+
+
+/* Find out about how many items are in the deque. If other
+ * threads are using it, the answer may be out of date.
+ * Argument
+ *    deque    -  Deque returned by newWorkDeque
+ * Returns the number of items.
+ */
+int workDequeSize(WORK_DEQUE_HANDLE deque);
+
+#endif